@@ -1,4 +1,5 @@
 #include "jsoncontextloader.h"
+#include "vl_contentsetmodel.h"
 
 #include <QFile>
 #include <QByteArray>
@@ -6,7 +7,6 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QDebug>
-#include <exception>
 
 
 
@@ -25,19 +25,14 @@ bool JsonContentSetLoader::init(const QString &p_zeraContentSetPath, const QStri
     m_zeraContentSetPath = p_zeraContentSetPath;
     m_customerContentSetPath = p_customerContentSetPath;
 
-    QFile zeraFile;
-    QFile customerFile;
-
-    zeraFile.setFileName(p_zeraContentSetPath);
-    customerFile.setFileName(p_customerContentSetPath);
-
-    if(!zeraFile.exists()){
+    //parses both files once for all loaders
+    if(!zeraModel()->exists()){
         m_zeraContentSetPath="";
         retVal=false;
         m_lastError=error::FileDoesNotExist;
     }
 
-    if(!customerFile.exists()){
+    if(!customerModel()->exists()){
         //m_customerContentSetPath="";
         //retVal=false;
         //m_lastError=error::FileDoesNotExist;
@@ -51,10 +46,12 @@ QMap<QString,QVector<QString>> JsonContentSetLoader::readContentSet(const QStrin
 {
     QMap<QString,QVector<QString>> retVal;
     try {
-        if(hasContentSet(m_zeraContentSetPath,p_contentSetName)){
-            retVal=readContentSetFromFile(m_zeraContentSetPath,p_contentSetName);
-        }else if(hasContentSet(m_customerContentSetPath,p_contentSetName)){
-            retVal=readContentSetFromFile(m_customerContentSetPath,p_contentSetName);
+        const QSharedPointer<const VeinLogger::ContentSetModel> zera = zeraModel();
+        const QSharedPointer<const VeinLogger::ContentSetModel> customer = customerModel();
+        if(hasContentSet(*zera,p_contentSetName)){
+            retVal=zera->contentSet(p_contentSetName);
+        }else if(hasContentSet(*customer,p_contentSetName)){
+            retVal=customer->contentSet(p_contentSetName);
         }
     }  catch (error &e) {
         m_lastError=e;
@@ -63,6 +60,16 @@ QMap<QString,QVector<QString>> JsonContentSetLoader::readContentSet(const QStrin
 
 }
 
+QVariant JsonContentSetLoader::readChangeFilter(const QString &p_contentSetName)
+{
+    return readContentSetOption(c_changeFilter, p_contentSetName);
+}
+
+QVariant JsonContentSetLoader::readDownsampling(const QString &p_contentSetName)
+{
+    return readContentSetOption(c_downsampling, p_contentSetName);
+}
+
 bool JsonContentSetLoader::addContentSet(const QString &p_contentSetName, const QString &p_session, QMap<QString,QVector<QString>> p_entityComponentMap)
 {
     bool retVal=true;
@@ -128,6 +135,8 @@ bool JsonContentSetLoader::addContentSet(const QString &p_contentSetName, const
         file.open(QFile::WriteOnly | QFile::Text | QFile::Truncate);
         file.write(doc.toJson());
         file.close();
+        //do not wait for the file watcher
+        VeinLogger::ContentSetModel::invalidate(m_customerContentSetPath);
 
 
     }  catch (error &e) {
@@ -197,6 +206,8 @@ bool JsonContentSetLoader::removeContentSet(const QString &p_contentSetName)
         file.open(QFile::WriteOnly | QFile::Text | QFile::Truncate);
         file.write(doc.toJson());
         file.close();
+        //do not wait for the file watcher
+        VeinLogger::ContentSetModel::invalidate(m_customerContentSetPath);
 
 
     }  catch (error &e) {
@@ -243,12 +254,22 @@ JsonContentSetLoader::error JsonContentSetLoader::readLasterror()
     return tmpError;
 }
 
+QSharedPointer<const VeinLogger::ContentSetModel> JsonContentSetLoader::zeraModel() const
+{
+    return VeinLogger::ContentSetModel::load(m_zeraContentSetPath);
+}
+
+QSharedPointer<const VeinLogger::ContentSetModel> JsonContentSetLoader::customerModel() const
+{
+    return VeinLogger::ContentSetModel::load(m_customerContentSetPath);
+}
+
 
 QVector<QString> JsonContentSetLoader::zeraContentSetList(const QString &p_session)
 {
     QVector<QString> retVal;
     if(!m_zeraContentSetPath.isEmpty()){
-        retVal = readContentSetListFromFile(m_zeraContentSetPath, p_session);
+        retVal = readContentSetListFromModel(*zeraModel(), p_session);
     }
     return retVal;
 }
@@ -257,7 +278,7 @@ QVector<QString> JsonContentSetLoader::customerContentSetList(const QString &p_s
 {
     QVector<QString> retVal;
     if(!m_customerContentSetPath.isEmpty()){
-        retVal = readContentSetListFromFile(m_customerContentSetPath, p_session);
+        retVal = readContentSetListFromModel(*customerModel(), p_session);
     }
     return retVal;
 }
@@ -266,7 +287,7 @@ QVector<QString> JsonContentSetLoader::zeraSessionList()
 {
     QVector<QString> retVal;
     if(!m_zeraContentSetPath.isEmpty()){
-        retVal = readSessionListFromFile(m_zeraContentSetPath);
+        retVal = readSessionListFromModel(*zeraModel());
     }
     return retVal;
 }
@@ -275,135 +296,57 @@ QVector<QString> JsonContentSetLoader::customerSessionList()
 {
     QVector<QString> retVal;
     if(!m_customerContentSetPath.isEmpty()){
-        retVal = readSessionListFromFile(m_customerContentSetPath);
+        retVal = readSessionListFromModel(*customerModel());
     }
     return retVal;
 }
 
-QVector<QString> JsonContentSetLoader::readSessionListFromFile(const QString &p_file)
+QVector<QString> JsonContentSetLoader::readSessionListFromModel(const VeinLogger::ContentSetModel &p_model)
 {
-    QVector<QString> retVal;
-    QFile file;
-    file.setFileName(p_file);
-    if(!file.open(QIODevice::Unbuffered | QIODevice::ReadOnly)){
+    if(!p_model.isReadable()){
         throw error::CanNotOpenFile;
     }
-    QByteArray fileContent=file.readAll();
-    QJsonParseError err;
-    QJsonDocument doc = QJsonDocument::fromJson(fileContent, &err);
-    if(err.error == QJsonParseError::NoError){
-        if(doc.isObject()){
-            QJsonObject rootObj = doc.object();
-            QJsonObject sessionObj = rootObj.value(c_session).toObject();
-            retVal=sessionObj.keys().toVector();
-        }
-    }
-    file.close();
-    return retVal;
+    return p_model.sessionList();
 }
 
-QVector<QString> JsonContentSetLoader::readContentSetListFromFile(const QString &p_file, const QString &p_session)
+QVector<QString> JsonContentSetLoader::readContentSetListFromModel(const VeinLogger::ContentSetModel &p_model, const QString &p_session)
 {
-    QVector<QString> retVal;
-    QFile file;
-    file.setFileName(p_file);
-    if(!file.open(QIODevice::Unbuffered | QIODevice::ReadOnly)){
+    if(!p_model.isReadable()){
         throw error::CanNotOpenFile;
     }
-    QByteArray fileContent=file.readAll();
-    QJsonParseError err;
-    QJsonDocument doc = QJsonDocument::fromJson(fileContent, &err);
-    if(err.error == QJsonParseError::NoError){
-        if(doc.isObject()){
-            QJsonObject rootObj = doc.object();
-            QJsonValue sessionObj = rootObj.value(c_session);
-            if(sessionObj == QJsonValue::Undefined){
-                file.close();
-                throw error::ObjectDoesNotExist;
-            }
-            QJsonValue  contentSetList = sessionObj.toObject().value(p_session);
-            if(contentSetList == QJsonValue::Undefined){
-            }else{
-                for(QJsonValue tmpVal : contentSetList.toArray()){
-                    retVal.append(tmpVal.toString());
-                }
-            }
-
-        }
+    if(p_model.isValid() && !p_model.hasSessionSection()){
+        throw error::ObjectDoesNotExist;
     }
-    file.close();
-    return retVal;
+    return p_model.contentSetList(p_session);
 }
 
-bool JsonContentSetLoader::hasContentSet(const QString &p_file, const QString &p_contentSetName)
+bool JsonContentSetLoader::hasContentSet(const VeinLogger::ContentSetModel &p_model, const QString &p_contentSetName)
 {
-
-    bool retVal=false;
-    QFile file;
-    file.setFileName(p_file);
-    if(file.exists()){
-        if(!file.open(QIODevice::Unbuffered | QIODevice::ReadOnly)){
-            throw std::runtime_error("Can not open File");
-        }
-        QByteArray fileContent=file.readAll();
-        QJsonParseError err;
-        QJsonDocument doc = QJsonDocument::fromJson(fileContent, &err);
-        if(err.error == QJsonParseError::NoError){
-            if(doc.isObject()){
-                QJsonObject rootObj = doc.object();
-                QJsonValue contentSetObj = rootObj.value(c_contentSet);
-                if(contentSetObj.isUndefined()){
-                    file.close();
-                    throw error::ObjectDoesNotExist;
-                }
-                QJsonValue  contentSetList = contentSetObj.toObject().value(p_contentSetName);
-                if(contentSetList.isUndefined()){
-                    retVal=false;
-                }else{
-                    retVal=true;
-                }
-            }
-        }
-        file.close();
+    if(!p_model.exists()){
+        return false;
     }
-    return retVal;
+    if(!p_model.isReadable()){
+        throw error::CanNotOpenFile;
+    }
+    if(p_model.isValid() && !p_model.hasContentSetSection()){
+        throw error::ObjectDoesNotExist;
+    }
+    return p_model.hasContentSet(p_contentSetName);
 }
 
-QMap<QString,QVector<QString>> JsonContentSetLoader::readContentSetFromFile(const QString &p_file, const QString &p_contentSet)
+QVariant JsonContentSetLoader::readContentSetOption(const QString &p_section, const QString &p_contentSetName)
 {
-    QMap<QString,QVector<QString>> retVal;
-    QFile file;
-    file.setFileName(p_file);
-    if(!file.open(QIODevice::Unbuffered | QIODevice::ReadOnly)){
-        throw error::CanNotOpenFile;
-    }
-    QByteArray fileContent=file.readAll();
-    QJsonParseError err;
-    QJsonDocument doc = QJsonDocument::fromJson(fileContent, &err);
-    if(err.error == QJsonParseError::NoError){
-        if(doc.isObject()){
-            QJsonObject rootObj = doc.object();
-            QJsonValue contentSetObj = rootObj.value(c_contentSet);
-            if(contentSetObj == QJsonValue::Undefined){
-                throw error::ObjectDoesNotExist;
-            }
-            QJsonValue contentSetList=contentSetObj.toObject().value(p_contentSet);
-            if(contentSetList == QJsonValue::Undefined){
-                throw error::ObjectDoesNotExist;
-            }
-            for(QJsonValue tmpVal : contentSetList.toArray()){
-                QJsonArray compListArray = tmpVal.toObject().value(c_component).toArray();
-                if(compListArray.count() > 0) {
-                    for(QJsonValue comp : compListArray){
-                        retVal[tmpVal.toObject().value(c_entity).toString()].append(comp.toString());
-                    }
-                }
-                else {
-                    retVal[tmpVal.toObject().value(c_entity).toString()] = QVector<QString>();
-                }
-            }
+    QVariant retVal;
+    try {
+        const QSharedPointer<const VeinLogger::ContentSetModel> zera = zeraModel();
+        const QSharedPointer<const VeinLogger::ContentSetModel> customer = customerModel();
+        if(hasContentSet(*zera,p_contentSetName)){
+            retVal=zera->option(p_section,p_contentSetName);
+        }else if(hasContentSet(*customer,p_contentSetName)){
+            retVal=customer->option(p_section,p_contentSetName);
         }
+    }  catch (error &e) {
+        m_lastError=e;
     }
-    file.close();
     return retVal;
 }
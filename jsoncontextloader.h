@@ -2,6 +2,13 @@
 #define JSONCONTEXTLOADER_H
 
 #include <QObject>
+#include <QVariant>
+#include <QSharedPointer>
+
+namespace VeinLogger
+{
+class ContentSetModel;
+}
 
 
 
@@ -28,10 +35,27 @@
  *          ${contentSetName},
  *          ...
  *      ]
+ *   },
+ *  "ChangeFilter": {
+ *      "${contentSetName}": {
+ *          "AbsoluteDeadband": ${value},
+ *          "RelativeDeadband": ${fraction},
+ *          "Heartbeat": ${ms}
+ *      }
+ *   },
+ *  "Downsampling": {
+ *      "${contentSetName}": {
+ *          "MaxRate": ${valuesPerSecond},
+ *          "Aggregation": "last" | "mean" | "min" | "max" | "all"
+ *      }
  *   }
  * }
  * @endcode
  *
+ * "ChangeFilter" is optional: content sets listed there only log changed values, see VeinLogger::ChangeFilter.
+ * "Downsampling" is optional: content sets listed there store at most MaxRate values per second and
+ * component, see VeinLogger::Downsampler.
+ *
  * To files are needed. One for defualt configuration.
  * This file is not editable (zeraContentSetPath).
  * And one editable file (customerContentSetPath).
@@ -39,6 +63,9 @@
  *
  * zeraContentSetPath will always be priortised in case a a contentSet is available in
  * both files.
+ *
+ * The files are not read by the lookups: all loaders share one parsed VeinLogger::ContentSetModel per file,
+ * which is parsed again only when the file changed.
  */
 class JsonContentSetLoader : public QObject
 {
@@ -68,6 +95,18 @@ public:
      * @return QMap<<QVector<componentName>>
      */
     QMap<QString,QVector<QString>>  readContentSet(const QString &p_contentSetName);
+    /**
+     * @brief readChangeFilter
+     * @param p_contentSetName: contentSet to read the filter settings for
+     * @return "ChangeFilter" entry of the contentSet as QVariantMap, invalid if its values are not filtered
+     */
+    QVariant readChangeFilter(const QString &p_contentSetName);
+    /**
+     * @brief readDownsampling
+     * @param p_contentSetName: contentSet to read the downsampling settings for
+     * @return "Downsampling" entry of the contentSet as QVariantMap, invalid if it stores every value
+     */
+    QVariant readDownsampling(const QString &p_contentSetName);
     /**
      * @brief addContentSet
      * @param p_contentSetName
@@ -107,17 +146,20 @@ public:
      */
     error readLasterror();
 private:
+    QSharedPointer<const VeinLogger::ContentSetModel> zeraModel() const;
+    QSharedPointer<const VeinLogger::ContentSetModel> customerModel() const;
+
     QVector<QString> zeraContentSetList(const QString &p_session);
     QVector<QString> customerContentSetList(const QString &p_file);
 
     QVector<QString> zeraSessionList();
     QVector<QString> customerSessionList();
 
-    QVector<QString> readSessionListFromFile(const QString &p_session);
+    QVector<QString> readSessionListFromModel(const VeinLogger::ContentSetModel &p_model);
 
-    QVector<QString> readContentSetListFromFile(const QString &p_file,  const QString &p_session);
-    bool hasContentSet(const QString &p_file,const QString &p_contentSetName);
-    QMap<QString,QVector<QString>>  readContentSetFromFile(const QString &p_file,  const QString &p_contentSet);
+    QVector<QString> readContentSetListFromModel(const VeinLogger::ContentSetModel &p_model, const QString &p_session);
+    bool hasContentSet(const VeinLogger::ContentSetModel &p_model, const QString &p_contentSetName);
+    QVariant readContentSetOption(const QString &p_section, const QString &p_contentSetName);
 
 private:
     QString m_zeraContentSetPath;
@@ -128,6 +170,8 @@ private:
     const QString c_contentSet = QLatin1String("ContentSet");
     const QString c_entity = QLatin1String("EntityId");
     const QString c_component = QLatin1String("Components");
+    const QString c_changeFilter = QLatin1String("ChangeFilter");
+    const QString c_downsampling = QLatin1String("Downsampling");
 
 signals:
 
@@ -0,0 +1,17 @@
+CREATE TABLE components (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, component_name varchar(255));
+CREATE TABLE entities (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, entity_name varchar(255));
+CREATE TABLE sessions (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, session_name varchar(255) NOT NULL);
+/* value_timestamp, start_time and stop_time: UTC microseconds since epoch as INTEGER, databases of older versions contain ISO 8601 text */;
+CREATE TABLE transactions (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, sessionid integer(10) NOT NULL, transaction_name varchar(255), contentset_names varchar(255), guicontext_name varchar(255), start_time timestamp, stop_time timestamp, FOREIGN KEY(sessionid) REFERENCES sessions(id));
+CREATE TABLE transactions_valuemap (transactionsid integer(10) NOT NULL, valueid integer(10) NOT NULL, PRIMARY KEY (transactionsid, valueid), FOREIGN KEY(valueid) REFERENCES valuemap(id), FOREIGN KEY(transactionsid) REFERENCES transactions(id));
+CREATE TABLE sessions_valuemap (sessionsid integer(10) NOT NULL, valueid integer(10) NOT NULL, PRIMARY KEY (sessionsid, valueid), FOREIGN KEY(valueid) REFERENCES valuemap(id), FOREIGN KEY(sessionsid) REFERENCES sessions(id));
+/* component_value has no declared type, so sqlite keeps the storage class of the bound value:
+ * INTEGER for integers and booleans, REAL (8 byte) for floating point numbers, TEXT for strings
+ * and BLOB (see VeinLogger::ValueCodec) for lists, maps and all other types.
+ */;
+CREATE TABLE valuemap (id INTEGER NOT NULL PRIMARY KEY AUTOINCREMENT, value_timestamp timestamp, component_value, componentid integer(10), entityiesid integer(10), FOREIGN KEY(entityiesid) REFERENCES entities(id), FOREIGN KEY(componentid) REFERENCES components(id));
+/* this creates schema version 0, indexes and later changes are migration steps applied on open (pragma user_version), see DBPrivate::schemaMigrationSteps */;
+
+/* numeric range queries and aggregates work directly on the stored values, example:
+ * SELECT min(component_value), max(component_value), avg(component_value) FROM valuemap WHERE componentid = 42 AND typeof(component_value) IN ('integer', 'real');
+ */;
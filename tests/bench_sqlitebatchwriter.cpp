@@ -0,0 +1,112 @@
+#include "vl_sqlitebatchwriter.h"
+
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QTemporaryDir>
+
+using namespace VeinLogger;
+
+/**
+ * @brief The BenchSQLiteBatchWriter class
+ *
+ * Writes one batch of 50k valuemap rows with their transaction mappings, once through the
+ * native sqlite3 statements and once through the QSqlQuery::execBatch fallback, which is
+ * the path all batches took before the native writer.
+ */
+class BenchSQLiteBatchWriter : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void writeBatch_data();
+    void writeBatch();
+
+private:
+    QSqlDatabase createDatabase(const QString &t_connectionName);
+
+    QTemporaryDir m_tempDir;
+    static constexpr int s_rowCount = 50000;
+};
+
+constexpr int BenchSQLiteBatchWriter::s_rowCount;
+
+void BenchSQLiteBatchWriter::initTestCase()
+{
+    QVERIFY(m_tempDir.isValid());
+}
+
+QSqlDatabase BenchSQLiteBatchWriter::createDatabase(const QString &t_connectionName)
+{
+    QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", t_connectionName);
+    database.setDatabaseName(m_tempDir.filePath(t_connectionName + ".db"));
+    if(database.open() == false) {
+        return database;
+    }
+    QFile schemaFile(QStringLiteral(VFLOGGER_SOURCE_DIR "/sqlite/schema_sqlite.sql"));
+    if(schemaFile.open(QFile::ReadOnly | QFile::Text)) {
+        for(const QString &statement : QString::fromUtf8(schemaFile.readAll()).split(';')) {
+            //comments and empty statements fail, like in SQLiteDB::openDatabase
+            QSqlQuery(database).exec(statement);
+        }
+    }
+    QSqlQuery(database).exec("pragma journal_mode = WAL;");
+    QSqlQuery(database).exec("pragma synchronous = NORMAL;");
+    return database;
+}
+
+void BenchSQLiteBatchWriter::writeBatch_data()
+{
+    QTest::addColumn<bool>("native");
+    QTest::newRow("QSqlQuery execBatch") << false;
+    QTest::newRow("native sqlite3") << true;
+}
+
+void BenchSQLiteBatchWriter::writeBatch()
+{
+    QFETCH(bool, native);
+    const QString connectionName = native ? QStringLiteral("native") : QStringLiteral("fallback");
+    {
+        QSqlDatabase database = createDatabase(connectionName);
+        QVERIFY2(database.isOpen(), qPrintable(database.lastError().text()));
+
+        sqlite3 *handle = nullptr;
+        if(native) {
+            QString mismatch;
+            handle = SQLiteBatchWriter::nativeHandle(database, mismatch);
+            if(handle == nullptr) {
+                QSKIP(qPrintable(mismatch));
+            }
+        }
+        SQLiteBatchWriter writer;
+        QVERIFY2(writer.prepare(database, handle), qPrintable(writer.lastError()));
+        QCOMPARE(writer.isNative(), native);
+
+        writer.reserve(s_rowCount);
+        for(int row = 0; row < s_rowCount; ++row) {
+            writer.addValueRow(row + 1, 1600000000000000LL + row * 1000LL, row % 40 + 1, row % 8 + 1);
+            writer.setRealValue(row * 0.25);
+            writer.addTransactionMapping(1, row + 1);
+        }
+
+        QBENCHMARK_ONCE {
+            QVERIFY(database.transaction());
+            QVERIFY2(writer.execute(), qPrintable(writer.lastError()));
+            QVERIFY(database.commit());
+        }
+
+        QSqlQuery countQuery(database);
+        QVERIFY(countQuery.exec("SELECT COUNT(*) FROM valuemap;"));
+        QVERIFY(countQuery.next());
+        QCOMPARE(countQuery.value(0).toInt(), s_rowCount);
+        countQuery.finish();
+        writer.finalize();
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+QTEST_GUILESS_MAIN(BenchSQLiteBatchWriter)
+
+#include "bench_sqlitebatchwriter.moc"
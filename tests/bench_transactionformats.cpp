@@ -0,0 +1,102 @@
+#include "vl_sqlitedb.h"
+
+#include <QtTest>
+#include <QTemporaryDir>
+
+using namespace VeinLogger;
+
+/**
+ * @brief The BenchTransactionFormats class
+ *
+ * Reads one transaction of s_valueCount values and encodes it like RPC_readTransaction does for
+ * the formats "json", "cbor" and "cbor+zlib". Half of the values are scalars, half are sample lists.
+ * The encoded size is printed after each row.
+ */
+class BenchTransactionFormats : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void readTransaction_data();
+    void readTransaction();
+    void cleanupTestCase();
+
+private:
+    QTemporaryDir m_tempDir;
+    SQLiteDB *m_database = nullptr;
+    static constexpr int s_valueCount = 20000;
+    static constexpr int s_entityId = 1040;
+};
+
+constexpr int BenchTransactionFormats::s_valueCount;
+constexpr int BenchTransactionFormats::s_entityId;
+
+void BenchTransactionFormats::initTestCase()
+{
+    QVERIFY(m_tempDir.isValid());
+    m_database = new SQLiteDB();
+    m_database->setStorageMode(AbstractLoggerDB::STORAGE_MODE::TYPED);
+    QVERIFY(m_database->openDatabase(m_tempDir.filePath("formats.db")));
+
+    m_database->addEntity(s_entityId, "POWER1Module1");
+    m_database->addComponent("ACT_PQS1");
+    m_database->addComponent("ACT_Samples");
+    const int sessionId = m_database->addSession("bench", QList<QVariantMap>());
+    const int transactionId = m_database->reserveTransactionId();
+    QVERIFY(sessionId > 0);
+    QVERIFY(transactionId > 0);
+    QVERIFY(m_database->addTransaction(transactionId, "snapshot", "bench", "ZeraAll", ""));
+
+    QList<double> samples;
+    for(int i = 0; i < 16; ++i) {
+        samples.append(i * 0.125);
+    }
+    for(int i = 0; i < s_valueCount; ++i) {
+        const qint64 timestamp = 1600000000000000LL + i * 1000LL;
+        if(i % 2 == 0) {
+            m_database->addLoggedValue(sessionId, {transactionId}, s_entityId, "ACT_PQS1", QVariant(230.0 + i * 0.001), timestamp);
+        }
+        else {
+            m_database->addLoggedValue(sessionId, {transactionId}, s_entityId, "ACT_Samples", QVariant::fromValue(samples), timestamp);
+        }
+    }
+    m_database->runBatchedExecution();
+    QCOMPARE(m_database->readTransactionIds("snapshot", "bench").size(), 1);
+}
+
+void BenchTransactionFormats::readTransaction_data()
+{
+    QTest::addColumn<QString>("format");
+    QTest::newRow("json") << QString("json");
+    QTest::newRow("cbor") << QString("cbor");
+    QTest::newRow("cbor+zlib") << QString("cbor+zlib");
+}
+
+void BenchTransactionFormats::readTransaction()
+{
+    QFETCH(QString, format);
+    QByteArray encoded;
+    QBENCHMARK {
+        if(format == QLatin1String("json")) {
+            encoded = m_database->readTransaction("snapshot", "bench").toJson();
+        }
+        else {
+            encoded = m_database->readTransactionColumns("snapshot", "bench").toCborValue().toCbor();
+            if(format == QLatin1String("cbor+zlib")) {
+                encoded = qCompress(encoded);
+            }
+        }
+    }
+    QVERIFY(encoded.isEmpty() == false);
+    qInfo("%s: %d bytes, %.1f bytes/value", qPrintable(format), encoded.size(), static_cast<double>(encoded.size()) / s_valueCount);
+}
+
+void BenchTransactionFormats::cleanupTestCase()
+{
+    delete m_database;
+    m_database = nullptr;
+}
+
+QTEST_GUILESS_MAIN(BenchTransactionFormats)
+
+#include "bench_transactionformats.moc"
@@ -0,0 +1,84 @@
+#include "vl_valuecodec.h"
+
+#include <QtTest>
+#include <QDataStream>
+
+using namespace VeinLogger;
+
+/**
+ * @brief The BenchValueCodec class
+ *
+ * Encodes s_valueCount values per benchmark iteration, once with ValueCodec and once with the
+ * QDataStream (Qt_5_0) representation all blobs used before. The time per value is printed
+ * after each row, QBENCHMARK reports the time for the whole set.
+ */
+class BenchValueCodec : public QObject
+{
+    Q_OBJECT
+private slots:
+    void encode_data();
+    void encode();
+
+private:
+    static constexpr int s_valueCount = 10000;
+};
+
+constexpr int BenchValueCodec::s_valueCount;
+
+void BenchValueCodec::encode_data()
+{
+    QTest::addColumn<QVariant>("value");
+    QTest::addColumn<bool>("dataStream");
+
+    QList<double> samples;
+    for(int i = 0; i < 128; ++i) {
+        samples.append(i * 0.5);
+    }
+    const QVariant scalar(230.25);
+    const QVariant list = QVariant::fromValue(samples);
+    const QVariant text(QStringLiteral("Ready"));
+
+    QTest::newRow("double QDataStream") << scalar << true;
+    QTest::newRow("double ValueCodec") << scalar << false;
+    QTest::newRow("QList<double>[128] QDataStream") << list << true;
+    QTest::newRow("QList<double>[128] ValueCodec") << list << false;
+    QTest::newRow("QString QDataStream") << text << true;
+    QTest::newRow("QString ValueCodec") << text << false;
+}
+
+void BenchValueCodec::encode()
+{
+    QFETCH(QVariant, value);
+    QFETCH(bool, dataStream);
+
+    qint64 encodedSize = 0;
+    qint64 elapsedNs = 0;
+    qint64 runs = 0;
+    QByteArray target;
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+        for(int i = 0; i < s_valueCount; ++i) {
+            //same reuse of the target capacity as the batch writer
+            target.resize(0);
+            if(dataStream) {
+                QDataStream dataWriter(&target, QIODevice::WriteOnly);
+                dataWriter.setVersion(QDataStream::Qt_5_0);
+                dataWriter << value;
+            }
+            else {
+                ValueCodec::encode(value, target);
+            }
+        }
+        elapsedNs += timer.nsecsElapsed();
+        ++runs;
+        encodedSize = target.size();
+    }
+    QVERIFY(encodedSize > 0);
+    qInfo("%s: %.1f ns/value, %lld bytes/value", QTest::currentDataTag(),
+          static_cast<double>(elapsedNs) / static_cast<double>(runs * s_valueCount), encodedSize);
+}
+
+QTEST_GUILESS_MAIN(BenchValueCodec)
+
+#include "bench_valuecodec.moc"
@@ -0,0 +1,4 @@
+#include "globalIncludes.h"
+
+//defined by vl_databaselogger.cpp in the library
+Q_LOGGING_CATEGORY(VEIN_LOGGER, VEIN_DEBUGNAME_LOGGER)
@@ -0,0 +1,272 @@
+#include "vl_changefilter.h"
+
+#include <QtTest>
+
+#include <limits>
+
+using namespace VeinLogger;
+
+/**
+ * @brief The TestChangeFilter class
+ *
+ * One filtered transaction s_transactionId logs entity s_entityId, component "ACT_PQS1" unless noted otherwise.
+ */
+class TestChangeFilter : public QObject
+{
+    Q_OBJECT
+private slots:
+    void unfilteredTransactionPassesThrough();
+    void firstValueIsLogged();
+    void deadband_data();
+    void deadband();
+    void driftIsComparedToLastLogged();
+    void arrays_data();
+    void arrays();
+    void otherTypesAreComparedExactly();
+    void nanIsAlwaysLogged();
+    void heartbeat();
+    void unfilteredContentSetWins();
+    void smallestDeadbandWins();
+    void onlySuppressingTransactionsAreRemoved();
+    void resetLastValues();
+    void removeTransaction();
+    void savings();
+
+private:
+    static QMultiHash<int, QVariant> entityFilter(double t_absolute, double t_relative = 0.0, qint64 t_heartbeatMs = 0);
+    /**
+     * @return true if t_value is logged by s_transactionId
+     */
+    static bool logs(ChangeFilter &t_filter, const QVariant &t_value, qint64 t_timestampUs = 0);
+
+    static constexpr int s_transactionId = 3;
+    static constexpr int s_entityId = 1040;
+};
+
+constexpr int TestChangeFilter::s_transactionId;
+constexpr int TestChangeFilter::s_entityId;
+
+QMultiHash<int, QVariant> TestChangeFilter::entityFilter(double t_absolute, double t_relative, qint64 t_heartbeatMs)
+{
+    QVariantMap config;
+    config.insert("AbsoluteDeadband", t_absolute);
+    config.insert("RelativeDeadband", t_relative);
+    config.insert("Heartbeat", t_heartbeatMs);
+    QMultiHash<int, QVariant> retVal;
+    retVal.insert(s_entityId, config);
+    return retVal;
+}
+
+bool TestChangeFilter::logs(ChangeFilter &t_filter, const QVariant &t_value, qint64 t_timestampUs)
+{
+    return t_filter.filter({s_transactionId}, s_entityId, "ACT_PQS1", t_value, t_timestampUs).contains(s_transactionId);
+}
+
+void TestChangeFilter::unfilteredTransactionPassesThrough()
+{
+    ChangeFilter filter;
+    QVERIFY(filter.isActive() == false);
+    const QVector<int> transactionIds({1, 2});
+    const QVector<int> &accepted = filter.filter(transactionIds, s_entityId, "ACT_PQS1", QVariant(1.0), 0);
+    QCOMPARE(accepted, transactionIds);
+    QCOMPARE(&accepted, &transactionIds);
+    QCOMPARE(filter.filter(transactionIds, s_entityId, "ACT_PQS1", QVariant(1.0), 0), transactionIds);
+}
+
+void TestChangeFilter::firstValueIsLogged()
+{
+    ChangeFilter filter;
+    filter.addTransaction(s_transactionId, entityFilter(0.0));
+    QVERIFY(filter.isActive());
+    QVERIFY(logs(filter, QVariant(230.0)));
+    QVERIFY(logs(filter, QVariant(230.0)) == false);
+    QVERIFY(logs(filter, QVariant(230.5)));
+}
+
+void TestChangeFilter::deadband_data()
+{
+    QTest::addColumn<double>("absolute");
+    QTest::addColumn<double>("relative");
+    QTest::addColumn<QVariant>("next");
+    QTest::addColumn<bool>("logged");
+    //last logged value is 200.0
+    QTest::newRow("inside absolute") << 1.0 << 0.0 << QVariant(200.9) << false;
+    QTest::newRow("on absolute edge") << 1.0 << 0.0 << QVariant(201.0) << false;
+    QTest::newRow("outside absolute") << 1.0 << 0.0 << QVariant(201.5) << true;
+    QTest::newRow("outside absolute below") << 1.0 << 0.0 << QVariant(198.5) << true;
+    QTest::newRow("inside relative") << 0.0 << 0.01 << QVariant(201.5) << false;
+    QTest::newRow("outside relative") << 0.0 << 0.01 << QVariant(202.5) << true;
+    QTest::newRow("larger band wins") << 5.0 << 0.01 << QVariant(204.0) << false;
+    QTest::newRow("float inside") << 1.0 << 0.0 << QVariant(200.5f) << false;
+    QTest::newRow("type changed") << 1.0 << 0.0 << QVariant(201) << true;
+}
+
+void TestChangeFilter::deadband()
+{
+    QFETCH(double, absolute);
+    QFETCH(double, relative);
+    QFETCH(QVariant, next);
+    QFETCH(bool, logged);
+    ChangeFilter filter;
+    filter.addTransaction(s_transactionId, entityFilter(absolute, relative));
+    const QVariant first = next.userType() == QMetaType::Float ? QVariant(200.0f) : QVariant(200.0);
+    QVERIFY(logs(filter, first));
+    QCOMPARE(logs(filter, next), logged);
+}
+
+void TestChangeFilter::driftIsComparedToLastLogged()
+{
+    ChangeFilter filter;
+    filter.addTransaction(s_transactionId, entityFilter(1.0));
+    QVERIFY(logs(filter, QVariant(10.0)));
+    QVERIFY(logs(filter, QVariant(10.6)) == false);
+    QVERIFY(logs(filter, QVariant(10.9)) == false);
+    //each step is within the band, the sum is not
+    QVERIFY(logs(filter, QVariant(11.2)));
+    QVERIFY(logs(filter, QVariant(11.8)) == false);
+}
+
+void TestChangeFilter::arrays_data()
+{
+    QTest::addColumn<QVariant>("first");
+    QTest::addColumn<QVariant>("next");
+    QTest::addColumn<bool>("logged");
+    QTest::newRow("double inside") << QVariant::fromValue(QList<double>({1.0, 2.0})) << QVariant::fromValue(QList<double>({1.4, 1.6})) << false;
+    QTest::newRow("double one outside") << QVariant::fromValue(QList<double>({1.0, 2.0})) << QVariant::fromValue(QList<double>({1.0, 2.6})) << true;
+    QTest::newRow("double size changed") << QVariant::fromValue(QList<double>({1.0, 2.0})) << QVariant::fromValue(QList<double>({1.0, 2.0, 3.0})) << true;
+    QTest::newRow("float inside") << QVariant::fromValue(QList<float>({1.0f})) << QVariant::fromValue(QList<float>({1.25f})) << false;
+    QTest::newRow("int inside") << QVariant::fromValue(QList<int>({10, 20})) << QVariant::fromValue(QList<int>({10, 20})) << false;
+    QTest::newRow("int outside") << QVariant::fromValue(QList<int>({10, 20})) << QVariant::fromValue(QList<int>({11, 20})) << true;
+}
+
+void TestChangeFilter::arrays()
+{
+    QFETCH(QVariant, first);
+    QFETCH(QVariant, next);
+    QFETCH(bool, logged);
+    ChangeFilter filter;
+    filter.addTransaction(s_transactionId, entityFilter(0.5));
+    QVERIFY(logs(filter, first));
+    QCOMPARE(logs(filter, next), logged);
+}
+
+void TestChangeFilter::otherTypesAreComparedExactly()
+{
+    ChangeFilter filter;
+    filter.addTransaction(s_transactionId, entityFilter(100.0));
+    QVERIFY(logs(filter, QVariant(QStringLiteral("Ready"))));
+    QVERIFY(logs(filter, QVariant(QStringLiteral("Ready"))) == false);
+    QVERIFY(logs(filter, QVariant(QStringLiteral("Busy"))));
+    QVERIFY(logs(filter, QVariant(QStringList({"a", "b"}))));
+    QVERIFY(logs(filter, QVariant(QStringList({"a", "b"}))) == false);
+}
+
+void TestChangeFilter::nanIsAlwaysLogged()
+{
+    ChangeFilter filter;
+    filter.addTransaction(s_transactionId, entityFilter(1.0));
+    QVERIFY(logs(filter, QVariant(1.0)));
+    QVERIFY(logs(filter, QVariant(std::numeric_limits<double>::quiet_NaN())));
+    QVERIFY(logs(filter, QVariant(1.0)));
+}
+
+void TestChangeFilter::heartbeat()
+{
+    ChangeFilter filter;
+    filter.addTransaction(s_transactionId, entityFilter(10.0, 0.0, 1000));
+    QVERIFY(logs(filter, QVariant(1.0), 0));
+    QVERIFY(logs(filter, QVariant(1.0), 999999) == false);
+    QVERIFY(logs(filter, QVariant(1.0), 1000000));
+    //the heartbeat restarts with every logged value
+    QVERIFY(logs(filter, QVariant(1.0), 1500000) == false);
+    QVERIFY(logs(filter, QVariant(1.0), 2000000));
+}
+
+void TestChangeFilter::unfilteredContentSetWins()
+{
+    QMultiHash<int, QVariant> filters = entityFilter(10.0);
+    //a content set without "ChangeFilter" logs the entity completely
+    filters.insert(s_entityId, QVariant());
+    ChangeFilter filter;
+    filter.addTransaction(s_transactionId, filters);
+    QVERIFY(filter.isActive() == false);
+    QVERIFY(logs(filter, QVariant(1.0)));
+    QVERIFY(logs(filter, QVariant(1.0)));
+}
+
+void TestChangeFilter::smallestDeadbandWins()
+{
+    QMultiHash<int, QVariant> filters = entityFilter(10.0, 0.0, 5000);
+    filters.unite(entityFilter(1.0, 0.0, 0));
+    ChangeFilter filter;
+    filter.addTransaction(s_transactionId, filters);
+    QVERIFY(logs(filter, QVariant(100.0), 0));
+    QVERIFY(logs(filter, QVariant(102.0), 1));
+    QVERIFY(logs(filter, QVariant(102.5), 2) == false);
+    //the heartbeat of the content set that has one
+    QVERIFY(logs(filter, QVariant(102.0), 5000001));
+}
+
+void TestChangeFilter::onlySuppressingTransactionsAreRemoved()
+{
+    ChangeFilter filter;
+    filter.addTransaction(s_transactionId, entityFilter(1.0));
+    const QVector<int> transactionIds({1, s_transactionId, 7});
+    QCOMPARE(filter.filter(transactionIds, s_entityId, "ACT_PQS1", QVariant(5.0), 0), transactionIds);
+    QCOMPARE(filter.filter(transactionIds, s_entityId, "ACT_PQS1", QVariant(5.5), 1), QVector<int>({1, 7}));
+    //other entities and components of the same transaction are not affected
+    QCOMPARE(filter.filter(transactionIds, s_entityId + 1, "ACT_PQS1", QVariant(5.5), 2), transactionIds);
+    QCOMPARE(filter.filter(transactionIds, s_entityId, "ACT_PQS2", QVariant(5.5), 2), transactionIds);
+    QCOMPARE(filter.filter(transactionIds, s_entityId, "ACT_PQS2", QVariant(5.5), 3), QVector<int>({1, 7}));
+}
+
+void TestChangeFilter::resetLastValues()
+{
+    ChangeFilter filter;
+    filter.addTransaction(s_transactionId, entityFilter(1.0));
+    QVERIFY(logs(filter, QVariant(1.0)));
+    QVERIFY(logs(filter, QVariant(1.0)) == false);
+    filter.resetLastValues();
+    QVERIFY(filter.isActive());
+    QVERIFY(logs(filter, QVariant(1.0)));
+}
+
+void TestChangeFilter::removeTransaction()
+{
+    ChangeFilter filter;
+    filter.addTransaction(s_transactionId, entityFilter(1.0));
+    QVERIFY(logs(filter, QVariant(1.0)));
+    filter.removeTransaction(s_transactionId);
+    QVERIFY(filter.isActive() == false);
+    QVERIFY(logs(filter, QVariant(1.0)));
+    //added again, the last value was dropped with the transaction
+    filter.addTransaction(s_transactionId, entityFilter(1.0));
+    QVERIFY(logs(filter, QVariant(1.0)));
+}
+
+void TestChangeFilter::savings()
+{
+    ChangeFilter filter;
+    filter.addTransaction(s_transactionId, entityFilter(1.0));
+    QVERIFY(filter.takeSavingsChanged() == false);
+    QVERIFY(logs(filter, QVariant(1.0)));
+    QVERIFY(logs(filter, QVariant(1.5)) == false);
+    QVERIFY(logs(filter, QVariant(1.5)) == false);
+    QVERIFY(filter.takeSavingsChanged());
+    QVERIFY(filter.takeSavingsChanged() == false);
+
+    const QVariantMap componentSavings = filter.savings().value(QString::number(s_entityId)).toMap().value("ACT_PQS1").toMap();
+    QCOMPARE(componentSavings.value("logged").toLongLong(), qint64(1));
+    QCOMPARE(componentSavings.value("suppressed").toLongLong(), qint64(2));
+    //tag and 8 bytes of a double
+    QCOMPARE(componentSavings.value("savedBytes").toLongLong(), 2 * (ChangeFilter::s_rowOverheadBytes + 9));
+
+    filter.clear();
+    QVERIFY(filter.takeSavingsChanged());
+    QVERIFY(filter.savings().isEmpty());
+    QVERIFY(filter.isActive() == false);
+}
+
+QTEST_GUILESS_MAIN(TestChangeFilter)
+
+#include "tst_changefilter.moc"
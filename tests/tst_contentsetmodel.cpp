@@ -0,0 +1,175 @@
+#include "vl_contentsetmodel.h"
+
+#include <QtTest>
+#include <QTemporaryDir>
+
+using namespace VeinLogger;
+
+/**
+ * @brief The TestContentSetModel class
+ *
+ * Parsing of content set files and the sharing of one model per file by ContentSetModel::load.
+ */
+class TestContentSetModel : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void emptyPath();
+    void missingFile();
+    void invalidJson();
+    void sessions();
+    void sessionListIsSorted();
+    void contentSets();
+    void options();
+    void loadSharesModel();
+    void invalidateReloads();
+
+private:
+    QString writeFile(const QString &t_fileName, const QByteArray &t_content);
+
+    QTemporaryDir m_tempDir;
+    static const QByteArray s_contentSetFile;
+};
+
+const QByteArray TestContentSetModel::s_contentSetFile = QByteArrayLiteral(R"({
+    "ContentSet": {
+        "ZeraActualValues": [
+            { "EntityId": "1040", "Comment": "RMSModule" },
+            { "EntityId": "1070", "Components": ["ACT_PQS1", "ACT_PQS2"] }
+        ],
+        "ZeraHarmonics": [
+            { "EntityId": "1110", "Components": ["ACT_THDN1"] }
+        ]
+    },
+    "Sessions": {
+        "Default": ["ZeraHarmonics", "ZeraActualValues"],
+        "Empty": []
+    },
+    "ChangeFilter": {
+        "ZeraActualValues": { "AbsoluteDeadband": 0.5 },
+        "ZeraHarmonics": "not an object"
+    }
+})");
+
+void TestContentSetModel::initTestCase()
+{
+    QVERIFY(m_tempDir.isValid());
+}
+
+void TestContentSetModel::emptyPath()
+{
+    const QSharedPointer<const ContentSetModel> model = ContentSetModel::load(QString());
+    QVERIFY(model.isNull() == false);
+    QVERIFY(model->exists() == false);
+    QVERIFY(model->isValid() == false);
+    QVERIFY(model->sessionList().isEmpty());
+}
+
+void TestContentSetModel::missingFile()
+{
+    const QSharedPointer<const ContentSetModel> model = ContentSetModel::load(m_tempDir.filePath("missing.json"));
+    QVERIFY(model->exists() == false);
+    QVERIFY(model->isReadable() == false);
+    QVERIFY(model->isValid() == false);
+    QVERIFY(model->hasSessionSection() == false);
+    QVERIFY(model->contentSetList("Default").isEmpty());
+    QVERIFY(model->isCurrent());
+}
+
+void TestContentSetModel::invalidJson()
+{
+    const QSharedPointer<const ContentSetModel> model = ContentSetModel::load(writeFile("invalid.json", QByteArrayLiteral("{\"Sessions\": {")));
+    QVERIFY(model->exists());
+    QVERIFY(model->isReadable());
+    QVERIFY(model->isValid() == false);
+    QVERIFY(model->hasSessionSection() == false);
+    QVERIFY(model->sessionList().isEmpty());
+}
+
+void TestContentSetModel::sessions()
+{
+    const QSharedPointer<const ContentSetModel> model = ContentSetModel::load(writeFile("sessions.json", s_contentSetFile));
+    QVERIFY(model->isValid());
+    QVERIFY(model->hasSessionSection());
+    QCOMPARE(model->sessionList(), QVector<QString>({"Default", "Empty"}));
+    //file order, not sorted
+    QCOMPARE(model->contentSetList("Default"), QVector<QString>({"ZeraHarmonics", "ZeraActualValues"}));
+    QVERIFY(model->contentSetList("Empty").isEmpty());
+    QVERIFY(model->contentSetList("Unknown").isEmpty());
+}
+
+void TestContentSetModel::sessionListIsSorted()
+{
+    const QSharedPointer<const ContentSetModel> model = ContentSetModel::load(writeFile("sorted.json", QByteArrayLiteral(
+        R"({"Sessions": {"Zeta": [], "Alpha": [], "Mu": [], "Beta": [], "Omega": [], "Kappa": [], "Delta": []}})")));
+    QCOMPARE(model->sessionList(), QVector<QString>({"Alpha", "Beta", "Delta", "Kappa", "Mu", "Omega", "Zeta"}));
+}
+
+void TestContentSetModel::contentSets()
+{
+    const QSharedPointer<const ContentSetModel> model = ContentSetModel::load(writeFile("contentsets.json", s_contentSetFile));
+    QVERIFY(model->hasContentSetSection());
+    QVERIFY(model->hasContentSet("ZeraActualValues"));
+    QVERIFY(model->hasContentSet("Unknown") == false);
+
+    const QMap<QString, QVector<QString>> actualValues = model->contentSet("ZeraActualValues");
+    QCOMPARE(actualValues.keys(), QList<QString>({"1040", "1070"}));
+    //no components: all components of the entity
+    QVERIFY(actualValues.value("1040").isEmpty());
+    QCOMPARE(actualValues.value("1070"), QVector<QString>({"ACT_PQS1", "ACT_PQS2"}));
+    QVERIFY(model->contentSet("Unknown").isEmpty());
+}
+
+void TestContentSetModel::options()
+{
+    const QSharedPointer<const ContentSetModel> model = ContentSetModel::load(writeFile("options.json", s_contentSetFile));
+    const QVariant filter = model->option("ChangeFilter", "ZeraActualValues");
+    QVERIFY(filter.isValid());
+    QCOMPARE(filter.toMap().value("AbsoluteDeadband").toDouble(), 0.5);
+    //entries that are not objects are ignored
+    QVERIFY(model->option("ChangeFilter", "ZeraHarmonics").isValid() == false);
+    QVERIFY(model->option("Downsampling", "ZeraActualValues").isValid() == false);
+    //the sections with their own accessors are no options
+    QVERIFY(model->option("Sessions", "Default").isValid() == false);
+}
+
+void TestContentSetModel::loadSharesModel()
+{
+    const QString filePath = writeFile("shared.json", s_contentSetFile);
+    const QSharedPointer<const ContentSetModel> first = ContentSetModel::load(filePath);
+    const QSharedPointer<const ContentSetModel> second = ContentSetModel::load(filePath);
+    QCOMPARE(first.data(), second.data());
+    QVERIFY(first->isCurrent());
+}
+
+void TestContentSetModel::invalidateReloads()
+{
+    const QString filePath = writeFile("changed.json", s_contentSetFile);
+    const QSharedPointer<const ContentSetModel> before = ContentSetModel::load(filePath);
+    QCOMPARE(before->sessionList().size(), 2);
+
+    writeFile("changed.json", QByteArrayLiteral(R"({"Sessions": {"Other": ["ZeraHarmonics"]}})"));
+    ContentSetModel::invalidate(filePath);
+    const QSharedPointer<const ContentSetModel> after = ContentSetModel::load(filePath);
+    QCOMPARE(after->sessionList(), QVector<QString>({"Other"}));
+    QVERIFY(after->hasContentSetSection() == false);
+    //a model that was handed out is immutable
+    QCOMPARE(before->sessionList().size(), 2);
+    QVERIFY(before->isCurrent() == false);
+}
+
+QString TestContentSetModel::writeFile(const QString &t_fileName, const QByteArray &t_content)
+{
+    const QString filePath = m_tempDir.filePath(t_fileName);
+    QFile file(filePath);
+    if(file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(t_content);
+        file.close();
+    }
+    return filePath;
+}
+
+QTEST_GUILESS_MAIN(TestContentSetModel)
+
+#include "tst_contentsetmodel.moc"
@@ -0,0 +1,302 @@
+#include "vl_downsampler.h"
+
+#include <QtTest>
+
+using namespace VeinLogger;
+
+/**
+ * @brief The TestDownsampler class
+ *
+ * One downsampled transaction s_transactionId stores entity s_entityId, component "ACT_PQS1" at 1 value/s unless noted otherwise.
+ */
+class TestDownsampler : public QObject
+{
+    Q_OBJECT
+private slots:
+    void aggregationNames();
+    void inactivePassesThrough();
+    void transactionMetadata();
+    void fullRateContentSetWins();
+    void highestRateWins();
+    void firstValueIsStored();
+    void singleValueIsStoredUnchanged();
+    void windowAggregates_data();
+    void windowAggregates();
+    void arrayAggregates();
+    void notNumericStoresLast_data();
+    void notNumericStoresLast();
+    void flushDue();
+    void flushAndRemoveTransaction();
+    void onlyDownsampledTransactionsAreRemoved();
+    void flushIntervalMs();
+
+private:
+    static QMultiHash<int, QVariant> entitySettings(double t_maxRate, const QString &t_aggregation = QString());
+    /**
+     * @return the aggregates stored for t_value
+     */
+    static QVector<Downsampler::Aggregate> process(Downsampler &t_downsampler, const QVariant &t_value, qint64 t_timestampUs);
+
+    static constexpr int s_transactionId = 3;
+    static constexpr int s_entityId = 1040;
+};
+
+constexpr int TestDownsampler::s_transactionId;
+constexpr int TestDownsampler::s_entityId;
+
+QMultiHash<int, QVariant> TestDownsampler::entitySettings(double t_maxRate, const QString &t_aggregation)
+{
+    QVariantMap config;
+    config.insert("MaxRate", t_maxRate);
+    if(t_aggregation.isEmpty() == false) {
+        config.insert("Aggregation", t_aggregation);
+    }
+    QMultiHash<int, QVariant> retVal;
+    retVal.insert(s_entityId, config);
+    return retVal;
+}
+
+QVector<Downsampler::Aggregate> TestDownsampler::process(Downsampler &t_downsampler, const QVariant &t_value, qint64 t_timestampUs)
+{
+    t_downsampler.process("session", {s_transactionId}, s_entityId, "ACT_PQS1", t_value, t_timestampUs);
+    return t_downsampler.takeAggregates();
+}
+
+void TestDownsampler::aggregationNames()
+{
+    for(const Downsampler::Aggregation aggregation : {Downsampler::Aggregation::LAST, Downsampler::Aggregation::MEAN, Downsampler::Aggregation::MIN,
+        Downsampler::Aggregation::MAX, Downsampler::Aggregation::ALL}) {
+        Downsampler::Aggregation parsed = Downsampler::Aggregation::LAST;
+        QVERIFY(Downsampler::aggregationFromName(Downsampler::aggregationName(aggregation), parsed));
+        QCOMPARE(parsed, aggregation);
+    }
+    Downsampler::Aggregation parsed = Downsampler::Aggregation::MEAN;
+    QVERIFY(Downsampler::aggregationFromName("median", parsed) == false);
+    QCOMPARE(parsed, Downsampler::Aggregation::MEAN);
+}
+
+void TestDownsampler::inactivePassesThrough()
+{
+    Downsampler downsampler;
+    QVERIFY(downsampler.isActive() == false);
+    const QVector<int> transactionIds({1, 2});
+    const QVector<int> &passThrough = downsampler.process("session", transactionIds, s_entityId, "ACT_PQS1", QVariant(1.0), 0);
+    QCOMPARE(&passThrough, &transactionIds);
+    QVERIFY(downsampler.takeAggregates().isEmpty());
+}
+
+void TestDownsampler::transactionMetadata()
+{
+    Downsampler downsampler;
+    //no rate means no downsampling
+    QVERIFY(downsampler.addTransaction(s_transactionId, entitySettings(0.0)).isEmpty());
+    QVERIFY(downsampler.isActive() == false);
+
+    const QVariantMap metadata = downsampler.addTransaction(s_transactionId, entitySettings(4.0, "mean"));
+    QVERIFY(downsampler.isActive());
+    QCOMPARE(metadata.size(), 1);
+    const QVariantMap entityMetadata = metadata.value(QString::number(s_entityId)).toMap();
+    QCOMPARE(entityMetadata.value("maxRate").toDouble(), 4.0);
+    QCOMPARE(entityMetadata.value("aggregation").toString(), QString("mean"));
+
+    //an unknown aggregation falls back to "all"
+    const QVariantMap fallbackMetadata = downsampler.addTransaction(s_transactionId, entitySettings(4.0, "median"));
+    QCOMPARE(fallbackMetadata.value(QString::number(s_entityId)).toMap().value("aggregation").toString(), QString("all"));
+}
+
+void TestDownsampler::fullRateContentSetWins()
+{
+    QMultiHash<int, QVariant> settings = entitySettings(1.0);
+    settings.insert(s_entityId, QVariant());
+    Downsampler downsampler;
+    QVERIFY(downsampler.addTransaction(s_transactionId, settings).isEmpty());
+    QVERIFY(downsampler.isActive() == false);
+}
+
+void TestDownsampler::highestRateWins()
+{
+    QMultiHash<int, QVariant> settings = entitySettings(1.0);
+    settings.unite(entitySettings(10.0));
+    Downsampler downsampler;
+    const QVariantMap metadata = downsampler.addTransaction(s_transactionId, settings);
+    QCOMPARE(metadata.value(QString::number(s_entityId)).toMap().value("maxRate").toDouble(), 10.0);
+    QCOMPARE(downsampler.flushIntervalMs(), 100);
+}
+
+void TestDownsampler::firstValueIsStored()
+{
+    Downsampler downsampler;
+    downsampler.addTransaction(s_transactionId, entitySettings(1.0, "last"));
+    const QVector<Downsampler::Aggregate> aggregates = process(downsampler, QVariant(5.0), 1000);
+    QCOMPARE(aggregates.size(), 1);
+    QCOMPARE(aggregates.first().sessionName, QString("session"));
+    QCOMPARE(aggregates.first().transactionId, s_transactionId);
+    QCOMPARE(aggregates.first().entityId, s_entityId);
+    QCOMPARE(aggregates.first().componentName, QString("ACT_PQS1"));
+    QCOMPARE(aggregates.first().value, QVariant(5.0));
+    QCOMPARE(aggregates.first().timestampUs, qint64(1000));
+}
+
+void TestDownsampler::singleValueIsStoredUnchanged()
+{
+    //default aggregation "all"
+    Downsampler downsampler;
+    downsampler.addTransaction(s_transactionId, entitySettings(1.0));
+    QCOMPARE(process(downsampler, QVariant(5.0), 0).first().value, QVariant(5.0));
+    //slower than the rate: each value is stored right away
+    QCOMPARE(process(downsampler, QVariant(6.0), 2000000).first().value, QVariant(6.0));
+    //one value in the window
+    QVERIFY(process(downsampler, QVariant(7.0), 2500000).isEmpty());
+    downsampler.flushDue(3000000);
+    const QVector<Downsampler::Aggregate> aggregates = downsampler.takeAggregates();
+    QCOMPARE(aggregates.size(), 1);
+    QCOMPARE(aggregates.first().value, QVariant(7.0));
+    QCOMPARE(aggregates.first().timestampUs, qint64(2500000));
+}
+
+void TestDownsampler::windowAggregates_data()
+{
+    QTest::addColumn<QString>("aggregation");
+    QTest::addColumn<QVariant>("expected");
+    QTest::newRow("last") << QString("last") << QVariant(5);
+    QTest::newRow("mean") << QString("mean") << QVariant(3.0);
+    QTest::newRow("min") << QString("min") << QVariant(1.0);
+    QTest::newRow("max") << QString("max") << QVariant(5.0);
+    QVariantMap all;
+    all.insert("min", 1.0);
+    all.insert("max", 5.0);
+    all.insert("mean", 3.0);
+    all.insert("last", 5);
+    all.insert("count", 3);
+    QTest::newRow("all") << QString("all") << QVariant(all);
+}
+
+void TestDownsampler::windowAggregates()
+{
+    QFETCH(QString, aggregation);
+    QFETCH(QVariant, expected);
+    Downsampler downsampler;
+    downsampler.addTransaction(s_transactionId, entitySettings(1.0, aggregation));
+    QCOMPARE(process(downsampler, QVariant(100), 0).size(), 1);
+    QVERIFY(process(downsampler, QVariant(1), 200000).isEmpty());
+    QVERIFY(process(downsampler, QVariant(3), 400000).isEmpty());
+    //one interval after the last stored value the window is closed by the value
+    const QVector<Downsampler::Aggregate> aggregates = process(downsampler, QVariant(5), 1000000);
+    QCOMPARE(aggregates.size(), 1);
+    QCOMPARE(aggregates.first().value, expected);
+    QCOMPARE(aggregates.first().timestampUs, qint64(1000000));
+}
+
+void TestDownsampler::arrayAggregates()
+{
+    Downsampler downsampler;
+    downsampler.addTransaction(s_transactionId, entitySettings(1.0, "mean"));
+    QCOMPARE(process(downsampler, QVariant::fromValue(QList<double>({0.0, 0.0})), 0).size(), 1);
+    QVERIFY(process(downsampler, QVariant::fromValue(QList<double>({1.0, 4.0})), 500000).isEmpty());
+    const QVector<Downsampler::Aggregate> aggregates = process(downsampler, QVariant::fromValue(QList<double>({3.0, 8.0})), 1000000);
+    QCOMPARE(aggregates.size(), 1);
+    QCOMPARE(aggregates.first().value.value<QList<double>>(), QList<double>({2.0, 6.0}));
+
+    downsampler.addTransaction(s_transactionId, entitySettings(1.0, "max"));
+    QCOMPARE(process(downsampler, QVariant::fromValue(QList<int>({1, 9})), 0).size(), 1);
+    QVERIFY(process(downsampler, QVariant::fromValue(QList<int>({7, 2})), 500000).isEmpty());
+    const QVector<Downsampler::Aggregate> maxAggregates = process(downsampler, QVariant::fromValue(QList<int>({3, 3})), 1000000);
+    QCOMPARE(maxAggregates.size(), 1);
+    QCOMPARE(maxAggregates.first().value.value<QList<double>>(), QList<double>({7.0, 3.0}));
+}
+
+void TestDownsampler::notNumericStoresLast_data()
+{
+    QTest::addColumn<QVariant>("first");
+    QTest::addColumn<QVariant>("last");
+    QTest::newRow("string") << QVariant(QStringLiteral("Busy")) << QVariant(QStringLiteral("Ready"));
+    QTest::newRow("number then string") << QVariant(1.0) << QVariant(QStringLiteral("Ready"));
+    QTest::newRow("array size changed") << QVariant::fromValue(QList<double>({1.0})) << QVariant::fromValue(QList<double>({1.0, 2.0}));
+    QTest::newRow("scalar then array") << QVariant(1.0) << QVariant::fromValue(QList<double>({2.0}));
+}
+
+void TestDownsampler::notNumericStoresLast()
+{
+    QFETCH(QVariant, first);
+    QFETCH(QVariant, last);
+    Downsampler downsampler;
+    downsampler.addTransaction(s_transactionId, entitySettings(1.0, "mean"));
+    QCOMPARE(process(downsampler, QVariant(0.0), 0).size(), 1);
+    QVERIFY(process(downsampler, first, 300000).isEmpty());
+    const QVector<Downsampler::Aggregate> aggregates = process(downsampler, last, 1000000);
+    QCOMPARE(aggregates.size(), 1);
+    QCOMPARE(aggregates.first().value, last);
+}
+
+void TestDownsampler::flushDue()
+{
+    Downsampler downsampler;
+    downsampler.addTransaction(s_transactionId, entitySettings(1.0, "last"));
+    QCOMPARE(process(downsampler, QVariant(1.0), 0).size(), 1);
+    QVERIFY(process(downsampler, QVariant(2.0), 500000).isEmpty());
+    downsampler.flushDue(999999);
+    QVERIFY(downsampler.takeAggregates().isEmpty());
+    downsampler.flushDue(1000000);
+    const QVector<Downsampler::Aggregate> aggregates = downsampler.takeAggregates();
+    QCOMPARE(aggregates.size(), 1);
+    QCOMPARE(aggregates.first().value, QVariant(2.0));
+    //the timestamp of the last value, not of the flush
+    QCOMPARE(aggregates.first().timestampUs, qint64(500000));
+    //empty windows are not stored again
+    downsampler.flushDue(5000000);
+    QVERIFY(downsampler.takeAggregates().isEmpty());
+    //the window started with the flush
+    QVERIFY(process(downsampler, QVariant(3.0), 1500000).isEmpty());
+    QCOMPARE(process(downsampler, QVariant(4.0), 2000000).size(), 1);
+}
+
+void TestDownsampler::flushAndRemoveTransaction()
+{
+    Downsampler downsampler;
+    downsampler.addTransaction(s_transactionId, entitySettings(1.0, "last"));
+    QCOMPARE(process(downsampler, QVariant(1.0), 0).size(), 1);
+    QVERIFY(process(downsampler, QVariant(2.0), 100000).isEmpty());
+    downsampler.flush();
+    QCOMPARE(downsampler.takeAggregates().size(), 1);
+    downsampler.flush();
+    QVERIFY(downsampler.takeAggregates().isEmpty());
+
+    QVERIFY(process(downsampler, QVariant(3.0), 200000).isEmpty());
+    downsampler.removeTransaction(s_transactionId);
+    QVERIFY(downsampler.isActive() == false);
+    const QVector<Downsampler::Aggregate> aggregates = downsampler.takeAggregates();
+    QCOMPARE(aggregates.size(), 1);
+    QCOMPARE(aggregates.first().value, QVariant(3.0));
+
+    downsampler.addTransaction(s_transactionId, entitySettings(1.0, "last"));
+    downsampler.clear();
+    QVERIFY(downsampler.isActive() == false);
+}
+
+void TestDownsampler::onlyDownsampledTransactionsAreRemoved()
+{
+    Downsampler downsampler;
+    downsampler.addTransaction(s_transactionId, entitySettings(1.0, "last"));
+    const QVector<int> transactionIds({1, s_transactionId, 7});
+    QCOMPARE(downsampler.process("session", transactionIds, s_entityId, "ACT_PQS1", QVariant(1.0), 0), QVector<int>({1, 7}));
+    QCOMPARE(downsampler.takeAggregates().size(), 1);
+    //other entities of the transaction store every value
+    QCOMPARE(downsampler.process("session", transactionIds, s_entityId + 1, "ACT_PQS1", QVariant(1.0), 0), transactionIds);
+    QVERIFY(downsampler.takeAggregates().isEmpty());
+}
+
+void TestDownsampler::flushIntervalMs()
+{
+    Downsampler downsampler;
+    downsampler.addTransaction(s_transactionId, entitySettings(0.5));
+    QCOMPARE(downsampler.flushIntervalMs(), 2000);
+    downsampler.addTransaction(s_transactionId + 1, entitySettings(4.0));
+    QCOMPARE(downsampler.flushIntervalMs(), 250);
+    //windows of fast values are closed by the values
+    downsampler.addTransaction(s_transactionId + 2, entitySettings(1000.0));
+    QCOMPARE(downsampler.flushIntervalMs(), 100);
+}
+
+QTEST_GUILESS_MAIN(TestDownsampler)
+
+#include "tst_downsampler.moc"
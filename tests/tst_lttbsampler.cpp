@@ -0,0 +1,209 @@
+#include "vl_lttbsampler.h"
+
+#include <QtTest>
+#include <QRandomGenerator>
+
+#include <cmath>
+
+using namespace VeinLogger;
+
+/**
+ * @brief The TestLttbSampler class
+ *
+ * The streaming sampler has to select the same points as Largest-Triangle-Three-Buckets on the whole series.
+ */
+class TestLttbSampler : public QObject
+{
+    Q_OBJECT
+private slots:
+    void passThrough();
+    void emptyAndSinglePoint();
+    void keepsFirstAndLast();
+    void selectsPeaks();
+    void matchesWholeSeries_data();
+    void matchesWholeSeries();
+    void fewerPointsThanCounted();
+    void morePointsThanCounted();
+
+private:
+    static QVector<LttbSampler::Point> sample(const QVector<LttbSampler::Point> &t_points, qint64 t_pointCount, int t_threshold);
+    /**
+     * @return the points selected by LTTB with all points in memory
+     */
+    static QVector<LttbSampler::Point> reference(const QVector<LttbSampler::Point> &t_points, int t_threshold);
+    static QVector<LttbSampler::Point> randomSeries(int t_pointCount, quint32 t_seed);
+    static bool isAscending(const QVector<LttbSampler::Point> &t_points);
+};
+
+void TestLttbSampler::passThrough()
+{
+    const QVector<LttbSampler::Point> points = randomSeries(10, 1);
+    const QVector<LttbSampler::Point> selected = sample(points, points.size(), 10);
+    QCOMPARE(selected.size(), points.size());
+    for(int index = 0; index < points.size(); ++index) {
+        QCOMPARE(selected.at(index).timestampUs, points.at(index).timestampUs);
+        QCOMPARE(selected.at(index).value, points.at(index).value);
+    }
+}
+
+void TestLttbSampler::emptyAndSinglePoint()
+{
+    QVERIFY(sample({}, 0, 3).isEmpty());
+    QVERIFY(sample({}, 100, 3).isEmpty());
+    const QVector<LttbSampler::Point> selected = sample({{5, 1.5}}, 100, 3);
+    QCOMPARE(selected.size(), 1);
+    QCOMPARE(selected.first().timestampUs, qint64(5));
+}
+
+void TestLttbSampler::keepsFirstAndLast()
+{
+    const QVector<LttbSampler::Point> points = randomSeries(1000, 2);
+    const QVector<LttbSampler::Point> selected = sample(points, points.size(), 20);
+    QCOMPARE(selected.size(), 20);
+    QCOMPARE(selected.first().timestampUs, points.first().timestampUs);
+    QCOMPARE(selected.last().timestampUs, points.last().timestampUs);
+    QVERIFY(isAscending(selected));
+}
+
+void TestLttbSampler::selectsPeaks()
+{
+    //a flat line with one spike up and one down, both have to survive
+    QVector<LttbSampler::Point> points;
+    for(int index = 0; index < 1000; ++index) {
+        double value = 230.0;
+        if(index == 321) {
+            value = 400.0;
+        }
+        else if(index == 777) {
+            value = -50.0;
+        }
+        points.append({qint64(index) * 1000, value});
+    }
+    bool hasMax = false;
+    bool hasMin = false;
+    for(const LttbSampler::Point &point : sample(points, points.size(), 10)) {
+        hasMax = hasMax || point.value == 400.0;
+        hasMin = hasMin || point.value == -50.0;
+    }
+    QVERIFY(hasMax);
+    QVERIFY(hasMin);
+}
+
+void TestLttbSampler::matchesWholeSeries_data()
+{
+    QTest::addColumn<int>("pointCount");
+    QTest::addColumn<int>("threshold");
+
+    QTest::newRow("one more than threshold") << 11 << 10;
+    QTest::newRow("minimum threshold") << 100 << 3;
+    QTest::newRow("uneven buckets") << 128 << 15;
+    QTest::newRow("many points") << 10007 << 500;
+}
+
+void TestLttbSampler::matchesWholeSeries()
+{
+    QFETCH(int, pointCount);
+    QFETCH(int, threshold);
+    const QVector<LttbSampler::Point> points = randomSeries(pointCount, quint32(pointCount));
+    const QVector<LttbSampler::Point> selected = sample(points, pointCount, threshold);
+    const QVector<LttbSampler::Point> expected = reference(points, threshold);
+    QCOMPARE(selected.size(), expected.size());
+    for(int index = 0; index < expected.size(); ++index) {
+        QCOMPARE(selected.at(index).timestampUs, expected.at(index).timestampUs);
+    }
+}
+
+void TestLttbSampler::fewerPointsThanCounted()
+{
+    //the count includes rows that are not numbers
+    const QVector<LttbSampler::Point> points = randomSeries(600, 3);
+    const QVector<LttbSampler::Point> selected = sample(points, 1000, 50);
+    QVERIFY(selected.size() <= 50);
+    QCOMPARE(selected.first().timestampUs, points.first().timestampUs);
+    QCOMPARE(selected.last().timestampUs, points.last().timestampUs);
+    QVERIFY(isAscending(selected));
+}
+
+void TestLttbSampler::morePointsThanCounted()
+{
+    //values committed between the count and the read end up in the last bucket
+    const QVector<LttbSampler::Point> points = randomSeries(1200, 4);
+    const QVector<LttbSampler::Point> selected = sample(points, 1000, 50);
+    QCOMPARE(selected.size(), 50);
+    QCOMPARE(selected.last().timestampUs, points.last().timestampUs);
+    QVERIFY(isAscending(selected));
+}
+
+QVector<LttbSampler::Point> TestLttbSampler::sample(const QVector<LttbSampler::Point> &t_points, qint64 t_pointCount, int t_threshold)
+{
+    LttbSampler sampler(t_pointCount, t_threshold);
+    for(const LttbSampler::Point &point : t_points) {
+        sampler.add(point.timestampUs, point.value);
+    }
+    return sampler.finish();
+}
+
+QVector<LttbSampler::Point> TestLttbSampler::reference(const QVector<LttbSampler::Point> &t_points, int t_threshold)
+{
+    const int pointCount = t_points.size();
+    const int bucketCount = t_threshold - 2;
+    auto bucketStart = [&](int t_bucket) { return int(qint64(t_bucket) * (pointCount - 2) / bucketCount) + 1; };
+    auto pointX = [&](int t_index) { return double(t_points.at(t_index).timestampUs - t_points.first().timestampUs); };
+
+    QVector<LttbSampler::Point> retVal;
+    int selected = 0;
+    retVal.append(t_points.at(selected));
+    for(int bucket = 0; bucket < bucketCount; ++bucket) {
+        const int averageStart = bucketStart(bucket + 1);
+        const int averageEnd = qMin(bucketStart(bucket + 2), pointCount);
+        double averageX = 0.0;
+        double averageY = 0.0;
+        for(int index = averageStart; index < averageEnd; ++index) {
+            averageX += pointX(index);
+            averageY += t_points.at(index).value;
+        }
+        averageX /= averageEnd - averageStart;
+        averageY /= averageEnd - averageStart;
+
+        double maxArea = -1.0;
+        int nextSelected = bucketStart(bucket);
+        for(int index = bucketStart(bucket); index < bucketStart(bucket + 1); ++index) {
+            const double area = std::fabs((pointX(selected) - averageX) * (t_points.at(index).value - t_points.at(selected).value)
+                                          - (pointX(selected) - pointX(index)) * (averageY - t_points.at(selected).value));
+            if(area > maxArea) {
+                maxArea = area;
+                nextSelected = index;
+            }
+        }
+        selected = nextSelected;
+        retVal.append(t_points.at(selected));
+    }
+    retVal.append(t_points.last());
+    return retVal;
+}
+
+QVector<LttbSampler::Point> TestLttbSampler::randomSeries(int t_pointCount, quint32 t_seed)
+{
+    QRandomGenerator generator(t_seed);
+    QVector<LttbSampler::Point> retVal;
+    qint64 timestampUs = 1600000000000000;
+    for(int index = 0; index < t_pointCount; ++index) {
+        timestampUs += 1 + generator.bounded(2000000);
+        retVal.append({timestampUs, 230.0 + generator.generateDouble() * 10.0});
+    }
+    return retVal;
+}
+
+bool TestLttbSampler::isAscending(const QVector<LttbSampler::Point> &t_points)
+{
+    for(int index = 1; index < t_points.size(); ++index) {
+        if(t_points.at(index).timestampUs <= t_points.at(index - 1).timestampUs) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QTEST_GUILESS_MAIN(TestLttbSampler)
+
+#include "tst_lttbsampler.moc"
@@ -0,0 +1,71 @@
+#include "vl_sqlitedb.h"
+
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+
+using namespace VeinLogger;
+
+/**
+ * @brief The TestQueryPlans class
+ *
+ * EXPLAIN QUERY PLAN of all read, write and delete statements of SQLiteDB, see SQLiteDB::queryPlanScans.
+ * Any full table scan on an up to date schema fails the test.
+ */
+class TestQueryPlans : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void newDatabaseHasNoScans();
+    void schemaWithoutIndexesIsReported();
+
+private:
+    QTemporaryDir m_tempDir;
+};
+
+void TestQueryPlans::initTestCase()
+{
+    QVERIFY(m_tempDir.isValid());
+}
+
+void TestQueryPlans::newDatabaseHasNoScans()
+{
+    SQLiteDB database;
+    QVERIFY(database.openDatabase(m_tempDir.filePath("new.db")));
+    const QStringList scans = database.queryPlanScans();
+    QVERIFY2(scans.isEmpty(), qPrintable(scans.join('\n')));
+}
+
+void TestQueryPlans::schemaWithoutIndexesIsReported()
+{
+    //schema version 0 as written by older versions, the indexes are added by the background migration
+    const QString dbPath = m_tempDir.filePath("version0.db");
+    {
+        QSqlDatabase oldDatabase = QSqlDatabase::addDatabase("QSQLITE", "version0");
+        oldDatabase.setDatabaseName(dbPath);
+        QVERIFY(oldDatabase.open());
+        QFile schemaFile(QStringLiteral(VFLOGGER_SOURCE_DIR "/sqlite/schema_sqlite.sql"));
+        QVERIFY(schemaFile.open(QFile::ReadOnly | QFile::Text));
+        for(const QString &statement : QString::fromUtf8(schemaFile.readAll()).split(';')) {
+            //comments and empty statements fail, like in SQLiteDB::openDatabase
+            QSqlQuery(oldDatabase).exec(statement);
+        }
+        oldDatabase.close();
+    }
+    QSqlDatabase::removeDatabase("version0");
+
+    SQLiteDB database;
+    QVERIFY(database.openDatabase(dbPath));
+    //no event loop runs, so the migration is still pending
+    const QStringList scans = database.queryPlanScans();
+    QVERIFY(scans.isEmpty() == false);
+    for(const QString &scan : scans) {
+        QVERIFY2(scan.contains(QLatin1String(": SCAN ")), qPrintable(scan));
+    }
+}
+
+QTEST_GUILESS_MAIN(TestQueryPlans)
+
+#include "tst_queryplans.moc"
@@ -0,0 +1,106 @@
+#include "vl_sqlitedb.h"
+
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+
+using namespace VeinLogger;
+
+/**
+ * @brief The TestSessionDeletion class
+ *
+ * Sessions are deleted in chunks by SQLiteDB::runSessionDeletion while batches keep being written.
+ */
+class TestSessionDeletion : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void pendingValuesOfDeletedSessionsAreDropped();
+    void staticDataIsNotCachedWhileDeleting();
+
+private:
+    int countRows(const QString &t_fileName, const QString &t_table);
+
+    QTemporaryDir m_tempDir;
+    static constexpr int s_entityId = 1040;
+};
+
+constexpr int TestSessionDeletion::s_entityId;
+
+void TestSessionDeletion::initTestCase()
+{
+    QVERIFY(m_tempDir.isValid());
+}
+
+int TestSessionDeletion::countRows(const QString &t_fileName, const QString &t_table)
+{
+    int retVal = -1;
+    {
+        QSqlDatabase checkDatabase = QSqlDatabase::addDatabase("QSQLITE", "check");
+        checkDatabase.setDatabaseName(m_tempDir.filePath(t_fileName));
+        if(checkDatabase.open()) {
+            QSqlQuery countQuery(checkDatabase);
+            if(countQuery.exec(QString("SELECT COUNT(*) FROM %1;").arg(t_table)) && countQuery.next()) {
+                retVal = countQuery.value(0).toInt();
+            }
+            countQuery.finish();
+            checkDatabase.close();
+        }
+    }
+    QSqlDatabase::removeDatabase("check");
+    return retVal;
+}
+
+void TestSessionDeletion::pendingValuesOfDeletedSessionsAreDropped()
+{
+    SQLiteDB database;
+    QVERIFY(database.openDatabase(m_tempDir.filePath("deletion.db")));
+    database.addEntity(s_entityId, "POWER1Module1");
+    database.addComponent("ACT_PQS1");
+    const int deletedSessionId = database.addSession("deleted", QList<QVariantMap>());
+    const int keptSessionId = database.addSession("kept", QList<QVariantMap>());
+    const int deletedTransactionId = database.reserveTransactionId();
+    const int keptTransactionId = database.reserveTransactionId();
+    QVERIFY(database.addTransaction(deletedTransactionId, "snapshot", "deleted", "ZeraAll", ""));
+    QVERIFY(database.addTransaction(keptTransactionId, "snapshot", "kept", "ZeraAll", ""));
+
+    database.addLoggedValue(deletedSessionId, {deletedTransactionId}, s_entityId, "ACT_PQS1", QVariant(1.0), 1600000000000000LL);
+    database.runBatchedExecution();
+    //queued, not yet written when the session is deleted
+    database.addLoggedValue(deletedSessionId, {deletedTransactionId}, s_entityId, "ACT_PQS1", QVariant(2.0), 1600000001000000LL);
+    database.addLoggedValue(keptSessionId, {deletedTransactionId, keptTransactionId}, s_entityId, "ACT_PQS1", QVariant(3.0), 1600000001000000LL);
+    QVERIFY(database.deleteSessions({"deleted"}));
+    database.runBatchedExecution();
+
+    QTRY_COMPARE(countRows("deletion.db", "transactions"), 1);
+    QCOMPARE(countRows("deletion.db", "sessions"), 1);
+    QCOMPARE(countRows("deletion.db", "valuemap"), 1);
+    QCOMPARE(countRows("deletion.db", "transactions_valuemap"), 1);
+}
+
+void TestSessionDeletion::staticDataIsNotCachedWhileDeleting()
+{
+    SQLiteDB database;
+    QVERIFY(database.openDatabase(m_tempDir.filePath("staticdata.db")));
+    database.addEntity(s_entityId, "POWER1Module1");
+    database.addComponent("PAR_Serial");
+    QVariantMap serial;
+    serial.insert("entityId", s_entityId);
+    serial.insert("compName", QString("PAR_Serial"));
+    serial.insert("value", QString("050059"));
+    serial.insert("time", 1600000000000000LL);
+    QVERIFY(database.addSession("deleted", {serial}) > 0);
+    QCOMPARE(database.readSessionComponent("deleted", "POWER1Module1", "PAR_Serial").toString(), QString("050059"));
+
+    QVERIFY(database.deleteSessions({"deleted"}));
+    //no chunk ran yet, the rows are still there but must not go back into the cache
+    QCOMPARE(database.readSessionComponent("deleted", "POWER1Module1", "PAR_Serial").toString(), QString("050059"));
+    QTRY_COMPARE(countRows("staticdata.db", "sessions"), 0);
+    QVERIFY(database.readSessionComponent("deleted", "POWER1Module1", "PAR_Serial").isValid() == false);
+}
+
+QTEST_GUILESS_MAIN(TestSessionDeletion)
+
+#include "tst_sessiondeletion.moc"
@@ -0,0 +1,162 @@
+#include "vl_spillfile.h"
+
+#include <QtTest>
+#include <QtEndian>
+#include <QTemporaryDir>
+
+using namespace VeinLogger;
+
+/**
+ * @brief The TestSpillFile class
+ *
+ * Replay of SpillFile after the file was reopened: truncated records, records read but not committed
+ * and values prepended in front of the spilled ones.
+ */
+class TestSpillFile : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void truncatedRecordIsCutOff();
+    void uncommittedRecordsAreReadAgain();
+    void prependKeepsOrder();
+    void invalidReplayOffsetIsRejected();
+
+private:
+    static SQLBatchData batchData(double t_value);
+    /**
+     * @return values of the records following the last read
+     */
+    static QList<double> readValues(SpillFile &t_spillFile);
+
+    QTemporaryDir m_tempDir;
+};
+
+void TestSpillFile::initTestCase()
+{
+    QVERIFY(m_tempDir.isValid());
+}
+
+SQLBatchData TestSpillFile::batchData(double t_value)
+{
+    SQLBatchData retVal;
+    retVal.entityId = 1040;
+    retVal.componentId = 1;
+    retVal.transactionIds = {1, 2};
+    retVal.sessionId = 1;
+    retVal.timestamp = 1600000000000000LL + qint64(t_value * 1000000);
+    retVal.value = t_value;
+    return retVal;
+}
+
+QList<double> TestSpillFile::readValues(SpillFile &t_spillFile)
+{
+    QList<double> retVal;
+    QVector<SQLBatchData> records;
+    if(t_spillFile.read(100, records) >= 0) {
+        for(const SQLBatchData &record : qAsConst(records)) {
+            retVal.append(record.value.toDouble());
+        }
+    }
+    return retVal;
+}
+
+void TestSpillFile::truncatedRecordIsCutOff()
+{
+    const QString path = m_tempDir.filePath("truncated.spill");
+    SpillFile spillFile;
+    QVERIFY(spillFile.open(path));
+    QVERIFY(spillFile.append(batchData(1.0)));
+    QVERIFY(spillFile.append(batchData(2.0)));
+    QVERIFY(spillFile.append(batchData(3.0)));
+    QVERIFY(spillFile.sync());
+    spillFile.close();
+
+    //power loss while the last record was written
+    QVERIFY(QFile::resize(path, QFileInfo(path).size() - 3));
+    QVERIFY(spillFile.open(path));
+    QCOMPARE(readValues(spillFile), QList<double>({1.0, 2.0}));
+    //appended behind the last complete record
+    QVERIFY(spillFile.append(batchData(4.0)));
+    QCOMPARE(readValues(spillFile), QList<double>({4.0}));
+    QVERIFY(spillFile.hasUnreadRecords() == false);
+}
+
+void TestSpillFile::uncommittedRecordsAreReadAgain()
+{
+    const QString path = m_tempDir.filePath("uncommitted.spill");
+    SpillFile spillFile;
+    QVERIFY(spillFile.open(path));
+    QVERIFY(spillFile.append(batchData(1.0)));
+    QVERIFY(spillFile.append(batchData(2.0)));
+    QVERIFY(spillFile.append(batchData(3.0)));
+    QVector<SQLBatchData> records;
+    QCOMPARE(spillFile.read(2, records), 2);
+    QVERIFY(spillFile.commitRead());
+    const qint64 pendingBytes = spillFile.pendingBytes();
+    //the batch of the last record is never committed
+    QCOMPARE(spillFile.read(1, records), 1);
+    QVERIFY(spillFile.sync());
+    spillFile.close();
+
+    QVERIFY(spillFile.open(path));
+    QCOMPARE(spillFile.pendingBytes(), pendingBytes);
+    QCOMPARE(spillFile.replayedBytes(), qint64(0));
+    QCOMPARE(readValues(spillFile), QList<double>({3.0}));
+    QVERIFY(spillFile.commitRead());
+    QVERIFY(spillFile.isReplayed());
+    QCOMPARE(spillFile.replayedBytes(), pendingBytes);
+}
+
+void TestSpillFile::prependKeepsOrder()
+{
+    const QString path = m_tempDir.filePath("prepend.spill");
+    SpillFile spillFile;
+    QVERIFY(spillFile.open(path));
+    QVERIFY(spillFile.append(batchData(3.0)));
+    QVERIFY(spillFile.append(batchData(4.0)));
+    QVERIFY(spillFile.append(batchData(5.0)));
+    QVector<SQLBatchData> records;
+    QCOMPARE(spillFile.read(1, records), 1);
+    QVERIFY(spillFile.commitRead());
+    //read for a batch that is not committed, it is kept behind the prepended values
+    QCOMPARE(spillFile.read(1, records), 1);
+
+    //e.g. the batch that failed to write when the database is closed, older than the spilled values
+    QVERIFY(spillFile.prepend({batchData(1.0), batchData(2.0)}));
+    QCOMPARE(readValues(spillFile), QList<double>({1.0, 2.0, 4.0, 5.0}));
+    spillFile.close();
+
+    //the prepended file replaces the old one
+    QVERIFY(spillFile.open(path));
+    QCOMPARE(readValues(spillFile), QList<double>({1.0, 2.0, 4.0, 5.0}));
+    QVERIFY(spillFile.commitRead());
+    QVERIFY(spillFile.isReplayed());
+}
+
+void TestSpillFile::invalidReplayOffsetIsRejected()
+{
+    const QString path = m_tempDir.filePath("offset.spill");
+    SpillFile spillFile;
+    QVERIFY(spillFile.open(path));
+    QVERIFY(spillFile.append(batchData(1.0)));
+    QVERIFY(spillFile.sync());
+    spillFile.close();
+
+    //replay offset behind the end of the file
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    char offsetBytes[8];
+    qToLittleEndian<qint64>(file.size() + 1, offsetBytes);
+    QVERIFY(file.seek(8));
+    QCOMPARE(file.write(offsetBytes, sizeof(offsetBytes)), qint64(sizeof(offsetBytes)));
+    file.close();
+
+    QVERIFY(spillFile.open(path) == false);
+    QVERIFY(spillFile.isOpen() == false);
+    QVERIFY(spillFile.lastError().isEmpty() == false);
+}
+
+QTEST_GUILESS_MAIN(TestSpillFile)
+
+#include "tst_spillfile.moc"
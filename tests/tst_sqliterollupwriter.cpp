@@ -0,0 +1,309 @@
+#include "vl_sqliterollupwriter.h"
+
+#include <QtTest>
+
+#include <sqlite3.h>
+
+#include <limits>
+
+using namespace VeinLogger;
+
+/**
+ * @brief The TestSQLiteRollupWriter class
+ *
+ * Cell aggregation and the merge of cells written by several batches, on an in-memory database.
+ */
+class TestSQLiteRollupWriter : public QObject
+{
+    Q_OBJECT
+private slots:
+    void init();
+    void cleanup();
+
+    void cellAdd();
+    void cellAddOutOfOrder();
+    void cellMerge();
+    void cellMergeEmpty();
+    void bucketStartUs_data();
+    void bucketStartUs();
+    void toNumber_data();
+    void toNumber();
+    void executeWritesCells();
+    void batchesMergeIntoCells();
+    void coverageKeepsFirstMark();
+
+private:
+    /**
+     * @return the cell stored in t_table for component s_componentId and t_bucketStartUs, count 0 if there is none
+     */
+    SQLiteRollupWriter::Cell readCell(const char *t_table, qint64 t_bucketStartUs);
+    qint64 readCoverage(int t_transactionId);
+    void writeBatch(SQLiteRollupWriter &t_writer, const QVector<QPair<qint64, double>> &t_values);
+
+    static constexpr int s_transactionId = 2;
+    static constexpr int s_entityId = 1040;
+    static constexpr int s_componentId = 7;
+    sqlite3 *m_handle = nullptr;
+};
+
+constexpr int TestSQLiteRollupWriter::s_transactionId;
+constexpr int TestSQLiteRollupWriter::s_entityId;
+constexpr int TestSQLiteRollupWriter::s_componentId;
+
+void TestSQLiteRollupWriter::init()
+{
+    QCOMPARE(sqlite3_open(":memory:", &m_handle), SQLITE_OK);
+    for(const QString &statement : {SQLiteRollupWriter::createTableStatement(SQLiteRollupWriter::s_secondTable),
+                                    SQLiteRollupWriter::createTableStatement(SQLiteRollupWriter::s_minuteTable),
+                                    SQLiteRollupWriter::coverageTableStatement()}) {
+        QCOMPARE(sqlite3_exec(m_handle, statement.toUtf8().constData(), nullptr, nullptr, nullptr), SQLITE_OK);
+    }
+}
+
+void TestSQLiteRollupWriter::cleanup()
+{
+    sqlite3_close(m_handle);
+    m_handle = nullptr;
+}
+
+void TestSQLiteRollupWriter::cellAdd()
+{
+    SQLiteRollupWriter::Cell cell;
+    cell.add(2.0, 100);
+    cell.add(-1.0, 200);
+    cell.add(5.0, 300);
+    QCOMPARE(cell.count, qint64(3));
+    QCOMPARE(cell.min, -1.0);
+    QCOMPARE(cell.max, 5.0);
+    QCOMPARE(cell.sum, 6.0);
+    QCOMPARE(cell.first, 2.0);
+    QCOMPARE(cell.last, 5.0);
+    QCOMPARE(cell.firstTimestampUs, qint64(100));
+    QCOMPARE(cell.lastTimestampUs, qint64(300));
+}
+
+void TestSQLiteRollupWriter::cellAddOutOfOrder()
+{
+    //first and last follow the timestamps, not the order of the calls
+    SQLiteRollupWriter::Cell cell;
+    cell.add(2.0, 200);
+    cell.add(1.0, 100);
+    cell.add(3.0, 150);
+    QCOMPARE(cell.first, 1.0);
+    QCOMPARE(cell.firstTimestampUs, qint64(100));
+    QCOMPARE(cell.last, 2.0);
+    QCOMPARE(cell.lastTimestampUs, qint64(200));
+}
+
+void TestSQLiteRollupWriter::cellMerge()
+{
+    SQLiteRollupWriter::Cell early;
+    early.add(4.0, 100);
+    early.add(1.0, 200);
+    SQLiteRollupWriter::Cell late;
+    late.add(8.0, 300);
+    late.add(3.0, 400);
+
+    SQLiteRollupWriter::Cell all;
+    for(const SQLiteRollupWriter::Cell &cell : {late, early}) {
+        all.merge(cell);
+    }
+    QCOMPARE(all.count, qint64(4));
+    QCOMPARE(all.min, 1.0);
+    QCOMPARE(all.max, 8.0);
+    QCOMPARE(all.sum, 16.0);
+    QCOMPARE(all.first, 4.0);
+    QCOMPARE(all.firstTimestampUs, qint64(100));
+    QCOMPARE(all.last, 3.0);
+    QCOMPARE(all.lastTimestampUs, qint64(400));
+}
+
+void TestSQLiteRollupWriter::cellMergeEmpty()
+{
+    SQLiteRollupWriter::Cell cell;
+    cell.add(-2.0, 100);
+    cell.merge(SQLiteRollupWriter::Cell());
+    QCOMPARE(cell.count, qint64(1));
+    QCOMPARE(cell.max, -2.0);
+
+    //an empty cell must not contribute its zero min and max
+    SQLiteRollupWriter::Cell empty;
+    empty.merge(cell);
+    QCOMPARE(empty.count, qint64(1));
+    QCOMPARE(empty.min, -2.0);
+    QCOMPARE(empty.max, -2.0);
+}
+
+void TestSQLiteRollupWriter::bucketStartUs_data()
+{
+    QTest::addColumn<qint64>("timestampUs");
+    QTest::addColumn<qint64>("bucketUs");
+    QTest::addColumn<qint64>("bucketStartUs");
+
+    QTest::newRow("start") << qint64(60000000) << SQLiteRollupWriter::s_minuteUs << qint64(60000000);
+    QTest::newRow("inside") << qint64(61500000) << SQLiteRollupWriter::s_minuteUs << qint64(60000000);
+    QTest::newRow("second") << qint64(61500000) << SQLiteRollupWriter::s_secondUs << qint64(61000000);
+    QTest::newRow("zero") << qint64(0) << SQLiteRollupWriter::s_secondUs << qint64(0);
+    QTest::newRow("before epoch") << qint64(-1) << SQLiteRollupWriter::s_secondUs << qint64(-1000000);
+    QTest::newRow("before epoch start") << qint64(-2000000) << SQLiteRollupWriter::s_secondUs << qint64(-2000000);
+}
+
+void TestSQLiteRollupWriter::bucketStartUs()
+{
+    QFETCH(qint64, timestampUs);
+    QFETCH(qint64, bucketUs);
+    QFETCH(qint64, bucketStartUs);
+    QCOMPARE(SQLiteRollupWriter::bucketStartUs(timestampUs, bucketUs), bucketStartUs);
+}
+
+void TestSQLiteRollupWriter::toNumber_data()
+{
+    QTest::addColumn<QVariant>("value");
+    QTest::addColumn<bool>("isNumber");
+    QTest::addColumn<double>("number");
+
+    QTest::newRow("int") << QVariant(-3) << true << -3.0;
+    QTest::newRow("uint") << QVariant(3u) << true << 3.0;
+    QTest::newRow("long long") << QVariant(qint64(1) << 40) << true << double(qint64(1) << 40);
+    QTest::newRow("float") << QVariant(0.5f) << true << 0.5;
+    QTest::newRow("double") << QVariant(230.25) << true << 230.25;
+    QTest::newRow("nan") << QVariant(std::numeric_limits<double>::quiet_NaN()) << false << 0.0;
+    QTest::newRow("infinity") << QVariant(std::numeric_limits<double>::infinity()) << false << 0.0;
+    QTest::newRow("bool") << QVariant(true) << false << 0.0;
+    QTest::newRow("numeric string") << QVariant(QString("1.5")) << false << 0.0;
+    QTest::newRow("list") << QVariant(QVariantList{1.0, 2.0}) << false << 0.0;
+    QTest::newRow("invalid") << QVariant() << false << 0.0;
+}
+
+void TestSQLiteRollupWriter::toNumber()
+{
+    QFETCH(QVariant, value);
+    QFETCH(bool, isNumber);
+    QFETCH(double, number);
+    double converted = 0.0;
+    QCOMPARE(SQLiteRollupWriter::toNumber(value, converted), isNumber);
+    if(isNumber) {
+        QCOMPARE(converted, number);
+    }
+}
+
+void TestSQLiteRollupWriter::executeWritesCells()
+{
+    SQLiteRollupWriter writer;
+    QVERIFY2(writer.prepare(m_handle), qPrintable(writer.lastError()));
+    writeBatch(writer, {{60100000, 1.0}, {60200000, 3.0}, {61100000, 2.0}});
+
+    const SQLiteRollupWriter::Cell firstSecond = readCell(SQLiteRollupWriter::s_secondTable, 60000000);
+    QCOMPARE(firstSecond.count, qint64(2));
+    QCOMPARE(firstSecond.sum, 4.0);
+    const SQLiteRollupWriter::Cell nextSecond = readCell(SQLiteRollupWriter::s_secondTable, 61000000);
+    QCOMPARE(nextSecond.count, qint64(1));
+    QCOMPARE(nextSecond.first, 2.0);
+    const SQLiteRollupWriter::Cell minute = readCell(SQLiteRollupWriter::s_minuteTable, 60000000);
+    QCOMPARE(minute.count, qint64(3));
+    QCOMPARE(minute.min, 1.0);
+    QCOMPARE(minute.max, 3.0);
+    QCOMPARE(minute.last, 2.0);
+}
+
+void TestSQLiteRollupWriter::batchesMergeIntoCells()
+{
+    //the upsert in sqlite has to give the same cell as merging in memory
+    const QVector<QPair<qint64, double>> firstBatch = {{60500000, 7.0}, {90000000, -4.0}};
+    const QVector<QPair<qint64, double>> secondBatch = {{60100000, 9.0}, {119000000, 0.5}};
+    SQLiteRollupWriter::Cell expected;
+    for(const auto &value : firstBatch + secondBatch) {
+        expected.add(value.second, value.first);
+    }
+
+    SQLiteRollupWriter writer;
+    QVERIFY2(writer.prepare(m_handle), qPrintable(writer.lastError()));
+    writeBatch(writer, firstBatch);
+    writeBatch(writer, secondBatch);
+
+    const SQLiteRollupWriter::Cell minute = readCell(SQLiteRollupWriter::s_minuteTable, 60000000);
+    QCOMPARE(minute.count, expected.count);
+    QCOMPARE(minute.min, expected.min);
+    QCOMPARE(minute.max, expected.max);
+    QCOMPARE(minute.sum, expected.sum);
+    QCOMPARE(minute.first, 9.0);
+    QCOMPARE(minute.first, expected.first);
+    QCOMPARE(minute.firstTimestampUs, expected.firstTimestampUs);
+    QCOMPARE(minute.last, expected.last);
+    QCOMPARE(minute.lastTimestampUs, expected.lastTimestampUs);
+    //a second bucket of both batches
+    QCOMPARE(readCell(SQLiteRollupWriter::s_secondTable, 60000000).count, qint64(2));
+}
+
+void TestSQLiteRollupWriter::coverageKeepsFirstMark()
+{
+    SQLiteRollupWriter writer;
+    QVERIFY2(writer.prepare(m_handle), qPrintable(writer.lastError()));
+    QCOMPARE(readCoverage(s_transactionId), qint64(-1));
+
+    writer.clear();
+    writer.markCoverage(s_transactionId, 12);
+    writer.markCoverage(s_transactionId, 10);
+    QCOMPARE(writer.markedTransactions(), QList<int>{s_transactionId});
+    QVERIFY2(writer.execute(), qPrintable(writer.lastError()));
+    QCOMPARE(readCoverage(s_transactionId), qint64(10));
+
+    writer.clear();
+    QVERIFY(writer.markedTransactions().isEmpty());
+    writer.markCoverage(s_transactionId, 20);
+    QVERIFY2(writer.execute(), qPrintable(writer.lastError()));
+    QCOMPARE(readCoverage(s_transactionId), qint64(10));
+}
+
+SQLiteRollupWriter::Cell TestSQLiteRollupWriter::readCell(const char *t_table, qint64 t_bucketStartUs)
+{
+    SQLiteRollupWriter::Cell retVal;
+    const QByteArray select = QString("SELECT value_count, value_min, value_max, value_sum, value_first, value_last, first_timestamp, last_timestamp"
+                                      " FROM %1 WHERE transactionsid = ? AND entityiesid = ? AND componentid = ? AND bucket_start = ?;").arg(QLatin1String(t_table)).toUtf8();
+    sqlite3_stmt *statement = nullptr;
+    if(sqlite3_prepare_v2(m_handle, select.constData(), -1, &statement, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int(statement, 1, s_transactionId);
+        sqlite3_bind_int(statement, 2, s_entityId);
+        sqlite3_bind_int(statement, 3, s_componentId);
+        sqlite3_bind_int64(statement, 4, t_bucketStartUs);
+        if(sqlite3_step(statement) == SQLITE_ROW) {
+            retVal.count = sqlite3_column_int64(statement, 0);
+            retVal.min = sqlite3_column_double(statement, 1);
+            retVal.max = sqlite3_column_double(statement, 2);
+            retVal.sum = sqlite3_column_double(statement, 3);
+            retVal.first = sqlite3_column_double(statement, 4);
+            retVal.last = sqlite3_column_double(statement, 5);
+            retVal.firstTimestampUs = sqlite3_column_int64(statement, 6);
+            retVal.lastTimestampUs = sqlite3_column_int64(statement, 7);
+        }
+    }
+    sqlite3_finalize(statement);
+    return retVal;
+}
+
+qint64 TestSQLiteRollupWriter::readCoverage(int t_transactionId)
+{
+    qint64 retVal = -1;
+    sqlite3_stmt *statement = nullptr;
+    if(sqlite3_prepare_v2(m_handle, "SELECT first_valueid FROM rollup_coverage WHERE transactionsid = ?;", -1, &statement, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int(statement, 1, t_transactionId);
+        if(sqlite3_step(statement) == SQLITE_ROW) {
+            retVal = sqlite3_column_int64(statement, 0);
+        }
+    }
+    sqlite3_finalize(statement);
+    return retVal;
+}
+
+void TestSQLiteRollupWriter::writeBatch(SQLiteRollupWriter &t_writer, const QVector<QPair<qint64, double>> &t_values)
+{
+    t_writer.clear();
+    for(const auto &value : t_values) {
+        t_writer.addValue(s_transactionId, s_entityId, s_componentId, value.first, value.second);
+    }
+    QVERIFY2(t_writer.execute(), qPrintable(t_writer.lastError()));
+}
+
+QTEST_GUILESS_MAIN(TestSQLiteRollupWriter)
+
+#include "tst_sqliterollupwriter.moc"
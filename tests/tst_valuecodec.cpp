@@ -0,0 +1,155 @@
+#include "vl_valuecodec.h"
+
+#include <QtTest>
+#include <QDataStream>
+#include <QJsonArray>
+#include <QCborArray>
+
+#include <limits>
+
+using namespace VeinLogger;
+
+class TestValueCodec : public QObject
+{
+    Q_OBJECT
+private slots:
+    void roundTrip_data();
+    void roundTrip();
+    void tagOfEncodedValue_data();
+    void tagOfEncodedValue();
+    void appendsToTarget();
+    void viewOfArrayIsUnaligned();
+    void truncatedDataIsRejected();
+    void legacyDataStreamBlob();
+    void decodeToJsonArrays();
+    void decodeToCborKeepsTypes();
+};
+
+void TestValueCodec::roundTrip_data()
+{
+    QTest::addColumn<QVariant>("value");
+    QTest::newRow("null") << QVariant();
+    QTest::newRow("bool") << QVariant(true);
+    QTest::newRow("negative int") << QVariant(static_cast<qlonglong>(-123456789));
+    QTest::newRow("int64 min") << QVariant(std::numeric_limits<qlonglong>::min());
+    QTest::newRow("uint64 max") << QVariant(std::numeric_limits<qulonglong>::max());
+    QTest::newRow("double") << QVariant(230.25);
+    QTest::newRow("float") << QVariant(0.5f);
+    QTest::newRow("string") << QVariant(QStringLiteral("Spannung µV"));
+    QTest::newRow("empty string") << QVariant(QString(""));
+    QTest::newRow("bytes") << QVariant(QByteArray("\x00\x01\xff", 3));
+    QTest::newRow("string list") << QVariant(QStringList({"a", "", "äöü"}));
+    QTest::newRow("double list") << QVariant::fromValue(QList<double>({1.5, -2.25, 1e300}));
+    QTest::newRow("float list") << QVariant::fromValue(QList<float>({1.5f, -2.25f}));
+    QTest::newRow("int list") << QVariant::fromValue(QList<int>({1, -1, std::numeric_limits<int>::max()}));
+    QTest::newRow("empty double list") << QVariant::fromValue(QList<double>());
+    QTest::newRow("datastream fallback") << QVariant(QPointF(1.0, 2.0));
+}
+
+void TestValueCodec::roundTrip()
+{
+    QFETCH(QVariant, value);
+    const QVariant decoded = ValueCodec::decode(ValueCodec::encode(value));
+    //integers come back as 64 bit types, compare the converted value
+    if(value.type() == QVariant::LongLong || value.type() == QVariant::ULongLong) {
+        QCOMPARE(decoded.toString(), value.toString());
+    }
+    else {
+        QCOMPARE(decoded.userType(), value.userType());
+        QCOMPARE(decoded, value);
+    }
+}
+
+void TestValueCodec::tagOfEncodedValue_data()
+{
+    QTest::addColumn<QVariant>("value");
+    QTest::addColumn<int>("tag");
+    QTest::newRow("int") << QVariant(42) << static_cast<int>(ValueCodec::Tag::INT64);
+    QTest::newRow("uint") << QVariant(42u) << static_cast<int>(ValueCodec::Tag::UINT64);
+    QTest::newRow("double") << QVariant(4.2) << static_cast<int>(ValueCodec::Tag::FLOAT64);
+    QTest::newRow("double list") << QVariant::fromValue(QList<double>({4.2})) << static_cast<int>(ValueCodec::Tag::FLOAT64_ARRAY);
+    QTest::newRow("point") << QVariant(QPoint(1, 2)) << static_cast<int>(ValueCodec::Tag::DATASTREAM);
+}
+
+void TestValueCodec::tagOfEncodedValue()
+{
+    QFETCH(QVariant, value);
+    QFETCH(int, tag);
+    const QByteArray encoded = ValueCodec::encode(value);
+    ValueCodec::View tmpView;
+    QVERIFY(ValueCodec::view(encoded.constData(), encoded.size(), tmpView));
+    QCOMPARE(static_cast<int>(tmpView.tag), tag);
+}
+
+void TestValueCodec::appendsToTarget()
+{
+    QByteArray target("prefix");
+    ValueCodec::encode(QVariant(1.0), target);
+    QVERIFY(target.startsWith("prefix"));
+    QCOMPARE(target.size(), 6 + 1 + 8);
+}
+
+void TestValueCodec::viewOfArrayIsUnaligned()
+{
+    const QList<double> values({0.1, 0.2, 0.3});
+    //the tag and the varint count leave the payload at an odd offset
+    const QByteArray encoded = ValueCodec::encode(QVariant::fromValue(values));
+    ValueCodec::View tmpView;
+    QVERIFY(ValueCodec::view(encoded.constData(), encoded.size(), tmpView));
+    QCOMPARE(tmpView.size, values.size());
+    for(int i = 0; i < values.size(); ++i) {
+        QCOMPARE(tmpView.float64At(i), values.at(i));
+    }
+}
+
+void TestValueCodec::truncatedDataIsRejected()
+{
+    const QByteArray encoded = ValueCodec::encode(QVariant::fromValue(QList<double>({1.0, 2.0})));
+    ValueCodec::View tmpView;
+    QVERIFY(ValueCodec::view(encoded.constData(), 0, tmpView) == false);
+    for(int size = 1; size < encoded.size(); ++size) {
+        QVERIFY2(ValueCodec::view(encoded.constData(), size, tmpView) == false, qPrintable(QString::number(size)));
+        QVERIFY(ValueCodec::decode(encoded.left(size)).isValid() == false);
+    }
+}
+
+void TestValueCodec::legacyDataStreamBlob()
+{
+    const QVariant value = QVariant::fromValue(QList<double>({1.0, 2.0}));
+    QByteArray legacyBlob;
+    QDataStream dataWriter(&legacyBlob, QIODevice::WriteOnly);
+    dataWriter.setVersion(QDataStream::Qt_5_0);
+    dataWriter << value;
+    QCOMPARE(static_cast<int>(static_cast<quint8>(legacyBlob.at(0))), static_cast<int>(ValueCodec::Tag::LEGACY_DATASTREAM));
+
+    ValueCodec::View tmpView;
+    QVERIFY(ValueCodec::view(legacyBlob.constData(), legacyBlob.size(), tmpView) == false);
+    QCOMPARE(ValueCodec::decode(legacyBlob), value);
+}
+
+void TestValueCodec::decodeToJsonArrays()
+{
+    const QVariant doubles = QVariant::fromValue(QList<double>({1.5, -2.0}));
+    const QVariant ints = QVariant::fromValue(QList<int>({3, 4}));
+    QCOMPARE(ValueCodec::decodeToJson(ValueCodec::encode(doubles)), ValueCodec::toJson(doubles));
+    QCOMPARE(ValueCodec::decodeToJson(ValueCodec::encode(ints)), QJsonValue(QJsonArray({3, 4})));
+    QCOMPARE(ValueCodec::decodeToJson(ValueCodec::encode(QVariant(QStringLiteral("x")))), QJsonValue(QStringLiteral("x")));
+}
+
+void TestValueCodec::decodeToCborKeepsTypes()
+{
+    const qint64 largeInteger = (Q_INT64_C(1) << 60) + 1;
+    QCOMPARE(ValueCodec::decodeToCbor(ValueCodec::encode(QVariant(largeInteger))).toInteger(), largeInteger);
+    const QByteArray bytes("\x00\xff", 2);
+    QCOMPARE(ValueCodec::decodeToCbor(ValueCodec::encode(QVariant(bytes))).toByteArray(), bytes);
+
+    const QCborValue samples = ValueCodec::decodeToCbor(ValueCodec::encode(QVariant::fromValue(QList<double>({1.5, -2.0}))));
+    QVERIFY(samples.isArray());
+    QCOMPARE(samples.toArray().size(), 2);
+    QCOMPARE(samples.toArray().at(1).toDouble(), -2.0);
+    QCOMPARE(samples, ValueCodec::toCbor(QVariant::fromValue(QList<double>({1.5, -2.0}))));
+}
+
+QTEST_GUILESS_MAIN(TestValueCodec)
+
+#include "tst_valuecodec.moc"
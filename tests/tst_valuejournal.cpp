@@ -0,0 +1,258 @@
+#include "vl_valuejournal.h"
+#include "vl_sqlitedb.h"
+
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+
+using namespace VeinLogger;
+
+/**
+ * @brief The TestValueJournal class
+ *
+ * Crash recovery of ValueJournal: the file is written, then torn, truncated or left with records of an older epoch
+ * and reopened. SQLiteDB replays a journal on open unless journal_state holds its epoch.
+ */
+class TestValueJournal : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void recordsSurviveReopen();
+    void tornRecordEndsReplay();
+    void truncatedFileEndsReplay();
+    void staleEpochRecordsAreNotRead();
+    void uncommittedJournalIsReplayed();
+    void committedEpochIsNotReplayed();
+
+private:
+    static SQLBatchData batchData(double t_value);
+    static QList<double> readValues(ValueJournal &t_journal);
+    /**
+     * @brief prepareDatabase
+     * Creates the database with the ids of batchData() and a journal holding one value of it
+     */
+    void prepareDatabase(const QString &t_dbPath);
+    int countRows(const QString &t_dbPath, const QString &t_table);
+
+    QTemporaryDir m_tempDir;
+    static constexpr qint64 s_capacity = 64 * 1024;
+    /**
+     * @brief s_headerSize, s_recordHeaderSize
+     * file layout, see ValueJournal
+     */
+    static constexpr qint64 s_headerSize = 16;
+    static constexpr qint64 s_recordHeaderSize = 12;
+    static constexpr int s_entityId = 1040;
+};
+
+constexpr qint64 TestValueJournal::s_capacity;
+constexpr qint64 TestValueJournal::s_headerSize;
+constexpr qint64 TestValueJournal::s_recordHeaderSize;
+constexpr int TestValueJournal::s_entityId;
+
+void TestValueJournal::initTestCase()
+{
+    QVERIFY(m_tempDir.isValid());
+}
+
+SQLBatchData TestValueJournal::batchData(double t_value)
+{
+    SQLBatchData retVal;
+    retVal.entityId = s_entityId;
+    retVal.componentId = 1;
+    retVal.transactionIds = {1};
+    retVal.sessionId = 1;
+    retVal.timestamp = 1600000000000000LL + qint64(t_value * 1000000);
+    retVal.value = t_value;
+    return retVal;
+}
+
+QList<double> TestValueJournal::readValues(ValueJournal &t_journal)
+{
+    QList<double> retVal;
+    QVector<SQLBatchData> records;
+    if(t_journal.readRecords(records)) {
+        for(const SQLBatchData &record : qAsConst(records)) {
+            retVal.append(record.value.toDouble());
+        }
+    }
+    return retVal;
+}
+
+void TestValueJournal::recordsSurviveReopen()
+{
+    const QString path = m_tempDir.filePath("reopen.journal");
+    ValueJournal journal;
+    QVERIFY(journal.open(path, s_capacity));
+    QVERIFY(journal.isEmpty());
+    QVERIFY(journal.append(batchData(1.0)));
+    QVERIFY(journal.append(batchData(2.0)));
+    QVERIFY(journal.needsSync());
+    QVERIFY(journal.sync());
+    journal.close();
+
+    QVERIFY(journal.open(path, s_capacity));
+    QCOMPARE(journal.epoch(), quint32(1));
+    QCOMPARE(readValues(journal), QList<double>({1.0, 2.0}));
+    //appended behind the records of the crashed run
+    QVERIFY(journal.append(batchData(3.0)));
+    journal.close();
+    QVERIFY(journal.open(path, s_capacity));
+    QCOMPARE(readValues(journal), QList<double>({1.0, 2.0, 3.0}));
+}
+
+void TestValueJournal::tornRecordEndsReplay()
+{
+    const QString path = m_tempDir.filePath("torn.journal");
+    ValueJournal journal;
+    QVERIFY(journal.open(path, s_capacity));
+    QVERIFY(journal.append(batchData(1.0)));
+    QVERIFY(journal.append(batchData(2.0)));
+    const qint64 tornBytes = journal.usedBytes();
+    QVERIFY(journal.append(batchData(3.0)));
+    journal.close();
+
+    //the payload of the last record did not reach the storage completely
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    const qint64 payloadPos = s_headerSize + tornBytes + s_recordHeaderSize;
+    QVERIFY(file.seek(payloadPos));
+    const char payloadByte = file.read(1).at(0);
+    QVERIFY(file.seek(payloadPos));
+    QCOMPARE(file.write(QByteArray(1, char(~payloadByte))), qint64(1));
+    file.close();
+
+    QVERIFY(journal.open(path, s_capacity));
+    QCOMPARE(journal.usedBytes(), tornBytes);
+    QCOMPARE(readValues(journal), QList<double>({1.0, 2.0}));
+    //the torn record is overwritten
+    QVERIFY(journal.append(batchData(4.0)));
+    journal.close();
+    QVERIFY(journal.open(path, s_capacity));
+    QCOMPARE(readValues(journal), QList<double>({1.0, 2.0, 4.0}));
+}
+
+void TestValueJournal::truncatedFileEndsReplay()
+{
+    const QString path = m_tempDir.filePath("truncated.journal");
+    ValueJournal journal;
+    QVERIFY(journal.open(path, s_capacity));
+    QVERIFY(journal.append(batchData(1.0)));
+    const qint64 truncatedBytes = journal.usedBytes();
+    QVERIFY(journal.append(batchData(2.0)));
+    journal.close();
+
+    //cut inside the payload of the second record, open() extends the file with zeros
+    QVERIFY(QFile::resize(path, s_headerSize + truncatedBytes + s_recordHeaderSize + 2));
+    QVERIFY(journal.open(path, s_capacity));
+    QCOMPARE(QFileInfo(path).size(), s_capacity);
+    QCOMPARE(journal.usedBytes(), truncatedBytes);
+    QCOMPARE(readValues(journal), QList<double>({1.0}));
+}
+
+void TestValueJournal::staleEpochRecordsAreNotRead()
+{
+    const QString path = m_tempDir.filePath("epoch.journal");
+    ValueJournal journal;
+    QVERIFY(journal.open(path, s_capacity));
+    QVERIFY(journal.append(batchData(1.0)));
+    QVERIFY(journal.append(batchData(2.0)));
+    QVERIFY(journal.append(batchData(3.0)));
+    QVERIFY(journal.truncate());
+    QCOMPARE(journal.epoch(), quint32(2));
+    QVERIFY(journal.isEmpty());
+    //overwrites the first record only, the following ones still hold epoch 1
+    QVERIFY(journal.append(batchData(4.0)));
+    journal.close();
+
+    QVERIFY(journal.open(path, s_capacity));
+    QCOMPARE(journal.epoch(), quint32(2));
+    QCOMPARE(readValues(journal), QList<double>({4.0}));
+
+    //nothing of epoch 2 left after a truncate
+    QVERIFY(journal.truncate());
+    journal.close();
+    QVERIFY(journal.open(path, s_capacity));
+    QCOMPARE(journal.epoch(), quint32(3));
+    QVERIFY(journal.isEmpty());
+}
+
+void TestValueJournal::prepareDatabase(const QString &t_dbPath)
+{
+    {
+        SQLiteDB database;
+        QVERIFY(database.openDatabase(t_dbPath));
+        database.addEntity(s_entityId, "POWER1Module1");
+        database.addComponent("ACT_PQS1");
+        QCOMPARE(database.addSession("session", QList<QVariantMap>()), 1);
+        const int transactionId = database.reserveTransactionId();
+        QCOMPARE(transactionId, 1);
+        QVERIFY(database.addTransaction(transactionId, "recording", "session", "ZeraAll", ""));
+    }
+    //the values of the crashed run, the batch was not committed yet
+    ValueJournal journal;
+    QVERIFY(journal.open(ValueJournal::pathForDatabase(t_dbPath)));
+    QVERIFY(journal.append(batchData(1.0)));
+    QVERIFY(journal.sync());
+    journal.close();
+}
+
+int TestValueJournal::countRows(const QString &t_dbPath, const QString &t_table)
+{
+    int retVal = -1;
+    {
+        QSqlDatabase checkDatabase = QSqlDatabase::addDatabase("QSQLITE", "check");
+        checkDatabase.setDatabaseName(t_dbPath);
+        if(checkDatabase.open()) {
+            QSqlQuery countQuery(checkDatabase);
+            if(countQuery.exec(QString("SELECT COUNT(*) FROM %1;").arg(t_table)) && countQuery.next()) {
+                retVal = countQuery.value(0).toInt();
+            }
+            countQuery.finish();
+            checkDatabase.close();
+        }
+    }
+    QSqlDatabase::removeDatabase("check");
+    return retVal;
+}
+
+void TestValueJournal::uncommittedJournalIsReplayed()
+{
+    const QString dbPath = m_tempDir.filePath("replay.db");
+    prepareDatabase(dbPath);
+    QCOMPARE(countRows(dbPath, "valuemap"), 0);
+
+    SQLiteDB database;
+    QVERIFY(database.openDatabase(dbPath));
+    QCOMPARE(countRows(dbPath, "valuemap"), 1);
+    QCOMPARE(countRows(dbPath, "transactions_valuemap"), 1);
+    QVERIFY(QFile::exists(ValueJournal::pathForDatabase(dbPath)) == false);
+}
+
+void TestValueJournal::committedEpochIsNotReplayed()
+{
+    const QString dbPath = m_tempDir.filePath("committed.db");
+    prepareDatabase(dbPath);
+    {
+        //crashed after the batch with the journal records was committed, before the journal was truncated
+        QSqlDatabase crashedDatabase = QSqlDatabase::addDatabase("QSQLITE", "crashed");
+        crashedDatabase.setDatabaseName(dbPath);
+        QVERIFY(crashedDatabase.open());
+        QSqlQuery epochQuery(crashedDatabase);
+        QVERIFY(epochQuery.exec("INSERT OR REPLACE INTO journal_state (id, epoch) VALUES (0, 1);"));
+        epochQuery.finish();
+        crashedDatabase.close();
+    }
+    QSqlDatabase::removeDatabase("crashed");
+
+    SQLiteDB database;
+    QVERIFY(database.openDatabase(dbPath));
+    QCOMPARE(countRows(dbPath, "valuemap"), 0);
+    QVERIFY(QFile::exists(ValueJournal::pathForDatabase(dbPath)) == false);
+}
+
+QTEST_GUILESS_MAIN(TestValueJournal)
+
+#include "tst_valuejournal.moc"
@@ -1,4 +1,5 @@
 #include "vl_abstractloggerdb.h"
+#include "vl_logrecordqueue.h"
 
 namespace VeinLogger
 {
@@ -7,4 +8,67 @@ namespace VeinLogger
 
   }
 
+  QString AbstractLoggerDB::durabilityProfileName(DURABILITY_PROFILE t_profile)
+  {
+    switch(t_profile) {
+    case DURABILITY_PROFILE::SAFE:
+      return QStringLiteral("safe");
+    default:
+      return QStringLiteral("fast");
+    }
+  }
+
+  bool AbstractLoggerDB::durabilityProfileFromName(const QString &t_name, DURABILITY_PROFILE &t_profile)
+  {
+    if(t_name == QLatin1String("fast")) {
+      t_profile = DURABILITY_PROFILE::FAST;
+      return true;
+    }
+    if(t_name == QLatin1String("safe")) {
+      t_profile = DURABILITY_PROFILE::SAFE;
+      return true;
+    }
+    return false;
+  }
+
+  void AbstractLoggerDB::setRecordQueue(QSharedPointer<LogRecordQueue> t_recordQueue)
+  {
+    m_recordQueue = t_recordQueue;
+  }
+
+  void AbstractLoggerDB::drainRecordQueue()
+  {
+    if(m_recordQueue.isNull()) {
+      return;
+    }
+    m_recordQueue->clearDrainRequest();
+    m_recordQueue->drain([this](LogRecord &t_record) {
+      switch(t_record.type) {
+      case LogRecord::Type::VALUE:
+        addLoggedValue(t_record.sessionName, t_record.transactionIds(), t_record.entityId, t_record.name, t_record.value, t_record.timestamp);
+        break;
+      case LogRecord::Type::ADD_ENTITY:
+        addEntity(t_record.entityId, t_record.name);
+        break;
+      case LogRecord::Type::ADD_COMPONENT:
+        addComponent(t_record.name);
+        break;
+      case LogRecord::Type::ADD_SESSION:
+        addSession(t_record.name, t_record.staticData);
+        break;
+      case LogRecord::Type::ADD_TRANSACTION: {
+        const QStringList names = t_record.value.toStringList();
+        addTransaction(t_record.transactionId(), t_record.name, t_record.sessionName, names.value(0), names.value(1));
+        break;
+      }
+      case LogRecord::Type::TRANSACTION_START:
+        addStartTime(t_record.transactionId(), t_record.timestamp);
+        break;
+      case LogRecord::Type::TRANSACTION_METADATA:
+        addTransactionMetadata(t_record.transactionId(), t_record.name, t_record.value.toString());
+        break;
+      }
+    });
+  }
+
 } // namespace VeinLogger
@@ -7,9 +7,15 @@
 #include <QVariant>
 #include <functional>
 #include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QCborMap>
+#include <QSharedPointer>
 
 namespace VeinLogger
 {
+class LogRecordQueue;
+
 class AbstractLoggerDB : public QObject
 {
     Q_OBJECT
@@ -24,8 +30,63 @@ public:
     enum class STORAGE_MODE : int {
         TEXT = 0,
         BINARY = 1,
+        /**
+         * numbers and strings in native INTEGER/REAL/TEXT storage, other types as binary BLOB
+         */
+        TYPED = 2,
+    };
+
+    /**
+     * @brief The DURABILITY_PROFILE enum
+     * Trade-off between commit cost and the data lost on power failure
+     */
+    enum class DURABILITY_PROFILE : int {
+        FAST = 0, ///< "fast": the last commits may be lost on power failure, the database stays consistent
+        SAFE = 1, ///< "safe": every commit is synced to the storage
     };
+    static QString durabilityProfileName(DURABILITY_PROFILE t_profile);
+    /**
+     * @return false if t_name is not a known profile name
+     */
+    static bool durabilityProfileFromName(const QString &t_name, DURABILITY_PROFILE &t_profile);
 
+    /**
+     * @brief The FlushPolicy struct
+     * A batch is written as soon as the first of the limits is reached
+     */
+    struct FlushPolicy
+    {
+        /**
+         * @brief maxRows
+         * upper bound of the batch size, the effective size is tuned to stay within commitBudgetMs
+         */
+        int maxRows = 10000;
+        /**
+         * @brief maxBytes
+         * approximate payload of the values in the batch
+         */
+        qint64 maxBytes = 4 * 1024 * 1024;
+        /**
+         * @brief maxAgeMs
+         * time a value waits for its batch at most
+         */
+        int maxAgeMs = 5000;
+        /**
+         * @brief commitBudgetMs
+         * target duration of writing and committing one batch
+         */
+        int commitBudgetMs = 50;
+        /**
+         * @brief journalSyncMs
+         * buffered values are journaled and synced at this interval, this bounds the data lost on a crash.
+         * 0 disables the journal, switching it on or off takes effect when the next database is opened.
+         */
+        int journalSyncMs = 1000;
+    };
+
+    /**
+     * @note hasEntityId, hasComponentName and hasSessionName read the ids of the database thread, call them there
+     */
     virtual bool hasEntityId(int t_entityId) const =0;
     virtual bool hasComponentName(const QString &t_componentName) const =0;
     virtual bool hasSessionName(const QString &t_sessionName) const =0;
@@ -34,41 +95,213 @@ public:
     virtual QString databasePath() const =0;
     virtual void setStorageMode(STORAGE_MODE t_storageMode) =0;
     virtual STORAGE_MODE getStorageMode() const =0;
+    /**
+     * @brief setDurabilityProfile
+     * Takes effect immediately if the database is open, call in the database thread then
+     */
+    virtual void setDurabilityProfile(DURABILITY_PROFILE t_profile) =0;
+    virtual DURABILITY_PROFILE getDurabilityProfile() const =0;
+    /**
+     * @brief setFlushPolicy
+     * Call in the database thread once it was moved there
+     */
+    virtual void setFlushPolicy(const FlushPolicy &t_policy) =0;
+    virtual FlushPolicy getFlushPolicy() const =0;
     virtual std::function<bool(QString)> getDatabaseValidationFunction() const =0;
+    /**
+     * @brief reserveTransactionId
+     * @return the id of a new transaction, -1 until the database is ready
+     *
+     * The transaction is created with addTransaction, usually queued as record, so the logger knows the id
+     * without waiting for the database thread.
+     * Thread safe, called from the logger thread
+     */
+    virtual int reserveTransactionId() =0;
+    /**
+     * @brief setRecordQueue
+     * @param t_recordQueue: queue filled by the DatabaseLogger
+     *
+     * Must be set before the database is moved to its thread.
+     */
+    void setRecordQueue(QSharedPointer<LogRecordQueue> t_recordQueue);
 
 signals:
     void sigDatabaseError(const QString &t_errorString);
     void sigDatabaseReady();
     void sigNewSessionList(QStringList p_sessions);
+    /**
+     * @brief sigSessionDeletionProgress
+     * @param t_progress: "active" (bool), "sessions" (QStringList), "deletedValues" (qint64), "failed" (bool)
+     */
+    void sigSessionDeletionProgress(const QVariantMap &t_progress);
+    /**
+     * @brief sigReclaimableSizeChanged
+     * @param t_bytes: size of the free pages in the database file, returned to the file system in the background
+     */
+    void sigReclaimableSizeChanged(qint64 t_bytes);
+    /**
+     * @brief sigEffectiveBatchSizeChanged
+     * @param t_rows: batch size currently used as row limit, see FlushPolicy
+     */
+    void sigEffectiveBatchSizeChanged(int t_rows);
+    /**
+     * @brief sigIngestionBufferChanged
+     * @param t_state: "bufferedBytes" (qint64, approximate size of the values waiting in memory),
+     * "spilling" (bool), "spilledBytes" (qint64, waiting in the spill file), "replayedBytes" (qint64),
+     * "droppedValues" (qint64, values neither buffered nor spilled)
+     */
+    void sigIngestionBufferChanged(const QVariantMap &t_state);
+    /**
+     * @brief sigStorageInfoChanged
+     * @param t_info: volume of the database: "rootPath" (QString), "bytesAvailable", "bytesTotal" (qint64),
+     * "ingestRate" (bytes/s, qint64), "timeToFull" (seconds until the free space reserve is reached, -1 if nothing is written)
+     */
+    void sigStorageInfoChanged(const QVariantMap &t_info);
 
 public slots:
     virtual void initLocalData() =0;
     virtual void addComponent(const QString &t_componentName) =0;
     virtual void addEntity(int t_entityId, QString t_entityName) =0;
-    virtual int addTransaction(const QString &t_transactionName, const QString &t_sessionName, const QString &t_contentSets, const QString &t_guiContextName) =0;
+    /**
+     * @brief addTransaction
+     * @param t_transactionId: from reserveTransactionId
+     * @return false on error
+     *
+     * adds the session t_sessionName if it does not exist yet
+     */
+    virtual bool addTransaction(int t_transactionId, const QString &t_transactionName, const QString &t_sessionName, const QString &t_contentSets, const QString &t_guiContextName) =0;
+    /**
+     * @brief addTransactionMetadata
+     * @param t_transactionId: sql transaction id
+     * @param t_key: e.g. "downsampling"
+     * @param t_value: JSON text, replaces an existing value of t_key
+     * @return false on error
+     *
+     * describes how the values of the transaction were stored, for readers of the database
+     */
+    virtual bool addTransactionMetadata(int t_transactionId, const QString &t_key, const QString &t_value) = 0;
     /**
      * @brief addStartTime
      * @param t_transactionId: sql transaction id
-     * @param t_time: transaction start time
+     * @param t_timestampUs: transaction start time in UTC microseconds since epoch
      * @return true
      *
-     * set the snapshot time or recording start time
+     * set the snapshot time or recording start time, implementations may defer the write to the next batch
      */
-    virtual bool addStartTime(int t_transactionId, QDateTime t_time) = 0;
+    virtual bool addStartTime(int t_transactionId, qint64 t_timestampUs) = 0;
     /**
      * @brief addStopTime
      * @param t_transactionId: sql transaction id
-     * @param t_time: transaction stop time
+     * @param t_timestampUs: transaction stop time in UTC microseconds since epoch
      * @return true
      *
-     * set the snapshot time or recording stop time.
+     * set the snapshot time or recording stop time, implementations may defer the write to the next batch
      */
-    virtual bool addStopTime(int t_transactionId,  QDateTime t_time) = 0;
+    virtual bool addStopTime(int t_transactionId, qint64 t_timestampUs) = 0;
 
+    /**
+     * @brief readTransaction
+     * Thread safe, called from the logger thread
+     */
     virtual QJsonDocument readTransaction(const QString &p_transaction, const QString &p_session) = 0;
+    /**
+     * @brief readTransactionColumns
+     * @return the records of readTransaction in columns, entity and component names as dictionaries:
+     * @code
+     * {
+     *   "session": session name, "transaction": transaction name,
+     *   "entities": [entity names], "components": [component names],
+     *   "id": [value ids], "value_timestamp": [UTC microseconds, ISO text for rows of older versions],
+     *   "entity": [index into entities], "component": [index into components], "component_value": [values]
+     * }
+     * @endcode
+     * Thread safe, called from the logger thread
+     */
+    virtual QCborMap readTransactionColumns(const QString &p_transaction, const QString &p_session) = 0;
+    /**
+     * @brief readSessionComponent
+     * @return a value of the static data stored with the session, implementations may cache it per session
+     * Thread safe, called from the logger thread
+     */
     virtual QVariant readSessionComponent(const QString &p_session, const QString &p_entity, const QString &p_component) = 0;
+    /**
+     * @brief readTransactionIds
+     * @return sql ids of all transactions named p_transaction in p_session, ascending
+     * Thread safe, called from the logger thread
+     */
+    virtual QVector<int> readTransactionIds(const QString &p_transaction, const QString &p_session) = 0;
+    /**
+     * @brief readLastValueId
+     * @return highest value id written so far, upper bound for paged reads
+     * Thread safe, called from the logger thread
+     */
+    virtual qint64 readLastValueId() = 0;
+    /**
+     * @brief readTransactionPage
+     * @param t_transactionId: sql transaction id
+     * @param t_afterValueId: only values with a higher id are returned
+     * @param t_lastValueId: only values up to this id are returned
+     * @param t_pageSize: maximum number of records
+     * @return records in the format of readTransaction, ordered by value id
+     *
+     * Thread safe, called from the logger thread
+     */
+    virtual QJsonArray readTransactionPage(int t_transactionId, qint64 t_afterValueId, qint64 t_lastValueId, int t_pageSize) = 0;
+    /**
+     * @brief readTrend
+     * @param t_resolutionUs: bucket length
+     * @return the scalar numbers of the component in the transaction aggregated per bucket, in columns:
+     * @code
+     * {
+     *   "session", "transaction", "entity", "component", "resolution": bucket length in ms,
+     *   "source": what the buckets were computed from, e.g. "rollup_minute", "valuemap" or "rollup_minute+valuemap"
+     *             for a transaction recorded across the introduction of the rollups,
+     *   "bucket_start": [UTC microseconds], "count": [...], "min": [...], "max": [...], "mean": [...], "first": [...], "last": [...]
+     * }
+     * @endcode
+     * Implementations answer from the coarsest pre-aggregated data that matches t_resolutionUs.
+     * Thread safe, called from the logger thread
+     */
+    virtual QJsonObject readTrend(const QString &p_transaction, const QString &p_session, const QString &p_entity, const QString &p_component, qint64 t_resolutionUs) = 0;
+    /**
+     * @brief readRange
+     * @param t_fromUs, t_toUs: time range in UTC microseconds since epoch, both inclusive
+     * @param t_maxPoints: upper bound of the returned points, at least 3
+     * @return the scalar numbers the transactions of the session logged for the component in the range:
+     * @code
+     * {
+     *   "session", "entity", "component", "from", "to",
+     *   "count": number of values in the range,
+     *   "value_timestamp": [UTC microseconds], "component_value": [numbers]
+     * }
+     * @endcode
+     * Ranges with more than t_maxPoints values are downsampled with Largest-Triangle-Three-Buckets,
+     * which keeps the first and last value and the peaks.
+     * Thread safe, called from the logger thread
+     */
+    virtual QJsonObject readRange(const QString &p_session, const QString &p_entity, const QString &p_component, qint64 t_fromUs, qint64 t_toUs, int t_maxPoints) = 0;
     virtual int addSession(const QString &t_sessionName,QList<QVariantMap> p_staticData) =0;
+    /**
+     * @brief deleteSession
+     * @return see deleteSessions, true does not mean the rows are deleted yet
+     */
     virtual bool deleteSession(const QString &t_session) = 0;
+    /**
+     * @brief deleteSessions
+     * @return true if at least one of t_sessions exists and is queued for deletion
+     *
+     * The sessions disappear from the session list right away, their rows are deleted in the background.
+     * Values still queued for their transactions are dropped. Progress is reported with sigSessionDeletionProgress.
+     */
+    virtual bool deleteSessions(const QStringList &t_sessions) = 0;
+    /**
+     * @brief convertToIncrementalVacuum
+     * @return false if the conversion failed or was refused, true if the database reclaims free pages now
+     *
+     * Databases created without auto vacuum keep the pages of deleted sessions. The conversion rewrites
+     * the whole file and blocks the database thread meanwhile, so it only runs when called explicitly.
+     */
+    virtual bool convertToIncrementalVacuum() = 0;
     /**
      * @brief addLoggedValue
      * @param t_sessionId
@@ -76,11 +309,11 @@ public slots:
      * @param t_entityId
      * @param t_componentName
      * @param t_value
-     * @param t_timestamp
+     * @param t_timestamp: UTC microseconds since epoch, see LoggerClock
      *
      * @todo Remove sessionId. Its not necessary and forces the user to store only in one session at the same time.
      */
-    virtual void addLoggedValue(int t_sessionId, QVector<int> t_transactionIds, int t_entityId, const QString &t_componentName, QVariant t_value, QDateTime t_timestamp) =0;
+    virtual void addLoggedValue(int t_sessionId, QVector<int> t_transactionIds, int t_entityId, const QString &t_componentName, QVariant t_value, qint64 t_timestamp) =0;
     /**
      * @brief addLoggedValue
      * @param t_sessionName
@@ -88,14 +321,27 @@ public slots:
      * @param t_entityId
      * @param t_componentName
      * @param t_value
-     * @param t_timestamp
+     * @param t_timestamp: UTC microseconds since epoch, see LoggerClock
      *
      * @todo Remove sessionName. Its not necessary and forces the user to store only in one session at the same time.
      */
-    virtual void addLoggedValue(const QString &t_sessionName, QVector<int> t_transactionIds, int t_entityId, const QString &t_componentName, QVariant t_value, QDateTime t_timestamp) =0;
+    virtual void addLoggedValue(const QString &t_sessionName, QVector<int> t_transactionIds, int t_entityId, const QString &t_componentName, QVariant t_value, qint64 t_timestamp) =0;
 
     virtual bool openDatabase(const QString &t_dbPath) =0;
+    /**
+     * @brief runBatchedExecution
+     * Writes the values queued so far, implementations schedule this themselves according to the FlushPolicy
+     */
     virtual void runBatchedExecution() =0;
+    /**
+     * @brief drainRecordQueue
+     *
+     * Applies all queued records in order. Implementations call this before writing a batch.
+     */
+    void drainRecordQueue();
+
+protected:
+    QSharedPointer<LogRecordQueue> m_recordQueue;
 };
 
 /// @b factory function alias to create database
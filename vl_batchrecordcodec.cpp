@@ -0,0 +1,62 @@
+#include "vl_batchrecordcodec.h"
+#include "vl_valuecodec.h"
+
+#include <QtEndian>
+
+namespace VeinLogger
+{
+namespace
+{
+/**
+ * timestamp, session id, entity id, component id, transaction count
+ */
+constexpr int s_fixedSize = 8 + 4 + 4 + 4 + 2;
+} // namespace
+
+//constexpr definition, see: https://stackoverflow.com/questions/8016780/undefined-reference-to-static-constexpr-char
+constexpr int BatchRecordCodec::s_maxTransactionCount;
+
+bool BatchRecordCodec::encode(const SQLBatchData &t_data, QByteArray &t_target)
+{
+    const int transactionCount = t_data.transactionIds.size();
+    if(transactionCount > s_maxTransactionCount) {
+        return false;
+    }
+    const int start = t_target.size();
+    t_target.resize(start + s_fixedSize + 4 * transactionCount);
+    char *data = t_target.data() + start;
+    qToLittleEndian<qint64>(t_data.timestamp, data);
+    qToLittleEndian<qint32>(t_data.sessionId, data + 8);
+    qToLittleEndian<qint32>(t_data.entityId, data + 12);
+    qToLittleEndian<qint32>(t_data.componentId, data + 16);
+    qToLittleEndian<quint16>(quint16(transactionCount), data + 20);
+    for(int i = 0; i < transactionCount; ++i) {
+        qToLittleEndian<qint32>(t_data.transactionIds.at(i), data + s_fixedSize + 4 * i);
+    }
+    ValueCodec::encode(t_data.value, t_target);
+    return true;
+}
+
+bool BatchRecordCodec::decode(const char *t_data, int t_size, SQLBatchData &t_target)
+{
+    if(t_size < s_fixedSize) {
+        return false;
+    }
+    const int transactionCount = qFromLittleEndian<quint16>(t_data + 20);
+    const int valueOffset = s_fixedSize + 4 * transactionCount;
+    if(valueOffset > t_size) {
+        return false;
+    }
+    t_target.timestamp = qFromLittleEndian<qint64>(t_data);
+    t_target.sessionId = qFromLittleEndian<qint32>(t_data + 8);
+    t_target.entityId = qFromLittleEndian<qint32>(t_data + 12);
+    t_target.componentId = qFromLittleEndian<qint32>(t_data + 16);
+    t_target.transactionIds.resize(transactionCount);
+    for(int i = 0; i < transactionCount; ++i) {
+        t_target.transactionIds[i] = qFromLittleEndian<qint32>(t_data + s_fixedSize + 4 * i);
+    }
+    t_target.value = ValueCodec::decode(QByteArray(t_data + valueOffset, t_size - valueOffset));
+    return true;
+}
+
+} // namespace VeinLogger
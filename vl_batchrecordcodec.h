@@ -0,0 +1,38 @@
+#ifndef VEINLOGGER_BATCHRECORDCODEC_H
+#define VEINLOGGER_BATCHRECORDCODEC_H
+
+#include "globalIncludes.h"
+#include "vl_sqlitedb.h"
+
+#include <QByteArray>
+
+namespace VeinLogger
+{
+/**
+ * @brief The BatchRecordCodec class
+ *
+ * Compact binary representation of one buffered value (SQLBatchData), used by the spill file and the journal.
+ *
+ * Layout: int64 timestamp, int32 session/entity/component id, uint16 transaction count + int32 transaction ids,
+ * value encoded with ValueCodec. All integers are little endian.
+ */
+class BatchRecordCodec
+{
+public:
+    /**
+     * @brief encode
+     * Appends the record to t_target
+     * @return false if the value is mapped to more transactions than the format can hold
+     */
+    static bool encode(const SQLBatchData &t_data, QByteArray &t_target);
+    /**
+     * @brief decode
+     * @return false for truncated data
+     */
+    static bool decode(const char *t_data, int t_size, SQLBatchData &t_target);
+
+    static constexpr int s_maxTransactionCount = 0xffff;
+};
+} // namespace VeinLogger
+
+#endif // VEINLOGGER_BATCHRECORDCODEC_H
@@ -0,0 +1,218 @@
+#include "vl_changefilter.h"
+#include "vl_valuecodec.h"
+
+#include <QSet>
+
+#include <cmath>
+#include <cstring>
+
+namespace VeinLogger
+{
+//constexpr definition, see: https://stackoverflow.com/questions/8016780/undefined-reference-to-static-constexpr-char
+constexpr qint64 ChangeFilter::s_rowOverheadBytes;
+
+void ChangeFilter::addTransaction(int t_transactionId, const QMultiHash<int, QVariant> &t_entityFilters)
+{
+    QHash<int, Settings> entitySettings;
+    QSet<int> unfilteredEntities;
+    for(auto iter = t_entityFilters.constBegin(); iter != t_entityFilters.constEnd(); ++iter) {
+        Settings settings;
+        if(readSettings(iter.value(), settings) == false) {
+            unfilteredEntities.insert(iter.key());
+            continue;
+        }
+        auto settingsIter = entitySettings.find(iter.key());
+        if(settingsIter == entitySettings.end()) {
+            entitySettings.insert(iter.key(), settings);
+        }
+        else {
+            //several content sets: the one logging most wins
+            settingsIter->absoluteDeadband = qMin(settingsIter->absoluteDeadband, settings.absoluteDeadband);
+            settingsIter->relativeDeadband = qMin(settingsIter->relativeDeadband, settings.relativeDeadband);
+            if(settings.heartbeatUs > 0 && (settingsIter->heartbeatUs == 0 || settings.heartbeatUs < settingsIter->heartbeatUs)) {
+                settingsIter->heartbeatUs = settings.heartbeatUs;
+            }
+        }
+    }
+    for(const int entityId : qAsConst(unfilteredEntities)) {
+        entitySettings.remove(entityId);
+    }
+
+    removeTransaction(t_transactionId);
+    if(entitySettings.isEmpty() == false) {
+        m_transactions.insert(t_transactionId, entitySettings);
+    }
+}
+
+void ChangeFilter::removeTransaction(int t_transactionId)
+{
+    if(m_transactions.remove(t_transactionId) > 0) {
+        for(auto iter = m_lastValues.begin(); iter != m_lastValues.end();) {
+            if(iter.key().transactionId == t_transactionId) {
+                iter = m_lastValues.erase(iter);
+            }
+            else {
+                ++iter;
+            }
+        }
+    }
+}
+
+void ChangeFilter::resetLastValues()
+{
+    m_lastValues.clear();
+}
+
+void ChangeFilter::clear()
+{
+    m_transactions.clear();
+    m_lastValues.clear();
+    m_savings.clear();
+    m_savingsChanged = true;
+}
+
+bool ChangeFilter::isActive() const
+{
+    return m_transactions.isEmpty() == false;
+}
+
+const QVector<int> &ChangeFilter::filter(const QVector<int> &t_transactionIds, int t_entityId, const QString &t_componentName, const QVariant &t_value, qint64 t_timestampUs)
+{
+    m_accepted.clear();
+    bool encoded = false;
+    bool suppressed = false;
+    for(const int transactionId : t_transactionIds) {
+        const Settings *settings = nullptr;
+        const auto transactionIter = m_transactions.constFind(transactionId);
+        if(transactionIter != m_transactions.constEnd()) {
+            const auto entityIter = transactionIter->constFind(t_entityId);
+            if(entityIter != transactionIter->constEnd()) {
+                settings = &entityIter.value();
+            }
+        }
+        if(settings == nullptr) {
+            m_accepted.append(transactionId);
+            continue;
+        }
+
+        if(encoded == false) {
+            m_encoded.clear();
+            ValueCodec::encode(t_value, m_encoded);
+            encoded = true;
+        }
+        LastValue &lastValue = m_lastValues[ValueKey{transactionId, t_entityId, t_componentName}];
+        Savings &savings = m_savings[t_entityId][t_componentName];
+        const bool heartbeatDue = settings->heartbeatUs > 0 && t_timestampUs - lastValue.timestampUs >= settings->heartbeatUs;
+        if(lastValue.encoded.isEmpty() || heartbeatDue || isSignificantChange(*settings, lastValue.encoded, m_encoded)) {
+            //copy into the existing buffer, assigning would share m_encoded and allocate with the next value
+            lastValue.encoded.resize(m_encoded.size());
+            std::memcpy(lastValue.encoded.data(), m_encoded.constData(), size_t(m_encoded.size()));
+            lastValue.timestampUs = t_timestampUs;
+            ++savings.logged;
+            m_accepted.append(transactionId);
+        }
+        else {
+            ++savings.suppressed;
+            savings.savedBytes += s_rowOverheadBytes + m_encoded.size();
+            suppressed = true;
+        }
+        m_savingsChanged = true;
+    }
+    return suppressed ? m_accepted : t_transactionIds;
+}
+
+QVariantMap ChangeFilter::savings() const
+{
+    QVariantMap retVal;
+    for(auto entityIter = m_savings.constBegin(); entityIter != m_savings.constEnd(); ++entityIter) {
+        QVariantMap entitySavings;
+        for(auto componentIter = entityIter->constBegin(); componentIter != entityIter->constEnd(); ++componentIter) {
+            QVariantMap componentSavings;
+            componentSavings.insert("logged", componentIter->logged);
+            componentSavings.insert("suppressed", componentIter->suppressed);
+            componentSavings.insert("savedBytes", componentIter->savedBytes);
+            entitySavings.insert(componentIter.key(), componentSavings);
+        }
+        retVal.insert(QString::number(entityIter.key()), entitySavings);
+    }
+    return retVal;
+}
+
+bool ChangeFilter::takeSavingsChanged()
+{
+    const bool retVal = m_savingsChanged;
+    m_savingsChanged = false;
+    return retVal;
+}
+
+bool ChangeFilter::readSettings(const QVariant &t_config, Settings &t_settings)
+{
+    if(t_config.canConvert<QVariantMap>() == false) {
+        return false;
+    }
+    const QVariantMap config = t_config.toMap();
+    t_settings.absoluteDeadband = qMax(config.value("AbsoluteDeadband", 0.0).toDouble(), 0.0);
+    t_settings.relativeDeadband = qMax(config.value("RelativeDeadband", 0.0).toDouble(), 0.0);
+    t_settings.heartbeatUs = qMax(config.value("Heartbeat", 0).toLongLong(), qint64(0)) * 1000;
+    return true;
+}
+
+bool ChangeFilter::isSignificantChange(const Settings &t_settings, const QByteArray &t_last, const QByteArray &t_new)
+{
+    if(t_last == t_new) {
+        return false;
+    }
+    if(t_settings.absoluteDeadband <= 0.0 && t_settings.relativeDeadband <= 0.0) {
+        return true;
+    }
+    ValueCodec::View lastView;
+    ValueCodec::View newView;
+    if(ValueCodec::view(t_last.constData(), t_last.size(), lastView) == false
+            || ValueCodec::view(t_new.constData(), t_new.size(), newView) == false
+            || lastView.tag != newView.tag) {
+        return true;
+    }
+    //NaN never is within the band
+    auto outsideBand = [&t_settings](double t_lastValue, double t_newValue) {
+        const double band = qMax(t_settings.absoluteDeadband, t_settings.relativeDeadband * std::fabs(t_lastValue));
+        return !(std::fabs(t_newValue - t_lastValue) <= band);
+    };
+    switch(newView.tag) {
+    case ValueCodec::Tag::INT64:
+    case ValueCodec::Tag::UINT64:
+        return outsideBand(double(lastView.integerValue), double(newView.integerValue));
+    case ValueCodec::Tag::FLOAT64:
+    case ValueCodec::Tag::FLOAT32:
+        return outsideBand(lastView.realValue, newView.realValue);
+    case ValueCodec::Tag::FLOAT64_ARRAY:
+    case ValueCodec::Tag::FLOAT32_ARRAY:
+    case ValueCodec::Tag::INT32_ARRAY:
+        if(lastView.size != newView.size) {
+            return true;
+        }
+        for(int index = 0; index < newView.size; ++index) {
+            double lastValue = 0.0;
+            double newValue = 0.0;
+            if(newView.tag == ValueCodec::Tag::FLOAT64_ARRAY) {
+                lastValue = lastView.float64At(index);
+                newValue = newView.float64At(index);
+            }
+            else if(newView.tag == ValueCodec::Tag::FLOAT32_ARRAY) {
+                lastValue = lastView.float32At(index);
+                newValue = newView.float32At(index);
+            }
+            else {
+                lastValue = lastView.int32At(index);
+                newValue = newView.int32At(index);
+            }
+            if(outsideBand(lastValue, newValue)) {
+                return true;
+            }
+        }
+        return false;
+    default:
+        return true;
+    }
+}
+
+} // namespace VeinLogger
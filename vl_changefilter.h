@@ -0,0 +1,124 @@
+#ifndef VEINLOGGER_CHANGEFILTER_H
+#define VEINLOGGER_CHANGEFILTER_H
+
+#include "globalIncludes.h"
+#include "vl_valuekey.h"
+
+#include <QHash>
+#include <QMultiHash>
+#include <QVector>
+#include <QString>
+#include <QByteArray>
+#include <QVariant>
+#include <QVariantMap>
+
+namespace VeinLogger
+{
+/**
+ * @brief The ChangeFilter class
+ *
+ * Optional filter stage in front of the record queue: for transactions whose content sets have a
+ * "ChangeFilter" entry (see JsonContentSetLoader) only values that changed are logged.
+ *
+ * The last logged value is kept per (transaction, entity, component) in its ValueCodec encoding.
+ * A value is suppressed if its encoding equals the last logged one or if all its numbers are within
+ * the deadband max("AbsoluteDeadband", "RelativeDeadband" * |last|) of the last logged value.
+ * Numbers are scalars and the elements of number arrays of the same size, other types are compared exactly.
+ * "Heartbeat" (ms, 0 = off) logs a value anyway once the last logged one is that old.
+ *
+ * Deadbands are compared against the last logged value, not the last received one, so slow drift is not lost.
+ */
+class ChangeFilter
+{
+public:
+    struct Settings
+    {
+        double absoluteDeadband = 0.0;
+        double relativeDeadband = 0.0;
+        qint64 heartbeatUs = 0;
+    };
+
+    /**
+     * @brief addTransaction
+     * @param t_entityFilters: see QmlLogger::readChangeFilters
+     *
+     * An entity that is also in a content set without filter is not filtered, for several filters the
+     * smallest deadbands and heartbeat are used.
+     */
+    void addTransaction(int t_transactionId, const QMultiHash<int, QVariant> &t_entityFilters);
+    void removeTransaction(int t_transactionId);
+    /**
+     * @brief resetLastValues
+     * The next value of every component is logged, e.g. after logging was restarted
+     */
+    void resetLastValues();
+    /**
+     * @brief clear
+     * Removes all transactions, last values and savings
+     */
+    void clear();
+    /**
+     * @brief isActive
+     * @return true if any transaction is filtered, checked first so unfiltered logging costs nothing
+     */
+    bool isActive() const;
+
+    /**
+     * @brief filter
+     * @return the transactions that log t_value: t_transactionIds itself if none suppressed it, otherwise an internal
+     * vector valid until the next call
+     */
+    const QVector<int> &filter(const QVector<int> &t_transactionIds, int t_entityId, const QString &t_componentName, const QVariant &t_value, qint64 t_timestampUs);
+
+    /**
+     * @brief savings
+     * @return entity id -> component name -> {"logged", "suppressed", "savedBytes"}
+     */
+    QVariantMap savings() const;
+    /**
+     * @brief takeSavingsChanged
+     * @return true if savings() changed since the last call
+     */
+    bool takeSavingsChanged();
+
+    /**
+     * @brief s_rowOverheadBytes
+     * estimated size of the valuemap and transactions_valuemap rows of a value without the value itself
+     */
+    static constexpr qint64 s_rowOverheadBytes = 48;
+
+private:
+    struct LastValue
+    {
+        QByteArray encoded;
+        qint64 timestampUs = 0;
+    };
+
+    struct Savings
+    {
+        qint64 logged = 0;
+        qint64 suppressed = 0;
+        qint64 savedBytes = 0;
+    };
+
+    static bool readSettings(const QVariant &t_config, Settings &t_settings);
+    static bool isSignificantChange(const Settings &t_settings, const QByteArray &t_last, const QByteArray &t_new);
+
+    /**
+     * @brief m_transactions
+     * transaction id -> entity id -> settings, entities without entry are not filtered
+     */
+    QHash<int, QHash<int, Settings>> m_transactions;
+    QHash<ValueKey, LastValue> m_lastValues;
+    QHash<int, QHash<QString, Savings>> m_savings;
+    bool m_savingsChanged = false;
+    /**
+     * @brief m_encoded, m_accepted
+     * reused for every value
+     */
+    QByteArray m_encoded;
+    QVector<int> m_accepted;
+};
+} // namespace VeinLogger
+
+#endif // VEINLOGGER_CHANGEFILTER_H
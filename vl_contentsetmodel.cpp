@@ -0,0 +1,256 @@
+#include "vl_contentsetmodel.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QThread>
+
+namespace VeinLogger
+{
+namespace
+{
+const QString c_session = QLatin1String("Sessions");
+const QString c_contentSet = QLatin1String("ContentSet");
+const QString c_entity = QLatin1String("EntityId");
+const QString c_component = QLatin1String("Components");
+
+/**
+ * @brief The ContentSetModelCache class
+ * One model per absolute file path, shared by all loaders
+ */
+class ContentSetModelCache
+{
+public:
+    static ContentSetModelCache &instance()
+    {
+        static ContentSetModelCache s_instance;
+        return s_instance;
+    }
+
+    QSharedPointer<const ContentSetModel> load(const QString &t_filePath, ContentSetModel *(*t_reader)(const QString &))
+    {
+        QMutexLocker locker(&m_mutex);
+        Entry &entry = m_entries[t_filePath];
+        if(entry.model.isNull() || entry.dirty || (entry.watched == false && entry.model->isCurrent() == false)) {
+            //a change reported while reading marks the entry dirty again, the watcher slot waits for the mutex
+            entry.dirty = false;
+            entry.model = QSharedPointer<const ContentSetModel>(t_reader(t_filePath));
+            entry.watched = watch(t_filePath);
+        }
+        return entry.model;
+    }
+
+    void invalidate(const QString &t_filePath)
+    {
+        QMutexLocker locker(&m_mutex);
+        const auto entryIter = m_entries.find(t_filePath);
+        if(entryIter != m_entries.end()) {
+            entryIter->dirty = true;
+        }
+    }
+
+private:
+    struct Entry
+    {
+        QSharedPointer<const ContentSetModel> model;
+        bool watched = false;
+        bool dirty = false;
+    };
+
+    /**
+     * @brief watch
+     * The watcher lives in the application thread, files loaded from other threads fall back to the mtime check
+     * @return true if changes of t_filePath are reported by the watcher
+     */
+    bool watch(const QString &t_filePath)
+    {
+        QCoreApplication *app = QCoreApplication::instance();
+        if(app == nullptr || QThread::currentThread() != app->thread()) {
+            return false;
+        }
+        if(m_watcher.isNull()) {
+            m_watcher = new QFileSystemWatcher(app);
+            //an editor replacing the file removes it from the watcher, load() adds it again
+            QObject::connect(m_watcher.data(), &QFileSystemWatcher::fileChanged, [this](const QString &t_changedPath) {
+                QMutexLocker locker(&m_mutex);
+                const auto entryIter = m_entries.find(t_changedPath);
+                if(entryIter != m_entries.end()) {
+                    entryIter->dirty = true;
+                    entryIter->watched = false;
+                }
+            });
+        }
+        if(QFileInfo::exists(t_filePath) == false) {
+            return false;
+        }
+        return m_watcher->files().contains(t_filePath) || m_watcher->addPath(t_filePath);
+    }
+
+    QMutex m_mutex;
+    QHash<QString, Entry> m_entries;
+    /**
+     * @brief m_watcher
+     * owned by the application, nullptr after it is gone
+     */
+    QPointer<QFileSystemWatcher> m_watcher;
+};
+} // namespace
+
+QSharedPointer<const ContentSetModel> ContentSetModel::load(const QString &t_filePath)
+{
+    if(t_filePath.isEmpty()) {
+        static const QSharedPointer<const ContentSetModel> s_missingFile(new ContentSetModel());
+        return s_missingFile;
+    }
+    return ContentSetModelCache::instance().load(QFileInfo(t_filePath).absoluteFilePath(), &ContentSetModel::read);
+}
+
+void ContentSetModel::invalidate(const QString &t_filePath)
+{
+    if(t_filePath.isEmpty() == false) {
+        ContentSetModelCache::instance().invalidate(QFileInfo(t_filePath).absoluteFilePath());
+    }
+}
+
+bool ContentSetModel::exists() const
+{
+    return m_exists;
+}
+
+bool ContentSetModel::isReadable() const
+{
+    return m_readable;
+}
+
+bool ContentSetModel::isValid() const
+{
+    return m_valid;
+}
+
+bool ContentSetModel::hasSessionSection() const
+{
+    return m_hasSessionSection;
+}
+
+bool ContentSetModel::hasContentSetSection() const
+{
+    return m_hasContentSetSection;
+}
+
+QVector<QString> ContentSetModel::sessionList() const
+{
+    return m_sessions.keys().toVector();
+}
+
+QVector<QString> ContentSetModel::contentSetList(const QString &t_session) const
+{
+    return m_sessions.value(t_session);
+}
+
+bool ContentSetModel::hasContentSet(const QString &t_contentSetName) const
+{
+    return m_contentSets.contains(t_contentSetName);
+}
+
+QMap<QString, QVector<QString>> ContentSetModel::contentSet(const QString &t_contentSetName) const
+{
+    return m_contentSets.value(t_contentSetName);
+}
+
+QVariant ContentSetModel::option(const QString &t_section, const QString &t_contentSetName) const
+{
+    return m_options.value(t_section).value(t_contentSetName);
+}
+
+bool ContentSetModel::isCurrent() const
+{
+    if(m_filePath.isEmpty()) {
+        return true;
+    }
+    const QFileInfo fileInfo(m_filePath);
+    if(fileInfo.exists() != m_exists) {
+        return false;
+    }
+    return m_exists == false || (fileInfo.lastModified() == m_lastModified && fileInfo.size() == m_size);
+}
+
+ContentSetModel *ContentSetModel::read(const QString &t_filePath)
+{
+    ContentSetModel *retVal = new ContentSetModel();
+    retVal->m_filePath = t_filePath;
+    //stat before reading: a write after it is seen as a change by the next isCurrent()
+    const QFileInfo fileInfo(t_filePath);
+    retVal->m_exists = fileInfo.exists();
+    retVal->m_lastModified = fileInfo.lastModified();
+    retVal->m_size = fileInfo.size();
+    if(retVal->m_exists) {
+        QFile file(t_filePath);
+        if(file.open(QIODevice::Unbuffered | QIODevice::ReadOnly)) {
+            retVal->m_readable = true;
+            retVal->parse(file.readAll());
+            file.close();
+        }
+        else {
+            qCWarning(VEIN_LOGGER) << "Can not open content set file" << t_filePath << file.errorString();
+        }
+    }
+    return retVal;
+}
+
+void ContentSetModel::parse(const QByteArray &t_fileContent)
+{
+    QJsonParseError err;
+    const QJsonDocument doc = QJsonDocument::fromJson(t_fileContent, &err);
+    if(err.error != QJsonParseError::NoError) {
+        qCWarning(VEIN_LOGGER) << "Content set file" << m_filePath << "is not valid json:" << err.errorString();
+        return;
+    }
+    if(doc.isObject() == false) {
+        return;
+    }
+    m_valid = true;
+    const QJsonObject rootObj = doc.object();
+    for(auto sectionIter = rootObj.constBegin(); sectionIter != rootObj.constEnd(); ++sectionIter) {
+        const QJsonObject sectionObj = sectionIter.value().toObject();
+        if(sectionIter.key() == c_session) {
+            m_hasSessionSection = true;
+            for(auto sessionIter = sectionObj.constBegin(); sessionIter != sectionObj.constEnd(); ++sessionIter) {
+                QVector<QString> &contentSetList = m_sessions[sessionIter.key()];
+                for(const QJsonValue tmpVal : sessionIter.value().toArray()) {
+                    contentSetList.append(tmpVal.toString());
+                }
+            }
+        }
+        else if(sectionIter.key() == c_contentSet) {
+            m_hasContentSetSection = true;
+            for(auto contentSetIter = sectionObj.constBegin(); contentSetIter != sectionObj.constEnd(); ++contentSetIter) {
+                QMap<QString, QVector<QString>> &entityComponents = m_contentSets[contentSetIter.key()];
+                for(const QJsonValue tmpVal : contentSetIter.value().toArray()) {
+                    //no components: all components of the entity
+                    QVector<QString> &components = entityComponents[tmpVal.toObject().value(c_entity).toString()];
+                    for(const QJsonValue comp : tmpVal.toObject().value(c_component).toArray()) {
+                        components.append(comp.toString());
+                    }
+                }
+            }
+        }
+        else {
+            //no entry: the option is off for the contentSet
+            QHash<QString, QVariant> &options = m_options[sectionIter.key()];
+            for(auto optionIter = sectionObj.constBegin(); optionIter != sectionObj.constEnd(); ++optionIter) {
+                if(optionIter.value().isObject()) {
+                    options.insert(optionIter.key(), QVariant(optionIter.value().toObject().toVariantMap()));
+                }
+            }
+        }
+    }
+}
+
+} // namespace VeinLogger
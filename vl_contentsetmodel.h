@@ -0,0 +1,111 @@
+#ifndef VEINLOGGER_CONTENTSETMODEL_H
+#define VEINLOGGER_CONTENTSETMODEL_H
+
+#include "globalIncludes.h"
+
+#include <QDateTime>
+#include <QHash>
+#include <QMap>
+#include <QSharedPointer>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+namespace VeinLogger
+{
+/**
+ * @brief The ContentSetModel class
+ *
+ * Immutable parsed content of one content set file (see JsonContentSetLoader), so lookups are hash lookups
+ * instead of reading and parsing the file again.
+ *
+ * load() shares one model per file with all loaders of the process. The file is parsed again only
+ * after a QFileSystemWatcher reported a change or invalidate() was called. Files that can not be watched
+ * (missing, or loaded away from the application thread) are checked by mtime and size with every load().
+ */
+class ContentSetModel
+{
+public:
+    /**
+     * @brief load
+     * @return the current model of t_filePath, never nullptr. An empty t_filePath returns a model of a missing file.
+     */
+    static QSharedPointer<const ContentSetModel> load(const QString &t_filePath);
+    /**
+     * @brief invalidate
+     * The next load() of t_filePath parses the file again, used after writing it
+     */
+    static void invalidate(const QString &t_filePath);
+
+    bool exists() const;
+    /**
+     * @brief isReadable
+     * @return false if the file exists but could not be opened
+     */
+    bool isReadable() const;
+    /**
+     * @brief isValid
+     * @return true if the file contains a json object, files with parser errors have no entries
+     */
+    bool isValid() const;
+    bool hasSessionSection() const;
+    bool hasContentSetSection() const;
+
+    /**
+     * @brief sessionList
+     * @return the session names in ascending order
+     */
+    QVector<QString> sessionList() const;
+    /**
+     * @brief contentSetList
+     * @return the content sets of t_session in file order, empty for unknown sessions
+     */
+    QVector<QString> contentSetList(const QString &t_session) const;
+    bool hasContentSet(const QString &t_contentSetName) const;
+    /**
+     * @brief contentSet
+     * @return entity id -> component names, an empty vector for entities logging all components
+     */
+    QMap<QString, QVector<QString>> contentSet(const QString &t_contentSetName) const;
+    /**
+     * @brief option
+     * @return entry of t_contentSetName in the section t_section, e.g. "ChangeFilter", as QVariantMap.
+     * Invalid if there is no such entry.
+     */
+    QVariant option(const QString &t_section, const QString &t_contentSetName) const;
+
+    /**
+     * @brief isCurrent
+     * @return false if the file was created, removed or modified since it was parsed
+     */
+    bool isCurrent() const;
+
+private:
+    ContentSetModel() = default;
+    static ContentSetModel *read(const QString &t_filePath);
+    void parse(const QByteArray &t_fileContent);
+
+    QString m_filePath;
+    bool m_exists = false;
+    bool m_readable = false;
+    bool m_valid = false;
+    bool m_hasSessionSection = false;
+    bool m_hasContentSetSection = false;
+    QDateTime m_lastModified;
+    qint64 m_size = 0;
+
+    /**
+     * @brief m_sessions
+     * session -> content sets, ordered so sessionList() is stable
+     */
+    QMap<QString, QVector<QString>> m_sessions;
+    QHash<QString, QMap<QString, QVector<QString>>> m_contentSets;
+    /**
+     * @brief m_options
+     * section -> content set -> QVariantMap, for all top level sections besides "Sessions" and "ContentSet"
+     */
+    QHash<QString, QHash<QString, QVariant>> m_options;
+};
+} // namespace VeinLogger
+
+#endif // VEINLOGGER_CONTENTSETMODEL_H
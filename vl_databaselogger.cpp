@@ -1,6 +1,11 @@
 #include "vl_databaselogger.h"
 #include "vl_datasource.h"
 #include "vl_qmllogger.h"
+#include "vl_subscriptionindex.h"
+#include "vl_logrecordqueue.h"
+#include "vl_loggerclock.h"
+#include "vl_changefilter.h"
+#include "vl_downsampler.h"
 
 #include <QHash>
 #include <QThread>
@@ -9,6 +14,8 @@
 #include <QStorageInfo>
 #include <QMimeDatabase>
 #include <QFileSystemWatcher>
+#include <QElapsedTimer>
+#include <QUuid>
 
 #include <ve_commandevent.h>
 #include <vcmp_componentdata.h>
@@ -16,6 +23,12 @@
 #include <vcmp_errordata.h>
 #include <veinmodulerpc.h>
 #include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+
+#include <atomic>
+#include <limits>
+#include <utility>
 
 Q_LOGGING_CATEGORY(VEIN_LOGGER, VEIN_DEBUGNAME_LOGGER)
 
@@ -25,12 +38,18 @@ class DataLoggerPrivate: public QObject
 {
     explicit DataLoggerPrivate(DatabaseLogger *t_qPtr) : m_qPtr(t_qPtr)
     {
-        m_batchedExecutionTimer.setInterval(5000);
-        m_batchedExecutionTimer.setSingleShot(false);
+        m_fileSizeUpdateTimer.setInterval(5000);
+        m_fileSizeUpdateTimer.setSingleShot(false);
+        m_changeFilterSavingsTimer.setInterval(5000);
+        m_changeFilterSavingsTimer.setSingleShot(true);
+        m_recordOverflowTimer.setInterval(s_recordOverflowRetryMs);
+        m_recordOverflowTimer.setSingleShot(false);
+        m_subscriptionIndexTimer.setInterval(0);
+        m_subscriptionIndexTimer.setSingleShot(true);
     }
     ~DataLoggerPrivate()
     {
-        m_batchedExecutionTimer.stop();
+        m_fileSizeUpdateTimer.stop();
         if(m_database != nullptr)
         {
             m_database->deleteLater(); ///@todo: check if the delete works across threads
@@ -69,6 +88,20 @@ class DataLoggerPrivate: public QObject
             componentData.insert(s_scheduledLoggingCountdownComponentName, QVariant(0.0));
             componentData.insert(s_existingSessionsComponentName, QStringList());
             componentData.insert(s_customerDataComponentName, QString());
+            componentData.insert(s_durabilityProfileComponentName, AbstractLoggerDB::durabilityProfileName(m_durabilityProfile));
+            componentData.insert(s_sessionDeletionComponentName, QVariantMap({{"active", false}}));
+            componentData.insert(s_databaseReclaimableSizeComponentName, QVariant(0));
+            componentData.insert(s_flushMaxRowsComponentName, m_flushPolicy.maxRows);
+            componentData.insert(s_flushMaxBytesComponentName, m_flushPolicy.maxBytes);
+            componentData.insert(s_flushMaxAgeComponentName, m_flushPolicy.maxAgeMs);
+            componentData.insert(s_commitBudgetComponentName, m_flushPolicy.commitBudgetMs);
+            componentData.insert(s_journalSyncIntervalComponentName, m_flushPolicy.journalSyncMs);
+            componentData.insert(s_effectiveBatchSizeComponentName, QVariant(0));
+            componentData.insert(s_ingestionBufferComponentName, QVariantMap({{"spilling", false}}));
+            componentData.insert(s_storageTimeToFullComponentName, QVariant(-1));
+            componentData.insert(s_ingestRateComponentName, QVariant(0));
+            componentData.insert(s_changeFilterSavingsComponentName, QVariantMap());
+            componentData.insert(s_recordQueueComponentName, QVariantMap());
 
             // TODO: Add more from modulemanager
             componentData.insert(s_sessionNameComponentName, QString());
@@ -91,12 +124,27 @@ class DataLoggerPrivate: public QObject
             }
 
             QMap<QString,QString> tmpParamMap;
+            //the signature without p_format is kept for existing clients, it answers with JSON
             VfCpp::cVeinModuleRpc::Ptr tmpval= VfCpp::cVeinModuleRpc::Ptr(new VfCpp::cVeinModuleRpc(m_entityId,m_qPtr,m_qPtr,"RPC_readTransaction",VfCpp::cVeinModuleRpc::Param({{"p_session", "QString"},{"p_transaction", "QString"}})), &QObject::deleteLater);
             m_rpcList[tmpval->rpcName()]=tmpval;
+            tmpval= VfCpp::cVeinModuleRpc::Ptr(new VfCpp::cVeinModuleRpc(m_entityId,m_qPtr,m_qPtr,"RPC_readTransaction",VfCpp::cVeinModuleRpc::Param({{"p_session", "QString"},{"p_transaction", "QString"},{"p_format", "QString"}})), &QObject::deleteLater);
+            m_rpcList[tmpval->rpcName()]=tmpval;
             tmpval= VfCpp::cVeinModuleRpc::Ptr(new VfCpp::cVeinModuleRpc(m_entityId,m_qPtr,m_qPtr,"RPC_readSessionComponent",VfCpp::cVeinModuleRpc::Param({{"p_session", "QString"},{"p_entity", "QString"},{"p_component", "QString"}})), &QObject::deleteLater);
             m_rpcList[tmpval->rpcName()]=tmpval;
             tmpval= VfCpp::cVeinModuleRpc::Ptr(new VfCpp::cVeinModuleRpc(m_entityId,m_qPtr,m_qPtr,"RPC_deleteSession",VfCpp::cVeinModuleRpc::Param({{"p_session", "QString"}})), &QObject::deleteLater);
             m_rpcList[tmpval->rpcName()]=tmpval;
+            tmpval= VfCpp::cVeinModuleRpc::Ptr(new VfCpp::cVeinModuleRpc(m_entityId,m_qPtr,m_qPtr,"RPC_deleteSessions",VfCpp::cVeinModuleRpc::Param({{"p_sessions", "QStringList"}})), &QObject::deleteLater);
+            m_rpcList[tmpval->rpcName()]=tmpval;
+            tmpval= VfCpp::cVeinModuleRpc::Ptr(new VfCpp::cVeinModuleRpc(m_entityId,m_qPtr,m_qPtr,"RPC_convertToIncrementalVacuum",VfCpp::cVeinModuleRpc::Param()), &QObject::deleteLater);
+            m_rpcList[tmpval->rpcName()]=tmpval;
+            tmpval= VfCpp::cVeinModuleRpc::Ptr(new VfCpp::cVeinModuleRpc(m_entityId,m_qPtr,m_qPtr,"RPC_openTransactionCursor",VfCpp::cVeinModuleRpc::Param({{"p_session", "QString"},{"p_transaction", "QString"},{"p_pageSize", "int"}})), &QObject::deleteLater);
+            m_rpcList[tmpval->rpcName()]=tmpval;
+            tmpval= VfCpp::cVeinModuleRpc::Ptr(new VfCpp::cVeinModuleRpc(m_entityId,m_qPtr,m_qPtr,"RPC_readTransactionPage",VfCpp::cVeinModuleRpc::Param({{"p_cursor", "QString"}})), &QObject::deleteLater);
+            m_rpcList[tmpval->rpcName()]=tmpval;
+            tmpval= VfCpp::cVeinModuleRpc::Ptr(new VfCpp::cVeinModuleRpc(m_entityId,m_qPtr,m_qPtr,"RPC_readRange",VfCpp::cVeinModuleRpc::Param({{"p_session", "QString"},{"p_entity", "QString"},{"p_component", "QString"},{"p_from", "QString"},{"p_to", "QString"},{"p_maxPoints", "int"}})), &QObject::deleteLater);
+            m_rpcList[tmpval->rpcName()]=tmpval;
+            tmpval= VfCpp::cVeinModuleRpc::Ptr(new VfCpp::cVeinModuleRpc(m_entityId,m_qPtr,m_qPtr,"RPC_readTrend",VfCpp::cVeinModuleRpc::Param({{"p_session", "QString"},{"p_transaction", "QString"},{"p_entity", "QString"},{"p_component", "QString"},{"p_resolution", "int"}})), &QObject::deleteLater);
+            m_rpcList[tmpval->rpcName()]=tmpval;
 
 
             initStateMachine();
@@ -130,6 +178,12 @@ class DataLoggerPrivate: public QObject
         m_loggingContainerState->setInitialState(m_loggingDisabledState);
         m_logSchedulerContainerState->setInitialState(m_logSchedulerDisabledState);
 
+        //keep the cached logging flag in sync with the state machine
+        QObject::connect(m_databaseReadyState, &QState::entered, [&](){ setDatabaseReady(true); });
+        QObject::connect(m_databaseUninitializedState, &QState::entered, [&](){ setDatabaseReady(false); });
+        QObject::connect(m_loggingEnabledState, &QState::entered, [&](){ setLoggingOn(true); });
+        QObject::connect(m_loggingDisabledState, &QState::entered, [&](){ setLoggingOn(false); });
+
         //uninitialized -> ready
         m_databaseUninitializedState->addTransition(m_qPtr, &DatabaseLogger::sigDatabaseReady, m_databaseReadyState);
         //ready -> uninitialized
@@ -196,7 +250,8 @@ class DataLoggerPrivate: public QObject
             qInfo("Database logger watching path(s): %s", qPrintable(watchedPaths.join(QStringLiteral(" + "))));
             QStringList unWatchedPaths = m_deleteWatcher.addPaths(watchedPaths);
             if(m_deleteWatcher.directories().count()) {
-                QObject::connect(&m_deleteWatcher, &QFileSystemWatcher::directoryChanged, m_qPtr, &DatabaseLogger::checkDatabaseStillValid);
+                //-wal/-shm files come and go with the connections: check once per burst of directory changes
+                QObject::connect(&m_deleteWatcher, &QFileSystemWatcher::directoryChanged, &m_deleteWatcherDelayTimer, QOverload<>::of(&QTimer::start));
             }
             if(unWatchedPaths.count()) {
                 qWarning("Unwatched paths: %s", qPrintable(unWatchedPaths.join(QStringLiteral(" + "))));
@@ -212,7 +267,7 @@ class DataLoggerPrivate: public QObject
                 //setStatusText("Logging disabled");
                 setStatusText("Database loaded");
             }
-            m_batchedExecutionTimer.stop();
+            m_fileSizeUpdateTimer.stop();
             updateDBFileSizeInfo();
         });
         QObject::connect(m_logSchedulerEnabledState, &QState::entered, [&](){
@@ -241,10 +296,324 @@ class DataLoggerPrivate: public QObject
         m_stateMachine.start();
     }
 
+    void setDatabaseReady(bool t_ready)
+    {
+        m_databaseReady = t_ready;
+        m_loggingActive.store(m_databaseReady && m_loggingOn);
+    }
+
+    void setLoggingOn(bool t_loggingOn)
+    {
+        m_loggingOn = t_loggingOn;
+        m_loggingActive.store(m_databaseReady && m_loggingOn);
+    }
+
+    void rebuildSubscriptionIndex()
+    {
+        m_subscriptionIndexTimer.stop();
+        m_subscriptionIndex.rebuild(m_loggerScripts);
+    }
+
+    /**
+     * @brief scheduleSubscriptionIndexRebuild
+     * Scripts change their logged values one component at a time, so the index is rebuilt once for all of them
+     */
+    void scheduleSubscriptionIndexRebuild()
+    {
+        if(m_subscriptionIndexTimer.isActive() == false) {
+            m_subscriptionIndexTimer.start();
+        }
+    }
+
+    /**
+     * @brief pushRecord
+     * Hands a record to the database thread. Never waits: when the writer is a full queue behind, records
+     * are kept in m_recordOverflow on this thread until the queue has room.
+     */
+    void pushRecord(LogRecord &t_record)
+    {
+        if(m_recordOverflow.isEmpty() == false) {
+            flushRecordOverflow();
+        }
+        if(m_recordOverflow.isEmpty() == false || m_recordQueue->push(t_record) == false) {
+            overflowRecord(t_record);
+            return;
+        }
+        //the first record wakes the database to start its flush timer, the later ones are picked up by that flush
+        const unsigned int occupancy = m_recordQueue->occupancy();
+        if(occupancy == 1 || occupancy >= m_recordQueue->capacity() / 2) {
+            requestDrain();
+        }
+    }
+
+    /**
+     * @brief overflowRecord
+     * Appends a record behind the ones already waiting for room in the queue. Beyond s_maxOverflowRecords
+     * values are dropped, control records are always kept.
+     */
+    void overflowRecord(LogRecord &t_record)
+    {
+        requestDrain();
+        const bool overflowStarted = m_recordOverflow.isEmpty();
+        if(m_recordOverflow.size() - m_recordOverflowHead >= s_maxOverflowRecords && t_record.type == LogRecord::Type::VALUE) {
+            if(m_droppedRecords++ == 0) {
+                qCWarning(VEIN_LOGGER) << "Database writer is" << m_recordQueue->capacity() + s_maxOverflowRecords << "records behind, dropping values";
+                publishRecordQueueState();
+            }
+            return;
+        }
+        m_recordOverflow.append(std::move(t_record));
+        if(overflowStarted) {
+            qCWarning(VEIN_LOGGER) << "Record queue is full, buffering records until the database writer caught up";
+            m_recordOverflowTimer.start();
+            publishRecordQueueState();
+        }
+    }
+
+    /**
+     * @brief flushRecordOverflow
+     * Moves waiting records into the queue as far as it has room
+     */
+    void flushRecordOverflow()
+    {
+        while(m_recordOverflowHead < m_recordOverflow.size() && m_recordQueue->push(m_recordOverflow[m_recordOverflowHead])) {
+            ++m_recordOverflowHead;
+        }
+        requestDrain();
+        if(m_recordOverflowHead == m_recordOverflow.size()) {
+            clearRecordOverflow();
+            publishRecordQueueState();
+        }
+    }
+
+    void clearRecordOverflow()
+    {
+        m_recordOverflow.clear();
+        m_recordOverflowHead = 0;
+        m_recordOverflowTimer.stop();
+    }
+
+    /**
+     * @brief publishRecordQueueState
+     * Sets the RecordQueue component if its value changed
+     */
+    void publishRecordQueueState()
+    {
+        QVariantMap state;
+        if(m_recordQueue.isNull() == false) {
+            state.insert("capacity", m_recordQueue->capacity());
+            state.insert("occupancy", m_recordQueue->occupancy());
+            state.insert("highWaterMark", m_recordQueue->highWaterMark());
+            state.insert("full", m_recordQueue->fullCount());
+        }
+        state.insert("overflow", m_recordOverflow.size() - m_recordOverflowHead);
+        state.insert("dropped", m_droppedRecords);
+        if(state != m_recordQueueState) {
+            m_recordQueueState = state;
+            VeinComponent::ComponentData *queueCData = new VeinComponent::ComponentData();
+            queueCData->setEntityId(m_entityId);
+            queueCData->setCommand(VeinComponent::ComponentData::Command::CCMD_SET);
+            queueCData->setComponentName(DataLoggerPrivate::s_recordQueueComponentName);
+            queueCData->setNewValue(state);
+            queueCData->setEventOrigin(VeinEvent::EventData::EventOrigin::EO_LOCAL);
+            queueCData->setEventTarget(VeinEvent::EventData::EventTarget::ET_ALL);
+            emit m_qPtr->sigSendEvent(new VeinEvent::CommandEvent(VeinEvent::CommandEvent::EventSubtype::NOTIFICATION, queueCData));
+        }
+    }
+
+    /**
+     * @brief requestDrain
+     * Wakes the database thread once until it drained the queue
+     */
+    void requestDrain()
+    {
+        if(m_database != nullptr && m_recordQueue->markDrainRequested()) {
+            QMetaObject::invokeMethod(m_database, "drainRecordQueue", Qt::QueuedConnection);
+        }
+    }
+
+    void queueEntity(int t_entityId)
+    {
+        if(m_queuedEntities.contains(t_entityId) == false) {
+            m_queuedEntities.insert(t_entityId);
+            //entities already in the database are skipped by the database thread
+            LogRecord record;
+            record.type = LogRecord::Type::ADD_ENTITY;
+            record.entityId = t_entityId;
+            record.name = m_dataSource->getEntityName(t_entityId);
+            pushRecord(record);
+            requestDrain();
+        }
+    }
+
+    void queueComponent(const QString &t_componentName)
+    {
+        if(m_queuedComponents.contains(t_componentName) == false) {
+            m_queuedComponents.insert(t_componentName);
+            LogRecord record;
+            record.type = LogRecord::Type::ADD_COMPONENT;
+            record.name = t_componentName;
+            pushRecord(record);
+            requestDrain();
+        }
+    }
+
+    void queueSession(const QString &t_sessionName, const QList<QVariantMap> &t_staticData)
+    {
+        m_queuedSessions.insert(t_sessionName);
+        LogRecord record;
+        record.type = LogRecord::Type::ADD_SESSION;
+        record.name = t_sessionName;
+        record.staticData = t_staticData;
+        pushRecord(record);
+        requestDrain();
+    }
+
+    /**
+     * @brief queueTransaction
+     * @return the id of the new transaction, -1 if the database is not ready
+     *
+     * The id is reserved right away, the row is written by the database thread before the values queued after it
+     */
+    int queueTransaction(const QString &t_transactionName, const QString &t_sessionName, const QString &t_contentSets, const QString &t_guiContextName)
+    {
+        const int transactionId = m_database->reserveTransactionId();
+        if(transactionId < 0) {
+            qCWarning(VEIN_LOGGER) << "No transaction id for" << t_transactionName << "- the database is not ready";
+            return transactionId;
+        }
+        m_queuedSessions.insert(t_sessionName);
+        LogRecord record;
+        record.type = LogRecord::Type::ADD_TRANSACTION;
+        record.setTransactionId(transactionId);
+        record.name = t_transactionName;
+        record.sessionName = t_sessionName;
+        record.value = QStringList({t_contentSets, t_guiContextName});
+        pushRecord(record);
+        requestDrain();
+        return transactionId;
+    }
+
+    void queueTransactionStart(int t_transactionId, qint64 t_timestamp)
+    {
+        LogRecord record;
+        record.type = LogRecord::Type::TRANSACTION_START;
+        record.setTransactionId(t_transactionId);
+        record.timestamp = t_timestamp;
+        pushRecord(record);
+    }
+
+    void queueValue(const QString &t_sessionName, const QVector<int> &t_transactionIds, int t_entityId, const QString &t_componentName, const QVariant &t_value, qint64 t_timestamp)
+    {
+        LogRecord record;
+        record.type = LogRecord::Type::VALUE;
+        record.sessionName = t_sessionName;
+        record.setTransactionIds(t_transactionIds);
+        record.entityId = t_entityId;
+        record.name = t_componentName;
+        record.value = t_value;
+        record.timestamp = t_timestamp;
+        pushRecord(record);
+    }
+
+    void queueTransactionMetadata(int t_transactionId, const QString &t_key, const QString &t_value)
+    {
+        LogRecord record;
+        record.type = LogRecord::Type::TRANSACTION_METADATA;
+        record.setTransactionId(t_transactionId);
+        record.name = t_key;
+        record.value = t_value;
+        pushRecord(record);
+    }
+
+    /**
+     * @brief queueLoggedValue
+     * Entry of logged values: downsampling, then change filter, then the record queue
+     */
+    void queueLoggedValue(const QString &t_sessionName, const QVector<int> &t_transactionIds, int t_entityId, const QString &t_componentName, const QVariant &t_value, qint64 t_timestamp)
+    {
+        const QVector<int> *transactionIds = &t_transactionIds;
+        if(m_downsampler.isActive()) {
+            transactionIds = &m_downsampler.process(t_sessionName, t_transactionIds, t_entityId, t_componentName, t_value, t_timestamp);
+            queueAggregates();
+        }
+        queueFilteredValue(t_sessionName, *transactionIds, t_entityId, t_componentName, t_value, t_timestamp);
+    }
+
+    /**
+     * @brief queueAggregates
+     * Queues the values the downsampler produced
+     */
+    void queueAggregates()
+    {
+        const QVector<Downsampler::Aggregate> aggregates = m_downsampler.takeAggregates();
+        for(const Downsampler::Aggregate &aggregate : aggregates) {
+            queueFilteredValue(aggregate.sessionName, {aggregate.transactionId}, aggregate.entityId, aggregate.componentName, aggregate.value, aggregate.timestampUs);
+        }
+    }
+
+    /**
+     * @brief updateDownsampling
+     * Applies the downsampling of the content sets of t_script and stores it with the transaction
+     */
+    void updateDownsampling(QmlLogger *t_script)
+    {
+        const QVariantMap metadata = m_downsampler.addTransaction(t_script->getTransactionId(), t_script->readDownsampling());
+        queueAggregates();
+        //INSERT OR REPLACE with an invalid id would overwrite the metadata of another transaction
+        if(metadata.isEmpty() == false && t_script->getTransactionId() >= 0) {
+            queueTransactionMetadata(t_script->getTransactionId(), QStringLiteral("downsampling"), QString::fromUtf8(QJsonDocument::fromVariant(metadata).toJson(QJsonDocument::Compact)));
+        }
+        if(m_downsampler.isActive()) {
+            m_downsamplingTimer.start(m_downsampler.flushIntervalMs());
+        }
+        else {
+            m_downsamplingTimer.stop();
+        }
+    }
+
+    /**
+     * @brief queueFilteredValue
+     * Like queueValue, transactions with a change filter only get the value if it changed
+     */
+    void queueFilteredValue(const QString &t_sessionName, const QVector<int> &t_transactionIds, int t_entityId, const QString &t_componentName, const QVariant &t_value, qint64 t_timestamp)
+    {
+        const QVector<int> *transactionIds = &t_transactionIds;
+        if(m_changeFilter.isActive()) {
+            transactionIds = &m_changeFilter.filter(t_transactionIds, t_entityId, t_componentName, t_value, t_timestamp);
+            if(m_changeFilterSavingsTimer.isActive() == false) {
+                m_changeFilterSavingsTimer.start();
+            }
+        }
+        if(transactionIds->isEmpty() == false) {
+            queueValue(t_sessionName, *transactionIds, t_entityId, t_componentName, t_value, t_timestamp);
+        }
+    }
+
+    void updateChangeFilter(QmlLogger *t_script)
+    {
+        m_changeFilter.addTransaction(t_script->getTransactionId(), t_script->readChangeFilters());
+    }
+
+    void updateChangeFilterSavings()
+    {
+        if(m_changeFilter.takeSavingsChanged()) {
+            VeinComponent::ComponentData *savingsCData = new VeinComponent::ComponentData();
+            savingsCData->setEntityId(m_entityId);
+            savingsCData->setCommand(VeinComponent::ComponentData::Command::CCMD_SET);
+            savingsCData->setComponentName(s_changeFilterSavingsComponentName);
+            savingsCData->setNewValue(m_changeFilter.savings());
+            savingsCData->setEventOrigin(VeinEvent::EventData::EventOrigin::EO_LOCAL);
+            savingsCData->setEventTarget(VeinEvent::EventData::EventTarget::ET_ALL);
+            emit m_qPtr->sigSendEvent(new VeinEvent::CommandEvent(VeinEvent::CommandEvent::EventSubtype::NOTIFICATION, savingsCData));
+        }
+    }
+
     void updateDBStorageInfo()
     {
         const auto storages = QStorageInfo::mountedVolumes();
-        QVariantMap storageInfoMap;
+        QVariantMap &storageInfoMap = m_filesystemInfo;
+        storageInfoMap.clear();
         for(const auto storDevice : storages)  {
             if(storDevice.fileSystemType().contains("tmpfs") == false) {
                 const double availGB = storDevice.bytesFree()/1.0e9;
@@ -269,6 +638,41 @@ class DataLoggerPrivate: public QObject
         emit m_qPtr->sigSendEvent(new VeinEvent::CommandEvent(VeinEvent::CommandEvent::EventSubtype::NOTIFICATION, storageCData));
     }
 
+    /**
+     * @brief updateStorageMonitorInfo
+     * @param t_info: see AbstractLoggerDB::sigStorageInfoChanged
+     *
+     * Publishes time to full and ingest rate, the free space of the database volume in FilesystemInfo
+     * is taken from the monitor instead of enumerating the volumes again
+     */
+    void updateStorageMonitorInfo(const QVariantMap &t_info)
+    {
+        QHash<QString, QVariant> componentData;
+        componentData.insert(s_storageTimeToFullComponentName, t_info.value("timeToFull"));
+        componentData.insert(s_ingestRateComponentName, t_info.value("ingestRate"));
+        const QString rootPath = t_info.value("rootPath").toString();
+        if(m_filesystemInfo.contains(rootPath)) {
+            QVariantMap storageData = m_filesystemInfo.value(rootPath).toMap();
+            const double availGB = t_info.value("bytesAvailable").toLongLong()/1.0e9;
+            //10MB steps are enough for the display
+            if(qAbs(storageData.value(DataLoggerPrivate::s_filesystemFreePropertyName).toDouble() - availGB) >= 0.01) {
+                storageData.insert(DataLoggerPrivate::s_filesystemFreePropertyName, availGB);
+                m_filesystemInfo.insert(rootPath, storageData);
+                componentData.insert(s_filesystemInfoComponentName, m_filesystemInfo);
+            }
+        }
+        for(auto iter = componentData.constBegin(); iter != componentData.constEnd(); ++iter) {
+            VeinComponent::ComponentData *storageCData = new VeinComponent::ComponentData();
+            storageCData->setEntityId(m_entityId);
+            storageCData->setCommand(VeinComponent::ComponentData::Command::CCMD_SET);
+            storageCData->setComponentName(iter.key());
+            storageCData->setNewValue(iter.value());
+            storageCData->setEventOrigin(VeinEvent::EventData::EventOrigin::EO_LOCAL);
+            storageCData->setEventTarget(VeinEvent::EventData::EventTarget::ET_ALL);
+            emit m_qPtr->sigSendEvent(new VeinEvent::CommandEvent(VeinEvent::CommandEvent::EventSubtype::NOTIFICATION, storageCData));
+        }
+    }
+
     bool checkDBFilePath(const QString &t_dbFilePath)
     {
         bool retVal = false;
@@ -304,11 +708,14 @@ class DataLoggerPrivate: public QObject
     {
         QFileInfo fInfo(m_databaseFilePath);
         if(fInfo.exists()) {
+            //not yet checkpointed data is in the write ahead log
+            QFileInfo walInfo(m_databaseFilePath + QLatin1String("-wal"));
+            const qint64 fileSize = fInfo.size() + (walInfo.exists() ? walInfo.size() : 0);
             VeinComponent::ComponentData *storageCData = new VeinComponent::ComponentData();
             storageCData->setEntityId(m_entityId);
             storageCData->setCommand(VeinComponent::ComponentData::Command::CCMD_SET);
             storageCData->setComponentName(DataLoggerPrivate::s_databaseFileSizeComponentName);
-            storageCData->setNewValue(QVariant(fInfo.size()));
+            storageCData->setNewValue(QVariant(fileSize));
             storageCData->setEventOrigin(VeinEvent::EventData::EventOrigin::EO_LOCAL);
             storageCData->setEventTarget(VeinEvent::EventData::EventTarget::ET_ALL);
 
@@ -331,16 +738,232 @@ class DataLoggerPrivate: public QObject
         }
     }
 
+    /**
+     * @brief Server side state of a paged transaction read, the read position travels in the continuation token
+     */
+    struct TransactionCursor
+    {
+        /**
+         * @brief all transactions with the requested name in the session, read one after another
+         */
+        QVector<int> transactionIds;
+        /**
+         * @brief values stored after the cursor was opened are not returned
+         */
+        qint64 lastValueId = 0;
+        int pageSize = 0;
+        QElapsedTimer lastAccess;
+    };
+
+    /**
+     * @brief openTransactionCursor
+     * @return cursor id, empty if the transaction does not exist
+     */
+    QString openTransactionCursor(const QString &t_transaction, const QString &t_session, int t_pageSize)
+    {
+        QString retVal;
+        TransactionCursor cursor;
+        cursor.transactionIds = m_database->readTransactionIds(t_transaction, t_session);
+        if(cursor.transactionIds.isEmpty()) {
+            return retVal;
+        }
+        cursor.lastValueId = m_database->readLastValueId();
+        cursor.pageSize = t_pageSize > 0 ? qMin(t_pageSize, s_maxTransactionPageSize) : s_defaultTransactionPageSize;
+        cursor.lastAccess.start();
+
+        expireTransactionCursors();
+        if(m_transactionCursors.size() >= s_maxTransactionCursors) {
+            //drop the least recently used one
+            auto oldest = m_transactionCursors.begin();
+            for(auto iter = m_transactionCursors.begin(); iter != m_transactionCursors.end(); ++iter) {
+                if(iter.value().lastAccess.elapsed() > oldest.value().lastAccess.elapsed()) {
+                    oldest = iter;
+                }
+            }
+            m_transactionCursors.erase(oldest);
+        }
+        retVal = QUuid::createUuid().toString(QUuid::WithoutBraces);
+        m_transactionCursors.insert(retVal, cursor);
+        if(m_transactionCursorExpiryTimer.isActive() == false) {
+            m_transactionCursorExpiryTimer.start();
+        }
+        return retVal;
+    }
+
+    /**
+     * @brief readTimestampParameter
+     * @param t_parameter: UTC microseconds since epoch as number or text, ISO 8601 as returned by RPC_readTransaction, or empty
+     * @param t_default: used for an empty t_parameter
+     * @return false if t_parameter is none of these
+     */
+    static bool readTimestampParameter(const QVariant &t_parameter, qint64 t_default, qint64 &t_timestampUs)
+    {
+        const QString text = t_parameter.toString().trimmed();
+        if(text.isEmpty()) {
+            t_timestampUs = t_default;
+            return true;
+        }
+        bool isNumber = false;
+        t_timestampUs = text.toLongLong(&isNumber);
+        return isNumber || LoggerClock::fromIsoString(text, t_timestampUs);
+    }
+
+    /**
+     * @brief rpcParameterError
+     * Checks the parameters cVeinModuleRpc can not check by type. The RPC functions can only return a result,
+     * so invalid calls are answered with RPC_EINVAL before they are invoked.
+     * @return error description for the caller, empty if the call is valid
+     */
+    static QString rpcParameterError(const QString &t_procedureName, const QVariantMap &t_parameters)
+    {
+        if(t_procedureName.startsWith(QLatin1String("RPC_readTransaction("))) {
+            const QString format = t_parameters.value("p_format").toString();
+            if(format.isEmpty() == false && format != QLatin1String("json") && format != QLatin1String("cbor") && format != QLatin1String("cbor+zlib")) {
+                return QString("Unknown p_format: %1, expected json, cbor or cbor+zlib").arg(format);
+            }
+        }
+        return QString();
+    }
+
+    /**
+     * @brief readTransactionPage
+     * @param t_cursorId: cursor returned by openTransactionCursor
+     * @param t_transactionIndex: read position, index into TransactionCursor::transactionIds
+     * @param t_afterValueId: read position, last value id already returned
+     * @return page object as returned by the RPCs, the cursor is closed with the last page
+     */
+    QJsonObject readTransactionPage(const QString &t_cursorId, int t_transactionIndex, qint64 t_afterValueId)
+    {
+        QJsonObject retVal;
+        auto cursorIter = m_transactionCursors.find(t_cursorId);
+        if(cursorIter == m_transactionCursors.end()) {
+            return retVal;
+        }
+        TransactionCursor &cursor = cursorIter.value();
+        cursor.lastAccess.restart();
+
+        QJsonArray records;
+        while(t_transactionIndex < cursor.transactionIds.size() && records.size() < cursor.pageSize) {
+            const int requested = cursor.pageSize - records.size();
+            const QJsonArray transactionRecords = m_database->readTransactionPage(cursor.transactionIds.at(t_transactionIndex), t_afterValueId, cursor.lastValueId, requested);
+            for(const QJsonValue &record : transactionRecords) {
+                records.append(record);
+            }
+            if(transactionRecords.size() < requested) {
+                ++t_transactionIndex;
+                t_afterValueId = 0;
+            }
+            else {
+                t_afterValueId = transactionRecords.last().toObject().value("id").toVariant().toLongLong();
+            }
+        }
+
+        const bool done = t_transactionIndex >= cursor.transactionIds.size();
+        if(done) {
+            m_transactionCursors.erase(cursorIter);
+        }
+        retVal.insert("cursor", done ? QString() : QString("%1:%2:%3").arg(t_cursorId).arg(t_transactionIndex).arg(t_afterValueId));
+        retVal.insert("records", records);
+        retVal.insert("done", done);
+        return retVal;
+    }
+
+    void expireTransactionCursors()
+    {
+        for(auto iter = m_transactionCursors.begin(); iter != m_transactionCursors.end();) {
+            if(iter.value().lastAccess.hasExpired(s_transactionCursorTimeoutMs)) {
+                iter = m_transactionCursors.erase(iter);
+            }
+            else {
+                ++iter;
+            }
+        }
+        if(m_transactionCursors.isEmpty()) {
+            m_transactionCursorExpiryTimer.stop();
+        }
+    }
+
+    void clearTransactionCursors()
+    {
+        m_transactionCursors.clear();
+        m_transactionCursorExpiryTimer.stop();
+    }
+
     /**
      * @brief The logging is implemented via interpreted scripts that state which values to log
      * @see vl_qmllogger.cpp
      */
     QVector<QmlLogger *> m_loggerScripts;
+    /**
+     * @brief Compiled from m_loggerScripts, answers which transactions log a value change
+     */
+    SubscriptionIndex m_subscriptionIndex;
+    /**
+     * @brief Pending while m_subscriptionIndex is out of date, see scheduleSubscriptionIndexRebuild
+     */
+    QTimer m_subscriptionIndexTimer;
+    /**
+     * @brief Drops unchanged values of transactions whose content sets have a change filter
+     */
+    ChangeFilter m_changeFilter;
+    /**
+     * @brief Throttles the ChangeFilterSavings component
+     */
+    QTimer m_changeFilterSavingsTimer;
+    /**
+     * @brief Stores at most the configured rate of values for transactions whose content sets are downsampled
+     */
+    Downsampler m_downsampler;
+    /**
+     * @brief Closes downsampling windows no further value arrived for
+     */
+    QTimer m_downsamplingTimer;
+    /**
+     * @brief Cached (database ready && logging enabled) so the event hot path does not query the state machine
+     */
+    std::atomic<bool> m_loggingActive{false};
+    bool m_databaseReady=false;
+    bool m_loggingOn=false;
 
     /**
      * @brief The actual database choice is an implementation detail of the DatabaseLogger
      */
     AbstractLoggerDB *m_database=nullptr;
+    /**
+     * @brief Values and control operations travel to m_database through this queue
+     */
+    QSharedPointer<LogRecordQueue> m_recordQueue;
+    /**
+     * @brief Records waiting for room in m_recordQueue, moved on from m_recordOverflowHead
+     */
+    QVector<LogRecord> m_recordOverflow;
+    int m_recordOverflowHead = 0;
+    /**
+     * @brief Retries flushRecordOverflow while records are waiting
+     */
+    QTimer m_recordOverflowTimer;
+    /**
+     * @brief Values dropped since the database was opened because m_recordOverflow was full
+     */
+    int m_droppedRecords = 0;
+    /**
+     * @brief Last value of the RecordQueue component
+     */
+    QVariantMap m_recordQueueState;
+    static constexpr int s_maxOverflowRecords = 65536;
+    static constexpr int s_recordOverflowRetryMs = 10;
+    /**
+     * @brief Items already queued for m_database, avoids queueing them again while the database is open.
+     * The hashes of the database belong to its thread, so they are not asked.
+     * m_queuedSessions is replaced by the sessions of each sigNewSessionList, so deleted sessions are queued again.
+     */
+    QSet<int> m_queuedEntities;
+    QSet<QString> m_queuedComponents;
+    QSet<QString> m_queuedSessions;
+    /**
+     * @brief timestamps of logged values, sampled once per event
+     */
+    LoggerClock m_clock;
     DBFactory m_databaseFactory;
     QString m_databaseFilePath;
     DataSource *m_dataSource=nullptr;
@@ -350,16 +973,20 @@ class DataLoggerPrivate: public QObject
      */
     QThread m_asyncDatabaseThread;
     /**
-     * @b Logging in batches is much more efficient for SQLITE (and for spinning disk storages in general)
-     * @note The batch timer is independent from the recording timeframe as it only pushes already logged values to the database
+     * @brief m_fileSizeUpdateTimer
+     * refreshes the database file size while logging, batches are scheduled by the database itself (see AbstractLoggerDB::FlushPolicy)
      */
-    QTimer m_batchedExecutionTimer;
+    QTimer m_fileSizeUpdateTimer;
     /**
      * @brief logging duration in ms
      */
     int m_scheduledLoggingDuration;
 
     QFileSystemWatcher m_deleteWatcher;
+    /**
+     * @brief Coalesces directoryChanged signals of m_deleteWatcher
+     */
+    QTimer m_deleteWatcherDelayTimer;
     bool m_noUninitMessage = false;
 
     QTimer m_schedulingTimer;
@@ -368,6 +995,17 @@ class DataLoggerPrivate: public QObject
     QString m_loggerStatusText="Logging inactive";
 
     QMap<QString,VfCpp::cVeinModuleRpc::Ptr> m_rpcList;
+    /**
+     * @brief open cursors of RPC_openTransactionCursor by cursor id
+     */
+    QHash<QString, TransactionCursor> m_transactionCursors;
+    QTimer m_transactionCursorExpiryTimer;
+    static constexpr int s_defaultTransactionPageSize = 1000;
+    static constexpr int s_maxTransactionPageSize = 10000;
+    static constexpr int s_maxTransactionCursors = 16;
+    static constexpr qint64 s_transactionCursorTimeoutMs = 60000;
+    static constexpr int s_defaultRangePoints = 1000;
+    static constexpr int s_maxRangePoints = 100000;
     /**
      * @brief m_sessionName
      * stores the current session Name.
@@ -377,6 +1015,11 @@ class DataLoggerPrivate: public QObject
      * will work out better.
      */
     QString m_sessionName;
+    /**
+     * @brief m_existingSessions
+     * sessions of the last sigNewSessionList, RPC_deleteSessions checks its parameters with it
+     */
+    QStringList m_existingSessions;
 
     int m_entityId;
     //entity name
@@ -398,6 +1041,20 @@ class DataLoggerPrivate: public QObject
     static constexpr QLatin1String s_scheduledLoggingCountdownComponentName = QLatin1String("ScheduledLoggingCountdown");
     static constexpr QLatin1String s_existingSessionsComponentName = QLatin1String("ExistingSessions");
     static constexpr QLatin1String s_customerDataComponentName = QLatin1String("CustomerData");
+    static constexpr QLatin1String s_durabilityProfileComponentName = QLatin1String("DurabilityProfile");
+    static constexpr QLatin1String s_sessionDeletionComponentName = QLatin1String("SessionDeletion");
+    static constexpr QLatin1String s_databaseReclaimableSizeComponentName = QLatin1String("DatabaseReclaimableSize");
+    static constexpr QLatin1String s_flushMaxRowsComponentName = QLatin1String("FlushMaxRows");
+    static constexpr QLatin1String s_flushMaxBytesComponentName = QLatin1String("FlushMaxBytes");
+    static constexpr QLatin1String s_flushMaxAgeComponentName = QLatin1String("FlushMaxAge");
+    static constexpr QLatin1String s_commitBudgetComponentName = QLatin1String("CommitBudget");
+    static constexpr QLatin1String s_journalSyncIntervalComponentName = QLatin1String("JournalSyncInterval");
+    static constexpr QLatin1String s_effectiveBatchSizeComponentName = QLatin1String("EffectiveBatchSize");
+    static constexpr QLatin1String s_ingestionBufferComponentName = QLatin1String("IngestionBuffer");
+    static constexpr QLatin1String s_storageTimeToFullComponentName = QLatin1String("StorageTimeToFull");
+    static constexpr QLatin1String s_ingestRateComponentName = QLatin1String("IngestRate");
+    static constexpr QLatin1String s_changeFilterSavingsComponentName = QLatin1String("ChangeFilterSavings");
+    static constexpr QLatin1String s_recordQueueComponentName = QLatin1String("RecordQueue");
 
     // TODO: Add more from modulemanager
     static constexpr QLatin1String s_sessionNameComponentName = QLatin1String("sessionName");
@@ -424,6 +1081,17 @@ class DataLoggerPrivate: public QObject
     QState *m_logSchedulerDisabledState = new QState(m_logSchedulerContainerState);
 
     AbstractLoggerDB::STORAGE_MODE m_storageMode;
+    AbstractLoggerDB::DURABILITY_PROFILE m_durabilityProfile = AbstractLoggerDB::DURABILITY_PROFILE::FAST;
+    /**
+     * @brief m_flushPolicy
+     * set by the Flush* / CommitBudget components, applied to every database opened
+     */
+    AbstractLoggerDB::FlushPolicy m_flushPolicy;
+    /**
+     * @brief m_filesystemInfo
+     * last value of the FilesystemInfo component
+     */
+    QVariantMap m_filesystemInfo;
 
     DatabaseLogger *m_qPtr=nullptr;
     friend class DatabaseLogger;
@@ -444,6 +1112,20 @@ constexpr QLatin1String DataLoggerPrivate::s_scheduledLoggingEnabledComponentNam
 constexpr QLatin1String DataLoggerPrivate::s_scheduledLoggingDurationComponentName;
 constexpr QLatin1String DataLoggerPrivate::s_scheduledLoggingCountdownComponentName;
 constexpr QLatin1String DataLoggerPrivate::s_existingSessionsComponentName;
+constexpr QLatin1String DataLoggerPrivate::s_durabilityProfileComponentName;
+constexpr QLatin1String DataLoggerPrivate::s_sessionDeletionComponentName;
+constexpr QLatin1String DataLoggerPrivate::s_databaseReclaimableSizeComponentName;
+constexpr QLatin1String DataLoggerPrivate::s_flushMaxRowsComponentName;
+constexpr QLatin1String DataLoggerPrivate::s_flushMaxBytesComponentName;
+constexpr QLatin1String DataLoggerPrivate::s_flushMaxAgeComponentName;
+constexpr QLatin1String DataLoggerPrivate::s_commitBudgetComponentName;
+constexpr QLatin1String DataLoggerPrivate::s_journalSyncIntervalComponentName;
+constexpr QLatin1String DataLoggerPrivate::s_effectiveBatchSizeComponentName;
+constexpr QLatin1String DataLoggerPrivate::s_ingestionBufferComponentName;
+constexpr QLatin1String DataLoggerPrivate::s_storageTimeToFullComponentName;
+constexpr QLatin1String DataLoggerPrivate::s_ingestRateComponentName;
+constexpr QLatin1String DataLoggerPrivate::s_changeFilterSavingsComponentName;
+constexpr QLatin1String DataLoggerPrivate::s_recordQueueComponentName;
 // TODO: Add more from modulemanager
 constexpr QLatin1String DataLoggerPrivate::s_customerDataComponentName;
 constexpr QLatin1String DataLoggerPrivate::s_sessionNameComponentName;
@@ -451,6 +1133,14 @@ constexpr QLatin1String DataLoggerPrivate::s_guiContextComponentName;
 constexpr QLatin1String DataLoggerPrivate::s_transactionNameComponentName;
 constexpr QLatin1String DataLoggerPrivate::s_currentContentSetsComponentName;
 constexpr QLatin1String DataLoggerPrivate::s_availableContentSetsComponentName;
+constexpr int DataLoggerPrivate::s_defaultTransactionPageSize;
+constexpr int DataLoggerPrivate::s_maxTransactionPageSize;
+constexpr int DataLoggerPrivate::s_maxTransactionCursors;
+constexpr qint64 DataLoggerPrivate::s_transactionCursorTimeoutMs;
+constexpr int DataLoggerPrivate::s_defaultRangePoints;
+constexpr int DataLoggerPrivate::s_maxRangePoints;
+constexpr int DataLoggerPrivate::s_maxOverflowRecords;
+constexpr int DataLoggerPrivate::s_recordOverflowRetryMs;
 
 DatabaseLogger::DatabaseLogger(DataSource *t_dataSource, DBFactory t_factoryFunction, QObject *t_parent, AbstractLoggerDB::STORAGE_MODE t_storageMode) :
     VeinEvent::EventSystem(t_parent),
@@ -460,6 +1150,9 @@ DatabaseLogger::DatabaseLogger(DataSource *t_dataSource, DBFactory t_factoryFunc
     m_dPtr->m_asyncDatabaseThread.setObjectName("VFLoggerDBThread");
     m_dPtr->m_schedulingTimer.setSingleShot(true);
     m_dPtr->m_countdownUpdateTimer.setInterval(100);
+    m_dPtr->m_deleteWatcherDelayTimer.setSingleShot(true);
+    m_dPtr->m_deleteWatcherDelayTimer.setInterval(200);
+    m_dPtr->m_transactionCursorExpiryTimer.setInterval(10000);
     m_dPtr->m_databaseFactory = t_factoryFunction;
     m_dPtr->m_storageMode=t_storageMode;
     switch(t_storageMode) {
@@ -476,15 +1169,38 @@ DatabaseLogger::DatabaseLogger(DataSource *t_dataSource, DBFactory t_factoryFunc
         qCDebug(VEIN_LOGGER) << "Created binary logger:" << m_dPtr->m_entityName << "with id:" << m_dPtr->m_entityId;
         break;
     }
+    case AbstractLoggerDB::STORAGE_MODE::TYPED: {
+        //use different id and entity name
+        m_dPtr->m_entityId = 200001;
+        m_dPtr->m_entityName = QLatin1String("_TypedLoggingSystem");
+        qCDebug(VEIN_LOGGER) << "Created typed logger:" << m_dPtr->m_entityName << "with id:" << m_dPtr->m_entityId;
+        break;
+    }
     }
 
     connect(this, &DatabaseLogger::sigAttached, [this](){ m_dPtr->initOnce(); });
-    connect(&m_dPtr->m_batchedExecutionTimer, &QTimer::timeout, [this]() {
+    connect(&m_dPtr->m_fileSizeUpdateTimer, &QTimer::timeout, [this]() {
         m_dPtr->updateDBFileSizeInfo();
+        m_dPtr->publishRecordQueueState();
         if(m_dPtr->m_stateMachine.configuration().contains(m_dPtr->m_loggingDisabledState)) {
-            m_dPtr->m_batchedExecutionTimer.stop();
+            m_dPtr->m_fileSizeUpdateTimer.stop();
+        }
+    });
+    connect(&m_dPtr->m_downsamplingTimer, &QTimer::timeout, [this]() {
+        if(m_dPtr->m_loggingActive.load()) {
+            m_dPtr->m_downsampler.flushDue(m_dPtr->m_clock.nowUs());
+            m_dPtr->queueAggregates();
         }
     });
+    connect(&m_dPtr->m_recordOverflowTimer, &QTimer::timeout, [this]() {
+        m_dPtr->flushRecordOverflow();
+    });
+    connect(&m_dPtr->m_changeFilterSavingsTimer, &QTimer::timeout, [this]() {
+        m_dPtr->updateChangeFilterSavings();
+    });
+    connect(&m_dPtr->m_subscriptionIndexTimer, &QTimer::timeout, [this]() {
+        m_dPtr->rebuildSubscriptionIndex();
+    });
     connect(&m_dPtr->m_schedulingTimer, &QTimer::timeout, [this]() {
         setLoggingEnabled(false);
     });
@@ -493,6 +1209,12 @@ DatabaseLogger::DatabaseLogger(DataSource *t_dataSource, DBFactory t_factoryFunc
         m_dPtr->updateSchedulerCountdown();
     });
 
+    connect(&m_dPtr->m_deleteWatcherDelayTimer, &QTimer::timeout, this, &DatabaseLogger::checkDatabaseStillValid);
+
+    connect(&m_dPtr->m_transactionCursorExpiryTimer, &QTimer::timeout, [this]() {
+        m_dPtr->expireTransactionCursors();
+    });
+
     connect(this, &DatabaseLogger::sigLoggingEnabledChanged, [this](bool t_enabled) {
         VeinComponent::ComponentData *loggingEnabledCData = new VeinComponent::ComponentData();
         loggingEnabledCData->setEntityId(m_dPtr->m_entityId);
@@ -537,19 +1259,29 @@ DatabaseLogger::~DatabaseLogger()
  */
 void DatabaseLogger::addScript(QmlLogger *t_script)
 {
-    const QSet<QAbstractState*> requiredStates = {m_dPtr->m_loggingEnabledState, m_dPtr->m_databaseReadyState};
-    if(m_dPtr->m_stateMachine.configuration().contains(requiredStates) && m_dPtr->m_loggerScripts.contains(t_script) == false) {
+    if(m_dPtr->m_loggingActive.load() && m_dPtr->m_loggerScripts.contains(t_script) == false) {
         m_dPtr->m_loggerScripts.append(t_script);
+        connect(t_script, &QmlLogger::loggedValuesChanged, this, [this](){ m_dPtr->scheduleSubscriptionIndexRebuild(); });
+        connect(t_script, &QmlLogger::sessionNameChanged, this, [this](){ m_dPtr->scheduleSubscriptionIndexRebuild(); });
+        connect(t_script, &QmlLogger::contentSetsChanged, this, [this, t_script](){
+            m_dPtr->updateDownsampling(t_script);
+            m_dPtr->updateChangeFilter(t_script);
+        });
         //writes the values from the data source to the database, some values may never change so they need to be initialized
         if(t_script->initializeValues() == true) {
             const QString tmpsessionName = t_script->sessionName();
             const QVector<QString> tmpTransactionName = {t_script->transactionName()};
             QString tmpContentSets = t_script->contentSets().join(QLatin1Char(','));
-            //add a new transaction and store ids in script.
-            t_script->setTransactionId(m_dPtr->m_database->addTransaction(t_script->transactionName(),t_script->sessionName(), tmpContentSets, t_script->guiContext()));
+            //add a new transaction and store ids in script, the transaction is written by the database thread
+            t_script->setTransactionId(m_dPtr->queueTransaction(t_script->transactionName(), t_script->sessionName(), tmpContentSets, t_script->guiContext()));
             const QVector<int> tmpTransactionIds = {t_script->getTransactionId()};
+            //the initial values are the first ones the filter compares with
+            m_dPtr->updateDownsampling(t_script);
+            m_dPtr->updateChangeFilter(t_script);
+            //start time and initial values share one timestamp
+            const qint64 timestamp = m_dPtr->m_clock.nowUs();
             // add starttime to transaction. stop time is set in batch execution.
-            m_dPtr->m_database->addStartTime(t_script->getTransactionId(),QDateTime::currentDateTime());
+            m_dPtr->queueTransactionStart(t_script->getTransactionId(), timestamp);
 
             QMultiHash<int, QString> tmpLoggedValues = t_script->getLoggedValues();
 
@@ -557,9 +1289,7 @@ void DatabaseLogger::addScript(QmlLogger *t_script)
                 const QList<QString> tmpComponents = tmpLoggedValues.values(tmpEntityId);
                 for(const QString &tmpComponentName : tmpComponents) {
                     if(m_dPtr->m_dataSource->hasEntity(tmpEntityId)) { // is entity available?
-                        if(m_dPtr->m_database->hasEntityId(tmpEntityId) == false) { // already in db?
-                            emit sigAddEntity(tmpEntityId, m_dPtr->m_dataSource->getEntityName(tmpEntityId));
-                        }
+                        m_dPtr->queueEntity(tmpEntityId);
                         QStringList componentNamesToAdd;
                         if(tmpComponentName == QStringLiteral("__ALL_COMPONENTS__")) {
                             componentNamesToAdd = m_dPtr->m_dataSource->getEntityComponentsForStore(tmpEntityId);
@@ -569,29 +1299,45 @@ void DatabaseLogger::addScript(QmlLogger *t_script)
                         }
                         for (auto componentToAdd : componentNamesToAdd) {
                             // add component to db
-                            if(m_dPtr->m_database->hasComponentName(componentToAdd) == false) {
-                                emit sigAddComponent(componentToAdd);
-                            }
+                            m_dPtr->queueComponent(componentToAdd);
                             // add initial values
-                            emit sigAddLoggedValue(
+                            m_dPtr->queueLoggedValue(
                                         tmpsessionName,
                                         tmpTransactionIds,
                                         tmpEntityId,
                                         componentToAdd,
                                         m_dPtr->m_dataSource->getValue(tmpEntityId, componentToAdd),
-                                        QDateTime::currentDateTime());
+                                        timestamp);
                         }
                     }
                 }
             }
         }
+        else {
+            m_dPtr->updateDownsampling(t_script);
+            m_dPtr->updateChangeFilter(t_script);
+        }
+        m_dPtr->rebuildSubscriptionIndex();
     }
 }
 
 void DatabaseLogger::removeScript(QmlLogger *t_script)
 {
-    m_dPtr->m_loggerScripts.removeAll(t_script);
-
+    if(m_dPtr->m_loggerScripts.removeAll(t_script) > 0) {
+        t_script->disconnect(this);
+        m_dPtr->m_downsampler.removeTransaction(t_script->getTransactionId());
+        if(m_dPtr->m_loggingActive.load()) {
+            m_dPtr->queueAggregates();
+        }
+        else {
+            m_dPtr->m_downsampler.takeAggregates();
+        }
+        if(m_dPtr->m_downsampler.isActive() == false) {
+            m_dPtr->m_downsamplingTimer.stop();
+        }
+        m_dPtr->m_changeFilter.removeTransaction(t_script->getTransactionId());
+        m_dPtr->rebuildSubscriptionIndex();
+    }
 }
 
 bool DatabaseLogger::loggingEnabled() const
@@ -615,7 +1361,9 @@ void DatabaseLogger::setLoggingEnabled(bool t_enabled)
     const QSet<QAbstractState *> activeStates = m_dPtr->m_stateMachine.configuration();
     if(t_enabled != activeStates.contains(m_dPtr->m_loggingEnabledState) ) {
         if(t_enabled) {
-            m_dPtr->m_batchedExecutionTimer.start();
+            m_dPtr->m_fileSizeUpdateTimer.start();
+            //values changed while logging was off
+            m_dPtr->m_changeFilter.resetLastValues();
             if(activeStates.contains(m_dPtr->m_logSchedulerEnabledState)) {
                 m_dPtr->m_schedulingTimer.start();
                 m_dPtr->m_countdownUpdateTimer.start();
@@ -625,6 +1373,14 @@ void DatabaseLogger::setLoggingEnabled(bool t_enabled)
         else {
             m_dPtr->m_schedulingTimer.stop();
             m_dPtr->m_countdownUpdateTimer.stop();
+            //the open windows belong to the recording that stops now
+            m_dPtr->m_downsampler.flush();
+            if(m_dPtr->m_database != nullptr) {
+                m_dPtr->queueAggregates();
+            }
+            else {
+                m_dPtr->m_downsampler.takeAggregates();
+            }
             emit sigLoggingStopped();
         }
         emit sigLoggingEnabledChanged(t_enabled);
@@ -674,21 +1430,72 @@ bool DatabaseLogger::openDatabase(const QString &t_filePath)
         m_dPtr->m_database = m_dPtr->m_databaseFactory();//new SQLiteDB(t_storageMode);
         // forward database's error my handler
         connect(m_dPtr->m_database, SIGNAL(sigDatabaseError(QString)), this, SIGNAL(sigDatabaseError(QString)));
+        // setFlushPolicy publishes the initial batch size, connect before
+        connect(m_dPtr->m_database, &AbstractLoggerDB::sigEffectiveBatchSizeChanged, this, [this](int t_rows) {
+            VeinComponent::ComponentData *batchSizeCData = new VeinComponent::ComponentData();
+            batchSizeCData->setEntityId(m_dPtr->m_entityId);
+            batchSizeCData->setCommand(VeinComponent::ComponentData::Command::CCMD_SET);
+            batchSizeCData->setComponentName(DataLoggerPrivate::s_effectiveBatchSizeComponentName);
+            batchSizeCData->setNewValue(t_rows);
+            batchSizeCData->setEventOrigin(VeinEvent::EventData::EventOrigin::EO_LOCAL);
+            batchSizeCData->setEventTarget(VeinEvent::EventData::EventTarget::ET_ALL);
+            emit sigSendEvent(new VeinEvent::CommandEvent(VeinEvent::CommandEvent::EventSubtype::NOTIFICATION, batchSizeCData));
+        });
         m_dPtr->m_database->setStorageMode(m_dPtr->m_storageMode);
+        m_dPtr->m_database->setDurabilityProfile(m_dPtr->m_durabilityProfile);
+        m_dPtr->m_database->setFlushPolicy(m_dPtr->m_flushPolicy);
+        // values, entities, components and sessions are passed in order through the record queue
+        m_dPtr->m_recordQueue = QSharedPointer<LogRecordQueue>::create();
+        m_dPtr->clearRecordOverflow();
+        m_dPtr->m_droppedRecords = 0;
+        m_dPtr->m_queuedEntities.clear();
+        m_dPtr->m_queuedComponents.clear();
+        m_dPtr->m_queuedSessions.clear();
+        m_dPtr->m_database->setRecordQueue(m_dPtr->m_recordQueue);
         m_dPtr->m_database->moveToThread(&m_dPtr->m_asyncDatabaseThread);
         m_dPtr->m_asyncDatabaseThread.start();
 
         // will be queued connection due to thread affinity
-        connect(this, SIGNAL(sigAddLoggedValue(QString,QVector<int>,int,QString,QVariant,QDateTime)), m_dPtr->m_database, SLOT(addLoggedValue(QString,QVector<int>,int,QString,QVariant,QDateTime)));
-        connect(this, SIGNAL(sigAddEntity(int, QString)), m_dPtr->m_database, SLOT(addEntity(int, QString)));
-        connect(this, SIGNAL(sigAddComponent(QString)), m_dPtr->m_database, SLOT(addComponent(QString)));
-        connect(this, SIGNAL(sigAddSession(QString,QList<QVariantMap>)), m_dPtr->m_database, SLOT(addSession(QString,QList<QVariantMap>)));
         connect(this, SIGNAL(sigOpenDatabase(QString)), m_dPtr->m_database, SLOT(openDatabase(QString)));
         connect(m_dPtr->m_database, SIGNAL(sigDatabaseReady()), this, SIGNAL(sigDatabaseReady()));
-        connect(&m_dPtr->m_batchedExecutionTimer, SIGNAL(timeout()), m_dPtr->m_database, SLOT(runBatchedExecution()));
         // run final batch instantly when logging is disabled
         connect(m_dPtr->m_loggingDisabledState, SIGNAL(entered()), m_dPtr->m_database, SLOT(runBatchedExecution()));
         connect(m_dPtr->m_database, SIGNAL(sigNewSessionList(QStringList)), this, SLOT(updateSessionList(QStringList)));
+        connect(m_dPtr->m_database, &AbstractLoggerDB::sigSessionDeletionProgress, this, [this](const QVariantMap &t_progress) {
+            VeinComponent::ComponentData *deletionCData = new VeinComponent::ComponentData();
+            deletionCData->setEntityId(m_dPtr->m_entityId);
+            deletionCData->setCommand(VeinComponent::ComponentData::Command::CCMD_SET);
+            deletionCData->setComponentName(DataLoggerPrivate::s_sessionDeletionComponentName);
+            deletionCData->setNewValue(t_progress);
+            deletionCData->setEventOrigin(VeinEvent::EventData::EventOrigin::EO_LOCAL);
+            deletionCData->setEventTarget(VeinEvent::EventData::EventTarget::ET_ALL);
+            emit sigSendEvent(new VeinEvent::CommandEvent(VeinEvent::CommandEvent::EventSubtype::NOTIFICATION, deletionCData));
+        });
+        connect(m_dPtr->m_database, &AbstractLoggerDB::sigStorageInfoChanged, this, [this](const QVariantMap &t_info) {
+            m_dPtr->updateStorageMonitorInfo(t_info);
+        });
+        connect(m_dPtr->m_database, &AbstractLoggerDB::sigIngestionBufferChanged, this, [this](const QVariantMap &t_state) {
+            VeinComponent::ComponentData *bufferCData = new VeinComponent::ComponentData();
+            bufferCData->setEntityId(m_dPtr->m_entityId);
+            bufferCData->setCommand(VeinComponent::ComponentData::Command::CCMD_SET);
+            bufferCData->setComponentName(DataLoggerPrivate::s_ingestionBufferComponentName);
+            bufferCData->setNewValue(t_state);
+            bufferCData->setEventOrigin(VeinEvent::EventData::EventOrigin::EO_LOCAL);
+            bufferCData->setEventTarget(VeinEvent::EventData::EventTarget::ET_ALL);
+            emit sigSendEvent(new VeinEvent::CommandEvent(VeinEvent::CommandEvent::EventSubtype::NOTIFICATION, bufferCData));
+        });
+        connect(m_dPtr->m_database, &AbstractLoggerDB::sigReclaimableSizeChanged, this, [this](qint64 t_bytes) {
+            VeinComponent::ComponentData *reclaimableCData = new VeinComponent::ComponentData();
+            reclaimableCData->setEntityId(m_dPtr->m_entityId);
+            reclaimableCData->setCommand(VeinComponent::ComponentData::Command::CCMD_SET);
+            reclaimableCData->setComponentName(DataLoggerPrivate::s_databaseReclaimableSizeComponentName);
+            reclaimableCData->setNewValue(t_bytes);
+            reclaimableCData->setEventOrigin(VeinEvent::EventData::EventOrigin::EO_LOCAL);
+            reclaimableCData->setEventTarget(VeinEvent::EventData::EventTarget::ET_ALL);
+            emit sigSendEvent(new VeinEvent::CommandEvent(VeinEvent::CommandEvent::EventSubtype::NOTIFICATION, reclaimableCData));
+            //the file shrinks while pages are reclaimed
+            m_dPtr->updateDBFileSizeInfo();
+        });
 
         emit sigOpenDatabase(t_filePath);
     }
@@ -699,6 +1506,7 @@ void DatabaseLogger::closeDatabase()
 {
     m_dPtr->m_noUninitMessage = false;
     setLoggingEnabled(false);
+    m_dPtr->clearRecordOverflow();
     if(m_dPtr->m_database != nullptr) {
         disconnect(m_dPtr->m_database, SIGNAL(sigDatabaseError(QString)), this, SIGNAL(sigDatabaseError(QString)));
         m_dPtr->m_database->deleteLater();
@@ -711,8 +1519,15 @@ void DatabaseLogger::closeDatabase()
         for(QString watchDir : watchedDirs) {
             m_dPtr->m_deleteWatcher.removePath(watchDir);
         }
-        QObject::disconnect(&m_dPtr->m_deleteWatcher, &QFileSystemWatcher::directoryChanged, this, &DatabaseLogger::checkDatabaseStillValid);
+        QObject::disconnect(&m_dPtr->m_deleteWatcher, &QFileSystemWatcher::directoryChanged, &m_dPtr->m_deleteWatcherDelayTimer, QOverload<>::of(&QTimer::start));
     }
+    m_dPtr->m_deleteWatcherDelayTimer.stop();
+    m_dPtr->clearTransactionCursors();
+    m_dPtr->m_downsampler.clear();
+    m_dPtr->m_downsamplingTimer.stop();
+    m_dPtr->m_changeFilter.clear();
+    m_dPtr->m_changeFilterSavingsTimer.stop();
+    m_dPtr->updateChangeFilterSavings();
     emit sigDatabaseUnloaded();
 
     // set database file name empty
@@ -740,6 +1555,7 @@ void DatabaseLogger::closeDatabase()
     emit sigSendEvent(new VeinEvent::CommandEvent(VeinEvent::CommandEvent::EventSubtype::NOTIFICATION, customerCData));
 
     m_dPtr->updateDBStorageInfo();
+    m_dPtr->updateStorageMonitorInfo(QVariantMap({{"timeToFull", -1}, {"ingestRate", 0}}));
 
     qCDebug(VEIN_LOGGER) << "Unloaded database:" << closedDb;
 }
@@ -754,6 +1570,9 @@ void DatabaseLogger::checkDatabaseStillValid()
 
 void DatabaseLogger::updateSessionList(QStringList p_sessions)
 {
+    //sessions queued but not in the list yet are queued again, the database skips existing ones
+    m_dPtr->m_queuedSessions = QSet<QString>(p_sessions.constBegin(), p_sessions.constEnd());
+    m_dPtr->m_existingSessions = p_sessions;
     VeinComponent::ComponentData *exisitingSessions = new VeinComponent::ComponentData();
     exisitingSessions ->setEntityId(m_dPtr->m_entityId);
     exisitingSessions ->setCommand(VeinComponent::ComponentData::Command::CCMD_SET);
@@ -766,14 +1585,33 @@ void DatabaseLogger::updateSessionList(QStringList p_sessions)
 }
 
 QVariant DatabaseLogger::RPC_deleteSession(QVariantMap p_parameters){
+    QVariantMap sessionsParameters;
+    sessionsParameters.insert("p_sessions", QStringList(p_parameters["p_session"].toString()));
+    return RPC_deleteSessions(sessionsParameters);
+}
+
+QVariant DatabaseLogger::RPC_deleteSessions(QVariantMap p_parameters){
     QVariant retVal;
-    QString session = p_parameters["p_session"].toString();
-    retVal=m_dPtr->m_database->deleteSession(session);
+    QStringList sessions = p_parameters["p_sessions"].toStringList();
+    if(m_dPtr->m_database != nullptr) {
+        //writes only run on the database thread, the event thread does not wait for it: the result is checked against
+        //the session list here, progress and failures are published in the SessionDeletion component
+        bool known = false;
+        for(const QString &session : sessions) {
+            known = known || m_dPtr->m_existingSessions.contains(session);
+            m_dPtr->m_queuedSessions.remove(session);
+        }
+        if(known) {
+            AbstractLoggerDB *database = m_dPtr->m_database;
+            QMetaObject::invokeMethod(database, [database, sessions]() { database->deleteSessions(sessions); }, Qt::QueuedConnection);
+        }
+        retVal = known;
+    }
 
     // check if deleted session is current Session and if it is set sessionName empty
     // We will not check retVal here. If something goes wrong and the session is still availabel the
     // user can choose it again without risking undefined behavior.
-    if(session == m_dPtr->m_sessionName){
+    if(sessions.contains(m_dPtr->m_sessionName)){
         VeinComponent::ComponentData *sessionNameCData = new VeinComponent::ComponentData();
         sessionNameCData ->setEntityId(m_dPtr->m_entityId);
         sessionNameCData ->setCommand(VeinComponent::ComponentData::Command::CCMD_SET);
@@ -787,6 +1625,21 @@ QVariant DatabaseLogger::RPC_deleteSession(QVariantMap p_parameters){
     return retVal;
 }
 
+QVariant DatabaseLogger::RPC_convertToIncrementalVacuum(QVariantMap p_parameters){
+    Q_UNUSED(p_parameters)
+    QVariant retVal = false;
+    if(loggingEnabled()) {
+        //VACUUM blocks the database thread for the whole file, values would pile up meanwhile
+        qCWarning(VEIN_LOGGER) << "RPC_convertToIncrementalVacuum is refused while logging is enabled";
+    }
+    else if(m_dPtr->m_database != nullptr) {
+        AbstractLoggerDB *database = m_dPtr->m_database;
+        QMetaObject::invokeMethod(database, [database]() { database->convertToIncrementalVacuum(); }, Qt::QueuedConnection);
+        retVal = true;
+    }
+    return retVal;
+}
+
 QVariant DatabaseLogger::RPC_readSessionComponent(QVariantMap p_parameters){
     QVariant retVal;
     QString session = p_parameters["p_session"].toString();
@@ -801,11 +1654,109 @@ QVariant DatabaseLogger::RPC_readSessionComponent(QVariantMap p_parameters){
 QVariant DatabaseLogger::RPC_readTransaction(QVariantMap p_parameters){
     QString session = p_parameters["p_session"].toString();
     QString transaction = p_parameters["p_transaction"].toString();
-    QJsonDocument retVal;
+    QString format = p_parameters["p_format"].toString();
+    QByteArray retVal;
+    const bool databaseReady = m_dPtr->m_stateMachine.configuration().contains(m_dPtr->m_databaseReadyState);
+    QElapsedTimer encodeTimer;
+    encodeTimer.start();
+    if(format.isEmpty() || format == QLatin1String("json")) {
+        QJsonDocument jsonDoc;
+        if(databaseReady){
+            jsonDoc=m_dPtr->m_database->readTransaction(transaction,session);
+        }
+        retVal = jsonDoc.toJson();
+    }
+    else if(format == QLatin1String("cbor") || format == QLatin1String("cbor+zlib")) {
+        QCborMap columns;
+        if(databaseReady){
+            columns=m_dPtr->m_database->readTransactionColumns(transaction,session);
+        }
+        retVal = columns.toCborValue().toCbor();
+        if(format == QLatin1String("cbor+zlib")) {
+            retVal = qCompress(retVal);
+        }
+    }
+    else {
+        //not reached through processEvent, which answers unknown formats with RPC_EINVAL
+        qCWarning(VEIN_LOGGER) << "RPC_readTransaction: unknown format" << format;
+        return QVariant();
+    }
+    vCDebug(VEIN_LOGGER) << "RPC_readTransaction" << session << transaction << "format:" << (format.isEmpty() ? QString("json") : format)
+                         << "bytes:" << retVal.size() << "ms:" << encodeTimer.elapsed();
+    return QVariant::fromValue(retVal);
+}
+
+QVariant DatabaseLogger::RPC_openTransactionCursor(QVariantMap p_parameters){
+    QString session = p_parameters["p_session"].toString();
+    QString transaction = p_parameters["p_transaction"].toString();
+    int pageSize = p_parameters["p_pageSize"].toInt();
+    QJsonObject retVal;
     if(m_dPtr->m_stateMachine.configuration().contains(m_dPtr->m_databaseReadyState)){
-        retVal=m_dPtr->m_database->readTransaction(transaction,session);
+        const QString cursorId = m_dPtr->openTransactionCursor(transaction, session, pageSize);
+        if(cursorId.isEmpty() == false) {
+            retVal = m_dPtr->readTransactionPage(cursorId, 0, 0);
+        }
+    }
+    return QVariant::fromValue(QJsonDocument(retVal).toJson(QJsonDocument::Compact));
+}
+
+QVariant DatabaseLogger::RPC_readTransactionPage(QVariantMap p_parameters){
+    //token format: <cursor id>:<transaction index>:<last value id>
+    const QStringList token = p_parameters["p_cursor"].toString().split(':');
+    QJsonObject retVal;
+    if(token.size() == 3 && m_dPtr->m_stateMachine.configuration().contains(m_dPtr->m_databaseReadyState)){
+        bool indexOk = false;
+        bool valueIdOk = false;
+        const int transactionIndex = token.at(1).toInt(&indexOk);
+        const qint64 afterValueId = token.at(2).toLongLong(&valueIdOk);
+        if(indexOk && valueIdOk && transactionIndex >= 0) {
+            retVal = m_dPtr->readTransactionPage(token.at(0), transactionIndex, afterValueId);
+        }
+    }
+    return QVariant::fromValue(QJsonDocument(retVal).toJson(QJsonDocument::Compact));
+}
+
+QVariant DatabaseLogger::RPC_readTrend(QVariantMap p_parameters){
+    const QString session = p_parameters["p_session"].toString();
+    const QString transaction = p_parameters["p_transaction"].toString();
+    const QString entity = p_parameters["p_entity"].toString();
+    const QString component = p_parameters["p_component"].toString();
+    const int resolutionMs = p_parameters["p_resolution"].toInt();
+    QJsonObject retVal;
+    if(resolutionMs > 0 && m_dPtr->m_stateMachine.configuration().contains(m_dPtr->m_databaseReadyState)){
+        QElapsedTimer readTimer;
+        readTimer.start();
+        retVal = m_dPtr->m_database->readTrend(transaction, session, entity, component, qint64(resolutionMs) * 1000);
+        vCDebug(VEIN_LOGGER) << "RPC_readTrend" << session << transaction << entity << component << "resolution:" << resolutionMs
+                             << "source:" << retVal.value("source").toString() << "buckets:" << retVal.value("bucket_start").toArray().size() << "ms:" << readTimer.elapsed();
+    }
+    return QVariant::fromValue(QJsonDocument(retVal).toJson(QJsonDocument::Compact));
+}
+
+QVariant DatabaseLogger::RPC_readRange(QVariantMap p_parameters){
+    const QString session = p_parameters["p_session"].toString();
+    const QString entity = p_parameters["p_entity"].toString();
+    const QString component = p_parameters["p_component"].toString();
+    int maxPoints = p_parameters["p_maxPoints"].toInt();
+    if(maxPoints <= 0) {
+        maxPoints = DataLoggerPrivate::s_defaultRangePoints;
+    }
+    maxPoints = qMin(maxPoints, DataLoggerPrivate::s_maxRangePoints);
+    qint64 fromUs = 0;
+    qint64 toUs = 0;
+    QJsonObject retVal;
+    if(DataLoggerPrivate::readTimestampParameter(p_parameters["p_from"], std::numeric_limits<qint64>::min(), fromUs) == false
+            || DataLoggerPrivate::readTimestampParameter(p_parameters["p_to"], std::numeric_limits<qint64>::max(), toUs) == false) {
+        qCWarning(VEIN_LOGGER) << "RPC_readRange: invalid time range" << p_parameters["p_from"] << p_parameters["p_to"];
+    }
+    else if(m_dPtr->m_stateMachine.configuration().contains(m_dPtr->m_databaseReadyState)){
+        QElapsedTimer readTimer;
+        readTimer.start();
+        retVal = m_dPtr->m_database->readRange(session, entity, component, fromUs, toUs, maxPoints);
+        vCDebug(VEIN_LOGGER) << "RPC_readRange" << session << entity << component << "values:" << retVal.value("count").toInt()
+                             << "points:" << retVal.value("value_timestamp").toArray().size() << "ms:" << readTimer.elapsed();
     }
-    return QVariant::fromValue(retVal.toJson());
+    return QVariant::fromValue(QJsonDocument(retVal).toJson(QJsonDocument::Compact));
 }
 
 bool DatabaseLogger::processEvent(QEvent *t_event)
@@ -824,8 +1775,6 @@ bool DatabaseLogger::processEvent(QEvent *t_event)
         evData = cEvent->eventData();
         Q_ASSERT(evData != nullptr);
 
-        const QSet<QAbstractState*> activeStates = m_dPtr->m_stateMachine.configuration();
-        const QSet<QAbstractState*> requiredStates = {m_dPtr->m_loggingEnabledState, m_dPtr->m_databaseReadyState};
         if(evData->type()==ComponentData::dataType()) {
 
             ComponentData *cData=nullptr;
@@ -841,31 +1790,20 @@ bool DatabaseLogger::processEvent(QEvent *t_event)
                     setLoggingEnabled(cData->newValue().toBool());
                 }
 
-                if(activeStates.contains(requiredStates)) {
-                    QString sessionName = "";
-                    QVector<int> transactionIds;
-                    const QVector<QmlLogger *> scripts = m_dPtr->m_loggerScripts;
-                    //check all scripts if they want to log the changed value
-                    for(const QmlLogger *entry : scripts) {
-                        if(entry->isLoggedComponent(evData->entityId(), cData->componentName())) {
-                            sessionName = entry->sessionName();
-                            transactionIds.append(entry->getTransactionId());
-                        }
-                    }
-
-                    if(sessionName.length() > 0)
+                if(m_dPtr->m_loggingActive.load()) {
+                    //most events are not logged: the index rejects them without allocating
+                    const SubscriptionIndex::Subscription *subscription = m_dPtr->m_subscriptionIndex.find(evData->entityId(), cData->componentName());
+                    if(subscription != nullptr && subscription->sessionName.length() > 0)
                     {
-                        if(m_dPtr->m_database->hasSessionName(sessionName) == false) {
-                            emit sigAddSession(sessionName,QList<QVariantMap>());
-                        }
-                        if(m_dPtr->m_database->hasEntityId(evData->entityId()) == false) {
-                            emit sigAddEntity(evData->entityId(), m_dPtr->m_dataSource->getEntityName(cData->entityId()));
-                        }
-                        if(m_dPtr->m_database->hasComponentName(cData->componentName()) == false) {
-                            emit sigAddComponent(cData->componentName());
+                        const QString &sessionName = subscription->sessionName;
+                        const QVector<int> &transactionIds = subscription->transactionIds;
+                        if(m_dPtr->m_queuedSessions.contains(sessionName) == false) {
+                            m_dPtr->queueSession(sessionName, QList<QVariantMap>());
                         }
+                        m_dPtr->queueEntity(evData->entityId());
+                        m_dPtr->queueComponent(cData->componentName());
                         if(transactionIds.length() != 0) {
-                            emit sigAddLoggedValue(sessionName, transactionIds, cData->entityId(), cData->componentName(), cData->newValue(), QDateTime::currentDateTime());
+                            m_dPtr->queueLoggedValue(sessionName, transactionIds, cData->entityId(), cData->componentName(), cData->newValue(), m_dPtr->m_clock.nowUs());
                         }
                         retVal = true;
                     }
@@ -935,7 +1873,7 @@ bool DatabaseLogger::processEvent(QEvent *t_event)
                             m_dPtr->m_scheduledLoggingDuration = logDurationMsecs;
                             if(logDurationMsecs > 0) {
                                 m_dPtr->m_schedulingTimer.setInterval(logDurationMsecs);
-                                if(activeStates.contains(requiredStates)) {
+                                if(m_dPtr->m_loggingActive.load()) {
                                     m_dPtr->m_schedulingTimer.start(); //restart timer
                                 }
                                 VeinComponent::ComponentData *schedulingDurationData = new VeinComponent::ComponentData();
@@ -963,6 +1901,93 @@ bool DatabaseLogger::processEvent(QEvent *t_event)
                             sigSendEvent(new VeinEvent::CommandEvent(VeinEvent::CommandEvent::EventSubtype::NOTIFICATION, errData));
                         }
                     }
+                    else if(cData->componentName() == DataLoggerPrivate::s_durabilityProfileComponentName) {
+                        AbstractLoggerDB::DURABILITY_PROFILE profile;
+                        if(AbstractLoggerDB::durabilityProfileFromName(cData->newValue().toString(), profile)) {
+                            retVal = true;
+                            if(profile != m_dPtr->m_durabilityProfile) {
+                                m_dPtr->m_durabilityProfile = profile;
+                                if(m_dPtr->m_database != nullptr) {
+                                    //the pragmas have to run in the database thread
+                                    AbstractLoggerDB *database = m_dPtr->m_database;
+                                    QMetaObject::invokeMethod(database, [database, profile]() { database->setDurabilityProfile(profile); }, Qt::QueuedConnection);
+                                }
+                            }
+                            VeinComponent::ComponentData *durabilityProfileCData = new VeinComponent::ComponentData();
+                            durabilityProfileCData->setEntityId(m_dPtr->m_entityId);
+                            durabilityProfileCData->setCommand(VeinComponent::ComponentData::Command::CCMD_SET);
+                            durabilityProfileCData->setComponentName(DataLoggerPrivate::s_durabilityProfileComponentName);
+                            durabilityProfileCData->setNewValue(AbstractLoggerDB::durabilityProfileName(profile));
+                            durabilityProfileCData->setEventOrigin(VeinEvent::EventData::EventOrigin::EO_LOCAL);
+                            durabilityProfileCData->setEventTarget(VeinEvent::EventData::EventTarget::ET_ALL);
+
+                            emit sigSendEvent(new VeinEvent::CommandEvent(VeinEvent::CommandEvent::EventSubtype::NOTIFICATION, durabilityProfileCData));
+                        }
+                        else {
+                            VeinComponent::ErrorData *errData = new VeinComponent::ErrorData();
+                            errData->setEntityId(m_dPtr->m_entityId);
+                            errData->setOriginalData(cData);
+                            errData->setEventOrigin(VeinComponent::ErrorData::EventOrigin::EO_LOCAL);
+                            errData->setEventTarget(VeinComponent::ErrorData::EventTarget::ET_ALL);
+                            errData->setErrorDescription(QString("Invalid durability profile: %1").arg(cData->newValue().toString()));
+
+                            sigSendEvent(new VeinEvent::CommandEvent(VeinEvent::CommandEvent::EventSubtype::NOTIFICATION, errData));
+                        }
+                    }
+                    else if(cData->componentName() == DataLoggerPrivate::s_flushMaxRowsComponentName
+                            || cData->componentName() == DataLoggerPrivate::s_flushMaxBytesComponentName
+                            || cData->componentName() == DataLoggerPrivate::s_flushMaxAgeComponentName
+                            || cData->componentName() == DataLoggerPrivate::s_commitBudgetComponentName
+                            || cData->componentName() == DataLoggerPrivate::s_journalSyncIntervalComponentName) {
+                        bool conversionOk = false;
+                        const qint64 limit = cData->newValue().toLongLong(&conversionOk);
+                        //a journal sync interval of 0 switches the journal off
+                        const qint64 minLimit = cData->componentName() == DataLoggerPrivate::s_journalSyncIntervalComponentName ? 0 : 1;
+                        if(conversionOk && limit >= minLimit && (cData->componentName() == DataLoggerPrivate::s_flushMaxBytesComponentName || limit <= std::numeric_limits<int>::max())) {
+                            retVal = true;
+                            AbstractLoggerDB::FlushPolicy policy = m_dPtr->m_flushPolicy;
+                            if(cData->componentName() == DataLoggerPrivate::s_flushMaxRowsComponentName) {
+                                policy.maxRows = int(limit);
+                            }
+                            else if(cData->componentName() == DataLoggerPrivate::s_flushMaxBytesComponentName) {
+                                policy.maxBytes = limit;
+                            }
+                            else if(cData->componentName() == DataLoggerPrivate::s_flushMaxAgeComponentName) {
+                                policy.maxAgeMs = int(limit);
+                            }
+                            else if(cData->componentName() == DataLoggerPrivate::s_commitBudgetComponentName) {
+                                policy.commitBudgetMs = int(limit);
+                            }
+                            else {
+                                policy.journalSyncMs = int(limit);
+                            }
+                            m_dPtr->m_flushPolicy = policy;
+                            if(m_dPtr->m_database != nullptr) {
+                                //the flush scheduler lives in the database thread
+                                AbstractLoggerDB *database = m_dPtr->m_database;
+                                QMetaObject::invokeMethod(database, [database, policy]() { database->setFlushPolicy(policy); }, Qt::QueuedConnection);
+                            }
+                            VeinComponent::ComponentData *flushPolicyCData = new VeinComponent::ComponentData();
+                            flushPolicyCData->setEntityId(m_dPtr->m_entityId);
+                            flushPolicyCData->setCommand(VeinComponent::ComponentData::Command::CCMD_SET);
+                            flushPolicyCData->setComponentName(cData->componentName());
+                            flushPolicyCData->setNewValue(limit);
+                            flushPolicyCData->setEventOrigin(VeinEvent::EventData::EventOrigin::EO_LOCAL);
+                            flushPolicyCData->setEventTarget(VeinEvent::EventData::EventTarget::ET_ALL);
+
+                            emit sigSendEvent(new VeinEvent::CommandEvent(VeinEvent::CommandEvent::EventSubtype::NOTIFICATION, flushPolicyCData));
+                        }
+                        else {
+                            VeinComponent::ErrorData *errData = new VeinComponent::ErrorData();
+                            errData->setEntityId(m_dPtr->m_entityId);
+                            errData->setOriginalData(cData);
+                            errData->setEventOrigin(VeinComponent::ErrorData::EventOrigin::EO_LOCAL);
+                            errData->setEventTarget(VeinComponent::ErrorData::EventTarget::ET_ALL);
+                            errData->setErrorDescription(QString("Invalid %1: %2").arg(cData->componentName()).arg(cData->newValue().toString()));
+
+                            sigSendEvent(new VeinEvent::CommandEvent(VeinEvent::CommandEvent::EventSubtype::NOTIFICATION, errData));
+                        }
+                    }
                     // TODO: Add more from modulemanager
                     else if(cData->componentName() == DataLoggerPrivate::s_sessionNameComponentName) {
                         VeinComponent::ComponentData *sessionNameCData = new VeinComponent::ComponentData();
@@ -990,11 +2015,12 @@ bool DatabaseLogger::processEvent(QEvent *t_event)
                                 m_dPtr->m_database &&
                                 m_dPtr->m_database->databaseIsOpen()){
 
-                            if(!m_dPtr->m_database->hasSessionName(sessionName)) {
+                            if(m_dPtr->m_queuedSessions.contains(sessionName) == false) {
                                 // Add session immediately: That helps us massively to create a smart user-interface
 
                                 QMultiHash<int, QString> tmpStaticComps;
                                 QList<QVariantMap> tmpStaticData;
+                                const qint64 timestamp = m_dPtr->m_clock.nowUs();
 
                                 // Add customer data at the beginning
                                 if(m_dPtr->m_dataSource->hasEntity(200)) {
@@ -1011,26 +2037,22 @@ bool DatabaseLogger::processEvent(QEvent *t_event)
                                 }
 
                                 for(const int tmpEntityId : tmpStaticComps.uniqueKeys()) { //only process once for every entity
-                                    if(m_dPtr->m_database->hasEntityId(tmpEntityId) == false) { // already in db?
-                                        emit sigAddEntity(tmpEntityId, m_dPtr->m_dataSource->getEntityName(tmpEntityId));
-                                    }
+                                    m_dPtr->queueEntity(tmpEntityId);
                                     const QList<QString> tmpComponents = tmpStaticComps.values(tmpEntityId);
                                     for(const QString &tmpComponentName : tmpComponents) {
-                                        if(m_dPtr->m_database->hasComponentName(tmpComponentName) == false) {
-                                            emit sigAddComponent(tmpComponentName);
-                                        }
+                                        m_dPtr->queueComponent(tmpComponentName);
                                         QVariantMap tmpMap;
                                         tmpMap["entityId"]=tmpEntityId;
                                         tmpMap["compName"]=tmpComponentName;
                                         tmpMap["value"]=m_dPtr->m_dataSource->getValue(tmpEntityId, tmpComponentName);
-                                        tmpMap["time"]=QDateTime::currentDateTime();
+                                        tmpMap["time"]=timestamp;
                                         tmpStaticData.append(tmpMap);
                                     }
                                 }
 
                                 // We are reading it like this because it is faster than writing it to the db and then reading it agian
                                 customerCData->setNewValue(m_dPtr->m_dataSource->getValue(200, "FileSelected"));
-                                emit sigAddSession(sessionName,tmpStaticData);
+                                m_dPtr->queueSession(sessionName, tmpStaticData);
                             }else{
                                 QString customerdata=m_dPtr->m_database->readSessionComponent(sessionName,"CustomerData","FileSelected").toString();
                                 customerCData->setNewValue(customerdata);
@@ -1097,7 +2119,26 @@ bool DatabaseLogger::processEvent(QEvent *t_event)
             if(rpcData->command() == VeinComponent::RemoteProcedureData::Command::RPCMD_CALL){
                 if(m_dPtr->m_rpcList.contains(rpcData->procedureName())){
                     const QUuid callId = rpcData->invokationData().value(VeinComponent::RemoteProcedureData::s_callIdString).toUuid();
-                    m_dPtr->m_rpcList[rpcData->procedureName()]->callFunction(callId,cEvent->peerId(),rpcData->invokationData());
+                    const QString parameterError = DataLoggerPrivate::rpcParameterError(rpcData->procedureName(), rpcData->invokationData().value(VeinComponent::RemoteProcedureData::s_parameterString).toMap());
+                    if(parameterError.isEmpty()) {
+                        m_dPtr->m_rpcList[rpcData->procedureName()]->callFunction(callId,cEvent->peerId(),rpcData->invokationData());
+                    }
+                    else {
+                        qCWarning(VEIN_LOGGER) << rpcData->procedureName() << parameterError;
+                        QVariantMap resultData = rpcData->invokationData();
+                        resultData.insert(VeinComponent::RemoteProcedureData::s_resultCodeString, static_cast<int>(VeinComponent::RemoteProcedureData::RPCResultCodes::RPC_EINVAL));
+                        resultData.insert(VeinComponent::RemoteProcedureData::s_errorMessageString, parameterError);
+                        VeinComponent::RemoteProcedureData *resultRpcData = new VeinComponent::RemoteProcedureData();
+                        resultRpcData->setEntityId(m_dPtr->m_entityId);
+                        resultRpcData->setCommand(VeinComponent::RemoteProcedureData::Command::RPCMD_RESULT);
+                        resultRpcData->setProcedureName(rpcData->procedureName());
+                        resultRpcData->setInvokationData(resultData);
+                        resultRpcData->setEventOrigin(VeinEvent::EventData::EventOrigin::EO_LOCAL);
+                        resultRpcData->setEventTarget(VeinEvent::EventData::EventTarget::ET_ALL);
+                        VeinEvent::CommandEvent *resultEvent = new VeinEvent::CommandEvent(VeinEvent::CommandEvent::EventSubtype::NOTIFICATION, resultRpcData);
+                        resultEvent->setPeerId(cEvent->peerId());
+                        emit sigSendEvent(resultEvent);
+                    }
                     cEvent->accept();
                 }else if(!cEvent->isAccepted()){
                     retVal = true;
@@ -50,20 +50,6 @@ public:
     QString entityName() const;
 
 signals:
-    /**
-     * @brief sigAddLoggedValue
-     * @param t_sessionName: used session Name
-     * @param t_transactionIds: sql id of transaction
-     * @param t_entityId: sql entity id of value
-     * @param t_componentName: sql component id of value
-     * @param t_value: value: itself
-     * @param t_timestamp: time the value change occured
-     */
-    void sigAddLoggedValue(QString t_sessionName, QVector<int> t_transactionIds, int t_entityId, const QString &t_componentName, QVariant t_value, QDateTime t_timestamp);
-    void sigAddEntity(int t_entityId, const QString &t_entityName);
-    void sigAddComponent(const QString &t_componentName);
-    void sigAddSession(const QString &t_sessionName,QList<QVariantMap> p_staticData);
-
     void sigOpenDatabase(const QString &t_filePath);
 
     void sigDatabaseError(const QString &t_errorString);
@@ -79,9 +65,73 @@ public slots:
     virtual bool openDatabase(const QString &t_filePath);
     virtual void closeDatabase();
     virtual void checkDatabaseStillValid();
+    /**
+     * @brief RPC_deleteSession
+     * @param p_parameters: p_session
+     * @return same as RPC_deleteSessions: true once the session is queued for deletion, not when its rows are gone
+     */
     QVariant RPC_deleteSession(QVariantMap p_parameters);
+    /**
+     * @brief RPC_deleteSessions
+     * @param p_parameters: p_sessions
+     * @return true if at least one of the sessions exists, it is deleted in the background.
+     * Progress and failures are published in the component SessionDeletion.
+     */
+    QVariant RPC_deleteSessions(QVariantMap p_parameters);
+    /**
+     * @brief RPC_readTransaction
+     * @param p_parameters: p_session, p_transaction, p_format (optional, registered as RPC with and without it)
+     * @return all records of the transaction encoded as selected by p_format:
+     * - "json", empty or no p_format: JSON array with one object per record
+     * - "cbor": columnar CBOR map, see AbstractLoggerDB::readTransactionColumns
+     * - "cbor+zlib": "cbor" compressed with qCompress (4 byte big endian size header + zlib stream)
+     *
+     * Other formats are answered with RPC_EINVAL and an error message.
+     */
     QVariant RPC_readTransaction(QVariantMap p_parameters);
     QVariant RPC_readSessionComponent(QVariantMap p_parameters);
+    /**
+     * @brief RPC_convertToIncrementalVacuum
+     * @param p_parameters: none
+     * @return false while logging is enabled or no database is open, true if the conversion is queued
+     *
+     * One time conversion of a database created without auto vacuum, so the pages of deleted sessions are
+     * returned to the file system. It rewrites the whole database file, the result is logged and
+     * DatabaseReclaimableSize is updated afterwards.
+     */
+    QVariant RPC_convertToIncrementalVacuum(QVariantMap p_parameters);
+    /**
+     * @brief RPC_openTransactionCursor
+     * @param p_parameters: p_session, p_transaction, p_pageSize (<= 0 for the default)
+     * @return first page as JSON object {"cursor": continuation token, "records": [...], "done": bool}
+     *
+     * The cursor covers the values stored when it was opened. The cursor is closed with the last page
+     * or after 60 s without a read. An unknown or expired cursor returns an empty object.
+     */
+    QVariant RPC_openTransactionCursor(QVariantMap p_parameters);
+    /**
+     * @brief RPC_readTransactionPage
+     * @param p_parameters: p_cursor, the continuation token of the previous page
+     * @return next page, same format as RPC_openTransactionCursor
+     *
+     * A token can be read again, e.g. when the reply got lost.
+     */
+    QVariant RPC_readTransactionPage(QVariantMap p_parameters);
+    /**
+     * @brief RPC_readTrend
+     * @param p_parameters: p_session, p_transaction, p_entity, p_component (names), p_resolution (ms, > 0)
+     * @return JSON object with the numbers of the component aggregated per p_resolution, see AbstractLoggerDB::readTrend
+     *
+     * Whole minutes and seconds are read from the rollup tables, so the time does not grow with the length of the recording.
+     */
+    QVariant RPC_readTrend(QVariantMap p_parameters);
+    /**
+     * @brief RPC_readRange
+     * @param p_parameters: p_session, p_entity, p_component (names), p_from, p_to (UTC microseconds since epoch or ISO 8601,
+     * empty for an open end), p_maxPoints (<= 0 for the default of 1000)
+     * @return JSON object with the numbers of the component in the range, at most p_maxPoints, see AbstractLoggerDB::readRange
+     */
+    QVariant RPC_readRange(QVariantMap p_parameters);
     /**
      * @brief updateSessionList
      * @param p_sessions: list of sessions stored in open database
@@ -0,0 +1,324 @@
+#include "vl_downsampler.h"
+
+#include <QSet>
+#include <QSequentialIterable>
+
+#include <limits>
+
+namespace VeinLogger
+{
+//constexpr definition, see: https://stackoverflow.com/questions/8016780/undefined-reference-to-static-constexpr-char
+constexpr int Downsampler::s_minFlushIntervalMs;
+
+QString Downsampler::aggregationName(Aggregation t_aggregation)
+{
+    switch(t_aggregation) {
+    case Aggregation::LAST:
+        return QStringLiteral("last");
+    case Aggregation::MEAN:
+        return QStringLiteral("mean");
+    case Aggregation::MIN:
+        return QStringLiteral("min");
+    case Aggregation::MAX:
+        return QStringLiteral("max");
+    default:
+        return QStringLiteral("all");
+    }
+}
+
+bool Downsampler::aggregationFromName(const QString &t_name, Aggregation &t_aggregation)
+{
+    for(const Aggregation aggregation : {Aggregation::LAST, Aggregation::MEAN, Aggregation::MIN, Aggregation::MAX, Aggregation::ALL}) {
+        if(t_name == aggregationName(aggregation)) {
+            t_aggregation = aggregation;
+            return true;
+        }
+    }
+    return false;
+}
+
+QVariantMap Downsampler::addTransaction(int t_transactionId, const QMultiHash<int, QVariant> &t_entitySettings)
+{
+    QHash<int, Settings> entitySettings;
+    QSet<int> fullRateEntities;
+    for(auto iter = t_entitySettings.constBegin(); iter != t_entitySettings.constEnd(); ++iter) {
+        Settings settings;
+        if(readSettings(iter.value(), settings) == false) {
+            fullRateEntities.insert(iter.key());
+            continue;
+        }
+        auto settingsIter = entitySettings.find(iter.key());
+        if(settingsIter == entitySettings.end() || settings.intervalUs < settingsIter->intervalUs) {
+            entitySettings.insert(iter.key(), settings);
+        }
+    }
+    for(const int entityId : qAsConst(fullRateEntities)) {
+        entitySettings.remove(entityId);
+    }
+
+    removeTransaction(t_transactionId);
+    QVariantMap retVal;
+    if(entitySettings.isEmpty() == false) {
+        for(auto iter = entitySettings.constBegin(); iter != entitySettings.constEnd(); ++iter) {
+            QVariantMap metadata;
+            metadata.insert("maxRate", 1.0e6 / iter->intervalUs);
+            metadata.insert("aggregation", aggregationName(iter->aggregation));
+            retVal.insert(QString::number(iter.key()), metadata);
+        }
+        m_transactions.insert(t_transactionId, entitySettings);
+    }
+    return retVal;
+}
+
+void Downsampler::removeTransaction(int t_transactionId)
+{
+    const auto transactionIter = m_transactions.constFind(t_transactionId);
+    if(transactionIter == m_transactions.constEnd()) {
+        return;
+    }
+    for(auto iter = m_windows.begin(); iter != m_windows.end();) {
+        if(iter.key().transactionId == t_transactionId) {
+            if(iter->count > 0) {
+                store(iter.key(), iter.value(), transactionIter->value(iter.key().entityId), iter->lastValueUs);
+            }
+            iter = m_windows.erase(iter);
+        }
+        else {
+            ++iter;
+        }
+    }
+    m_transactions.remove(t_transactionId);
+}
+
+void Downsampler::clear()
+{
+    m_transactions.clear();
+    m_windows.clear();
+    m_aggregates.clear();
+}
+
+bool Downsampler::isActive() const
+{
+    return m_transactions.isEmpty() == false;
+}
+
+const QVector<int> &Downsampler::process(const QString &t_sessionName, const QVector<int> &t_transactionIds, int t_entityId, const QString &t_componentName, const QVariant &t_value, qint64 t_timestampUs)
+{
+    m_passThrough.clear();
+    bool downsampled = false;
+    for(const int transactionId : t_transactionIds) {
+        const Settings *settings = nullptr;
+        const auto transactionIter = m_transactions.constFind(transactionId);
+        if(transactionIter != m_transactions.constEnd()) {
+            const auto entityIter = transactionIter->constFind(t_entityId);
+            if(entityIter != transactionIter->constEnd()) {
+                settings = &entityIter.value();
+            }
+        }
+        if(settings == nullptr) {
+            m_passThrough.append(transactionId);
+            continue;
+        }
+
+        downsampled = true;
+        const ValueKey key{transactionId, t_entityId, t_componentName};
+        Window &window = m_windows[key];
+        window.sessionName = t_sessionName;
+        accumulate(window, t_value, t_timestampUs);
+        if(window.lastStoredUs < 0 || t_timestampUs - window.lastStoredUs >= settings->intervalUs) {
+            store(key, window, *settings, t_timestampUs);
+        }
+    }
+    return downsampled ? m_passThrough : t_transactionIds;
+}
+
+void Downsampler::flushDue(qint64 t_nowUs)
+{
+    for(auto iter = m_windows.begin(); iter != m_windows.end(); ++iter) {
+        if(iter->count > 0) {
+            const Settings settings = m_transactions.value(iter.key().transactionId).value(iter.key().entityId);
+            if(t_nowUs - iter->lastStoredUs >= settings.intervalUs) {
+                //the window ends now, the next value starts a new one
+                store(iter.key(), iter.value(), settings, t_nowUs);
+            }
+        }
+    }
+}
+
+void Downsampler::flush()
+{
+    for(auto iter = m_windows.begin(); iter != m_windows.end(); ++iter) {
+        if(iter->count > 0) {
+            store(iter.key(), iter.value(), m_transactions.value(iter.key().transactionId).value(iter.key().entityId), iter->lastValueUs);
+        }
+    }
+}
+
+QVector<Downsampler::Aggregate> Downsampler::takeAggregates()
+{
+    QVector<Aggregate> retVal;
+    retVal.swap(m_aggregates);
+    return retVal;
+}
+
+int Downsampler::flushIntervalMs() const
+{
+    qint64 retVal = std::numeric_limits<int>::max();
+    for(const QHash<int, Settings> &entitySettings : m_transactions) {
+        for(const Settings &settings : entitySettings) {
+            retVal = qMin(retVal, settings.intervalUs / 1000);
+        }
+    }
+    return int(qMax(retVal, qint64(s_minFlushIntervalMs)));
+}
+
+bool Downsampler::readSettings(const QVariant &t_config, Settings &t_settings)
+{
+    if(t_config.canConvert<QVariantMap>() == false) {
+        return false;
+    }
+    const QVariantMap config = t_config.toMap();
+    const double maxRate = config.value("MaxRate", 0.0).toDouble();
+    if(maxRate <= 0.0) {
+        return false;
+    }
+    t_settings.intervalUs = qMax(qint64(1.0e6 / maxRate), qint64(1));
+    t_settings.aggregation = Aggregation::ALL;
+    if(config.contains("Aggregation") && aggregationFromName(config.value("Aggregation").toString(), t_settings.aggregation) == false) {
+        qCWarning(VEIN_LOGGER) << "Unknown downsampling aggregation" << config.value("Aggregation") << "using" << aggregationName(t_settings.aggregation);
+    }
+    return true;
+}
+
+bool Downsampler::readNumbers(const QVariant &t_value, QVector<double> &t_numbers, bool &t_scalar)
+{
+    t_numbers.clear();
+    const int dataType = t_value.userType();
+    switch(dataType) {
+    case QMetaType::Double:
+    case QMetaType::Float:
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+        t_scalar = true;
+        t_numbers.append(t_value.toDouble());
+        return true;
+    default:
+        break;
+    }
+    t_scalar = false;
+    if(dataType == qMetaTypeId<QList<double> >()) {
+        for(const double number : t_value.value<QList<double> >()) {
+            t_numbers.append(number);
+        }
+        return true;
+    }
+    if(dataType == qMetaTypeId<QList<float> >()) {
+        for(const float number : t_value.value<QList<float> >()) {
+            t_numbers.append(number);
+        }
+        return true;
+    }
+    if(dataType == qMetaTypeId<QList<int> >()) {
+        for(const int number : t_value.value<QList<int> >()) {
+            t_numbers.append(number);
+        }
+        return true;
+    }
+    if(dataType == QMetaType::QVariantList) {
+        for(const QVariant &element : t_value.toList()) {
+            bool isNumber = false;
+            t_numbers.append(element.toDouble(&isNumber));
+            if(isNumber == false || element.userType() == QMetaType::QString) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+void Downsampler::accumulate(Window &t_window, const QVariant &t_value, qint64 t_timestampUs)
+{
+    bool scalar = false;
+    const bool numeric = readNumbers(t_value, m_numbers, scalar);
+    if(t_window.count == 0) {
+        t_window.numeric = numeric;
+        t_window.scalar = scalar;
+        t_window.min = m_numbers;
+        t_window.max = m_numbers;
+        t_window.sum = m_numbers;
+    }
+    else if(t_window.numeric && numeric && scalar == t_window.scalar && m_numbers.size() == t_window.sum.size()) {
+        for(int index = 0; index < m_numbers.size(); ++index) {
+            const double number = m_numbers.at(index);
+            t_window.min[index] = qMin(t_window.min.at(index), number);
+            t_window.max[index] = qMax(t_window.max.at(index), number);
+            t_window.sum[index] += number;
+        }
+    }
+    else {
+        t_window.numeric = false;
+    }
+    t_window.last = t_value;
+    t_window.lastValueUs = t_timestampUs;
+    ++t_window.count;
+}
+
+void Downsampler::store(const ValueKey &t_key, Window &t_window, const Settings &t_settings, qint64 t_storedUs)
+{
+    Aggregate aggregate;
+    aggregate.sessionName = t_window.sessionName;
+    aggregate.transactionId = t_key.transactionId;
+    aggregate.entityId = t_key.entityId;
+    aggregate.componentName = t_key.componentName;
+    aggregate.timestampUs = t_window.lastValueUs;
+
+    //a single value is stored as it is, e.g. values arriving slower than the rate
+    if(t_settings.aggregation == Aggregation::LAST || t_window.numeric == false || t_window.count == 1) {
+        aggregate.value = t_window.last;
+    }
+    else {
+        QVector<double> mean = t_window.sum;
+        for(double &number : mean) {
+            number /= t_window.count;
+        }
+        switch(t_settings.aggregation) {
+        case Aggregation::MEAN:
+            aggregate.value = numbersToVariant(mean, t_window.scalar);
+            break;
+        case Aggregation::MIN:
+            aggregate.value = numbersToVariant(t_window.min, t_window.scalar);
+            break;
+        case Aggregation::MAX:
+            aggregate.value = numbersToVariant(t_window.max, t_window.scalar);
+            break;
+        default: {
+            QVariantMap aggregateMap;
+            aggregateMap.insert("min", numbersToVariant(t_window.min, t_window.scalar));
+            aggregateMap.insert("max", numbersToVariant(t_window.max, t_window.scalar));
+            aggregateMap.insert("mean", numbersToVariant(mean, t_window.scalar));
+            aggregateMap.insert("last", t_window.last);
+            aggregateMap.insert("count", t_window.count);
+            aggregate.value = aggregateMap;
+            break;
+        }
+        }
+    }
+    m_aggregates.append(aggregate);
+
+    t_window.lastStoredUs = t_storedUs;
+    t_window.count = 0;
+    t_window.last = QVariant();
+}
+
+QVariant Downsampler::numbersToVariant(const QVector<double> &t_numbers, bool t_scalar)
+{
+    if(t_scalar) {
+        return t_numbers.value(0);
+    }
+    return QVariant::fromValue(t_numbers.toList());
+}
+
+} // namespace VeinLogger
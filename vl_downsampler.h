@@ -0,0 +1,166 @@
+#ifndef VEINLOGGER_DOWNSAMPLER_H
+#define VEINLOGGER_DOWNSAMPLER_H
+
+#include "globalIncludes.h"
+#include "vl_valuekey.h"
+
+#include <QHash>
+#include <QMultiHash>
+#include <QVector>
+#include <QString>
+#include <QVariant>
+#include <QVariantMap>
+
+namespace VeinLogger
+{
+/**
+ * @brief The Downsampler class
+ *
+ * Optional streaming stage in front of the change filter: for transactions whose content sets have a
+ * "Downsampling" entry (see JsonContentSetLoader) at most "MaxRate" values per second are stored per component.
+ *
+ * A value arriving at least one interval after the last stored one is stored right away. Values arriving
+ * faster are collected in a window that is stored as one aggregate when the interval has passed,
+ * either with the next value or by flushDue() if no further value arrives.
+ *
+ * "Aggregation" selects what is stored for a window:
+ * - "last": the last value, unchanged
+ * - "mean", "min", "max": double, QList<double> element wise for number arrays
+ * - "all" (default): QVariantMap {"min", "max", "mean", "last", "count"}
+ *
+ * Windows of a single value and windows of values that are not numbers or change their array size store the last value.
+ * The timestamp of an aggregate is the one of the last value in the window.
+ */
+class Downsampler
+{
+public:
+    enum class Aggregation : int {
+        LAST = 0,
+        MEAN,
+        MIN,
+        MAX,
+        ALL,
+    };
+
+    struct Settings
+    {
+        qint64 intervalUs = 0;
+        Aggregation aggregation = Aggregation::ALL;
+    };
+
+    /**
+     * @brief The Aggregate struct
+     * A value to store for one transaction, produced by process(), flushDue() or flush()
+     */
+    struct Aggregate
+    {
+        QString sessionName;
+        int transactionId = 0;
+        int entityId = 0;
+        QString componentName;
+        QVariant value;
+        qint64 timestampUs = 0;
+    };
+
+    static QString aggregationName(Aggregation t_aggregation);
+    static bool aggregationFromName(const QString &t_name, Aggregation &t_aggregation);
+
+    /**
+     * @brief addTransaction
+     * @param t_entitySettings: see QmlLogger::readDownsampling
+     * @return entity id -> {"maxRate", "aggregation"} of the downsampled entities, stored with the transaction
+     *
+     * An entity that is also in a content set without downsampling stores every value, for several settings
+     * the highest rate is used.
+     */
+    QVariantMap addTransaction(int t_transactionId, const QMultiHash<int, QVariant> &t_entitySettings);
+    /**
+     * @brief removeTransaction
+     * The open windows of the transaction are flushed to aggregates()
+     */
+    void removeTransaction(int t_transactionId);
+    void clear();
+    /**
+     * @brief isActive
+     * @return true if any transaction is downsampled, checked first so logging every value costs nothing
+     */
+    bool isActive() const;
+
+    /**
+     * @brief process
+     * @return the transactions that store t_value unchanged: t_transactionIds itself if none is downsampled,
+     * otherwise an internal vector valid until the next call. The values for the downsampled ones are in aggregates().
+     */
+    const QVector<int> &process(const QString &t_sessionName, const QVector<int> &t_transactionIds, int t_entityId, const QString &t_componentName, const QVariant &t_value, qint64 t_timestampUs);
+    /**
+     * @brief flushDue
+     * Stores the windows whose interval has passed at t_nowUs without a new value
+     */
+    void flushDue(qint64 t_nowUs);
+    /**
+     * @brief flush
+     * Stores all open windows, e.g. before logging stops
+     */
+    void flush();
+    /**
+     * @brief takeAggregates
+     * @return the aggregates produced since the last call, the internal list is cleared
+     */
+    QVector<Aggregate> takeAggregates();
+    /**
+     * @brief flushIntervalMs
+     * @return interval to call flushDue() with, the shortest window of all transactions
+     */
+    int flushIntervalMs() const;
+
+private:
+    struct Window
+    {
+        QString sessionName;
+        /**
+         * @brief lastStoredUs
+         * -1 until the first value is stored
+         */
+        qint64 lastStoredUs = -1;
+        qint64 lastValueUs = 0;
+        int count = 0;
+        bool numeric = false;
+        bool scalar = false;
+        QVariant last;
+        QVector<double> min;
+        QVector<double> max;
+        QVector<double> sum;
+    };
+
+    static bool readSettings(const QVariant &t_config, Settings &t_settings);
+    /**
+     * @brief readNumbers
+     * @return false if t_value is neither a number nor a list of numbers
+     */
+    static bool readNumbers(const QVariant &t_value, QVector<double> &t_numbers, bool &t_scalar);
+    void accumulate(Window &t_window, const QVariant &t_value, qint64 t_timestampUs);
+    void store(const ValueKey &t_key, Window &t_window, const Settings &t_settings, qint64 t_storedUs);
+    static QVariant numbersToVariant(const QVector<double> &t_numbers, bool t_scalar);
+
+    /**
+     * @brief m_transactions
+     * transaction id -> entity id -> settings, entities without entry store every value
+     */
+    QHash<int, QHash<int, Settings>> m_transactions;
+    QHash<ValueKey, Window> m_windows;
+    QVector<Aggregate> m_aggregates;
+    /**
+     * @brief m_passThrough, m_numbers
+     * reused for every value
+     */
+    QVector<int> m_passThrough;
+    QVector<double> m_numbers;
+    /**
+     * @brief s_minFlushIntervalMs
+     * lower bound of flushIntervalMs() for high rates, windows of fast values are closed by the values themselves
+     */
+    static constexpr int s_minFlushIntervalMs = 100;
+};
+} // namespace VeinLogger
+
+#endif // VEINLOGGER_DOWNSAMPLER_H
@@ -0,0 +1,61 @@
+#include "vl_loggerclock.h"
+
+#include <QDateTime>
+
+#include <chrono>
+
+namespace VeinLogger
+{
+
+constexpr qint64 LoggerClock::s_resyncIntervalUs;
+
+LoggerClock::LoggerClock()
+{
+}
+
+qint64 LoggerClock::nowUs()
+{
+    const qint64 monotonic = monotonicUs();
+    if(m_synced == false || monotonic - m_lastSyncUs > s_resyncIntervalUs) {
+        resync();
+    }
+    return monotonic + m_offsetUs;
+}
+
+void LoggerClock::resync()
+{
+    //sample the monotonic clock on both sides of the wall clock read to keep the offset error small
+    const qint64 before = monotonicUs();
+    const qint64 utc = utcUs();
+    const qint64 after = monotonicUs();
+    m_offsetUs = utc - (before + (after - before) / 2);
+    m_lastSyncUs = after;
+    m_synced = true;
+}
+
+QString LoggerClock::toIsoString(qint64 t_timestampUs)
+{
+    return QDateTime::fromMSecsSinceEpoch(t_timestampUs / 1000).toString(Qt::ISODateWithMs);
+}
+
+bool LoggerClock::fromIsoString(const QString &t_isoString, qint64 &t_timestampUs)
+{
+    const QDateTime dateTime = QDateTime::fromString(t_isoString, Qt::ISODateWithMs);
+    if(dateTime.isValid() == false) {
+        return false;
+    }
+    t_timestampUs = dateTime.toMSecsSinceEpoch() * 1000;
+    return true;
+}
+
+qint64 LoggerClock::monotonicUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+qint64 LoggerClock::utcUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace VeinLogger
@@ -0,0 +1,61 @@
+#ifndef VEINLOGGER_LOGGERCLOCK_H
+#define VEINLOGGER_LOGGERCLOCK_H
+
+#include "globalIncludes.h"
+
+#include <QtGlobal>
+#include <QString>
+
+namespace VeinLogger
+{
+/**
+ * @brief The LoggerClock class
+ *
+ * Timestamps in microseconds since epoch (UTC) as stored in the database.
+ *
+ * nowUs() reads the monotonic clock and adds an offset to UTC, which is computed on the first call
+ * and re-synced every s_resyncIntervalUs, so wall clock adjustments (NTP, manual setting) are picked up.
+ *
+ * Not thread safe, every thread that creates timestamps uses its own instance.
+ */
+class LoggerClock
+{
+public:
+    LoggerClock();
+
+    /**
+     * @brief nowUs
+     * @return UTC microseconds since epoch
+     */
+    qint64 nowUs();
+    /**
+     * @brief resync
+     * Recomputes the offset between the monotonic clock and UTC
+     */
+    void resync();
+
+    /**
+     * @brief toIsoString
+     * @return local time in ISO 8601 format with milliseconds, as written by older versions
+     */
+    static QString toIsoString(qint64 t_timestampUs);
+    /**
+     * @brief fromIsoString
+     * @param t_isoString: ISO 8601, local time unless it has an offset, e.g. as returned by toIsoString
+     * @return false if t_isoString is not a valid date and time
+     */
+    static bool fromIsoString(const QString &t_isoString, qint64 &t_timestampUs);
+
+    static constexpr qint64 s_resyncIntervalUs = 60 * 1000 * 1000;
+
+private:
+    static qint64 monotonicUs();
+    static qint64 utcUs();
+
+    qint64 m_offsetUs = 0;
+    qint64 m_lastSyncUs = 0;
+    bool m_synced = false;
+};
+} // namespace VeinLogger
+
+#endif // VEINLOGGER_LOGGERCLOCK_H
@@ -0,0 +1,103 @@
+#include "vl_logrecordqueue.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace VeinLogger
+{
+//constexpr definition, see: https://stackoverflow.com/questions/8016780/undefined-reference-to-static-constexpr-char
+constexpr int LogRecord::s_inlineTransactionIds;
+
+void LogRecord::setTransactionIds(const QVector<int> &t_transactionIds)
+{
+    m_transactionCount = t_transactionIds.size();
+    if(m_transactionCount <= s_inlineTransactionIds) {
+        std::copy(t_transactionIds.constBegin(), t_transactionIds.constEnd(), m_inlineTransactionIds);
+        m_sharedTransactionIds.clear();
+    }
+    else {
+        m_sharedTransactionIds = t_transactionIds;
+    }
+}
+
+void LogRecord::setTransactionId(int t_transactionId)
+{
+    m_transactionCount = 1;
+    m_inlineTransactionIds[0] = t_transactionId;
+    m_sharedTransactionIds.clear();
+}
+
+int LogRecord::transactionId() const
+{
+    return m_transactionCount > 0 ? (m_transactionCount <= s_inlineTransactionIds ? m_inlineTransactionIds[0] : m_sharedTransactionIds.at(0)) : 0;
+}
+
+QVector<int> LogRecord::transactionIds() const
+{
+    if(m_transactionCount > s_inlineTransactionIds) {
+        return m_sharedTransactionIds;
+    }
+    QVector<int> retVal(m_transactionCount);
+    std::copy(m_inlineTransactionIds, m_inlineTransactionIds + m_transactionCount, retVal.begin());
+    return retVal;
+}
+
+LogRecordQueue::LogRecordQueue(unsigned int t_capacity)
+{
+    unsigned int capacity = 2;
+    while(capacity < t_capacity) {
+        capacity <<= 1;
+    }
+    m_slots.resize(capacity);
+    m_mask = capacity - 1;
+}
+
+bool LogRecordQueue::push(LogRecord &t_record)
+{
+    const unsigned int tail = m_tail.load(std::memory_order_relaxed);
+    const unsigned int head = m_head.load(std::memory_order_acquire);
+    if(tail - head > m_mask) {
+        m_fullCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    m_slots[tail & m_mask] = std::move(t_record);
+    m_tail.store(tail + 1, std::memory_order_release);
+
+    const unsigned int occupancy = tail + 1 - head;
+    if(occupancy > m_highWaterMark.load(std::memory_order_relaxed)) {
+        m_highWaterMark.store(occupancy, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+bool LogRecordQueue::markDrainRequested()
+{
+    return m_drainRequested.exchange(true) == false;
+}
+
+void LogRecordQueue::clearDrainRequest()
+{
+    m_drainRequested.store(false);
+}
+
+unsigned int LogRecordQueue::capacity() const
+{
+    return m_mask + 1;
+}
+
+unsigned int LogRecordQueue::occupancy() const
+{
+    return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+}
+
+unsigned int LogRecordQueue::highWaterMark() const
+{
+    return m_highWaterMark.load(std::memory_order_relaxed);
+}
+
+unsigned int LogRecordQueue::fullCount() const
+{
+    return m_fullCount.load(std::memory_order_relaxed);
+}
+
+} // namespace VeinLogger
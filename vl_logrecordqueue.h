@@ -0,0 +1,163 @@
+#ifndef VEINLOGGER_LOGRECORDQUEUE_H
+#define VEINLOGGER_LOGRECORDQUEUE_H
+
+#include "globalIncludes.h"
+
+#include <QString>
+#include <QVector>
+#include <QVariant>
+
+#include <atomic>
+#include <vector>
+
+namespace VeinLogger
+{
+/**
+ * @brief The LogRecord struct
+ *
+ * Fixed size record passed from the DatabaseLogger to the database thread.
+ * Control operations travel through the same queue as values, so their
+ * order relative to the values is kept.
+ *
+ * A VALUE push does not allocate: names and the value are implicitly shared
+ * with the event, up to s_inlineTransactionIds transaction ids are stored in
+ * the record itself.
+ */
+struct LogRecord
+{
+    enum class Type : int {
+        VALUE = 0,
+        ADD_ENTITY,
+        ADD_COMPONENT,
+        ADD_SESSION,
+        ADD_TRANSACTION,
+        TRANSACTION_START,
+        TRANSACTION_METADATA,
+    };
+
+    /**
+     * @brief setTransactionIds
+     * transactions of a VALUE, the transaction for ADD_TRANSACTION, TRANSACTION_START and TRANSACTION_METADATA
+     */
+    void setTransactionIds(const QVector<int> &t_transactionIds);
+    void setTransactionId(int t_transactionId);
+    int transactionId() const;
+    /**
+     * @brief transactionIds
+     * @note allocates, for the consumer
+     */
+    QVector<int> transactionIds() const;
+
+    Type type = Type::VALUE;
+    int entityId = 0;
+    /**
+     * @brief name
+     * component name for VALUE and ADD_COMPONENT, entity name for ADD_ENTITY, session name for ADD_SESSION,
+     * transaction name for ADD_TRANSACTION, key for TRANSACTION_METADATA
+     */
+    QString name;
+    QString sessionName;
+    /**
+     * @brief value
+     * logged value for VALUE, content set names and gui context name (QStringList) for ADD_TRANSACTION
+     */
+    QVariant value;
+    /**
+     * @brief timestamp
+     * UTC microseconds since epoch, see LoggerClock
+     */
+    qint64 timestamp = 0;
+    /**
+     * @brief staticData
+     * only used by ADD_SESSION
+     */
+    QList<QVariantMap> staticData;
+
+    static constexpr int s_inlineTransactionIds = 4;
+
+private:
+    int m_transactionCount = 0;
+    int m_inlineTransactionIds[s_inlineTransactionIds] = {};
+    /**
+     * @brief m_sharedTransactionIds
+     * only used for more than s_inlineTransactionIds transactions
+     */
+    QVector<int> m_sharedTransactionIds;
+};
+
+/**
+ * @brief The LogRecordQueue class
+ *
+ * Bounded lock-free single-producer/single-consumer ring of LogRecords.
+ *
+ * The producer is the DatabaseLogger (Vein event thread), the consumer is the
+ * database living on the VFLoggerDBThread. The consumer drains in bulk, so it
+ * is not woken once per value.
+ */
+class LogRecordQueue
+{
+public:
+    /**
+     * @param t_capacity: rounded up to the next power of two
+     */
+    explicit LogRecordQueue(unsigned int t_capacity = 16384);
+
+    /**
+     * @brief push
+     * @return false if the queue is full, t_record is left untouched then
+     * @note producer only
+     */
+    bool push(LogRecord &t_record);
+
+    /**
+     * @brief drain
+     * @param t_consumer: called for every record that was queued when drain started
+     * @return number of records drained
+     * @note consumer only
+     */
+    template <class T> unsigned int drain(T t_consumer)
+    {
+        const unsigned int tail = m_tail.load(std::memory_order_acquire);
+        unsigned int head = m_head.load(std::memory_order_relaxed);
+        const unsigned int count = tail - head;
+        while(head != tail) {
+            LogRecord &slot = m_slots[head & m_mask];
+            t_consumer(slot);
+            //release the shared payloads here and not in the producer thread
+            slot = LogRecord();
+            ++head;
+            m_head.store(head, std::memory_order_release);
+        }
+        return count;
+    }
+
+    /**
+     * @brief markDrainRequested
+     * @return true if no drain was requested since the last clearDrainRequest()
+     *
+     * Used by the producer to wake the consumer only once per fill level crossing.
+     */
+    bool markDrainRequested();
+    void clearDrainRequest();
+
+    unsigned int capacity() const;
+    unsigned int occupancy() const;
+    unsigned int highWaterMark() const;
+    /**
+     * @brief fullCount
+     * @return number of push() calls rejected because the queue was full
+     */
+    unsigned int fullCount() const;
+
+private:
+    std::vector<LogRecord> m_slots;
+    unsigned int m_mask = 0;
+    std::atomic<unsigned int> m_head{0};
+    std::atomic<unsigned int> m_tail{0};
+    std::atomic<unsigned int> m_highWaterMark{0};
+    std::atomic<unsigned int> m_fullCount{0};
+    std::atomic<bool> m_drainRequested{false};
+};
+} // namespace VeinLogger
+
+#endif // VEINLOGGER_LOGRECORDQUEUE_H
@@ -0,0 +1,129 @@
+#include "vl_lttbsampler.h"
+
+#include <cmath>
+
+namespace VeinLogger
+{
+LttbSampler::LttbSampler(qint64 t_pointCount, int t_threshold) :
+    m_passThrough(t_pointCount <= qMax(t_threshold, 3)),
+    m_bucketCount(qMax(t_threshold, 3) - 2),
+    m_pointCount(t_pointCount)
+{
+}
+
+void LttbSampler::add(qint64 t_timestampUs, double t_value)
+{
+    const Point point{t_timestampUs, t_value};
+    ++m_addedCount;
+    if(m_passThrough) {
+        m_selected.append(point);
+        return;
+    }
+    if(m_addedCount == 1) {
+        m_originUs = t_timestampUs;
+        m_selected.append(point);
+        return;
+    }
+    if(m_hasPending) {
+        assign(m_pending);
+    }
+    m_pending = point;
+    m_hasPending = true;
+}
+
+QVector<LttbSampler::Point> LttbSampler::finish()
+{
+    if(m_hasPending) {
+        //the pending point is the last one: it is the average of the last bucket
+        if(m_currentBucket.isEmpty() == false) {
+            if(m_nextBucket.isEmpty() == false) {
+                double averageX = 0.0;
+                double averageY = 0.0;
+                average(m_nextBucket, averageX, averageY);
+                selectFromCurrent(averageX, averageY);
+                m_currentBucket.swap(m_nextBucket);
+                m_nextBucket.clear();
+            }
+            selectFromCurrent(double(m_pending.timestampUs - m_originUs), m_pending.value);
+        }
+        m_selected.append(m_pending);
+        m_hasPending = false;
+    }
+    m_currentBucket.clear();
+    m_nextBucket.clear();
+    QVector<Point> retVal;
+    retVal.swap(m_selected);
+    return retVal;
+}
+
+qint64 LttbSampler::addedCount() const
+{
+    return m_addedCount;
+}
+
+int LttbSampler::bucketOf(qint64 t_index) const
+{
+    //bucket b starts at index b * (count - 2) / buckets + 1, in integers: a floating point bucket size can drop the second last point
+    return int(qMin((t_index * m_bucketCount - 1) / (m_pointCount - 2), qint64(m_bucketCount - 1)));
+}
+
+void LttbSampler::assign(const Point &t_point)
+{
+    //index of t_point, the first point has index 0 and m_addedCount already counts the point after t_point
+    const int bucket = bucketOf(m_addedCount - 2);
+    if(m_currentBucket.isEmpty() || bucket == m_currentBucketIndex) {
+        m_currentBucket.append(t_point);
+        m_currentBucketIndex = bucket;
+    }
+    else if(m_nextBucket.isEmpty() || bucket == m_nextBucketIndex) {
+        m_nextBucket.append(t_point);
+        m_nextBucketIndex = bucket;
+    }
+    else {
+        //the next bucket is complete, so the current one can be decided
+        double averageX = 0.0;
+        double averageY = 0.0;
+        average(m_nextBucket, averageX, averageY);
+        selectFromCurrent(averageX, averageY);
+        m_currentBucket.swap(m_nextBucket);
+        m_currentBucketIndex = m_nextBucketIndex;
+        m_nextBucket.clear();
+        m_nextBucket.append(t_point);
+        m_nextBucketIndex = bucket;
+    }
+}
+
+void LttbSampler::selectFromCurrent(double t_averageX, double t_averageY)
+{
+    const Point &selected = m_selected.constLast();
+    const double selectedX = double(selected.timestampUs - m_originUs);
+    const double selectedY = selected.value;
+    double maxArea = -1.0;
+    int nextSelected = 0;
+    for(int index = 0; index < m_currentBucket.size(); ++index) {
+        const Point &point = m_currentBucket.at(index);
+        //twice the triangle area, only compared
+        const double area = std::fabs((selectedX - t_averageX) * (point.value - selectedY)
+                                      - (selectedX - double(point.timestampUs - m_originUs)) * (t_averageY - selectedY));
+        if(area > maxArea) {
+            maxArea = area;
+            nextSelected = index;
+        }
+    }
+    m_selected.append(m_currentBucket.at(nextSelected));
+    m_currentBucket.clear();
+}
+
+void LttbSampler::average(const QVector<Point> &t_points, double &t_x, double &t_y) const
+{
+    t_x = 0.0;
+    t_y = 0.0;
+    for(const Point &point : t_points) {
+        t_x += double(point.timestampUs - m_originUs);
+        t_y += point.value;
+    }
+    t_x /= t_points.size();
+    t_y /= t_points.size();
+}
+
+} // namespace VeinLogger
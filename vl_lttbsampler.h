@@ -0,0 +1,85 @@
+#ifndef VEINLOGGER_LTTBSAMPLER_H
+#define VEINLOGGER_LTTBSAMPLER_H
+
+#include "globalIncludes.h"
+
+#include <QVector>
+
+namespace VeinLogger
+{
+/**
+ * @brief The LttbSampler class
+ *
+ * Largest-Triangle-Three-Buckets downsampling of a stream of points in ascending time order.
+ *
+ * Keeps the first and the last point. The points in between are split into t_threshold - 2 buckets by their index.
+ * Each bucket contributes the point that spans the largest triangle with the point selected before and the average
+ * of the next bucket. Only the current and the next bucket are held, so a range is read with one bucket of look-ahead
+ * instead of all of its points.
+ *
+ * The buckets are sized for the point count passed to the constructor. With fewer points the last buckets stay empty
+ * and fewer points are selected, more points than announced end up in the last bucket.
+ */
+class LttbSampler
+{
+public:
+    struct Point
+    {
+        qint64 timestampUs;
+        double value;
+    };
+
+    /**
+     * @param t_pointCount: number of points add() will be called with, e.g. from a COUNT(*)
+     * @param t_threshold: number of points to select, at least 3. All points are selected if t_pointCount is not larger.
+     */
+    LttbSampler(qint64 t_pointCount, int t_threshold);
+
+    void add(qint64 t_timestampUs, double t_value);
+    /**
+     * @brief finish
+     * @return the selected points in the order they were added, the sampler is empty afterwards
+     */
+    QVector<Point> finish();
+    /**
+     * @brief addedCount
+     * @return number of points added since construction
+     */
+    qint64 addedCount() const;
+
+private:
+    int bucketOf(qint64 t_index) const;
+    void assign(const Point &t_point);
+    /**
+     * @brief selectFromCurrent
+     * Appends the point of m_currentBucket spanning the largest triangle with the last selected point and t_averageX/Y
+     */
+    void selectFromCurrent(double t_averageX, double t_averageY);
+    void average(const QVector<Point> &t_points, double &t_x, double &t_y) const;
+
+    const bool m_passThrough;
+    const int m_bucketCount;
+    const qint64 m_pointCount;
+
+    QVector<Point> m_selected;
+    /**
+     * @brief m_pending
+     * the latest point, held back until the next one arrives as it may be the last
+     */
+    Point m_pending = {0, 0.0};
+    bool m_hasPending = false;
+    qint64 m_addedCount = 0;
+    /**
+     * @brief m_originUs
+     * x coordinates are relative to the first point, microseconds since epoch lose precision in the products
+     */
+    qint64 m_originUs = 0;
+
+    QVector<Point> m_currentBucket;
+    int m_currentBucketIndex = -1;
+    QVector<Point> m_nextBucket;
+    int m_nextBucketIndex = -1;
+};
+} // namespace VeinLogger
+
+#endif // VEINLOGGER_LTTBSAMPLER_H
@@ -105,6 +105,29 @@ QVariantMap QmlLogger::readContentSets()
     return resultMap;
 }
 
+QMultiHash<int, QVariant> QmlLogger::readChangeFilters()
+{
+    return readEntityOptions(&JsonContentSetLoader::readChangeFilter);
+}
+
+QMultiHash<int, QVariant> QmlLogger::readDownsampling()
+{
+    return readEntityOptions(&JsonContentSetLoader::readDownsampling);
+}
+
+QMultiHash<int, QVariant> QmlLogger::readEntityOptions(QVariant (JsonContentSetLoader::*t_optionReader)(const QString &))
+{
+    QMultiHash<int, QVariant> result;
+    for(const QString &contentSet : qAsConst(m_contentSets)) {
+        const QVariant option = (m_contentSetLoader.*t_optionReader)(contentSet);
+        const QMap<QString,QVector<QString>> map = m_contentSetLoader.readContentSet(contentSet);
+        for(auto iter = map.constBegin(); iter != map.constEnd(); ++iter) {
+            result.insert(iter.key().toInt(), option);
+        }
+    }
+    return result;
+}
+
 void QmlLogger::startLogging()
 {
     if(!m_sessionName.isEmpty() && !m_transactionName.isEmpty()){
@@ -125,6 +148,7 @@ void QmlLogger::addLoggerEntry(int t_entityId, const QString &t_componentName)
     if(m_loggedValues.contains(t_entityId, t_componentName) == false)
     {
         m_loggedValues.insert(t_entityId, t_componentName);
+        emit loggedValuesChanged();
     }
 }
 
@@ -133,12 +157,17 @@ void QmlLogger::removeLoggerEntry(int t_entityId, const QString &t_componentName
     if(m_loggedValues.contains(t_entityId, t_componentName))
     {
         m_loggedValues.remove(t_entityId, t_componentName);
+        emit loggedValuesChanged();
     }
 }
 
 void QmlLogger::clearLoggerEntries()
 {
-    m_loggedValues.clear();
+    if(m_loggedValues.isEmpty() == false)
+    {
+        m_loggedValues.clear();
+        emit loggedValuesChanged();
+    }
 }
 
 void QmlLogger::setSessionName(QString t_sessionName)
@@ -70,6 +70,18 @@ public:
 
     Q_INVOKABLE QStringList readSession();
     Q_INVOKABLE QVariantMap readContentSets();
+    /**
+     * @brief readChangeFilters
+     * @return entity id -> "ChangeFilter" settings of every content set containing the entity,
+     * an invalid QVariant for content sets without filter
+     */
+    QMultiHash<int, QVariant> readChangeFilters();
+    /**
+     * @brief readDownsampling
+     * @return entity id -> "Downsampling" settings of every content set containing the entity,
+     * an invalid QVariant for content sets storing every value
+     */
+    QMultiHash<int, QVariant> readDownsampling();
 
     int getTransactionId() const;
     void setTransactionId(int transactionId);
@@ -101,15 +113,26 @@ signals:
     void guiContextChanged(QString t_guiContext);
     void loggingEnabledChanged(bool t_loggingEnabled);
     void initializeValuesChanged(bool t_initializeValues);
+    /**
+     * @brief loggedValuesChanged
+     * Emitted when logger entries are added, removed or cleared
+     */
+    void loggedValuesChanged();
 
 private:
+    QMultiHash<int, QVariant> readEntityOptions(QVariant (JsonContentSetLoader::*t_optionReader)(const QString &));
+
     static DatabaseLogger *s_dbLogger;
     static QString m_zeraContentSetPath;
     static QString m_customerContentSetPath;
     QString m_session;
     QString m_sessionName;
     QString m_transactionName;
-    int m_transactionId;
+    /**
+     * @brief m_transactionId
+     * -1 until DatabaseLogger::addScript created the transaction, scripts without initializeValues never get one
+     */
+    int m_transactionId=-1;
     QDateTime m_startTime;
     QDateTime m_stopTime;
     QStringList m_contentSets;
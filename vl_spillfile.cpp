@@ -0,0 +1,290 @@
+#include "vl_spillfile.h"
+#include "vl_batchrecordcodec.h"
+
+#include <QtEndian>
+#include <QSaveFile>
+
+#if defined(Q_OS_UNIX)
+#include <unistd.h>
+#endif
+
+namespace VeinLogger
+{
+namespace
+{
+const char s_magic[8] = {'V', 'L', 'S', 'P', 'I', 'L', 'L', '1'};
+constexpr qint64 s_headerSize = 16;
+constexpr int s_recordSizeSize = 4;
+} // namespace
+
+SpillFile::SpillFile()
+{
+}
+
+SpillFile::~SpillFile()
+{
+    close();
+}
+
+QString SpillFile::pathForDatabase(const QString &t_dbPath)
+{
+    return t_dbPath + QStringLiteral(".spill");
+}
+
+bool SpillFile::open(const QString &t_path)
+{
+    close();
+    m_file.setFileName(t_path);
+    if(m_file.open(QIODevice::ReadWrite) == false) {
+        return setError(QStringLiteral("open"));
+    }
+    const qint64 fileSize = m_file.size();
+    if(fileSize == 0) {
+        QByteArray header(s_magic, sizeof(s_magic));
+        header.resize(s_headerSize);
+        qToLittleEndian<qint64>(s_headerSize, header.data() + sizeof(s_magic));
+        if(m_file.write(header) != s_headerSize) {
+            return setError(QStringLiteral("write header"));
+        }
+        m_committedPos = s_headerSize;
+        m_writePos = s_headerSize;
+    }
+    else {
+        const QByteArray header = m_file.read(s_headerSize);
+        if(header.size() != s_headerSize || header.startsWith(QByteArray(s_magic, sizeof(s_magic))) == false) {
+            m_lastError = QStringLiteral("SpillFile: %1 is not a spill file").arg(t_path);
+            m_file.close();
+            return false;
+        }
+        m_committedPos = qFromLittleEndian<qint64>(header.constData() + sizeof(s_magic));
+        if(m_committedPos < s_headerSize || m_committedPos > fileSize) {
+            m_lastError = QStringLiteral("SpillFile: invalid replay offset in %1").arg(t_path);
+            m_file.close();
+            return false;
+        }
+        //find the end of the last complete record, the rest was cut off by a power loss
+        qint64 recordPos = m_committedPos;
+        while(recordPos + s_recordSizeSize <= fileSize) {
+            char sizeBytes[s_recordSizeSize];
+            if(m_file.seek(recordPos) == false || m_file.read(sizeBytes, s_recordSizeSize) != s_recordSizeSize) {
+                return setError(QStringLiteral("scan"));
+            }
+            const qint64 nextPos = recordPos + s_recordSizeSize + qFromLittleEndian<quint32>(sizeBytes);
+            if(nextPos > fileSize) {
+                break;
+            }
+            recordPos = nextPos;
+        }
+        if(recordPos < fileSize && m_file.resize(recordPos) == false) {
+            return setError(QStringLiteral("truncate"));
+        }
+        m_writePos = recordPos;
+    }
+    m_readPos = m_committedPos;
+    m_openCommittedPos = m_committedPos;
+    return true;
+}
+
+bool SpillFile::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+void SpillFile::close()
+{
+    if(m_file.isOpen()) {
+        m_file.close();
+    }
+    m_committedPos = 0;
+    m_openCommittedPos = 0;
+    m_readPos = 0;
+    m_writePos = 0;
+}
+
+bool SpillFile::remove()
+{
+    const QString path = m_file.fileName();
+    close();
+    if(QFile::exists(path) && QFile::remove(path) == false) {
+        m_lastError = QStringLiteral("SpillFile: unable to remove %1").arg(path);
+        return false;
+    }
+    return true;
+}
+
+bool SpillFile::append(const SQLBatchData &t_data)
+{
+    if(m_file.isOpen() == false) {
+        m_lastError = QStringLiteral("SpillFile: not open");
+        return false;
+    }
+    if(encodeRecord(t_data) == false) {
+        return false;
+    }
+    if(m_file.seek(m_writePos) == false || m_file.write(m_buffer) != m_buffer.size()) {
+        return setError(QStringLiteral("append"));
+    }
+    m_writePos += m_buffer.size();
+    return true;
+}
+
+bool SpillFile::prepend(const QVector<SQLBatchData> &t_data)
+{
+    if(m_file.isOpen() == false) {
+        m_lastError = QStringLiteral("SpillFile: not open");
+        return false;
+    }
+    const QString path = m_file.fileName();
+    QSaveFile newFile(path);
+    if(newFile.open(QIODevice::WriteOnly) == false) {
+        m_lastError = QStringLiteral("SpillFile prepend (%1): %2").arg(path).arg(newFile.errorString());
+        return false;
+    }
+    QByteArray header(s_magic, sizeof(s_magic));
+    header.resize(s_headerSize);
+    qToLittleEndian<qint64>(s_headerSize, header.data() + sizeof(s_magic));
+    bool writeOk = newFile.write(header) == s_headerSize;
+    for(auto iter = t_data.constBegin(); writeOk && iter != t_data.constEnd(); ++iter) {
+        if(encodeRecord(*iter) == false) {
+            newFile.cancelWriting();
+            return false;
+        }
+        writeOk = newFile.write(m_buffer) == m_buffer.size();
+    }
+    //records read but not committed are replayed again, copy from the committed position
+    if(writeOk && m_file.seek(m_committedPos) == false) {
+        newFile.cancelWriting();
+        return setError(QStringLiteral("prepend"));
+    }
+    qint64 copyPos = m_committedPos;
+    while(writeOk && copyPos < m_writePos) {
+        m_buffer = m_file.read(qMin(m_writePos - copyPos, qint64(1 << 16)));
+        if(m_buffer.isEmpty()) {
+            newFile.cancelWriting();
+            return setError(QStringLiteral("prepend"));
+        }
+        writeOk = newFile.write(m_buffer) == m_buffer.size();
+        copyPos += m_buffer.size();
+    }
+    if(writeOk == false || newFile.commit() == false) {
+        m_lastError = QStringLiteral("SpillFile prepend (%1): %2").arg(path).arg(newFile.errorString());
+        return false;
+    }
+    return open(path);
+}
+
+bool SpillFile::sync()
+{
+    if(m_file.isOpen() == false) {
+        return true;
+    }
+    if(m_file.flush() == false) {
+        return setError(QStringLiteral("sync"));
+    }
+#if defined(Q_OS_LINUX)
+    if(::fdatasync(m_file.handle()) != 0) {
+        return setError(QStringLiteral("sync"));
+    }
+#elif defined(Q_OS_UNIX)
+    if(::fsync(m_file.handle()) != 0) {
+        return setError(QStringLiteral("sync"));
+    }
+#endif
+    return true;
+}
+
+int SpillFile::read(int t_maxRecords, QVector<SQLBatchData> &t_target)
+{
+    if(m_file.isOpen() == false) {
+        m_lastError = QStringLiteral("SpillFile: not open");
+        return -1;
+    }
+    int recordCount = 0;
+    while(recordCount < t_maxRecords && m_readPos < m_writePos) {
+        //seek() flushes the appended records
+        char sizeBytes[s_recordSizeSize];
+        if(m_file.seek(m_readPos) == false || m_file.read(sizeBytes, s_recordSizeSize) != s_recordSizeSize) {
+            setError(QStringLiteral("read"));
+            return -1;
+        }
+        const int payloadSize = int(qFromLittleEndian<quint32>(sizeBytes));
+        m_buffer.resize(payloadSize);
+        if(m_file.read(m_buffer.data(), payloadSize) != payloadSize) {
+            setError(QStringLiteral("read"));
+            return -1;
+        }
+        SQLBatchData batchData;
+        if(BatchRecordCodec::decode(m_buffer.constData(), payloadSize, batchData) == false) {
+            m_lastError = QStringLiteral("SpillFile: corrupt record at %1").arg(m_readPos);
+            return -1;
+        }
+        t_target.append(batchData);
+
+        m_readPos += s_recordSizeSize + payloadSize;
+        ++recordCount;
+    }
+    return recordCount;
+}
+
+bool SpillFile::commitRead()
+{
+    if(m_committedPos == m_readPos) {
+        return true;
+    }
+    m_committedPos = m_readPos;
+    return writeCommittedPos();
+}
+
+bool SpillFile::hasUnreadRecords() const
+{
+    return m_readPos < m_writePos;
+}
+
+bool SpillFile::isReplayed() const
+{
+    return m_committedPos == m_writePos;
+}
+
+qint64 SpillFile::pendingBytes() const
+{
+    return m_writePos - m_committedPos;
+}
+
+qint64 SpillFile::replayedBytes() const
+{
+    return m_committedPos - m_openCommittedPos;
+}
+
+QString SpillFile::lastError() const
+{
+    return m_lastError;
+}
+
+bool SpillFile::writeCommittedPos()
+{
+    char offsetBytes[8];
+    qToLittleEndian<qint64>(m_committedPos, offsetBytes);
+    if(m_file.seek(sizeof(s_magic)) == false || m_file.write(offsetBytes, sizeof(offsetBytes)) != sizeof(offsetBytes)) {
+        return setError(QStringLiteral("write replay offset"));
+    }
+    return true;
+}
+
+bool SpillFile::encodeRecord(const SQLBatchData &t_data)
+{
+    m_buffer.resize(s_recordSizeSize);
+    if(BatchRecordCodec::encode(t_data, m_buffer) == false) {
+        m_lastError = QStringLiteral("SpillFile: too many transactions for one value");
+        return false;
+    }
+    qToLittleEndian<quint32>(quint32(m_buffer.size() - s_recordSizeSize), m_buffer.data());
+    return true;
+}
+
+bool SpillFile::setError(const QString &t_context)
+{
+    m_lastError = QStringLiteral("SpillFile %1 (%2): %3").arg(t_context).arg(m_file.fileName()).arg(m_file.errorString());
+    return false;
+}
+
+} // namespace VeinLogger
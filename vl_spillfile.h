@@ -0,0 +1,117 @@
+#ifndef VEINLOGGER_SPILLFILE_H
+#define VEINLOGGER_SPILLFILE_H
+
+#include "globalIncludes.h"
+#include "vl_sqlitedb.h"
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QFile>
+
+namespace VeinLogger
+{
+/**
+ * @brief The SpillFile class
+ *
+ * Append-only overflow buffer for logged values that do not fit into the memory budget of SQLiteDB,
+ * stored next to the database and replayed into it in order.
+ *
+ * Layout: 8 bytes magic, int64 offset of the first record not yet written to the database,
+ * then the records: uint32 payload size + payload (see BatchRecordCodec). All integers are little endian.
+ *
+ * The replay offset is only advanced with commitRead(), records read for a batch that never gets
+ * committed are read again after the file is reopened.
+ */
+class SpillFile
+{
+public:
+    SpillFile();
+    ~SpillFile();
+
+    /**
+     * @brief pathForDatabase
+     * @return path of the spill file belonging to the database t_dbPath
+     */
+    static QString pathForDatabase(const QString &t_dbPath);
+
+    /**
+     * @brief open
+     * Creates the file or opens an existing one for replay, a truncated last record (power loss) is cut off
+     * @return false on error, see lastError()
+     */
+    bool open(const QString &t_path);
+    bool isOpen() const;
+    void close();
+    /**
+     * @brief remove
+     * Closes and deletes the file, call when everything was replayed
+     */
+    bool remove();
+
+    bool append(const SQLBatchData &t_data);
+    /**
+     * @brief prepend
+     * Rewrites the file with t_data in front of the records not yet committed, for values older than the spilled ones.
+     * The new file replaces the old one atomically and is synced.
+     */
+    bool prepend(const QVector<SQLBatchData> &t_data);
+    /**
+     * @brief sync
+     * Writes the appended records through to the storage, on platforms without fsync they are only flushed to the OS
+     */
+    bool sync();
+    /**
+     * @brief read
+     * Appends up to t_maxRecords records following the last read to t_target
+     * @return number of records read, -1 on error
+     */
+    int read(int t_maxRecords, QVector<SQLBatchData> &t_target);
+    /**
+     * @brief commitRead
+     * The records read so far are in the database, stores the replay offset
+     */
+    bool commitRead();
+    /**
+     * @brief hasUnreadRecords
+     * @return true if there are records appended after the last read
+     */
+    bool hasUnreadRecords() const;
+    /**
+     * @brief isReplayed
+     * @return true if all records are committed
+     */
+    bool isReplayed() const;
+
+    /**
+     * @brief pendingBytes
+     * @return bytes of the records not yet committed to the database
+     */
+    qint64 pendingBytes() const;
+    /**
+     * @brief replayedBytes
+     * @return bytes of the records committed since the file was opened
+     */
+    qint64 replayedBytes() const;
+    QString lastError() const;
+
+private:
+    bool writeCommittedPos();
+    bool encodeRecord(const SQLBatchData &t_data);
+    bool setError(const QString &t_context);
+
+    QFile m_file;
+    qint64 m_committedPos = 0;
+    qint64 m_openCommittedPos = 0;
+    qint64 m_readPos = 0;
+    qint64 m_writePos = 0;
+    /**
+     * @brief m_buffer
+     * reused for encoding and decoding records
+     */
+    QByteArray m_buffer;
+    QString m_lastError;
+};
+} // namespace VeinLogger
+
+#endif // VEINLOGGER_SPILLFILE_H
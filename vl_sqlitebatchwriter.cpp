@@ -0,0 +1,382 @@
+#include "vl_sqlitebatchwriter.h"
+
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QVariantList>
+
+#include <sqlite3.h>
+
+#if defined(Q_OS_UNIX)
+#include <dlfcn.h>
+#endif
+
+namespace VeinLogger
+{
+//constexpr definition, see: https://stackoverflow.com/questions/8016780/undefined-reference-to-static-constexpr-char
+constexpr const char *SQLiteBatchWriter::s_valueInsertSql;
+constexpr const char *SQLiteBatchWriter::s_transactionMappingInsertSql;
+constexpr const char *SQLiteBatchWriter::s_sessionMappingInsertSql;
+
+SQLiteBatchWriter::SQLiteBatchWriter()
+{
+}
+
+SQLiteBatchWriter::~SQLiteBatchWriter()
+{
+    finalize();
+}
+
+sqlite3 *SQLiteBatchWriter::nativeHandle(const QSqlDatabase &t_database, QString &t_mismatch)
+{
+    const QVariant driverHandle = t_database.driver()->handle();
+    if(driverHandle.isValid() == false || qstrcmp(driverHandle.typeName(), "sqlite3*") != 0) {
+        t_mismatch = QStringLiteral("the driver has no sqlite3 handle");
+        return nullptr;
+    }
+    //sqlite_version() and sqlite_source_id() are answered by the library QSQLITE runs on
+    QSqlQuery versionQuery(t_database);
+    if(versionQuery.exec("SELECT sqlite_version(), sqlite_source_id();") == false || versionQuery.next() == false) {
+        t_mismatch = QString("reading the sqlite version of the driver failed: %1").arg(versionQuery.lastError().text());
+        return nullptr;
+    }
+    const QString driverVersion = versionQuery.value(0).toString();
+    const QString driverSourceId = versionQuery.value(1).toString();
+    versionQuery.finish();
+    if(driverVersion != QLatin1String(sqlite3_libversion()) || driverSourceId != QLatin1String(sqlite3_sourceid())) {
+        t_mismatch = QString("QSQLITE runs on sqlite %1, the logger is linked against sqlite %2").arg(driverVersion).arg(QLatin1String(sqlite3_libversion()));
+        return nullptr;
+    }
+#if defined(Q_OS_UNIX)
+    //a bundled copy of the same version passes the check above: the driver has to resolve sqlite3 to our library
+    Dl_info driverInfo;
+    if(dladdr(reinterpret_cast<const void *>(t_database.driver()->metaObject()), &driverInfo) != 0 && driverInfo.dli_fname != nullptr) {
+        void *driverLibrary = dlopen(driverInfo.dli_fname, RTLD_LAZY | RTLD_NOLOAD);
+        if(driverLibrary != nullptr) {
+            void *driverSymbol = dlsym(driverLibrary, "sqlite3_libversion");
+            dlclose(driverLibrary);
+            if(driverSymbol != reinterpret_cast<void *>(&sqlite3_libversion)) {
+                t_mismatch = QString("%1 does not use the shared sqlite library, Qt has to be built with -system-sqlite").arg(QString::fromLocal8Bit(driverInfo.dli_fname));
+                return nullptr;
+            }
+        }
+    }
+#endif
+    return *static_cast<sqlite3 *const *>(driverHandle.constData());
+}
+
+QStringList SQLiteBatchWriter::statements()
+{
+    return QStringList({s_valueInsertSql, s_transactionMappingInsertSql, s_sessionMappingInsertSql});
+}
+
+bool SQLiteBatchWriter::prepare(const QSqlDatabase &t_database, sqlite3 *t_handle)
+{
+    finalize();
+    m_handle = t_handle;
+    if(m_handle == nullptr) {
+        m_valueInsertQuery = QSqlQuery(t_database);
+        m_transactionMappingInsertQuery = QSqlQuery(t_database);
+        m_sessionMappingInsertQuery = QSqlQuery(t_database);
+        if(m_valueInsertQuery.prepare(s_valueInsertSql) == false) {
+            return setError("prepare valuemap insert", m_valueInsertQuery);
+        }
+        if(m_transactionMappingInsertQuery.prepare(s_transactionMappingInsertSql) == false) {
+            return setError("prepare transactions_valuemap insert", m_transactionMappingInsertQuery);
+        }
+        if(m_sessionMappingInsertQuery.prepare(s_sessionMappingInsertSql) == false) {
+            return setError("prepare sessions_valuemap insert", m_sessionMappingInsertQuery);
+        }
+        m_queriesPrepared = true;
+        return true;
+    }
+    if(sqlite3_prepare_v2(m_handle, s_valueInsertSql, -1, &m_valueInsertStatement, nullptr) != SQLITE_OK) {
+        return setError("prepare valuemap insert");
+    }
+    if(sqlite3_prepare_v2(m_handle, s_transactionMappingInsertSql, -1, &m_transactionMappingInsertStatement, nullptr) != SQLITE_OK) {
+        return setError("prepare transactions_valuemap insert");
+    }
+    if(sqlite3_prepare_v2(m_handle, s_sessionMappingInsertSql, -1, &m_sessionMappingInsertStatement, nullptr) != SQLITE_OK) {
+        return setError("prepare sessions_valuemap insert");
+    }
+    return true;
+}
+
+void SQLiteBatchWriter::finalize()
+{
+    //sqlite3_finalize is a harmless no-op for nullptr
+    sqlite3_finalize(m_valueInsertStatement);
+    sqlite3_finalize(m_transactionMappingInsertStatement);
+    sqlite3_finalize(m_sessionMappingInsertStatement);
+    m_valueInsertStatement = nullptr;
+    m_transactionMappingInsertStatement = nullptr;
+    m_sessionMappingInsertStatement = nullptr;
+    m_handle = nullptr;
+    m_valueInsertQuery.finish();
+    m_transactionMappingInsertQuery.finish();
+    m_sessionMappingInsertQuery.finish();
+    m_queriesPrepared = false;
+}
+
+bool SQLiteBatchWriter::isPrepared() const
+{
+    return m_valueInsertStatement != nullptr || m_queriesPrepared;
+}
+
+bool SQLiteBatchWriter::isNative() const
+{
+    return m_valueInsertStatement != nullptr;
+}
+
+void SQLiteBatchWriter::reserve(int t_rows)
+{
+    m_valueRows.reserve(t_rows);
+    m_transactionMappings.reserve(t_rows);
+    //rough guess: a short value per row
+    m_bytes.reserve(t_rows * 16);
+}
+
+void SQLiteBatchWriter::clear()
+{
+    m_valueRows.clear();
+    m_transactionMappings.clear();
+    m_sessionMappings.clear();
+    m_bytes.clear();
+}
+
+void SQLiteBatchWriter::addValueRow(qint64 t_valueId, qint64 t_timestampUs, int t_componentId, int t_entityId)
+{
+    ValueRow row;
+    row.valueId = t_valueId;
+    row.timestampUs = t_timestampUs;
+    row.componentId = t_componentId;
+    row.entityId = t_entityId;
+    row.valueType = ValueType::NULL_VALUE;
+    row.integerValue = 0;
+    row.realValue = 0.0;
+    row.bytesOffset = 0;
+    row.bytesLength = 0;
+    m_valueRows.push_back(row);
+}
+
+void SQLiteBatchWriter::setNullValue()
+{
+    m_valueRows.back().valueType = ValueType::NULL_VALUE;
+}
+
+void SQLiteBatchWriter::setIntegerValue(qint64 t_value)
+{
+    ValueRow &row = m_valueRows.back();
+    row.valueType = ValueType::INTEGER;
+    row.integerValue = t_value;
+}
+
+void SQLiteBatchWriter::setRealValue(double t_value)
+{
+    ValueRow &row = m_valueRows.back();
+    row.valueType = ValueType::REAL;
+    row.realValue = t_value;
+}
+
+void SQLiteBatchWriter::setTextValue(const QByteArray &t_utf8Value)
+{
+    ValueRow &row = m_valueRows.back();
+    row.valueType = ValueType::TEXT;
+    row.bytesLength = t_utf8Value.size();
+    row.bytesOffset = appendBytes(t_utf8Value);
+}
+
+void SQLiteBatchWriter::setBlobValue(const QByteArray &t_value)
+{
+    ValueRow &row = m_valueRows.back();
+    row.valueType = ValueType::BLOB;
+    row.bytesLength = t_value.size();
+    row.bytesOffset = appendBytes(t_value);
+}
+
+void SQLiteBatchWriter::addTransactionMapping(int t_transactionId, qint64 t_valueId)
+{
+    MappingRow row;
+    row.ownerId = t_transactionId;
+    row.valueId = t_valueId;
+    m_transactionMappings.push_back(row);
+}
+
+void SQLiteBatchWriter::addSessionMapping(int t_sessionId, qint64 t_valueId)
+{
+    MappingRow row;
+    row.ownerId = t_sessionId;
+    row.valueId = t_valueId;
+    m_sessionMappings.push_back(row);
+}
+
+int SQLiteBatchWriter::valueRowCount() const
+{
+    return static_cast<int>(m_valueRows.size());
+}
+
+bool SQLiteBatchWriter::execute()
+{
+    if(isPrepared() == false) {
+        m_lastError = QStringLiteral("SQLiteBatchWriter: statements are not prepared");
+        return false;
+    }
+    if(isNative() == false) {
+        return executeQueries();
+    }
+    //the arena does not grow anymore, so the pointers stay valid until the statements are reset
+    const char *bytes = m_bytes.data();
+    for(const ValueRow &row : m_valueRows) {
+        sqlite3_stmt *statement = m_valueInsertStatement;
+        sqlite3_bind_int64(statement, 1, row.valueId);
+        sqlite3_bind_int64(statement, 2, row.timestampUs);
+        switch(row.valueType) {
+        case ValueType::NULL_VALUE:
+            sqlite3_bind_null(statement, 3);
+            break;
+        case ValueType::INTEGER:
+            sqlite3_bind_int64(statement, 3, row.integerValue);
+            break;
+        case ValueType::REAL:
+            sqlite3_bind_double(statement, 3, row.realValue);
+            break;
+        case ValueType::TEXT:
+            sqlite3_bind_text(statement, 3, bytes + row.bytesOffset, row.bytesLength, SQLITE_STATIC);
+            break;
+        case ValueType::BLOB:
+            sqlite3_bind_blob(statement, 3, bytes + row.bytesOffset, row.bytesLength, SQLITE_STATIC);
+            break;
+        }
+        sqlite3_bind_int(statement, 4, row.componentId);
+        sqlite3_bind_int(statement, 5, row.entityId);
+
+        const int stepResult = sqlite3_step(statement);
+        sqlite3_reset(statement);
+        if(stepResult != SQLITE_DONE) {
+            sqlite3_clear_bindings(statement);
+            return setError("valuemap insert");
+        }
+    }
+    sqlite3_clear_bindings(m_valueInsertStatement);
+
+    if(insertMappings(m_transactionMappingInsertStatement, m_transactionMappings) == false) {
+        return setError("transactions_valuemap insert");
+    }
+    if(insertMappings(m_sessionMappingInsertStatement, m_sessionMappings) == false) {
+        return setError("sessions_valuemap insert");
+    }
+    return true;
+}
+
+QString SQLiteBatchWriter::lastError() const
+{
+    return m_lastError;
+}
+
+int SQLiteBatchWriter::appendBytes(const QByteArray &t_bytes)
+{
+    const int offset = static_cast<int>(m_bytes.size());
+    m_bytes.insert(m_bytes.end(), t_bytes.constData(), t_bytes.constData() + t_bytes.size());
+    return offset;
+}
+
+bool SQLiteBatchWriter::insertMappings(sqlite3_stmt *t_statement, const std::vector<MappingRow> &t_rows)
+{
+    for(const MappingRow &row : t_rows) {
+        sqlite3_bind_int(t_statement, 1, row.ownerId);
+        sqlite3_bind_int64(t_statement, 2, row.valueId);
+        const int stepResult = sqlite3_step(t_statement);
+        sqlite3_reset(t_statement);
+        if(stepResult != SQLITE_DONE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SQLiteBatchWriter::executeQueries()
+{
+    //column lists as addBindValue expects them, QSQLITE runs execBatch row by row
+    QVariantList valueIds;
+    QVariantList timestamps;
+    QVariantList values;
+    QVariantList componentIds;
+    QVariantList entityIds;
+    const int rowCount = valueRowCount();
+    valueIds.reserve(rowCount);
+    timestamps.reserve(rowCount);
+    values.reserve(rowCount);
+    componentIds.reserve(rowCount);
+    entityIds.reserve(rowCount);
+    for(const ValueRow &row : m_valueRows) {
+        valueIds.append(row.valueId);
+        timestamps.append(row.timestampUs);
+        switch(row.valueType) {
+        case ValueType::NULL_VALUE:
+            values.append(QVariant());
+            break;
+        case ValueType::INTEGER:
+            values.append(row.integerValue);
+            break;
+        case ValueType::REAL:
+            values.append(row.realValue);
+            break;
+        case ValueType::TEXT:
+            values.append(QString::fromUtf8(m_bytes.data() + row.bytesOffset, row.bytesLength));
+            break;
+        case ValueType::BLOB:
+            values.append(QByteArray(m_bytes.data() + row.bytesOffset, row.bytesLength));
+            break;
+        }
+        componentIds.append(row.componentId);
+        entityIds.append(row.entityId);
+    }
+    if(rowCount > 0) {
+        m_valueInsertQuery.addBindValue(valueIds);
+        m_valueInsertQuery.addBindValue(timestamps);
+        m_valueInsertQuery.addBindValue(values);
+        m_valueInsertQuery.addBindValue(componentIds);
+        m_valueInsertQuery.addBindValue(entityIds);
+        if(m_valueInsertQuery.execBatch() == false) {
+            return setError("valuemap insert", m_valueInsertQuery);
+        }
+    }
+    if(insertMappings(m_transactionMappingInsertQuery, m_transactionMappings) == false) {
+        return setError("transactions_valuemap insert", m_transactionMappingInsertQuery);
+    }
+    if(insertMappings(m_sessionMappingInsertQuery, m_sessionMappings) == false) {
+        return setError("sessions_valuemap insert", m_sessionMappingInsertQuery);
+    }
+    return true;
+}
+
+bool SQLiteBatchWriter::insertMappings(QSqlQuery &t_query, const std::vector<MappingRow> &t_rows)
+{
+    if(t_rows.empty()) {
+        return true;
+    }
+    QVariantList ownerIds;
+    QVariantList valueIds;
+    ownerIds.reserve(static_cast<int>(t_rows.size()));
+    valueIds.reserve(static_cast<int>(t_rows.size()));
+    for(const MappingRow &row : t_rows) {
+        ownerIds.append(row.ownerId);
+        valueIds.append(row.valueId);
+    }
+    t_query.addBindValue(ownerIds);
+    t_query.addBindValue(valueIds);
+    return t_query.execBatch();
+}
+
+bool SQLiteBatchWriter::setError(const char *t_context, const QSqlQuery &t_query)
+{
+    m_lastError = QString("SQLiteBatchWriter %1 failed: %2").arg(QLatin1String(t_context)).arg(t_query.lastError().text());
+    return false;
+}
+
+bool SQLiteBatchWriter::setError(const char *t_context)
+{
+    m_lastError = QString("SQLiteBatchWriter %1 failed: %2").arg(QLatin1String(t_context)).arg(QString::fromUtf8(sqlite3_errmsg(m_handle)));
+    return false;
+}
+
+} // namespace VeinLogger
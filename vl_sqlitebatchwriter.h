@@ -0,0 +1,170 @@
+#ifndef VEINLOGGER_SQLITEBATCHWRITER_H
+#define VEINLOGGER_SQLITEBATCHWRITER_H
+
+#include "globalIncludes.h"
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+
+#include <vector>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace VeinLogger
+{
+/**
+ * @brief The SQLiteBatchWriter class
+ *
+ * Bulk insert engine working on the native sqlite3 handle of the QSQLITE connection.
+ *
+ * Rows are collected in typed column vectors that keep their capacity between batches.
+ * execute() binds them with sqlite3_bind_* to statements that are prepared once,
+ * so no QVariant is created and nothing is sorted per row.
+ *
+ * Without a usable native handle (see nativeHandle()) the rows are written with QSqlQuery::execBatch instead.
+ *
+ * The caller owns the SQL transaction, the writer only runs the inserts.
+ */
+class SQLiteBatchWriter
+{
+public:
+    enum class ValueType : int {
+        NULL_VALUE = 0,
+        INTEGER,
+        REAL,
+        TEXT,
+        BLOB,
+    };
+
+    SQLiteBatchWriter();
+    ~SQLiteBatchWriter();
+
+    /**
+     * @brief nativeHandle
+     * @param t_mismatch: why the handle can not be used, set if nullptr is returned
+     * @return the sqlite3 handle of t_database if QSQLITE runs on the same sqlite library the logger is linked
+     * against. With Qt's bundled sqlite the handle belongs to another copy of the library and must not be used.
+     */
+    static sqlite3 *nativeHandle(const QSqlDatabase &t_database, QString &t_mismatch);
+    /**
+     * @brief statements
+     * @return the insert statements of the writer, e.g. to check their query plans
+     */
+    static QStringList statements();
+
+    /**
+     * @brief prepare
+     * @param t_database: open connection
+     * @param t_handle: see nativeHandle(), nullptr selects the QSqlQuery fallback
+     * @return false on error, see lastError()
+     */
+    bool prepare(const QSqlDatabase &t_database, sqlite3 *t_handle);
+    /**
+     * @brief finalize
+     * Must be called before the connection is closed
+     */
+    void finalize();
+    bool isPrepared() const;
+    /**
+     * @brief isNative
+     * @return true if the rows are bound to sqlite3 statements, false for the QSqlQuery fallback
+     */
+    bool isNative() const;
+
+    /**
+     * @brief reserve
+     * @param t_rows: expected number of value rows per batch
+     */
+    void reserve(int t_rows);
+    /**
+     * @brief clear
+     * Drops all collected rows but keeps the allocated memory for the next batch
+     */
+    void clear();
+
+    /**
+     * @brief addValueRow
+     * Starts a valuemap row, exactly one of the set*Value functions has to follow
+     */
+    void addValueRow(qint64 t_valueId, qint64 t_timestampUs, int t_componentId, int t_entityId);
+    void setNullValue();
+    void setIntegerValue(qint64 t_value);
+    void setRealValue(double t_value);
+    void setTextValue(const QByteArray &t_utf8Value);
+    void setBlobValue(const QByteArray &t_value);
+
+    void addTransactionMapping(int t_transactionId, qint64 t_valueId);
+    void addSessionMapping(int t_sessionId, qint64 t_valueId);
+
+    int valueRowCount() const;
+    /**
+     * @brief execute
+     * @return false on error, see lastError(). The collected rows are kept in both cases.
+     */
+    bool execute();
+    QString lastError() const;
+
+    //valuemap_id, value_timestamp, value, component_id, entity_id
+    static constexpr const char *s_valueInsertSql = "INSERT INTO valuemap VALUES (?, ?, ?, ?, ?);";
+    //transaction_id, valuemap_id
+    static constexpr const char *s_transactionMappingInsertSql = "INSERT INTO transactions_valuemap VALUES (?, ?);";
+    //session_id, valuemap_id
+    static constexpr const char *s_sessionMappingInsertSql = "INSERT INTO sessions_valuemap VALUES (?, ?);";
+
+private:
+    struct ValueRow
+    {
+        qint64 valueId;
+        qint64 timestampUs;
+        int componentId;
+        int entityId;
+        ValueType valueType;
+        qint64 integerValue;
+        double realValue;
+        int bytesOffset;
+        int bytesLength;
+    };
+    struct MappingRow
+    {
+        int ownerId;
+        qint64 valueId;
+    };
+
+    int appendBytes(const QByteArray &t_bytes);
+    bool insertMappings(sqlite3_stmt *t_statement, const std::vector<MappingRow> &t_rows);
+    bool setError(const char *t_context);
+    bool executeQueries();
+    bool insertMappings(QSqlQuery &t_query, const std::vector<MappingRow> &t_rows);
+    bool setError(const char *t_context, const QSqlQuery &t_query);
+
+    sqlite3 *m_handle = nullptr;
+    sqlite3_stmt *m_valueInsertStatement = nullptr;
+    sqlite3_stmt *m_transactionMappingInsertStatement = nullptr;
+    sqlite3_stmt *m_sessionMappingInsertStatement = nullptr;
+    /**
+     * @brief m_valueInsertQuery, m_transactionMappingInsertQuery, m_sessionMappingInsertQuery
+     * QSqlQuery fallback, only prepared without native handle
+     */
+    QSqlQuery m_valueInsertQuery;
+    QSqlQuery m_transactionMappingInsertQuery;
+    QSqlQuery m_sessionMappingInsertQuery;
+    bool m_queriesPrepared = false;
+
+    std::vector<ValueRow> m_valueRows;
+    std::vector<MappingRow> m_transactionMappings;
+    std::vector<MappingRow> m_sessionMappings;
+    /**
+     * @brief m_bytes
+     * Arena for texts and blobs, referenced by offset/length from the rows
+     */
+    std::vector<char> m_bytes;
+
+    QString m_lastError;
+};
+} // namespace VeinLogger
+
+#endif // VEINLOGGER_SQLITEBATCHWRITER_H
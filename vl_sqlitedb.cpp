@@ -1,10 +1,26 @@
 #include "vl_sqlitedb.h"
+#include "vl_logrecordqueue.h"
+#include "vl_sqlitebatchwriter.h"
+#include "vl_sqliterollupwriter.h"
+#include "vl_valuecodec.h"
+#include "vl_sqlitereadpool.h"
+#include "vl_spillfile.h"
+#include "vl_valuejournal.h"
+#include "vl_storagemonitor.h"
 #include <QMetaType>
 #include <QDebug>
 #include <QJsonDocument>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QSet>
 #include <QtSql>
 #include <QtSql/QSqlQuery>
-#include <QMultiMap>
+
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
 
 namespace VeinLogger
 {
@@ -15,62 +31,140 @@ class DBPrivate
     DBPrivate(SQLiteDB *t_qPtr) :
         m_qPtr(t_qPtr)
     {
+        m_encodeBuffer.reserve(1024);
     }
 
-    QVariant getTextRepresentation(const QVariant &t_value) const
+    /**
+     * @brief appendTextRepresentation
+     * Sets the value of the current m_batchWriter row, scalars keep their native type
+     */
+    void appendTextRepresentation(const QVariant &t_value)
     {
-        QVariant retVal;
         switch(static_cast<QMetaType::Type>(t_value.type())) { //see http://stackoverflow.com/questions/31290606/qmetatypefloat-not-in-qvarianttype
         case QMetaType::Bool:
-        case QMetaType::Float:
-        case QMetaType::Double:
         case QMetaType::Int:
         case QMetaType::UInt:
         case QMetaType::Long:
-        case QMetaType::LongLong:
-        case QMetaType::QString:
+        case QMetaType::LongLong: {
+            m_batchWriter.setIntegerValue(t_value.toLongLong());
+            break;
+        }
+        case QMetaType::Float:
+        case QMetaType::Double: {
+            m_batchWriter.setRealValue(t_value.toDouble());
+            break;
+        }
+        case QMetaType::QString: {
+            m_batchWriter.setTextValue(t_value.toString().toUtf8());
+            break;
+        }
         case QMetaType::QByteArray: {
-            retVal = t_value;
+            m_batchWriter.setBlobValue(t_value.toByteArray());
             break;
         }
         case QMetaType::QVariant: {
             //try to store as string
-            retVal = t_value.toString();
+            m_batchWriter.setTextValue(t_value.toString().toUtf8());
             break;
         }
         case QMetaType::QVariantMap: {
             QJsonDocument tmpDoc;
             tmpDoc.setObject(QJsonObject::fromVariantMap(t_value.toMap()));
-            retVal = QString::fromUtf8(tmpDoc.toJson());
+            m_batchWriter.setTextValue(tmpDoc.toJson());
             break;
         }
         default: {
-            const int tmpDataType = QMetaType::type(t_value.typeName());
+            const int tmpDataType = t_value.userType();
 
-            if(tmpDataType == QMetaType::type("QList<double>")) { //store as double list
-                retVal = convertListToString<QList<double> >(t_value);
+            if(tmpDataType == qMetaTypeId<QList<double> >()) { //store as double list
+                m_batchWriter.setTextValue(convertListToString<QList<double> >(t_value).toUtf8());
+            }
+            else if(tmpDataType == qMetaTypeId<QList<int> >()) { //store as int list
+                m_batchWriter.setTextValue(convertListToString<QList<int> >(t_value).toUtf8());
             }
-            else if(tmpDataType == QMetaType::type("QList<int>")) { //store as int list
-                retVal = convertListToString<QList<int> >(t_value);
+            else if(tmpDataType == QMetaType::QStringList) { //store as string
+                m_batchWriter.setTextValue(t_value.toStringList().join(';').toUtf8());
             }
-            else if(tmpDataType == QMetaType::type("QStringList") || tmpDataType == QMetaType::type("QList<QString>")) { //store as string
-                retVal = t_value.toStringList().join(';');
+            else {
+                m_batchWriter.setNullValue();
             }
             break;
         }
         }
-        return retVal;
     }
 
-    QByteArray getBinaryRepresentation(const QVariant &t_value) const
+    /**
+     * @brief getBinaryRepresentation
+     * @return ValueCodec representation of t_value, valid until the next call
+     */
+    const QByteArray &getBinaryRepresentation(const QVariant &t_value)
     {
-        QByteArray tmpData;
-        QDataStream dataWriter(&tmpData, QIODevice::WriteOnly);
-        dataWriter.device()->seek(0);
-        dataWriter.setVersion(QDataStream::Qt_5_0);
-        dataWriter << t_value;
+        //keeps its capacity, see QByteArray::reserve
+        m_encodeBuffer.resize(0);
+        ValueCodec::encode(t_value, m_encodeBuffer);
+        return m_encodeBuffer;
+    }
 
-        return tmpData;
+    /**
+     * @brief appendTypedRepresentation
+     * Sets the value of the current m_batchWriter row for STORAGE_MODE::TYPED
+     *
+     * Numbers and strings use the native sqlite storage classes INTEGER, REAL and TEXT,
+     * everything else is stored as BLOB in the binary representation.
+     */
+    void appendTypedRepresentation(const QVariant &t_value)
+    {
+        switch(static_cast<QMetaType::Type>(t_value.type())) { //see http://stackoverflow.com/questions/31290606/qmetatypefloat-not-in-qvarianttype
+        case QMetaType::Bool:
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::Long:
+        case QMetaType::LongLong: {
+            m_batchWriter.setIntegerValue(t_value.toLongLong());
+            break;
+        }
+        case QMetaType::Float:
+        case QMetaType::Double: {
+            m_batchWriter.setRealValue(t_value.toDouble());
+            break;
+        }
+        case QMetaType::QString: {
+            m_batchWriter.setTextValue(t_value.toString().toUtf8());
+            break;
+        }
+        default: {
+            if(t_value.isValid()) {
+                m_batchWriter.setBlobValue(getBinaryRepresentation(t_value));
+            }
+            else {
+                m_batchWriter.setNullValue();
+            }
+            break;
+        }
+        }
+    }
+
+    /**
+     * @brief appendValueRow
+     * Adds one valuemap row for t_entry to m_batchWriter, the value is stored according to m_storageMode
+     */
+    void appendValueRow(qint64 t_valueId, const SQLBatchData &t_entry)
+    {
+        m_batchWriter.addValueRow(t_valueId, t_entry.timestamp, t_entry.componentId, t_entry.entityId);
+        switch(m_storageMode) {
+        case SQLiteDB::STORAGE_MODE::BINARY: {
+            m_batchWriter.setBlobValue(getBinaryRepresentation(t_entry.value)); //store as binary
+            break;
+        }
+        case SQLiteDB::STORAGE_MODE::TYPED: {
+            appendTypedRepresentation(t_entry.value); //store in native storage classes
+            break;
+        }
+        default: {
+            appendTextRepresentation(t_entry.value); //store as text
+            break;
+        }
+        }
     }
 
     template <class T> QString convertListToString(QVariant t_value) const
@@ -88,92 +182,939 @@ class DBPrivate
     }
 
 
-    QVariant readSessionComponent(const QString &p_session, const QString &p_entity, const QString &p_component){
-        QVariant retVal;
-        if(m_logDB.isOpen()){
-            m_sessionCustomerQuery.bindValue(":sessionname",p_session);
-            m_sessionCustomerQuery.bindValue(":entity",p_entity);
-            m_sessionCustomerQuery.bindValue(":component",p_component);
-            if (!m_sessionCustomerQuery.exec()){
-                QString err=m_sessionCustomerQuery.lastError().text();
-                return retVal;
+    QSharedPointer<SQLiteReadPool> readPool()
+    {
+        QMutexLocker locker(&m_readPoolMutex);
+        return m_readPool;
+    }
+
+    void setReadPool(QSharedPointer<SQLiteReadPool> t_readPool)
+    {
+        QSharedPointer<SQLiteReadPool> oldPool;
+        {
+            QMutexLocker locker(&m_readPoolMutex);
+            oldPool.swap(m_readPool);
+            m_readPool = t_readPool;
+        }
+        //oldPool is released outside the lock, a running read keeps its own reference
+    }
+
+    /**
+     * @brief cachedSessionStaticData
+     * @param t_generation: set to the current m_sessionStaticDataGeneration if t_session is not cached
+     * @return true if t_session is cached
+     */
+    bool cachedSessionStaticData(const QString &t_session, QHash<QString, QVariantHash> &t_staticData, quint64 &t_generation)
+    {
+        QMutexLocker locker(&m_sessionStaticDataMutex);
+        const auto iter = m_sessionStaticData.constFind(t_session);
+        if(iter != m_sessionStaticData.constEnd()) {
+            t_staticData = iter.value();
+            return true;
+        }
+        t_generation = m_sessionStaticDataGeneration;
+        return false;
+    }
+
+    /**
+     * @brief cacheSessionStaticData
+     * @param t_generation: generation the data was read at, data read before an invalidation is dropped
+     *
+     * Sessions that are being deleted are not cached, a read between two delete chunks sees partly deleted data.
+     */
+    void cacheSessionStaticData(const QString &t_session, const QHash<QString, QVariantHash> &t_staticData, quint64 t_generation)
+    {
+        QMutexLocker locker(&m_sessionStaticDataMutex);
+        if(t_generation == m_sessionStaticDataGeneration && m_uncachedSessions.contains(t_session) == false) {
+            m_sessionStaticData.insert(t_session, t_staticData);
+        }
+    }
+
+    /**
+     * @brief invalidateSessionStaticData
+     * @param t_sessions: sessions to remove from the cache, all sessions if empty
+     */
+    void invalidateSessionStaticData(const QStringList &t_sessions)
+    {
+        QMutexLocker locker(&m_sessionStaticDataMutex);
+        if(t_sessions.isEmpty()) {
+            m_sessionStaticData.clear();
+        }
+        for(const QString &session : t_sessions) {
+            m_sessionStaticData.remove(session);
+        }
+        ++m_sessionStaticDataGeneration;
+    }
+
+    /**
+     * @brief setDeletingSessions
+     * @param t_sessions: the sessions of m_deletingSessions, empty once the deletion completed or aborted
+     *
+     * Invalidates the sessions passed before and t_sessions, the cache refuses t_sessions until the next call.
+     */
+    void setDeletingSessions(const QStringList &t_sessions)
+    {
+        QMutexLocker locker(&m_sessionStaticDataMutex);
+        for(const QString &session : qAsConst(m_uncachedSessions)) {
+            m_sessionStaticData.remove(session);
+        }
+        m_uncachedSessions.clear();
+        for(const QString &session : t_sessions) {
+            m_sessionStaticData.remove(session);
+            m_uncachedSessions.insert(session);
+        }
+        ++m_sessionStaticDataGeneration;
+    }
+
+    /**
+     * @brief applyDurabilityProfile
+     * Sets journal and sync mode according to m_durabilityProfile
+     */
+    void applyDurabilityProfile()
+    {
+        QSqlQuery pragmaQuery(m_logDB);
+        //WAL: readers do not block the writer and a commit is a sequential append to the -wal file
+        if(pragmaQuery.exec("pragma journal_mode = wal;") && pragmaQuery.next()) {
+            if(pragmaQuery.value(0).toString() != QLatin1String("wal")) {
+                qCWarning(VEIN_LOGGER) << "Database" << m_logDB.databaseName() << "does not support WAL, journal mode:" << pragmaQuery.value(0).toString();
             }
+        }
+        pragmaQuery.finish();
+        //NORMAL syncs on checkpoints only: a power failure may lose the last commits but does not corrupt the database
+        if(m_durabilityProfile == SQLiteDB::DURABILITY_PROFILE::SAFE) {
+            pragmaQuery.exec("pragma synchronous = full;");
+        }
+        else {
+            pragmaQuery.exec("pragma synchronous = normal;");
+        }
+        //checkpoints normally run in runMaintenance, the automatic checkpoint only limits the -wal size under permanent load
+        pragmaQuery.exec(QString("pragma wal_autocheckpoint = %1;").arg(s_walAutoCheckpointPages));
+        pragmaQuery.finish();
+        qCDebug(VEIN_LOGGER) << "Durability profile" << SQLiteDB::durabilityProfileName(m_durabilityProfile) << "applied to" << m_logDB.databaseName();
+    }
+
+    /**
+     * @brief checkpoint
+     * Copies the write ahead log into the database file without waiting for readers
+     */
+    void checkpoint()
+    {
+        QSqlQuery checkpointQuery(m_logDB);
+        if(checkpointQuery.exec("pragma wal_checkpoint(passive);") && checkpointQuery.next()) {
+            //busy, frames in the log, frames checkpointed
+            const int logFrames = checkpointQuery.value(1).toInt();
+            const int checkpointedFrames = checkpointQuery.value(2).toInt();
+            m_walDirty = checkpointedFrames < logFrames;
+        }
+        checkpointQuery.finish();
+        m_lastCheckpointTimer.start();
+    }
+
+    /**
+     * @brief The SchemaMigrationStep struct
+     * One statement of the upgrade to version, statements must be idempotent
+     *
+     * Immediate steps create tables the writer needs right away, they also run on open (see runImmediateMigrationSteps).
+     */
+    struct SchemaMigrationStep
+    {
+        int version;
+        QString statement;
+        bool immediate;
+    };
 
-            while(m_sessionCustomerQuery.next()){
-                int fieldNo = m_sessionCustomerQuery.record().indexOf("component_value");
-                retVal=m_sessionCustomerQuery.value(fieldNo);
+    /**
+     * @brief schemaMigrationSteps
+     * @return steps to upgrade a database with user_version t_fromVersion to s_schemaVersion
+     *
+     * The schema files create version 0, everything added later is a migration step
+     */
+    static QVector<SchemaMigrationStep> schemaMigrationSteps(int t_fromVersion)
+    {
+        QVector<SchemaMigrationStep> retVal;
+        if(t_fromVersion < 1) {
+            //version 1: lookups by name and the reverse lookups of the mapping tables (deleteSession)
+            retVal.append({1, QStringLiteral("CREATE INDEX IF NOT EXISTS sessions_session_name ON sessions (session_name);"), false});
+            retVal.append({1, QStringLiteral("CREATE INDEX IF NOT EXISTS transactions_sessionid_name ON transactions (sessionid, transaction_name);"), false});
+            retVal.append({1, QStringLiteral("CREATE INDEX IF NOT EXISTS transactions_valuemap_valueid ON transactions_valuemap (valueid);"), false});
+            retVal.append({1, QStringLiteral("CREATE INDEX IF NOT EXISTS sessions_valuemap_valueid ON sessions_valuemap (valueid);"), false});
+        }
+        if(t_fromVersion < 2) {
+            //version 2: time range reads of one component (readRange), costs one more index entry per value
+            retVal.append({2, QStringLiteral("CREATE INDEX IF NOT EXISTS valuemap_entity_component_timestamp ON valuemap (entityiesid, componentid, value_timestamp);"), false});
+        }
+        if(t_fromVersion < 3) {
+            //version 3: tables written from the first batch on, created on open (immediate)
+            //the metadata of a transaction, e.g. its downsampling
+            retVal.append({3, QStringLiteral("CREATE TABLE IF NOT EXISTS transactions_metadata (transactionsid integer(10) NOT NULL, metadata_key varchar(255) NOT NULL, metadata_value TEXT,"
+                                             " PRIMARY KEY (transactionsid, metadata_key), FOREIGN KEY(transactionsid) REFERENCES transactions(id)) WITHOUT ROWID;"), true});
+            //rollups of existing databases start with the first batch after the upgrade, older values are read from valuemap
+            retVal.append({3, SQLiteRollupWriter::createTableStatement(SQLiteRollupWriter::s_secondTable), true});
+            retVal.append({3, SQLiteRollupWriter::createTableStatement(SQLiteRollupWriter::s_minuteTable), true});
+            //epoch of the last value journal records committed with a batch (replayJournal)
+            retVal.append({3, QStringLiteral("CREATE TABLE IF NOT EXISTS journal_state (id INTEGER PRIMARY KEY CHECK (id = 0), epoch INTEGER NOT NULL);"), true});
+        }
+        if(t_fromVersion < 4) {
+            //version 4: the first value of each transaction in the rollups, readTrend takes the older values from valuemap
+            retVal.append({4, SQLiteRollupWriter::coverageTableStatement(), true});
+            //entity and component lookups by name of the trend and range reads
+            retVal.append({4, QStringLiteral("CREATE INDEX IF NOT EXISTS entities_entity_name ON entities (entity_name);"), false});
+            retVal.append({4, QStringLiteral("CREATE INDEX IF NOT EXISTS components_component_name ON components (component_name);"), false});
+        }
+        return retVal;
+    }
+
+    /**
+     * @brief runImmediateMigrationSteps
+     * Runs the immediate steps of m_pendingMigrationSteps ahead of the others, they stay pending to set the version in order
+     * @return false on error, see t_error
+     */
+    bool runImmediateMigrationSteps(QString &t_error)
+    {
+        for(const SchemaMigrationStep &step : qAsConst(m_pendingMigrationSteps)) {
+            if(step.immediate) {
+                QSqlQuery migrationQuery(m_logDB);
+                if(migrationQuery.exec(step.statement) == false) {
+                    t_error = QString("version %1: %2 %3").arg(step.version).arg(step.statement).arg(migrationQuery.lastError().text());
+                    return false;
+                }
+                migrationQuery.finish();
             }
         }
+        return true;
+    }
+
+    int readSchemaVersion()
+    {
+        int retVal = 0;
+        QSqlQuery versionQuery(m_logDB);
+        if(versionQuery.exec("pragma user_version;") && versionQuery.next()) {
+            retVal = versionQuery.value(0).toInt();
+        }
+        versionQuery.finish();
         return retVal;
     }
 
-    QJsonDocument readTransaction(const QString &p_transaction, const QString &p_session)
+    /**
+     * @brief runMigrationStep
+     * Executes the first of m_pendingMigrationSteps in its own transaction, the version is set with the last step of a version
+     * @return false on error, the remaining steps are dropped then
+     */
+    bool runMigrationStep()
     {
-        QJsonDocument  retVal;
-        QJsonArray     recordsArray;
-        m_readTransactionQuery.bindValue(":transaction",p_transaction);
-        m_readTransactionQuery.bindValue(":sessionname",p_session);
-        if (!m_readTransactionQuery.exec())return QJsonDocument();
+        const SchemaMigrationStep step = m_pendingMigrationSteps.takeFirst();
+        const bool versionComplete = m_pendingMigrationSteps.isEmpty() || m_pendingMigrationSteps.first().version != step.version;
+        QElapsedTimer stepTimer;
+        stepTimer.start();
+        QSqlQuery migrationQuery(m_logDB);
+        bool retVal = m_logDB.transaction() && migrationQuery.exec(step.statement);
+        if(retVal && versionComplete) {
+            retVal = migrationQuery.exec(QString("pragma user_version = %1;").arg(step.version));
+        }
+        migrationQuery.finish();
+        retVal = retVal && m_logDB.commit();
+        if(retVal == false) {
+            qCWarning(VEIN_LOGGER) << "Schema migration of" << m_logDB.databaseName() << "failed:" << step.statement << migrationQuery.lastError().text();
+            m_logDB.rollback();
+            m_pendingMigrationSteps.clear();
+            return retVal;
+        }
+        m_walDirty = true;
+        vCDebug(VEIN_LOGGER) << "Schema migration step" << step.statement << "took" << stepTimer.elapsed() << "ms";
+        if(versionComplete) {
+            qCDebug(VEIN_LOGGER) << "Database" << m_logDB.databaseName() << "upgraded to schema version" << step.version;
+        }
+        return retVal;
+    }
 
-        while(m_readTransactionQuery.next())
-        {
-            QJsonObject recordObject;
-            for(int x=0; x < m_readTransactionQuery.record().count(); x++)
-            {
-                recordObject.insert( m_readTransactionQuery.record().fieldName(x),QJsonValue::fromVariant(m_readTransactionQuery.value(x)) );
+    /**
+     * @brief readNextId
+     * @param t_nextId: set to the id following the highest one ever used in t_table,
+     * sqlite_sequence keeps it for deleted rows so their ids are not handed out again
+     */
+    bool readNextId(const QString &t_table, qint64 &t_nextId)
+    {
+        QSqlQuery seedQuery(m_logDB);
+        const bool retVal = seedQuery.exec(QString("SELECT MAX(COALESCE((SELECT MAX(id) FROM %1), 0), COALESCE((SELECT seq FROM sqlite_sequence WHERE name = '%1'), 0));").arg(t_table))
+                && seedQuery.next();
+        if(retVal) {
+            t_nextId = seedQuery.value(0).toLongLong() + 1;
+        }
+        else {
+            emit m_qPtr->sigDatabaseError(QString("Error reading the highest id of %1: %2").arg(t_table, seedQuery.lastError().text()));
+        }
+        //close the query as we read all data from it and it has to be closed to commit the transaction
+        seedQuery.finish();
+        return retVal;
+    }
+
+    qint64 readPragma(const QString &t_pragma)
+    {
+        qint64 retVal = 0;
+        QSqlQuery pragmaQuery(m_logDB);
+        if(pragmaQuery.exec(QString("pragma %1;").arg(t_pragma)) && pragmaQuery.next()) {
+            retVal = pragmaQuery.value(0).toLongLong();
+        }
+        pragmaQuery.finish();
+        return retVal;
+    }
+
+    /**
+     * @brief updateReclaimableSize
+     * Emits sigReclaimableSizeChanged if the size of the free pages changed
+     */
+    void updateReclaimableSize()
+    {
+        const qint64 reclaimableBytes = readPragma("freelist_count") * readPragma("page_size");
+        if(reclaimableBytes != m_reclaimableBytes) {
+            m_reclaimableBytes = reclaimableBytes;
+            emit m_qPtr->sigReclaimableSizeChanged(m_reclaimableBytes);
+        }
+    }
+
+    /**
+     * @brief reclaimFreePages
+     * Returns up to s_incrementalVacuumPages free pages to the file system, the file shrinks with the next checkpoint.
+     * After a failure the next attempt waits s_vacuumRetryDelayMs.
+     */
+    void reclaimFreePages()
+    {
+        if(m_vacuumRetryTimer.isValid() && m_vacuumRetryTimer.hasExpired(s_vacuumRetryDelayMs) == false) {
+            return;
+        }
+        QElapsedTimer vacuumTimer;
+        vacuumTimer.start();
+        QString vacuumError;
+        if(m_nativeHandle != nullptr) {
+            //every step frees one page, sqlite3_exec steps until all are done. The handle is only set if QSQLITE uses our library, see SQLiteBatchWriter::nativeHandle
+            char *errorMessage = nullptr;
+            const QByteArray vacuumStatement = QString("pragma incremental_vacuum(%1);").arg(s_incrementalVacuumPages).toLatin1();
+            const int resultCode = sqlite3_exec(m_nativeHandle, vacuumStatement.constData(), nullptr, nullptr, &errorMessage);
+            if(resultCode != SQLITE_OK) {
+                vacuumError = QString("%1 (code %2)").arg(QString::fromUtf8(errorMessage != nullptr ? errorMessage : sqlite3_errstr(resultCode))).arg(sqlite3_extended_errcode(m_nativeHandle));
+            }
+            sqlite3_free(errorMessage);
+        }
+        else {
+            //QSQLITE steps a statement without result columns only once, so one page per exec
+            QSqlQuery vacuumQuery(m_logDB);
+            for(int page = 0; page < s_incrementalVacuumPages && vacuumError.isEmpty(); ++page) {
+                if(vacuumQuery.exec("pragma incremental_vacuum(1);") == false) {
+                    vacuumError = QString("%1 (code %2)").arg(vacuumQuery.lastError().text(), vacuumQuery.lastError().nativeErrorCode());
+                }
             }
-            recordsArray.push_back(recordObject);
+            vacuumQuery.finish();
+        }
+        if(vacuumError.isEmpty()) {
+            m_vacuumRetryTimer.invalidate();
+            m_walDirty = true;
+            vCDebug(VEIN_LOGGER) << "Incremental vacuum took" << vacuumTimer.elapsed() << "ms";
         }
-        retVal.setArray(recordsArray);
+        else {
+            m_vacuumRetryTimer.start();
+            qCWarning(VEIN_LOGGER) << "Incremental vacuum of" << m_logDB.databaseName() << "failed:" << vacuumError << "- retrying in" << s_vacuumRetryDelayMs / 1000 << "s";
+        }
+    }
+
+    /**
+     * @brief convertToIncrementalVacuum
+     * One time conversion of a database created without auto_vacuum, rewrites the whole file with VACUUM
+     * @return false on error
+     */
+    bool convertToIncrementalVacuum()
+    {
+        bool retVal = false;
+        const QFileInfo fileInfo(m_logDB.databaseName());
+        //VACUUM builds a copy of the database
+        if(m_storageMonitor != nullptr && m_storageMonitor->bytesAvailable() < 2 * fileInfo.size()) {
+            qCWarning(VEIN_LOGGER) << "Not enough free space to convert" << m_logDB.databaseName() << "to incremental auto vacuum";
+            return retVal;
+        }
+        QElapsedTimer vacuumTimer;
+        vacuumTimer.start();
+        QSqlQuery vacuumQuery(m_logDB);
+        if(vacuumQuery.exec("pragma auto_vacuum = incremental;") && vacuumQuery.exec("VACUUM;")) {
+            m_autoVacuumMode = readPragma("auto_vacuum");
+            retVal = m_autoVacuumMode == 2;
+            qCDebug(VEIN_LOGGER) << "Converted" << m_logDB.databaseName() << "to incremental auto vacuum in" << vacuumTimer.elapsed() << "ms";
+        }
+        else {
+            qCWarning(VEIN_LOGGER) << "Converting" << m_logDB.databaseName() << "to incremental auto vacuum failed:" << vacuumQuery.lastError().text();
+        }
+        vacuumQuery.finish();
+        m_walDirty = true;
         return retVal;
     }
 
-    QHash<QString, int> m_sessionIds;
-    QHash<int, QString> m_transactionIds;
-    QVector<int> m_entityIds;
-    QHash<QString, int> m_componentIds;
+    /**
+     * @brief queryPlanScans
+     * @return full table scans in the query plans of the read, write and delete statements
+     */
+    QStringList queryPlanScans()
+    {
+        QStringList statements = SQLiteBatchWriter::statements();
+        for(const QSqlQuery *query : {&m_componentInsertQuery, &m_entityInsertQuery, &m_transactionInsertQuery, &m_startTimeUpdateQuery,
+                                      &m_stopTimeUpdateQuery, &m_sessionInsertQuery, &m_transactionMetadataInsertQuery, &m_journalEpochUpdateQuery}) {
+            statements.append(query->lastQuery());
+        }
+        statements.append(SQLiteRollupWriter::statements());
+        QSqlQuery createQuery(m_logDB);
+        if(createDeleteTables(createQuery)) {
+            for(int i = static_cast<int>(DELETE_STATEMENT::CLEAR_CHUNK); i < static_cast<int>(DELETE_STATEMENT::COUNT); ++i) {
+                statements.append(deleteStatement(static_cast<DELETE_STATEMENT>(i)));
+            }
+        }
+        createQuery.finish();
+        //the temp tables only hold the ids of one deletion
+        QStringList retVal = SQLiteReadPool::queryPlanScans(m_logDB, statements, {"delete_sessions", "delete_transactions", "delete_chunk"});
+        QSharedPointer<SQLiteReadPool> pool = readPool();
+        if(pool.isNull() == false) {
+            retVal.append(pool->queryPlanScans());
+        }
+        return retVal;
+    }
 
-    QVector<SQLBatchData> m_batchVector;
+    /**
+     * @brief verifyQueryPlans
+     * Warns about queries that scan a whole table, called once the schema is up to date
+     */
+    void verifyQueryPlans()
+    {
+        for(const QString &scan : queryPlanScans()) {
+            qCWarning(VEIN_LOGGER) << "Full table scan in query plan of" << m_logDB.databaseName() << scan;
+        }
+    }
 
-    QFile m_queryReader;
+    enum class DELETE_PHASE : int {
+        IDLE = 0,
+        TRANSACTION_VALUES, ///< values mapped to the transactions of the deleted sessions
+        STATIC_VALUES, ///< values mapped to the deleted sessions (static data)
+        ROLLUPS, ///< the rollup rows of the deleted transactions
+        PARENTS, ///< the transactions and sessions
+    };
+
+    enum class DELETE_STATEMENT : int {
+        CLEAR_CHUNK = 0,
+        TRANSACTION_VALUES_CHUNK, ///< fills temp.delete_chunk
+        TRANSACTION_VALUES_MAPPINGS,
+        STATIC_VALUES_CHUNK, ///< fills temp.delete_chunk
+        STATIC_VALUES_MAPPINGS,
+        UNREFERENCED_VALUES, ///< values of temp.delete_chunk not mapped to anything else
+        SECOND_ROLLUPS_CHUNK,
+        MINUTE_ROLLUPS,
+        ROLLUP_COVERAGE,
+        METADATA,
+        TRANSACTIONS,
+        SESSIONS,
+        CLEAR_TRANSACTIONS,
+        CLEAR_SESSIONS,
+        COUNT, ///< number of statements, not a statement
+    };
 
-    //commonly used queries
     /**
-     * @brief m_valueMapInsertQuery
-     * Insert values in database
+     * @brief createDeleteTables
+     * Creates the temp tables holding the sessions and transactions to delete, see runDeleteChunk
      */
-    QSqlQuery m_valueMapInsertQuery;
+    static bool createDeleteTables(QSqlQuery &t_query)
+    {
+        return t_query.exec("CREATE TEMP TABLE IF NOT EXISTS delete_sessions (id INTEGER PRIMARY KEY);")
+                && t_query.exec("CREATE TEMP TABLE IF NOT EXISTS delete_transactions (id INTEGER PRIMARY KEY);")
+                && t_query.exec("CREATE TEMP TABLE IF NOT EXISTS delete_chunk (valueid INTEGER PRIMARY KEY);");
+    }
+
     /**
-     * @brief m_valueMapSequenceQuery
-     * Get highest value id in database
+     * @brief deleteStatement
+     * @return the statements of runDeleteChunk, kept in one place so their query plans can be checked
      */
-    QSqlQuery m_valueMapSequenceQuery;
+    static QString deleteStatement(DELETE_STATEMENT t_statement)
+    {
+        switch(t_statement) {
+        case DELETE_STATEMENT::CLEAR_CHUNK:
+            return QStringLiteral("DELETE FROM temp.delete_chunk;");
+        case DELETE_STATEMENT::TRANSACTION_VALUES_CHUNK:
+            return QString("INSERT OR IGNORE INTO temp.delete_chunk SELECT valueid FROM transactions_valuemap WHERE transactionsid IN (SELECT id FROM temp.delete_transactions) LIMIT %1;").arg(s_deleteChunkSize);
+        case DELETE_STATEMENT::TRANSACTION_VALUES_MAPPINGS:
+            return QStringLiteral("DELETE FROM transactions_valuemap WHERE transactionsid IN (SELECT id FROM temp.delete_transactions) AND valueid IN (SELECT valueid FROM temp.delete_chunk);");
+        case DELETE_STATEMENT::STATIC_VALUES_CHUNK:
+            return QString("INSERT OR IGNORE INTO temp.delete_chunk SELECT valueid FROM sessions_valuemap WHERE sessionsid IN (SELECT id FROM temp.delete_sessions) LIMIT %1;").arg(s_deleteChunkSize);
+        case DELETE_STATEMENT::STATIC_VALUES_MAPPINGS:
+            return QStringLiteral("DELETE FROM sessions_valuemap WHERE sessionsid IN (SELECT id FROM temp.delete_sessions) AND valueid IN (SELECT valueid FROM temp.delete_chunk);");
+        case DELETE_STATEMENT::UNREFERENCED_VALUES:
+            //values can be mapped to transactions and sessions that are not deleted
+            return QStringLiteral("DELETE FROM valuemap WHERE id IN (SELECT valueid FROM temp.delete_chunk)"
+                                  " AND NOT EXISTS (SELECT 1 FROM transactions_valuemap WHERE transactions_valuemap.valueid = valuemap.id)"
+                                  " AND NOT EXISTS (SELECT 1 FROM sessions_valuemap WHERE sessions_valuemap.valueid = valuemap.id);");
+        case DELETE_STATEMENT::SECOND_ROLLUPS_CHUNK:
+            //one row per second and component, as many rows as values for components logged about once a second
+            return QString("DELETE FROM %1 WHERE (transactionsid, entityiesid, componentid, bucket_start) IN"
+                           " (SELECT transactionsid, entityiesid, componentid, bucket_start FROM %1 WHERE transactionsid IN (SELECT id FROM temp.delete_transactions) LIMIT %2);")
+                    .arg(QLatin1String(SQLiteRollupWriter::s_secondTable)).arg(s_deleteChunkSize);
+        case DELETE_STATEMENT::MINUTE_ROLLUPS:
+            return QString("DELETE FROM %1 WHERE transactionsid IN (SELECT id FROM temp.delete_transactions);").arg(QLatin1String(SQLiteRollupWriter::s_minuteTable));
+        case DELETE_STATEMENT::ROLLUP_COVERAGE:
+            return QString("DELETE FROM %1 WHERE transactionsid IN (SELECT id FROM temp.delete_transactions);").arg(QLatin1String(SQLiteRollupWriter::s_coverageTable));
+        case DELETE_STATEMENT::METADATA:
+            return QStringLiteral("DELETE FROM transactions_metadata WHERE transactionsid IN (SELECT id FROM temp.delete_transactions);");
+        case DELETE_STATEMENT::TRANSACTIONS:
+            return QStringLiteral("DELETE FROM transactions WHERE id IN (SELECT id FROM temp.delete_transactions);");
+        case DELETE_STATEMENT::SESSIONS:
+            return QStringLiteral("DELETE FROM sessions WHERE id IN (SELECT id FROM temp.delete_sessions);");
+        case DELETE_STATEMENT::CLEAR_TRANSACTIONS:
+            return QStringLiteral("DELETE FROM temp.delete_transactions;");
+        case DELETE_STATEMENT::CLEAR_SESSIONS:
+            return QStringLiteral("DELETE FROM temp.delete_sessions;");
+        default:
+            return QString();
+        }
+    }
+
     /**
-     * @brief m_transactionMappingInsertQuery
-     * Add transaction to database
+     * @brief runDeleteChunk
+     * Deletes up to s_deleteChunkSize mapping rows of the current phase in one database transaction
+     * and the values that are no longer referenced, advances m_deletePhase when the phase is complete
      *
-     * The id is needed beacause writing is done in batches
-     * and the ids are managed in this class parallel to the database
+     * The sessions and transactions to delete are stored in the temp tables delete_sessions and delete_transactions.
+     */
+    bool runDeleteChunk()
+    {
+        DELETE_PHASE nextPhase = m_deletePhase;
+        int deletedValues = 0;
+        QSqlQuery chunkQuery(m_logDB);
+        bool retVal = m_logDB.transaction();
+        switch(m_deletePhase) {
+        case DELETE_PHASE::TRANSACTION_VALUES:
+        case DELETE_PHASE::STATIC_VALUES: {
+            const bool transactionValues = m_deletePhase == DELETE_PHASE::TRANSACTION_VALUES;
+            retVal = retVal
+                    && chunkQuery.exec(deleteStatement(DELETE_STATEMENT::CLEAR_CHUNK))
+                    && chunkQuery.exec(deleteStatement(transactionValues ? DELETE_STATEMENT::TRANSACTION_VALUES_CHUNK : DELETE_STATEMENT::STATIC_VALUES_CHUNK));
+            const int chunkRows = retVal ? chunkQuery.numRowsAffected() : 0;
+            retVal = retVal
+                    && chunkQuery.exec(deleteStatement(transactionValues ? DELETE_STATEMENT::TRANSACTION_VALUES_MAPPINGS : DELETE_STATEMENT::STATIC_VALUES_MAPPINGS))
+                    && chunkQuery.exec(deleteStatement(DELETE_STATEMENT::UNREFERENCED_VALUES));
+            if(retVal) {
+                deletedValues = chunkQuery.numRowsAffected();
+            }
+            if(chunkRows == 0) {
+                nextPhase = transactionValues ? DELETE_PHASE::STATIC_VALUES : DELETE_PHASE::ROLLUPS;
+            }
+            break;
+        }
+        case DELETE_PHASE::ROLLUPS: {
+            retVal = retVal && chunkQuery.exec(deleteStatement(DELETE_STATEMENT::SECOND_ROLLUPS_CHUNK));
+            if(retVal && chunkQuery.numRowsAffected() == 0) {
+                retVal = chunkQuery.exec(deleteStatement(DELETE_STATEMENT::MINUTE_ROLLUPS))
+                        && chunkQuery.exec(deleteStatement(DELETE_STATEMENT::ROLLUP_COVERAGE));
+                nextPhase = DELETE_PHASE::PARENTS;
+            }
+            break;
+        }
+        case DELETE_PHASE::PARENTS: {
+            retVal = retVal
+                    && chunkQuery.exec(deleteStatement(DELETE_STATEMENT::METADATA))
+                    && chunkQuery.exec(deleteStatement(DELETE_STATEMENT::TRANSACTIONS))
+                    && chunkQuery.exec(deleteStatement(DELETE_STATEMENT::SESSIONS))
+                    && chunkQuery.exec(deleteStatement(DELETE_STATEMENT::CLEAR_TRANSACTIONS))
+                    && chunkQuery.exec(deleteStatement(DELETE_STATEMENT::CLEAR_SESSIONS));
+            nextPhase = DELETE_PHASE::IDLE;
+            break;
+        }
+        default:
+            break;
+        }
+        chunkQuery.finish();
+        retVal = retVal && m_logDB.commit();
+        if(retVal == false) {
+            qCWarning(VEIN_LOGGER) << "Error deleting sessions:" << chunkQuery.lastQuery() << chunkQuery.lastError().text();
+            m_logDB.rollback();
+            return retVal;
+        }
+        m_deletePhase = nextPhase;
+        m_deletedValueCount += deletedValues;
+        m_walDirty = true;
+        return retVal;
+    }
+
+    /**
+     * @brief emitDeletionProgress
+     * @param t_force: emit even if the last progress was sent less than s_deleteProgressIntervalMs ago
      */
-    QSqlQuery m_transactionMappingInsertQuery;
+    void emitDeletionProgress(bool t_force, bool t_failed = false)
+    {
+        if(t_force || m_deleteProgressTimer.isValid() == false || m_deleteProgressTimer.hasExpired(s_deleteProgressIntervalMs)) {
+            QVariantMap progress;
+            progress.insert("active", m_deletePhase != DELETE_PHASE::IDLE);
+            progress.insert("sessions", m_deletingSessions);
+            progress.insert("deletedValues", m_deletedValueCount);
+            progress.insert("failed", t_failed);
+            emit m_qPtr->sigSessionDeletionProgress(progress);
+            m_deleteProgressTimer.start();
+        }
+    }
 
     /**
-     * @brief m_sessionMappingInsertQuery
-     * store sessionId, valuemapId pairs
+     * @brief writeTransactionTimes
+     * Writes the pending start and stop times, called inside the transaction of a batch
+     */
+    bool writeTransactionTimes()
+    {
+        bool retVal = true;
+        for(auto iter = m_pendingStartTimes.constBegin(); retVal && iter != m_pendingStartTimes.constEnd(); ++iter) {
+            m_startTimeUpdateQuery.bindValue(":start_time", iter.value());
+            m_startTimeUpdateQuery.bindValue(":id", iter.key());
+            retVal = m_startTimeUpdateQuery.exec();
+        }
+        m_startTimeUpdateQuery.finish();
+        for(auto iter = m_pendingStopTimes.constBegin(); retVal && iter != m_pendingStopTimes.constEnd(); ++iter) {
+            m_stopTimeUpdateQuery.bindValue(":stop_time", iter.value());
+            m_stopTimeUpdateQuery.bindValue(":id", iter.key());
+            retVal = m_stopTimeUpdateQuery.exec();
+        }
+        m_stopTimeUpdateQuery.finish();
+        return retVal;
+    }
+
+    /**
+     * @brief approximateValueBytes
+     * @return rough size of a value row, only used for the maxBytes limit of the flush policy
+     */
+    static qint64 approximateValueBytes(const QVariant &t_value)
+    {
+        switch(t_value.userType()) {
+        case QMetaType::QString:
+            return s_rowOverheadBytes + 2 * t_value.toString().size();
+        case QMetaType::QByteArray:
+            return s_rowOverheadBytes + t_value.toByteArray().size();
+        default:
+            //lists of numbers, e.g. samples or harmonics
+            if(t_value.canConvert<QVariantList>()) {
+                return s_rowOverheadBytes + 8 * t_value.value<QSequentialIterable>().size();
+            }
+            return s_rowOverheadBytes + 8;
+        }
+    }
+
+    /**
+     * @brief requestFlush
+     * Writes the batch once the queued records are applied
+     */
+    void requestFlush()
+    {
+        if(m_flushQueued == false) {
+            m_flushQueued = true;
+            QMetaObject::invokeMethod(m_qPtr, "runBatchedExecution", Qt::QueuedConnection);
+        }
+    }
+
+    /**
+     * @brief tuneBatchSize
+     * @param t_rowCount: rows of the batch just written
+     * @param t_batchNsecs: time to write and commit it
      *
-     * writes static data to database
+     * Fits batch time = fixed cost + rows * row cost by least squares over the recent batches (older ones decay
+     * with s_costSampleDecay). Batches of different sizes are common, partial batches are flushed by the timer.
+     * The batch size converges to the number of rows that fit into 3/4 of the commit budget.
      */
-    QSqlQuery m_sessionMappingInsertQuery;
+    void tuneBatchSize(int t_rowCount, qint64 t_batchNsecs)
+    {
+        if(t_rowCount <= 0) {
+            return;
+        }
+        const double rows = t_rowCount;
+        const double nsecs = static_cast<double>(qMax(t_batchNsecs, qint64(1)));
+        m_costSamples.weight = m_costSamples.weight * s_costSampleDecay + 1.0;
+        m_costSamples.rows = m_costSamples.rows * s_costSampleDecay + rows;
+        m_costSamples.nsecs = m_costSamples.nsecs * s_costSampleDecay + nsecs;
+        m_costSamples.rowsSquared = m_costSamples.rowsSquared * s_costSampleDecay + rows * rows;
+        m_costSamples.rowsNsecs = m_costSamples.rowsNsecs * s_costSampleDecay + rows * nsecs;
+
+        double rowCostNs = m_costSamples.nsecs / m_costSamples.rows;
+        double fixedCostNs = 0.0;
+        //relative spread of the batch sizes, below 5% the slope is noise
+        const double rowsVariance = m_costSamples.weight * m_costSamples.rowsSquared - m_costSamples.rows * m_costSamples.rows;
+        if(rowsVariance > 0.0025 * m_costSamples.rows * m_costSamples.rows) {
+            const double slope = (m_costSamples.weight * m_costSamples.rowsNsecs - m_costSamples.rows * m_costSamples.nsecs) / rowsVariance;
+            const double intercept = (m_costSamples.nsecs - slope * m_costSamples.rows) / m_costSamples.weight;
+            if(slope > 0.0 && intercept >= 0.0) {
+                rowCostNs = slope;
+                fixedCostNs = intercept;
+            }
+        }
+        m_rowCostNs = qMax(rowCostNs, 1.0);
+        m_fixedCostNs = fixedCostNs;
+        updateEffectiveBatchRows();
+    }
+
+    void updateEffectiveBatchRows()
+    {
+        if(m_rowCostNs > 0.0) {
+            const double budgetNs = double(m_flushPolicy.commitBudgetMs) * 1000000.0 * 3.0 / 4.0;
+            //a fixed cost beyond the budget leaves the minimum size
+            const double rows = (budgetNs - m_fixedCostNs) / m_rowCostNs;
+            m_effectiveBatchRows = int(qBound(0.0, rows, double(std::numeric_limits<int>::max())));
+        }
+        m_effectiveBatchRows = qBound(qMin(s_minBatchRows, m_flushPolicy.maxRows), m_effectiveBatchRows, m_flushPolicy.maxRows);
+        //the size changes a bit with every batch, only larger steps are worth a notification
+        const int reportDelta = qAbs(m_effectiveBatchRows - m_reportedBatchRows);
+        if(reportDelta > 0 && (reportDelta >= m_reportedBatchRows / 8 || m_effectiveBatchRows == m_flushPolicy.maxRows)) {
+            m_reportedBatchRows = m_effectiveBatchRows;
+            emit m_qPtr->sigEffectiveBatchSizeChanged(m_effectiveBatchRows);
+        }
+    }
+
     /**
-     * @brief m_componentInsertQuery
-     * Add component to database
+     * @brief spillValue
+     * Appends a value to the spill file instead of the batch, opens the file with the first one
      */
-    QSqlQuery m_componentInsertQuery;
+    void spillValue(const SQLBatchData &t_batchData)
+    {
+        if(m_spillFile.isOpen() == false) {
+            const QString spillPath = SpillFile::pathForDatabase(m_logDB.databaseName());
+            if(m_spillFile.open(spillPath) == false) {
+                dropValue(m_spillFile.lastError());
+                return;
+            }
+            qCWarning(VEIN_LOGGER) << "Buffered values exceed" << s_memoryBudgetBytes << "bytes, spilling to" << spillPath;
+            emitBufferState(true);
+        }
+        if(m_spillFile.append(t_batchData) == false) {
+            dropValue(m_spillFile.lastError());
+            return;
+        }
+        scheduleSync();
+        emitBufferState(false);
+    }
+
+    void dropValue(const QString &t_reason)
+    {
+        //one warning per spill episode, a full volume fails for every value
+        if(m_droppedValueCount == m_reportedDroppedValueCount) {
+            qCWarning(VEIN_LOGGER) << "Dropping logged values, unable to spill:" << t_reason;
+        }
+        ++m_droppedValueCount;
+        emitBufferState(false);
+    }
+
+    /**
+     * @brief readSpilledValues
+     * Fills the empty batch with the next spilled values, values of unknown sessions, entities or components are dropped
+     */
+    void readSpilledValues()
+    {
+        Q_ASSERT(m_batchVector.isEmpty());
+        if(m_spillFile.read(m_effectiveBatchRows, m_batchVector) < 0) {
+            qCWarning(VEIN_LOGGER) << "Replaying spilled values failed:" << m_spillFile.lastError();
+            m_batchVector.clear();
+            m_spillFile.close();
+            emitBufferState(true);
+            return;
+        }
+        m_replayingSpill = true;
+        dropUnknownValues();
+    }
+
+    /**
+     * @brief dropUnknownValues
+     * Removes values of unknown sessions, entities or components from a batch read back from disk
+     */
+    void dropUnknownValues()
+    {
+        //ids are looked up per value, the maps are keyed by name
+        const QSet<int> knownEntityIds(m_entityIds.constBegin(), m_entityIds.constEnd());
+        QSet<int> knownComponentIds;
+        knownComponentIds.reserve(m_componentIds.size());
+        for(const int componentId : qAsConst(m_componentIds)) {
+            knownComponentIds.insert(componentId);
+        }
+        QSet<int> knownSessionIds;
+        knownSessionIds.reserve(m_sessionIds.size());
+        for(const int sessionId : qAsConst(m_sessionIds)) {
+            knownSessionIds.insert(sessionId);
+        }
+        for(auto iter = m_batchVector.begin(); iter != m_batchVector.end();) {
+            if(knownEntityIds.contains(iter->entityId) == false || knownComponentIds.contains(iter->componentId) == false || knownSessionIds.contains(iter->sessionId) == false) {
+                ++m_droppedValueCount;
+                iter = m_batchVector.erase(iter);
+            }
+            else {
+                m_batchBytes += approximateValueBytes(iter->value);
+                ++iter;
+            }
+        }
+    }
+
+    /**
+     * @brief openJournal
+     * Creates the journal for the first value, a failure is reported once per database
+     */
+    bool openJournal()
+    {
+        if(m_flushPolicy.journalSyncMs <= 0 || m_journalUnavailable || m_logDB.isOpen() == false) {
+            return false;
+        }
+        //an epoch stored by an earlier journal file must not match the records of this one
+        QSqlQuery clearEpochQuery(m_logDB);
+        if(clearEpochQuery.exec("DELETE FROM journal_state;") == false) {
+            qCWarning(VEIN_LOGGER) << "Values are not journaled:" << clearEpochQuery.lastError().text();
+            m_journalUnavailable = true;
+            return false;
+        }
+        clearEpochQuery.finish();
+        if(m_journal.open(ValueJournal::pathForDatabase(m_logDB.databaseName())) == false) {
+            qCWarning(VEIN_LOGGER) << "Values are not journaled:" << m_journal.lastError();
+            m_journalUnavailable = true;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief closeJournal
+     * An empty journal is removed, the next database opened creates its own when needed
+     */
+    void closeJournal()
+    {
+        if(m_journal.isOpen() && m_journal.isEmpty()) {
+            if(m_journal.remove() == false) {
+                qCWarning(VEIN_LOGGER) << m_journal.lastError();
+            }
+        }
+        else {
+            m_journal.close();
+        }
+    }
+
+    /**
+     * @brief readCommittedJournalEpoch
+     * @return journal epoch stored with the last committed batch, 0 if there is none
+     */
+    quint32 readCommittedJournalEpoch()
+    {
+        quint32 retVal = 0;
+        QSqlQuery epochQuery(m_logDB);
+        if(epochQuery.exec("SELECT epoch FROM journal_state WHERE id = 0;") && epochQuery.next()) {
+            retVal = epochQuery.value(0).toUInt();
+        }
+        epochQuery.finish();
+        return retVal;
+    }
+
+    /**
+     * @brief journalValue
+     * Writes a value appended to the batch to the journal
+     */
+    void journalValue(const SQLBatchData &t_batchData)
+    {
+        if(m_journal.isOpen() == false && openJournal() == false) {
+            return;
+        }
+        if(m_journal.append(t_batchData)) {
+            scheduleSync();
+        }
+        else if(m_journalOverflow == false) {
+            //the batch is written early, the values up to then are not crash safe
+            m_journalOverflow = true;
+            qCWarning(VEIN_LOGGER) << "Values are not journaled until the next batch:" << m_journal.lastError();
+            requestFlush();
+        }
+    }
+
+    /**
+     * @brief scheduleSync
+     * Starts the sync interval of the journal and the spill file with the first unsynced record
+     */
+    void scheduleSync()
+    {
+        if(m_syncTimer->isActive() == false) {
+            m_syncTimer->start(qMax(m_flushPolicy.journalSyncMs, 1));
+        }
+    }
+
+    /**
+     * @brief reportStorageFailure
+     * The logger closes the database on the error, so it is emitted once
+     */
+    void reportStorageFailure()
+    {
+        if(m_storageErrorReported == false && m_storageMonitor != nullptr) {
+            m_storageErrorReported = true;
+            emit m_qPtr->sigDatabaseError(m_storageMonitor->failureReason());
+        }
+    }
+
+    void startStorageMonitor(const QString &t_dbPath)
+    {
+        StorageMonitor::destroy(m_storageMonitor);
+        m_storageErrorReported = false;
+        m_storageMonitor = StorageMonitor::create(t_dbPath);
+        QObject::connect(m_storageMonitor, &StorageMonitor::sigStorageInfoChanged, m_qPtr, &AbstractLoggerDB::sigStorageInfoChanged);
+        QObject::connect(m_storageMonitor, &StorageMonitor::sigStorageFailed, m_qPtr, [this]() { reportStorageFailure(); });
+    }
+
+    /**
+     * @brief emitBufferState
+     * @param t_force: emit even if the last state was sent less than s_bufferStateIntervalMs ago
+     */
+    void emitBufferState(bool t_force)
+    {
+        if(t_force || m_bufferStateTimer.isValid() == false || m_bufferStateTimer.hasExpired(s_bufferStateIntervalMs)) {
+            QVariantMap bufferState;
+            bufferState.insert("bufferedBytes", m_batchBytes);
+            bufferState.insert("spilling", m_spillFile.isOpen());
+            bufferState.insert("spilledBytes", m_spillFile.pendingBytes());
+            bufferState.insert("replayedBytes", m_spillFile.replayedBytes());
+            bufferState.insert("droppedValues", m_droppedValueCount);
+            emit m_qPtr->sigIngestionBufferChanged(bufferState);
+            m_reportedDroppedValueCount = m_droppedValueCount;
+            m_bufferStateTimer.start();
+        }
+    }
+
+    QHash<QString, int> m_sessionIds;
+    QHash<int, QString> m_transactionIds;
+    /**
+     * @brief m_pendingStartTimes
+     * transaction id -> start time not yet written, kept until a batch commits
+     */
+    QHash<int, qint64> m_pendingStartTimes;
+    /**
+     * @brief m_pendingStopTimes
+     * transaction id -> time of the last value logged to the transaction, kept until a batch commits
+     */
+    QHash<int, qint64> m_pendingStopTimes;
+    QVector<int> m_entityIds;
+    QHash<QString, int> m_componentIds;
+
+    QVector<SQLBatchData> m_batchVector;
+    /**
+     * @brief m_batchWriter
+     * Inserts valuemap rows and their transaction/session mappings through the native sqlite3 handle
+     */
+    SQLiteBatchWriter m_batchWriter;
+    /**
+     * @brief m_rollupWriter
+     * Merges the scalar numbers of a batch into the per second and per minute rollup tables
+     */
+    SQLiteRollupWriter m_rollupWriter;
+    /**
+     * @brief m_rollupCoveredTransactions
+     * transactions whose rollup_coverage row was committed on this connection, the others are marked by the next batch
+     */
+    QSet<int> m_rollupCoveredTransactions;
+    /**
+     * @brief m_encodeBuffer
+     * reused by getBinaryRepresentation
+     */
+    QByteArray m_encodeBuffer;
+
+    QFile m_queryReader;
+
+    //commonly used queries
     /**
-     * @brief m_componentSequenceQuery
-     * get highest component id in database
+     * @brief m_componentInsertQuery
+     * Add component to database, the id is assigned by sqlite
      */
-    QSqlQuery m_componentSequenceQuery;
+    QSqlQuery m_componentInsertQuery;
     /**
      * @brief m_entityInsertQuery
      * Add entity to database
@@ -184,46 +1125,78 @@ class DBPrivate
     QSqlQuery m_entityInsertQuery;
     /**
      * @brief m_transactionInsertQuery
-     * add transactin to database
+     * add transactin to database with the id from reserveTransactionId
      */
     QSqlQuery m_transactionInsertQuery;
     /**
-     * @brief m_transactionSequenceQuery
-     * get highest transaction id in database
+     * @brief m_startTimeUpdateQuery
+     * set transaction start time
+     */
+    QSqlQuery m_startTimeUpdateQuery;
+    /**
+     * @brief m_stopTimeUpdateQuery
+     * set transaction stop time
      */
-    QSqlQuery m_transactionSequenceQuery;
+    QSqlQuery m_stopTimeUpdateQuery;
     /**
      * @brief m_sessionInsertQuery
-     * add session to database
-     *
-     * The id is needed beacause writing is done in batches
-     * and the ids are managed in this class parallel to the database
+     * add session to database with the id from m_nextSessionId, in the transaction of its static data
      */
     QSqlQuery m_sessionInsertQuery;
     /**
-     * @brief m_sessionSequenceQuery
-     * get highest session id to database
-     *
-     * The id is needed beacause writing is done in batches
-     * and the ids are managed in this class parallel to the database
+     * @brief m_transactionMetadataInsertQuery
+     * add or replace a key of the transaction metadata
      */
-    QSqlQuery m_sessionSequenceQuery;
+    QSqlQuery m_transactionMetadataInsertQuery;
     /**
-     * @brief m_readTransactionQuery
+     * @brief m_journalEpochUpdateQuery
+     * stores the journal epoch committed with a batch, see replayJournal
      */
-    QSqlQuery m_readTransactionQuery;
-
-
+    QSqlQuery m_journalEpochUpdateQuery;
+    /**
+     * @brief m_readPool
+     * read-only connections for readTransaction and readSessionComponent, guarded by m_readPoolMutex
+     */
+    QSharedPointer<SQLiteReadPool> m_readPool;
+    QMutex m_readPoolMutex;
     /**
-     * @brief m_sessionCustomerQuery
+     * @brief m_sessionStaticData
+     * session name -> entity name -> component name -> static value (e.g. of the entities 200 and 1150),
+     * filled by addSession or the first readSessionComponent of a session, guarded by m_sessionStaticDataMutex
      *
-     * Read session customer data file name
+     * The static data of a session is written once with the session, so the entries stay valid until the session is deleted.
      */
-    QSqlQuery m_sessionCustomerQuery;
+    QHash<QString, QHash<QString, QVariantHash> > m_sessionStaticData;
+    /**
+     * @brief m_sessionStaticDataGeneration
+     * incremented by invalidateSessionStaticData, reads that started before do not fill the cache
+     */
+    quint64 m_sessionStaticDataGeneration=0;
+    /**
+     * @brief m_uncachedSessions
+     * copy of m_deletingSessions for the readers, see setDeletingSessions
+     */
+    QSet<QString> m_uncachedSessions;
+    QMutex m_sessionStaticDataMutex;
 
 
 
-    int m_valueMapQueryCounter=0;
+    /**
+     * @brief m_nextValueId
+     * valuemap ids are assigned here because the mapping rows of a batch reference them,
+     * seeded once in openDatabase and reset to the first id of a batch if the batch fails
+     */
+    qint64 m_nextValueId=1;
+    /**
+     * @brief m_nextTransactionId
+     * handed out by reserveTransactionId in the logger thread, seeded in openDatabase, -1 before
+     */
+    std::atomic<int> m_nextTransactionId{-1};
+    /**
+     * @brief m_nextSessionId
+     * seeded in openDatabase, only advanced once the session row is committed
+     */
+    int m_nextSessionId=1;
     /**
      * @brief m_logDB
      * manages the actual database access
@@ -231,20 +1204,269 @@ class DBPrivate
     QSqlDatabase m_logDB;
 
     SQLiteDB::STORAGE_MODE m_storageMode=SQLiteDB::STORAGE_MODE::TEXT;
+    SQLiteDB::DURABILITY_PROFILE m_durabilityProfile=SQLiteDB::DURABILITY_PROFILE::FAST;
+    SQLiteDB::FlushPolicy m_flushPolicy;
+    /**
+     * @brief m_flushTimer
+     * single shot, started by the first value of a batch to write it after m_flushPolicy.maxAgeMs at the latest
+     */
+    QTimer *m_flushTimer=nullptr;
+    /**
+     * @brief m_flushQueued
+     * runBatchedExecution is queued or running, suppresses further flush requests
+     */
+    bool m_flushQueued=false;
+    qint64 m_batchBytes=0;
+    /**
+     * @brief m_effectiveBatchRows
+     * row limit of a batch, tuned by tuneBatchSize
+     */
+    int m_effectiveBatchRows=s_initialBatchRows;
+    int m_reportedBatchRows=0;
+    /**
+     * @brief The CostSamples struct
+     * Decayed sums of the batch sizes and times for the least squares fit in tuneBatchSize
+     */
+    struct CostSamples
+    {
+        double weight = 0.0;
+        double rows = 0.0;
+        double nsecs = 0.0;
+        double rowsSquared = 0.0;
+        double rowsNsecs = 0.0;
+    };
+    CostSamples m_costSamples;
+    /**
+     * @brief m_rowCostNs
+     * time to write one more row, 0 until the first batch was written
+     */
+    double m_rowCostNs=0.0;
+    /**
+     * @brief m_fixedCostNs
+     * time of a batch independent of its size (transaction, commit, fsync)
+     */
+    double m_fixedCostNs=0.0;
+    /**
+     * @brief m_spillFile
+     * values beyond s_memoryBudgetBytes, open while it has values not yet written to the database
+     */
+    SpillFile m_spillFile;
+    /**
+     * @brief m_storageMonitor
+     * free space and existence of the database file, refreshed in the background
+     */
+    StorageMonitor *m_storageMonitor=nullptr;
+    bool m_storageErrorReported=false;
+    /**
+     * @brief m_journal
+     * crash safe copy of m_batchVector, spilled and replayed values are not journaled
+     */
+    ValueJournal m_journal;
+    /**
+     * @brief m_journalOverflow
+     * a value of the current batch did not fit into the journal
+     */
+    bool m_journalOverflow=false;
+    /**
+     * @brief m_journalUnavailable
+     * creating the journal failed, values of this database are not journaled
+     */
+    bool m_journalUnavailable=false;
+    /**
+     * @brief m_syncTimer
+     * single shot, syncs journal and spill file m_flushPolicy.journalSyncMs after the first unsynced record
+     */
+    QTimer *m_syncTimer=nullptr;
+    /**
+     * @brief m_replayingSpill
+     * m_batchVector was read from the spill file and is still in there until the batch is committed
+     */
+    bool m_replayingSpill=false;
+    qint64 m_droppedValueCount=0;
+    qint64 m_reportedDroppedValueCount=0;
+    QElapsedTimer m_bufferStateTimer;
+    /**
+     * @brief s_memoryBudgetBytes
+     * approximate size of the values kept in m_batchVector, later values go to the spill file
+     */
+    static constexpr qint64 s_memoryBudgetBytes = 16 * 1024 * 1024;
+    static constexpr int s_bufferStateIntervalMs = 1000;
+    static constexpr int s_initialBatchRows = 1000;
+    static constexpr int s_minBatchRows = 100;
+    /**
+     * @brief s_costSampleDecay
+     * weight of the previous batches in the cost fit, same smoothing as a 3/4 moving average
+     */
+    static constexpr double s_costSampleDecay = 0.75;
+    /**
+     * @brief s_rowOverheadBytes
+     * ids, timestamp and the transaction mapping of a value row
+     */
+    static constexpr int s_rowOverheadBytes = 48;
+    /**
+     * @brief m_maintenanceTimer
+     * child of the SQLiteDB so it moves to the database thread
+     */
+    QTimer *m_maintenanceTimer=nullptr;
+    /**
+     * @brief m_walDirty
+     * the write ahead log contains frames that are not checkpointed yet
+     */
+    bool m_walDirty=false;
+    QElapsedTimer m_lastBatchTimer;
+    QElapsedTimer m_lastCheckpointTimer;
+    /**
+     * @brief m_pendingMigrationSteps
+     * schema upgrade of an existing database, executed step by step in runMaintenance
+     */
+    QVector<SchemaMigrationStep> m_pendingMigrationSteps;
+    /**
+     * @brief m_deletePhase
+     * state of the session deletion, IDLE if no deletion is running
+     */
+    DELETE_PHASE m_deletePhase=DELETE_PHASE::IDLE;
+    QStringList m_deletingSessions;
+    /**
+     * @brief m_deletedSessionIds
+     * sessions queued for deletion while the database is open, ids are never reused (AUTOINCREMENT)
+     */
+    QSet<int> m_deletedSessionIds;
+    /**
+     * @brief m_deletedTransactionIds
+     * transactions of m_deletedSessionIds, values still pending for them are not written, see writeBatch
+     */
+    QSet<int> m_deletedTransactionIds;
+    qint64 m_deletedValueCount=0;
+    QElapsedTimer m_deleteTimer;
+    QElapsedTimer m_deleteProgressTimer;
+    /**
+     * @brief s_deleteChunkSize
+     * mapping rows per delete chunk, keeps a chunk in the range of a batch
+     */
+    static constexpr int s_deleteChunkSize = 5000;
+    /**
+     * @brief m_autoVacuumMode
+     * pragma auto_vacuum: 0 none, 1 full, 2 incremental
+     */
+    int m_autoVacuumMode=0;
+    qint64 m_reclaimableBytes=-1;
+    /**
+     * @brief m_nativeHandle
+     * connection handle of m_logDB, owned by the QSQLITE driver
+     */
+    sqlite3 *m_nativeHandle=nullptr;
+    /**
+     * @brief s_incrementalVacuumPages
+     * pages per maintenance slice, 256 pages (1MB at the default page size) take a few ms
+     */
+    static constexpr int s_incrementalVacuumPages = 256;
+    /**
+     * @brief m_vacuumRetryTimer
+     * started by a failed incremental vacuum, e.g. SQLITE_BUSY or SQLITE_FULL, invalid otherwise
+     */
+    QElapsedTimer m_vacuumRetryTimer;
+    static constexpr int s_vacuumRetryDelayMs = 60000;
+    static constexpr int s_deleteProgressIntervalMs = 250;
+
+    /**
+     * @brief s_schemaVersion
+     * stored in pragma user_version, see schemaMigrationSteps
+     */
+    static constexpr int s_schemaVersion = 4;
+
+    /**
+     * @brief s_walAutoCheckpointPages
+     * 4096 pages (16MB at the default page size): rare checkpoints keep the write amplification on flash media low
+     */
+    static constexpr int s_walAutoCheckpointPages = 4096;
+    static constexpr int s_maintenanceIntervalMs = 1000;
+    /**
+     * @brief s_idleCheckpointDelayMs
+     * checkpoint when no batch was written for this time
+     */
+    static constexpr int s_idleCheckpointDelayMs = 2000;
+    /**
+     * @brief s_maxCheckpointIntervalMs
+     * checkpoint even if batches are written all the time
+     */
+    static constexpr int s_maxCheckpointIntervalMs = 30000;
 
     SQLiteDB *m_qPtr=nullptr;
 
     friend class SQLiteDB;
 };
 
+//constexpr definition, see: https://stackoverflow.com/questions/8016780/undefined-reference-to-static-constexpr-char
+constexpr int DBPrivate::s_schemaVersion;
+constexpr int DBPrivate::s_deleteChunkSize;
+constexpr int DBPrivate::s_incrementalVacuumPages;
+constexpr int DBPrivate::s_vacuumRetryDelayMs;
+constexpr int DBPrivate::s_deleteProgressIntervalMs;
+constexpr int DBPrivate::s_walAutoCheckpointPages;
+constexpr int DBPrivate::s_maintenanceIntervalMs;
+constexpr int DBPrivate::s_idleCheckpointDelayMs;
+constexpr int DBPrivate::s_maxCheckpointIntervalMs;
+constexpr qint64 DBPrivate::s_memoryBudgetBytes;
+constexpr int DBPrivate::s_bufferStateIntervalMs;
+constexpr int DBPrivate::s_initialBatchRows;
+constexpr int DBPrivate::s_minBatchRows;
+constexpr double DBPrivate::s_costSampleDecay;
+constexpr int DBPrivate::s_rowOverheadBytes;
+
 SQLiteDB::SQLiteDB(QObject *t_parent) : AbstractLoggerDB(t_parent), m_dPtr(new DBPrivate(this))
 {
     m_dPtr->m_logDB = QSqlDatabase::addDatabase("QSQLITE", "VFLogDB"); //default database
+    m_dPtr->m_maintenanceTimer = new QTimer(this);
+    m_dPtr->m_maintenanceTimer->setInterval(DBPrivate::s_maintenanceIntervalMs);
+    connect(m_dPtr->m_maintenanceTimer, &QTimer::timeout, this, &SQLiteDB::runMaintenance);
+    m_dPtr->m_flushTimer = new QTimer(this);
+    m_dPtr->m_flushTimer->setSingleShot(true);
+    connect(m_dPtr->m_flushTimer, &QTimer::timeout, this, &SQLiteDB::runBatchedExecution);
+    m_dPtr->m_syncTimer = new QTimer(this);
+    m_dPtr->m_syncTimer->setSingleShot(true);
+    connect(m_dPtr->m_syncTimer, &QTimer::timeout, this, [this]() {
+        if(m_dPtr->m_journal.sync() == false) {
+            qCWarning(VEIN_LOGGER) << m_dPtr->m_journal.lastError();
+        }
+        if(m_dPtr->m_spillFile.sync() == false) {
+            qCWarning(VEIN_LOGGER) << m_dPtr->m_spillFile.lastError();
+        }
+    });
 }
 
 SQLiteDB::~SQLiteDB()
 {
     runBatchedExecution(); //finish the remaining batch of data
+    //keep what could not be written for the next time the database is opened,
+    //journaled values are replayed from the journal before the spill file
+    const bool batchJournaled = m_dPtr->m_journal.isOpen() && m_dPtr->m_journalOverflow == false;
+    if(m_dPtr->m_logDB.isOpen() && m_dPtr->m_batchVector.isEmpty() == false && m_dPtr->m_replayingSpill == false && batchJournaled == false) {
+        qCWarning(VEIN_LOGGER) << "Spilling" << m_dPtr->m_batchVector.size() << "values that could not be written";
+        if(m_dPtr->m_spillFile.isOpen() && m_dPtr->m_spillFile.isReplayed() == false) {
+            //the batch is older than the values already spilled, keep the timestamp order
+            if(m_dPtr->m_spillFile.prepend(m_dPtr->m_batchVector)) {
+                m_dPtr->m_journal.truncate();
+            }
+            else {
+                qCWarning(VEIN_LOGGER) << "Dropping" << m_dPtr->m_batchVector.size() << "values:" << m_dPtr->m_spillFile.lastError();
+            }
+        }
+        else {
+            for(const SQLBatchData &entry : qAsConst(m_dPtr->m_batchVector)) {
+                m_dPtr->spillValue(entry);
+            }
+            if(m_dPtr->m_spillFile.sync()) {
+                m_dPtr->m_journal.truncate();
+            }
+        }
+    }
+    m_dPtr->m_spillFile.sync();
+    m_dPtr->m_spillFile.close();
+    m_dPtr->closeJournal();
+    StorageMonitor::destroy(m_dPtr->m_storageMonitor);
+    m_dPtr->setReadPool(QSharedPointer<SQLiteReadPool>());
+    m_dPtr->m_batchWriter.finalize(); //statements must not outlive the connection
+    m_dPtr->m_rollupWriter.finalize();
     m_dPtr->m_logDB.close();
     delete m_dPtr;
     QSqlDatabase::removeDatabase("VFLogDB");
@@ -265,26 +1487,56 @@ bool SQLiteDB::hasSessionName(const QString &t_sessionName) const
     return m_dPtr->m_sessionIds.contains(t_sessionName);
 }
 
-bool SQLiteDB::databaseIsOpen() const
+bool SQLiteDB::databaseIsOpen() const
+{
+    return m_dPtr->m_logDB.isOpen();
+}
+
+QString SQLiteDB::databasePath() const
+{
+    return m_dPtr->m_logDB.databaseName();
+}
+
+void SQLiteDB::setStorageMode(AbstractLoggerDB::STORAGE_MODE t_storageMode)
+{
+    if(m_dPtr->m_storageMode != t_storageMode) {
+        m_dPtr->m_storageMode = t_storageMode;
+    }
+}
+
+AbstractLoggerDB::STORAGE_MODE SQLiteDB::getStorageMode() const
+{
+    return m_dPtr->m_storageMode;
+}
+
+void SQLiteDB::setDurabilityProfile(AbstractLoggerDB::DURABILITY_PROFILE t_profile)
 {
-    return m_dPtr->m_logDB.isOpen();
+    if(m_dPtr->m_durabilityProfile != t_profile) {
+        m_dPtr->m_durabilityProfile = t_profile;
+        if(m_dPtr->m_logDB.isOpen()) {
+            m_dPtr->applyDurabilityProfile();
+        }
+    }
 }
 
-QString SQLiteDB::databasePath() const
+AbstractLoggerDB::DURABILITY_PROFILE SQLiteDB::getDurabilityProfile() const
 {
-    return m_dPtr->m_logDB.databaseName();
+    return m_dPtr->m_durabilityProfile;
 }
 
-void SQLiteDB::setStorageMode(AbstractLoggerDB::STORAGE_MODE t_storageMode)
+void SQLiteDB::setFlushPolicy(const AbstractLoggerDB::FlushPolicy &t_policy)
 {
-    if(m_dPtr->m_storageMode != t_storageMode) {
-        m_dPtr->m_storageMode = t_storageMode;
+    m_dPtr->m_flushPolicy = t_policy;
+    m_dPtr->updateEffectiveBatchRows();
+    //a running age timer keeps its interval, the next batch uses the new one
+    if(m_dPtr->m_batchVector.size() >= m_dPtr->m_effectiveBatchRows || m_dPtr->m_batchBytes >= m_dPtr->m_flushPolicy.maxBytes) {
+        m_dPtr->requestFlush();
     }
 }
 
-AbstractLoggerDB::STORAGE_MODE SQLiteDB::getStorageMode() const
+AbstractLoggerDB::FlushPolicy SQLiteDB::getFlushPolicy() const
 {
-    return m_dPtr->m_storageMode;
+    return m_dPtr->m_flushPolicy;
 }
 
 std::function<bool (QString)> SQLiteDB::getDatabaseValidationFunction() const
@@ -294,7 +1546,20 @@ std::function<bool (QString)> SQLiteDB::getDatabaseValidationFunction() const
 
 QJsonDocument SQLiteDB::readTransaction(const QString &p_transaction, const QString &p_session)
 {
-   return m_dPtr->readTransaction(p_transaction, p_session);
+    QSharedPointer<SQLiteReadPool> readPool = m_dPtr->readPool();
+    if(readPool.isNull()) {
+        return QJsonDocument();
+    }
+    return readPool->readTransaction(p_transaction, p_session);
+}
+
+QCborMap SQLiteDB::readTransactionColumns(const QString &p_transaction, const QString &p_session)
+{
+    QSharedPointer<SQLiteReadPool> readPool = m_dPtr->readPool();
+    if(readPool.isNull()) {
+        return QCborMap();
+    }
+    return readPool->readTransactionColumns(p_transaction, p_session);
 }
 
 bool SQLiteDB::isValidDatabase(QString t_dbPath)
@@ -377,24 +1642,13 @@ void SQLiteDB::initLocalData()
 void SQLiteDB::addComponent(const QString &t_componentName)
 {
     if(m_dPtr->m_componentIds.contains(t_componentName) == false) {
-        int nextComponentId=0;
-
-        if(m_dPtr->m_componentSequenceQuery.exec() == true) {
-            m_dPtr->m_componentSequenceQuery.next();
-            nextComponentId = m_dPtr->m_componentSequenceQuery.value(0).toInt()+1;
-        }
-        else {
-            emit sigDatabaseError(QString("SQLiteDB::addComponent m_componentSequenceQuery failed: %1").arg(m_dPtr->m_componentSequenceQuery.lastError().text()));
-            return;
-        }
-
-        m_dPtr->m_componentInsertQuery.bindValue(":id", nextComponentId);
         m_dPtr->m_componentInsertQuery.bindValue(":component_name", t_componentName);
         if(m_dPtr->m_componentInsertQuery.exec() == false) {
             emit sigDatabaseError(QString("SQLiteDB::addComponent m_componentQuery failed: %1").arg(m_dPtr->m_componentInsertQuery.lastError().text()));
             return;
         }
-        m_dPtr->m_componentSequenceQuery.finish();
+        const int nextComponentId = m_dPtr->m_componentInsertQuery.lastInsertId().toInt();
+        m_dPtr->m_componentInsertQuery.finish();
 
         if(nextComponentId > 0) {
             m_dPtr->m_componentIds.insert(t_componentName, nextComponentId);
@@ -422,9 +1676,16 @@ void SQLiteDB::addEntity(int t_entityId, QString t_entityName)
     }
 }
 
-int SQLiteDB::addTransaction(const QString &t_transactionName, const QString &t_sessionName, const QString &t_contentSets, const QString &t_guiContextName)
+int SQLiteDB::reserveTransactionId()
+{
+    int transactionId = m_dPtr->m_nextTransactionId.load();
+    while(transactionId > 0 && m_dPtr->m_nextTransactionId.compare_exchange_weak(transactionId, transactionId + 1) == false) {
+    }
+    return transactionId > 0 ? transactionId : -1;
+}
+
+bool SQLiteDB::addTransaction(int t_transactionId, const QString &t_transactionName, const QString &t_sessionName, const QString &t_contentSets, const QString &t_guiContextName)
 {
-    int retVal = -1;
     int sessionId = 0;
 
     //check if session exists. If session does not exist add to list.
@@ -437,17 +1698,7 @@ int SQLiteDB::addTransaction(const QString &t_transactionName, const QString &t_
         sessionId = newSession;
     }
 
-    int nexttransactionId = 0;
-    if(m_dPtr->m_transactionSequenceQuery.exec() == true)    {
-        m_dPtr->m_transactionSequenceQuery.next();
-        nexttransactionId = m_dPtr->m_transactionSequenceQuery.value(0).toInt()+1;
-    }
-    else {
-        emit sigDatabaseError(QString("SQLiteDB::addTrancaction m_tranactionSequenceQuery failed: %1").arg(m_dPtr->m_transactionSequenceQuery.lastError().text()));
-        return retVal;
-    }
-
-    m_dPtr->m_transactionInsertQuery.bindValue(":id", nexttransactionId);
+    m_dPtr->m_transactionInsertQuery.bindValue(":id", t_transactionId);
     m_dPtr->m_transactionInsertQuery.bindValue(":sessionid", sessionId);
     m_dPtr->m_transactionInsertQuery.bindValue(":transaction_name", t_transactionName);
     m_dPtr->m_transactionInsertQuery.bindValue(":contentset_names", t_contentSets);
@@ -455,202 +1706,165 @@ int SQLiteDB::addTransaction(const QString &t_transactionName, const QString &t_
 
     if(m_dPtr->m_transactionInsertQuery.exec() == false) {
         emit sigDatabaseError(QString("SQLiteDB::addTransaction m_transactionsQuery failed: %1").arg(m_dPtr->m_transactionInsertQuery.lastError().text()));
-        return retVal;
+        return false;
     }
-    m_dPtr->m_transactionSequenceQuery.finish();
+    m_dPtr->m_transactionInsertQuery.finish();
+    m_dPtr->m_transactionIds.insert(t_transactionId, t_transactionName);
+    return true;
+}
 
-    if(nexttransactionId > 0) {
-        retVal = nexttransactionId;
-    }
-    else {
-        emit sigDatabaseError(QString("Error in SQLiteDB::addTransaction transaction: %1").arg(m_dPtr->m_logDB.lastError().text()));
+bool SQLiteDB::addTransactionMetadata(int t_transactionId, const QString &t_key, const QString &t_value)
+{
+    m_dPtr->m_transactionMetadataInsertQuery.bindValue(":transactionsid", t_transactionId);
+    m_dPtr->m_transactionMetadataInsertQuery.bindValue(":metadata_key", t_key);
+    m_dPtr->m_transactionMetadataInsertQuery.bindValue(":metadata_value", t_value);
+    if(m_dPtr->m_transactionMetadataInsertQuery.exec() == false) {
+        emit sigDatabaseError(QString("SQLiteDB::addTransactionMetadata m_transactionMetadataInsertQuery failed: %1").arg(m_dPtr->m_transactionMetadataInsertQuery.lastError().text()));
+        return false;
     }
-    return retVal;
+    m_dPtr->m_transactionMetadataInsertQuery.finish();
+    return true;
 }
 
-bool SQLiteDB::addStartTime(int t_transactionId, QDateTime t_time)
+bool SQLiteDB::addStartTime(int t_transactionId, qint64 t_timestampUs)
 {
-    QSqlQuery logtimeQuery(QString("UPDATE transactions SET (start_time) = ('\%0\') WHERE id = \'%1\';").arg(t_time.toString()).arg(t_transactionId),m_dPtr->m_logDB);
-    if(logtimeQuery.exec()){
-        logtimeQuery.finish();
-        return true;
-    }
-    return false;
+    m_dPtr->m_pendingStartTimes.insert(t_transactionId, t_timestampUs);
+    return true;
 }
 
-bool SQLiteDB::addStopTime(int t_transactionId, QDateTime t_time)
+bool SQLiteDB::addStopTime(int t_transactionId, qint64 t_timestampUs)
 {
-    QSqlQuery logtimeQuery(QString("UPDATE transactions SET (stop_time) = ('\%0\') WHERE id = \'%1\';").arg(t_time.toString()).arg(t_transactionId),m_dPtr->m_logDB);
-    if(logtimeQuery.exec()){
-        logtimeQuery.finish();
-        return true;
+    auto stopIter = m_dPtr->m_pendingStopTimes.find(t_transactionId);
+    if(stopIter == m_dPtr->m_pendingStopTimes.end()) {
+        m_dPtr->m_pendingStopTimes.insert(t_transactionId, t_timestampUs);
     }
-    return false;
+    else if(stopIter.value() < t_timestampUs) {
+        stopIter.value() = t_timestampUs;
+    }
+    return true;
 }
 // @TODO: remove transaction rpc?
 bool SQLiteDB::deleteSession(const QString &t_session)
 {
-    bool retVal=true;
-    // retrun false if any error occurs
-    try{
-        // Database has to be open!
-        if(m_dPtr->m_logDB.isOpen() != true){
-            throw false;
-        }
-
-        if(m_dPtr->m_sessionIds.contains(t_session)){
-
-            // There is much to do here as you can see. Please use this function
-            // threaded and do not use to often.
-            // Furthermore notice that those queries are located here because
-            // the amount of class members is just not acceptable anymore, if I add them as members.
-            // Furthermore we can not prepare the queries, if we want to use lists.
-
-
-            QSqlQuery getSessionIdQuery(m_dPtr->m_logDB);
-            QSqlQuery getTransactionsIdsQuery(m_dPtr->m_logDB);
-            QSqlQuery getValueIdsQuery(m_dPtr->m_logDB);
-
-            QSqlQuery getStaticValueIdsQuery(m_dPtr->m_logDB);
-
-
-            QSqlQuery deletevalueTransQuery(m_dPtr->m_logDB);
-            QSqlQuery deletetransactionsQuery(m_dPtr->m_logDB);
-
-            // id used for static data and transaction data
-            QSqlQuery deleteValuesQuery(m_dPtr->m_logDB);
-
-
-            QSqlQuery deleteSessValueQuery(m_dPtr->m_logDB);
-            QSqlQuery deleteSessionQuery(m_dPtr->m_logDB);
-
-            getSessionIdQuery.prepare("SELECT id FROM sessions WHERE session_name=:sessionName");
-            getTransactionsIdsQuery.prepare("SELECT tr.id,se.session_name From transactions tr JOIN sessions se ON se.id = tr.sessionid WHERE se.id=:sessionId");
-            // getValueIdsQuery is prepare like this because bindValue will not accept lists, and batchExecution is not fitted
-            // for select statements. In consequence we build the query dynamic with those strings.
-            QString valueSelect1="SELECT tv.valueid FROM transactions_valuemap tv JOIN valuemap vm ON tv.valueid = vm.id JOIN transactions_valuemap tv2 ON vm.id = tv2.valueid WHERE tv2.transactionsid IN (";
-            QString valueSelect2=") GROUP BY tv.valueid  HAVING count(tv.transactionsid) = 1";
-
-            getStaticValueIdsQuery.prepare("SELECT sv.valueid FROM sessions_valuemap sv JOIN valuemap vm ON "
-                                           "sv.valueid = vm.id JOIN sessions_valuemap sv2 ON vm.id = sv2.valueid WHERE sv2.sessionsid = :sessionId GROUP BY sv.valueid  HAVING count(sv.sessionsid) = 1");
-            deletevalueTransQuery.prepare("Delete FROM transactions_valuemap WHERE transactionsid IN (?)");
-            deletetransactionsQuery.prepare("Delete FROM transactions  WHERE id IN (?)");
-            deleteValuesQuery.prepare("Delete From valuemap Where id IN (?)");
-            deleteSessValueQuery.prepare("Delete FROM sessions_valuemap WHERE sessionsid = :sessionId");
-            deleteSessionQuery.prepare("Delete From sessions Where id= :sessionId");
-
-
-            // query return values
-            QString sessionId;
-            QStringList transactionIds;
-            QStringList valueIds;
-            QStringList staticValueIds; // could use valueIds but I guess it is better readable like that.
-
-            // read session id
-            getSessionIdQuery.bindValue(":sessionName",t_session);
-            if(!getSessionIdQuery.exec()){
-                throw false;
-            }
-
-            int fieldNo = getSessionIdQuery.record().indexOf("id");
-            while (getSessionIdQuery.next()) {
-                sessionId = getSessionIdQuery.value(fieldNo).toString();
-            }
-
-            // read transactionsIds
-            getTransactionsIdsQuery.bindValue(":sessionId",sessionId);
-            if(!getTransactionsIdsQuery.exec()){
-                throw false;
-            }
-
-            fieldNo = getTransactionsIdsQuery.record().indexOf("id");
-            while (getTransactionsIdsQuery.next()) {
-                transactionIds.append(getTransactionsIdsQuery.value(fieldNo).toString());
-            }
-
-            // Create Query with strings.
-            QString tmp=transactionIds.join(",");
-            if(!getValueIdsQuery.exec(valueSelect1+tmp+valueSelect2)){
-                throw false;
-            }
-
-            fieldNo = getValueIdsQuery.record().indexOf("valueid");
-            while (getValueIdsQuery.next()) {
-                valueIds.append(getValueIdsQuery.value(fieldNo).toString());
-            }
+    return deleteSessions(QStringList(t_session));
+}
 
+bool SQLiteDB::deleteSessions(const QStringList &t_sessions)
+{
+    bool retVal = false;
+    if(m_dPtr->m_logDB.isOpen() == false) {
+        return retVal;
+    }
+    QStringList queuedSessions;
+    QSqlQuery enqueueQuery(m_dPtr->m_logDB);
+    bool queued = m_dPtr->m_logDB.transaction()
+            && DBPrivate::createDeleteTables(enqueueQuery)
+            && enqueueQuery.prepare("INSERT OR IGNORE INTO temp.delete_sessions VALUES (:id);");
+    for(const QString &session : t_sessions) {
+        if(queued && m_dPtr->m_sessionIds.contains(session)) {
+            enqueueQuery.bindValue(":id", m_dPtr->m_sessionIds.value(session));
+            queued = enqueueQuery.exec();
+            queuedSessions.append(session);
+        }
+    }
+    queued = queued && enqueueQuery.exec("INSERT OR IGNORE INTO temp.delete_transactions SELECT id FROM transactions WHERE sessionid IN (SELECT id FROM temp.delete_sessions);");
+    QVector<int> transactionIds;
+    if(queued && enqueueQuery.exec("SELECT id FROM temp.delete_transactions;")) {
+        while(enqueueQuery.next()) {
+            transactionIds.append(enqueueQuery.value(0).toInt());
+        }
+    }
+    enqueueQuery.finish();
+    queued = queued && m_dPtr->m_logDB.commit();
+    if(queued == false) {
+        qCWarning(VEIN_LOGGER) << "Error queueing sessions for deletion:" << t_sessions << enqueueQuery.lastError().text();
+        m_dPtr->m_logDB.rollback();
+        return retVal;
+    }
 
-            // read all to delete static value ids
-            getStaticValueIdsQuery.bindValue(":sessionId", sessionId);
-            if(!getStaticValueIdsQuery.exec()){
-                throw false;
-            }
+    if(queuedSessions.isEmpty() == false) {
+        //the sessions are gone for the logger right away, the rows are deleted in chunks by runSessionDeletion
+        for(const QString &session : qAsConst(queuedSessions)) {
+            m_dPtr->m_deletedSessionIds.insert(m_dPtr->m_sessionIds.take(session));
+        }
+        for(const int transactionId : qAsConst(transactionIds)) {
+            m_dPtr->m_transactionIds.remove(transactionId);
+            m_dPtr->m_deletedTransactionIds.insert(transactionId);
+        }
+        m_dPtr->m_deletingSessions.append(queuedSessions);
+        m_dPtr->setDeletingSessions(m_dPtr->m_deletingSessions);
+        const bool running = m_dPtr->m_deletePhase != DBPrivate::DELETE_PHASE::IDLE;
+        //values of the new transactions may already have passed the first phase
+        m_dPtr->m_deletePhase = DBPrivate::DELETE_PHASE::TRANSACTION_VALUES;
+        if(running == false) {
+            m_dPtr->m_deletedValueCount = 0;
+            m_dPtr->m_deleteTimer.start();
+            QTimer::singleShot(0, this, &SQLiteDB::runSessionDeletion);
+        }
+        m_dPtr->emitDeletionProgress(true);
+        emit sigNewSessionList(QStringList(m_dPtr->m_sessionIds.keys()));
+        retVal = true;
+    }
+    return retVal;
+}
 
-            fieldNo = getStaticValueIdsQuery.record().indexOf("valueid");
-            while (getStaticValueIdsQuery.next()) {
-                staticValueIds.append(getStaticValueIdsQuery.value(fieldNo).toString());
-            }
+bool SQLiteDB::convertToIncrementalVacuum()
+{
+    bool retVal = false;
+    if(m_dPtr->m_logDB.isOpen() == false) {
+        return retVal;
+    }
+    if(m_dPtr->m_autoVacuumMode == 2) {
+        retVal = true;
+    }
+    else if(m_dPtr->m_pendingMigrationSteps.isEmpty() == false || m_dPtr->m_deletePhase != DBPrivate::DELETE_PHASE::IDLE) {
+        qCWarning(VEIN_LOGGER) << "Converting" << m_dPtr->m_logDB.databaseName() << "to incremental auto vacuum is refused while the schema migration or a session deletion runs";
+    }
+    else {
+        retVal = m_dPtr->convertToIncrementalVacuum();
+        m_dPtr->updateReclaimableSize();
+    }
+    return retVal;
+}
 
-            // Do not change order. The order is important because an entry can
-            // not be deleted as long as the parent element still exists.
-
-            //delete session
-            deleteSessionQuery.bindValue(":sessionId",sessionId);
-            deleteSessionQuery.exec();
-            deleteSessionQuery.finish();
-            //clean transaction_valuemap
-            deletevalueTransQuery.addBindValue(transactionIds);
-            deletevalueTransQuery.execBatch();
-            deletevalueTransQuery.finish();
-            //clean session_valuemap
-            deleteSessValueQuery.bindValue(":sessionId",sessionId);
-            deleteSessValueQuery.exec();
-            deleteSessValueQuery.finish();
-            //delete transactions
-            deletetransactionsQuery.addBindValue(transactionIds);
-            deletetransactionsQuery.execBatch();
-            deletetransactionsQuery.finish();
-            //delete transactions values
-            deleteValuesQuery.addBindValue(valueIds);
-            deleteValuesQuery.execBatch();
-            deleteValuesQuery.finish();
-            //delete static values
-            deleteValuesQuery.addBindValue(staticValueIds);
-            deleteValuesQuery.execBatch();
-            deleteValuesQuery.finish();
-
-            m_dPtr->m_sessionIds.remove(t_session);
-            emit sigNewSessionList(QStringList(m_dPtr->m_sessionIds.keys()));
-        }
-    }catch(...){
-        retVal=false;
+void SQLiteDB::runSessionDeletion()
+{
+    if(m_dPtr->m_logDB.isOpen() == false || m_dPtr->m_deletePhase == DBPrivate::DELETE_PHASE::IDLE) {
+        return;
+    }
+    if(m_dPtr->m_pendingMigrationSteps.isEmpty() == false) {
+        //the chunks rely on the valueid indexes of schema version 1
+        m_dPtr->runMigrationStep();
+    }
+    else if(m_dPtr->runDeleteChunk() == false) {
+        qCWarning(VEIN_LOGGER) << "Deleting sessions" << m_dPtr->m_deletingSessions << "failed, the remaining rows stay in the database";
+        m_dPtr->m_deletePhase = DBPrivate::DELETE_PHASE::IDLE;
+        m_dPtr->m_deletingSessions.clear();
+        m_dPtr->setDeletingSessions(QStringList());
+        m_dPtr->emitDeletionProgress(true, true);
+        return;
     }
 
-return retVal;
+    if(m_dPtr->m_deletePhase == DBPrivate::DELETE_PHASE::IDLE) {
+        qCDebug(VEIN_LOGGER) << "Deleted sessions" << m_dPtr->m_deletingSessions << "with" << m_dPtr->m_deletedValueCount << "values in" << m_dPtr->m_deleteTimer.elapsed() << "ms";
+        m_dPtr->m_deletingSessions.clear();
+        //the names are free again, nothing cached for them may outlive the deletion
+        m_dPtr->setDeletingSessions(QStringList());
+        m_dPtr->emitDeletionProgress(true);
+    }
+    else {
+        m_dPtr->emitDeletionProgress(false);
+        //yield, batches queued meanwhile are written before the next chunk
+        QTimer::singleShot(0, this, &SQLiteDB::runSessionDeletion);
+    }
 }
 
 int SQLiteDB::addSession(const QString &t_sessionName, QList<QVariantMap> p_staticData)
 {
     int retVal = -1;
     if(m_dPtr->m_sessionIds.contains(t_sessionName) == false) {
-        int nextsessionId = 0;
-        if(m_dPtr->m_sessionSequenceQuery.exec() == true) {
-            m_dPtr->m_sessionSequenceQuery.next();
-            nextsessionId = m_dPtr->m_sessionSequenceQuery.value(0).toInt()+1;
-        }
-        else {
-            emit sigDatabaseError(QString("SQLiteDB::addSession m_sessionSequenceQuery failed: %1").arg(m_dPtr->m_sessionSequenceQuery.lastError().text()));
-            return retVal;
-        }
-
-        m_dPtr->m_sessionInsertQuery.bindValue(":id", nextsessionId);
-        m_dPtr->m_sessionInsertQuery.bindValue(":session_name", t_sessionName);
-        if(m_dPtr->m_sessionInsertQuery.exec() == false) {
-            emit sigDatabaseError(QString("SQLiteDB::addSession m_sessionInsertQuery failed: %1").arg(m_dPtr->m_sessionInsertQuery.lastError().text()));
-            return retVal;
-        }
-        m_dPtr->m_sessionSequenceQuery.finish();
-
+        //assigned here so the static data rows reference it in the transaction of the session row
+        const int nextsessionId = m_dPtr->m_nextSessionId;
         QVector<SQLBatchData> batchDataVector;
 
 
@@ -660,27 +1874,27 @@ int SQLiteDB::addSession(const QString &t_sessionName, QList<QVariantMap> p_stat
             batchData.entityId=comp["entityId"].toInt();
             batchData.componentId=m_dPtr->m_componentIds.value(comp["compName"].toString());
             batchData.value=comp["value"];
-            batchData.timestamp=comp["time"].value<QDateTime>();
+            batchData.timestamp=comp["time"].toLongLong();
             batchDataVector.append(batchData);
         }
 
-        writeStaticData(batchDataVector);
-
-
-        if(nextsessionId > 0) {
+        if(writeSession(nextsessionId, t_sessionName, batchDataVector)) {
+            ++m_dPtr->m_nextSessionId;
             m_dPtr->m_sessionIds.insert(t_sessionName, nextsessionId);
+            QSharedPointer<SQLiteReadPool> readPool = m_dPtr->readPool();
+            if(readPool.isNull() == false) {
+                //read back once instead of caching p_staticData: the values as stored, e.g. converted to text in STORAGE_MODE::TEXT.
+                //The generation only changes in this thread.
+                m_dPtr->cacheSessionStaticData(t_sessionName, readPool->readSessionStaticData(t_sessionName), m_dPtr->m_sessionStaticDataGeneration);
+            }
             retVal = nextsessionId;
             emit sigNewSessionList(QStringList(m_dPtr->m_sessionIds.keys()));
         }
-        else {
-            emit sigDatabaseError(QString("Error in SQLiteDB::addSession transaction: %1").arg(m_dPtr->m_logDB.lastError().text()));
-            return retVal;
-        }
     }
     return retVal;
 }
 
-void SQLiteDB::addLoggedValue(int t_sessionId, QVector<int> t_transactionIds, int t_entityId, const QString &t_componentName, QVariant t_value, QDateTime t_timestamp)
+void SQLiteDB::addLoggedValue(int t_sessionId, QVector<int> t_transactionIds, int t_entityId, const QString &t_componentName, QVariant t_value, qint64 t_timestamp)
 {
     const int componentId = m_dPtr->m_componentIds.value(t_componentName, 0);
 
@@ -698,10 +1912,24 @@ void SQLiteDB::addLoggedValue(int t_sessionId, QVector<int> t_transactionIds, in
     batchData.value=t_value;
     batchData.timestamp=t_timestamp;
 
+    //once values are spilled all later ones follow them through the spill file to keep the order
+    if(m_dPtr->m_spillFile.isOpen() || m_dPtr->m_batchBytes >= DBPrivate::s_memoryBudgetBytes) {
+        m_dPtr->spillValue(batchData);
+        m_dPtr->requestFlush();
+        return;
+    }
     m_dPtr->m_batchVector.append(batchData);
+    m_dPtr->m_batchBytes += DBPrivate::approximateValueBytes(t_value);
+    m_dPtr->journalValue(batchData);
+    if(m_dPtr->m_batchVector.size() >= m_dPtr->m_effectiveBatchRows || m_dPtr->m_batchBytes >= m_dPtr->m_flushPolicy.maxBytes) {
+        m_dPtr->requestFlush();
+    }
+    else if(m_dPtr->m_batchVector.size() == 1) {
+        m_dPtr->m_flushTimer->start(m_dPtr->m_flushPolicy.maxAgeMs);
+    }
 }
 
-void SQLiteDB::addLoggedValue(const QString &t_sessionName, QVector<int> t_transactionIds, int t_entityId, const QString &t_componentName, QVariant t_value, QDateTime t_timestamp)
+void SQLiteDB::addLoggedValue(const QString &t_sessionName, QVector<int> t_transactionIds, int t_entityId, const QString &t_componentName, QVariant t_value, qint64 t_timestamp)
 {
     int sessionId = 0;
     if(m_dPtr->m_sessionIds.contains(t_sessionName)) {
@@ -717,7 +1945,65 @@ void SQLiteDB::addLoggedValue(const QString &t_sessionName, QVector<int> t_trans
 
 QVariant SQLiteDB::readSessionComponent(const QString &p_session, const QString &p_entity, const QString &p_component)
 {
-    return m_dPtr->readSessionComponent(p_session,p_entity,p_component);
+    QHash<QString, QVariantHash> staticData;
+    quint64 generation = 0;
+    if(m_dPtr->cachedSessionStaticData(p_session, staticData, generation) == false) {
+        QSharedPointer<SQLiteReadPool> readPool = m_dPtr->readPool();
+        if(readPool.isNull()) {
+            return QVariant();
+        }
+        staticData = readPool->readSessionStaticData(p_session);
+        //unknown session names would fill the cache, sessions without static data are rare
+        if(staticData.isEmpty() == false) {
+            m_dPtr->cacheSessionStaticData(p_session, staticData, generation);
+        }
+    }
+    return staticData.value(p_entity).value(p_component);
+}
+
+QVector<int> SQLiteDB::readTransactionIds(const QString &p_transaction, const QString &p_session)
+{
+    QSharedPointer<SQLiteReadPool> readPool = m_dPtr->readPool();
+    if(readPool.isNull()) {
+        return QVector<int>();
+    }
+    return readPool->readTransactionIds(p_transaction, p_session);
+}
+
+qint64 SQLiteDB::readLastValueId()
+{
+    QSharedPointer<SQLiteReadPool> readPool = m_dPtr->readPool();
+    if(readPool.isNull()) {
+        return 0;
+    }
+    return readPool->readLastValueId();
+}
+
+QJsonArray SQLiteDB::readTransactionPage(int t_transactionId, qint64 t_afterValueId, qint64 t_lastValueId, int t_pageSize)
+{
+    QSharedPointer<SQLiteReadPool> readPool = m_dPtr->readPool();
+    if(readPool.isNull()) {
+        return QJsonArray();
+    }
+    return readPool->readTransactionPage(t_transactionId, t_afterValueId, t_lastValueId, t_pageSize);
+}
+
+QJsonObject SQLiteDB::readTrend(const QString &p_transaction, const QString &p_session, const QString &p_entity, const QString &p_component, qint64 t_resolutionUs)
+{
+    QSharedPointer<SQLiteReadPool> readPool = m_dPtr->readPool();
+    if(readPool.isNull()) {
+        return QJsonObject();
+    }
+    return readPool->readTrend(p_transaction, p_session, p_entity, p_component, t_resolutionUs);
+}
+
+QJsonObject SQLiteDB::readRange(const QString &p_session, const QString &p_entity, const QString &p_component, qint64 t_fromUs, qint64 t_toUs, int t_maxPoints)
+{
+    QSharedPointer<SQLiteReadPool> readPool = m_dPtr->readPool();
+    if(readPool.isNull()) {
+        return QJsonObject();
+    }
+    return readPool->readRange(p_session, p_entity, p_component, t_fromUs, t_toUs, t_maxPoints);
 }
 
 bool SQLiteDB::openDatabase(const QString &t_dbPath)
@@ -726,9 +2012,34 @@ bool SQLiteDB::openDatabase(const QString &t_dbPath)
     bool retVal = false;
     if(fInfo.absoluteDir().exists()) {
         QSqlError dbError;
+        m_dPtr->setReadPool(QSharedPointer<SQLiteReadPool>());
+        m_dPtr->invalidateSessionStaticData(QStringList());
         if(m_dPtr->m_logDB.isOpen()) {
+            m_dPtr->m_maintenanceTimer->stop();
+            //the temp tables of a running deletion are gone with the connection
+            if(m_dPtr->m_deletePhase != DBPrivate::DELETE_PHASE::IDLE) {
+                qCWarning(VEIN_LOGGER) << "Deletion of sessions" << m_dPtr->m_deletingSessions << "aborted by closing the database";
+                m_dPtr->m_deletePhase = DBPrivate::DELETE_PHASE::IDLE;
+                m_dPtr->m_deletingSessions.clear();
+                m_dPtr->setDeletingSessions(QStringList());
+            }
+            m_dPtr->m_deletedSessionIds.clear();
+            m_dPtr->m_deletedTransactionIds.clear();
+            m_dPtr->m_batchWriter.finalize();
+            m_dPtr->m_rollupWriter.finalize();
+            m_dPtr->m_nativeHandle = nullptr;
             m_dPtr->m_logDB.close();
         }
+        //spilled and journaled values stay in the files of the old database, a replayed batch is read again from there
+        m_dPtr->m_spillFile.close();
+        m_dPtr->closeJournal();
+        if(m_dPtr->m_replayingSpill) {
+            m_dPtr->m_replayingSpill = false;
+            m_dPtr->m_batchVector.clear();
+            m_dPtr->m_batchBytes = 0;
+        }
+        m_dPtr->m_pendingStartTimes.clear();
+        m_dPtr->m_pendingStopTimes.clear();
 
         m_dPtr->m_logDB.setDatabaseName(t_dbPath);
         if (!m_dPtr->m_logDB.open()) {
@@ -742,26 +2053,28 @@ bool SQLiteDB::openDatabase(const QString &t_dbPath)
         }
         else {
             //the database was not open when these queries were initialized
-            m_dPtr->m_valueMapInsertQuery = QSqlQuery(m_dPtr->m_logDB);
-            m_dPtr->m_valueMapSequenceQuery = QSqlQuery(m_dPtr->m_logDB);
-            m_dPtr->m_transactionMappingInsertQuery = QSqlQuery(m_dPtr->m_logDB);
             m_dPtr->m_componentInsertQuery = QSqlQuery(m_dPtr->m_logDB);
-            m_dPtr->m_componentSequenceQuery = QSqlQuery(m_dPtr->m_logDB);
             m_dPtr->m_entityInsertQuery = QSqlQuery(m_dPtr->m_logDB);
             m_dPtr->m_transactionInsertQuery = QSqlQuery(m_dPtr->m_logDB);
-            m_dPtr->m_transactionSequenceQuery = QSqlQuery(m_dPtr->m_logDB);
-            m_dPtr->m_sessionSequenceQuery = QSqlQuery(m_dPtr->m_logDB);
+            m_dPtr->m_startTimeUpdateQuery = QSqlQuery(m_dPtr->m_logDB);
+            m_dPtr->m_stopTimeUpdateQuery = QSqlQuery(m_dPtr->m_logDB);
             m_dPtr->m_sessionInsertQuery = QSqlQuery(m_dPtr->m_logDB);
-            m_dPtr->m_readTransactionQuery = QSqlQuery(m_dPtr->m_logDB);
-            m_dPtr->m_sessionMappingInsertQuery = QSqlQuery(m_dPtr->m_logDB);
-            m_dPtr->m_sessionCustomerQuery = QSqlQuery(m_dPtr->m_logDB);
+            m_dPtr->m_transactionMetadataInsertQuery = QSqlQuery(m_dPtr->m_logDB);
             //setup database if necessary
             QSqlQuery schemaVersionQuery(m_dPtr->m_logDB);
 
             if(schemaVersionQuery.exec("pragma schema_version;") == true) { //check if the file is valid (empty or a valid database)
                 schemaVersionQuery.first();
-                if(schemaVersionQuery.value(0) == 0) { //if there is no database schema or if the file does not exist, then this will create the database and initialize the schema
-                    m_dPtr->m_queryReader.setFileName("://sqlite/schema_sqlite.sql");
+                const bool schemaCreated = schemaVersionQuery.value(0) == 0;
+                if(schemaCreated) { //if there is no database schema or if the file does not exist, then this will create the database and initialize the schema
+                    //has to be set before the first table is created
+                    QSqlQuery(m_dPtr->m_logDB).exec("pragma auto_vacuum = incremental;");
+                    if(m_dPtr->m_storageMode == STORAGE_MODE::TYPED) {
+                        m_dPtr->m_queryReader.setFileName("://sqlite/schema_sqlite_typed.sql");
+                    }
+                    else {
+                        m_dPtr->m_queryReader.setFileName("://sqlite/schema_sqlite.sql");
+                    }
                     qCDebug(VEIN_LOGGER) << "No schema found in db:"<< t_dbPath << "creating schema from:" << m_dPtr->m_queryReader.fileName();
                     m_dPtr->m_queryReader.open(QFile::ReadOnly | QFile::Text);
                     QTextStream queryStreamIn(&m_dPtr->m_queryReader);
@@ -780,73 +2093,125 @@ bool SQLiteDB::openDatabase(const QString &t_dbPath)
                     }
                 }
                 schemaVersionQuery.finish();
+                if(m_dPtr->m_storageMode == STORAGE_MODE::TYPED) {
+                    //a declared column type forces its affinity on the values, e.g. NUMERIC stores 2.0 as INTEGER 2
+                    QSqlQuery columnTypeQuery(m_dPtr->m_logDB);
+                    if(columnTypeQuery.exec("pragma table_info(valuemap);")) {
+                        while(columnTypeQuery.next()) {
+                            if(columnTypeQuery.value(1).toString() == QLatin1String("component_value") && columnTypeQuery.value(2).toString().isEmpty() == false) {
+                                qCWarning(VEIN_LOGGER) << "Database" << t_dbPath << "was not created for typed storage, component_value has affinity:" << columnTypeQuery.value(2).toString();
+                            }
+                        }
+                    }
+                    columnTypeQuery.finish();
+                }
+                //bring the schema up to date: a new database right away, an existing one in idle slices of runMaintenance
+                const int userVersion = m_dPtr->readSchemaVersion();
+                if(userVersion > DBPrivate::s_schemaVersion) {
+                    qCWarning(VEIN_LOGGER) << "Database" << t_dbPath << "has schema version" << userVersion << "newer than the supported version" << DBPrivate::s_schemaVersion;
+                }
+                m_dPtr->m_pendingMigrationSteps = DBPrivate::schemaMigrationSteps(userVersion);
+                QString migrationError;
+                if(m_dPtr->runImmediateMigrationSteps(migrationError) == false) {
+                    emit sigDatabaseError(QString("Error creating tables of schema %1").arg(migrationError));
+                    return retVal;
+                }
+                //valuemap and mapping inserts run on the native handle, QSQLITE would emulate execBatch row by row
+                QString handleMismatch;
+                sqlite3 *nativeHandle = SQLiteBatchWriter::nativeHandle(m_dPtr->m_logDB, handleMismatch);
+                if(nativeHandle == nullptr) {
+                    qCWarning(VEIN_LOGGER) << "No native sqlite3 access to" << t_dbPath << "-" << handleMismatch << "- values are written through QSqlQuery, rollups are off";
+                }
+                m_dPtr->m_nativeHandle = nativeHandle;
+                if(m_dPtr->m_batchWriter.prepare(m_dPtr->m_logDB, nativeHandle) == false) {
+                    emit sigDatabaseError(QString("Error preparing batch writer: %1").arg(m_dPtr->m_batchWriter.lastError()));
+                    return retVal;
+                }
                 //prepare common queries
-                /* id INTEGER PRIMARY KEY,
-                 * entitiesid INTEGER REFERENCES entities(entity_id) NOT NULL,
-                 * componentid INTEGER REFERENCES components(component_id) NOT NULL,
-                 * value_timestamp VARCHAR(255) NOT NULL, -- timestamp in ISO 8601 format, example: 2016-10-06 11:58:34.504319
-                 * component_value NUMERIC) WITHOUT ROWID; -- can be any type but numeric is preferred
-                 */
-                m_dPtr->m_valueMapInsertQuery.prepare("INSERT INTO valuemap VALUES (?, ?, ?, ?, ?);");
-                //executed to get the next id for internal tracking, other database clients must not alter the value while the internal reference is kept
-                m_dPtr->m_valueMapSequenceQuery.prepare("SELECT MAX(id) FROM valuemap;");
-                m_dPtr->m_componentInsertQuery.prepare("INSERT INTO components (id, component_name) VALUES (:id, :component_name);");
-                m_dPtr->m_componentSequenceQuery.prepare("SELECT MAX(id) FROM components;");
+                //component ids are assigned by sqlite and read with last_insert_rowid(), session and transaction ids in memory
+                m_dPtr->m_componentInsertQuery.prepare("INSERT INTO components (component_name) VALUES (:component_name);");
                 m_dPtr->m_entityInsertQuery.prepare("INSERT INTO entities VALUES (:id, :entity_name);");
                 /* -- The session is a series of values collected over a variable duration connected to customer data
                  * CREATE TABLE sessions (id INTEGER PRIMARY KEY, session_name VARCHAR(255) NOT NULL UNIQUE) WITHOUT ROWID;
                  */
+                //transaction ids are reserved by the logger before the transaction is queued, see reserveTransactionId
                 m_dPtr->m_transactionInsertQuery.prepare("INSERT INTO transactions (id, sessionid, transaction_name, contentset_names, guicontext_name, start_time, stop_time) VALUES (:id, :sessionid, :transaction_name, :contentset_names, :guicontext_name, :start_time, :stop_time);");
-                //executed after the transactions was added to get the last used number
-                m_dPtr->m_transactionSequenceQuery.prepare("SELECT MAX(id) FROM transactions;");
-                m_dPtr->m_transactionMappingInsertQuery.prepare("INSERT INTO transactions_valuemap VALUES (?, ?);"); //transactionId, valuemapid
-                m_dPtr->m_sessionMappingInsertQuery.prepare("INSERT INTO sessions_valuemap VALUES (:sessionId, :valuemapId)");
-                m_dPtr->m_readTransactionQuery.prepare("SELECT valuemap.value_timestamp,"
-                                                       " valuemap.component_value,"
-                                                       " valuemap.id,"
-                                                       " components.component_name,"
-                                                       " entities.entity_name,"
-                                                       " transactions.transaction_name,"
-                                                       " sessions.session_name"
-                                                       " FROM sessions INNER JOIN transactions ON"
-                                                       " sessions.id = transactions.sessionid "
-                                                       " INNER JOIN transactions_valuemap ON "
-                                                       " transactions.id = transactions_valuemap.transactionsid "
-                                                       " INNER JOIN valuemap ON "
-                                                       " transactions_valuemap.valueid = valuemap.id "
-                                                       " INNER JOIN components ON "
-                                                       " valuemap.componentid = components.id "
-                                                       " INNER JOIN entities ON valuemap.entityiesid = entities.id where transactions.transaction_name = :transaction AND sessions.session_name = :sessionname ;");
-
+                //times are UTC microseconds since epoch
+                m_dPtr->m_startTimeUpdateQuery.prepare("UPDATE transactions SET start_time = :start_time WHERE id = :id;");
+                m_dPtr->m_stopTimeUpdateQuery.prepare("UPDATE transactions SET stop_time = :stop_time WHERE id = :id;");
                 m_dPtr->m_sessionInsertQuery.prepare("INSERT INTO sessions (id, session_name) VALUES (:id, :session_name);");
-                //ecexute after session was added to  get last used number
-                m_dPtr->m_sessionSequenceQuery.prepare("SELECT MAX(id) FROM sessions");
-
+                m_dPtr->m_transactionMetadataInsertQuery.prepare("INSERT OR REPLACE INTO transactions_metadata (transactionsid, metadata_key, metadata_value) VALUES (:transactionsid, :metadata_key, :metadata_value);");
+                m_dPtr->m_journalEpochUpdateQuery.prepare("INSERT OR REPLACE INTO journal_state (id, epoch) VALUES (0, :epoch);");
+                //values are logged without rollups rather than not at all, readTrend reads them from valuemap
+                m_dPtr->m_rollupCoveredTransactions.clear();
+                if(nativeHandle != nullptr && m_dPtr->m_rollupWriter.prepare(nativeHandle) == false) {
+                    qCWarning(VEIN_LOGGER) << "Rollups of" << t_dbPath << "are off:" << m_dPtr->m_rollupWriter.lastError();
+                }
 
-                m_dPtr->m_sessionCustomerQuery.prepare("SELECT sessions.session_name, components.component_name,entities.entity_name, valuemap.component_value"
-                                                       " FROM sessions INNER JOIN"
-                                                       " sessions_valuemap ON sessions.id = sessions_valuemap.sessionsid INNER JOIN"
-                                                       " valuemap ON sessions_valuemap.valueid = valuemap.id INNER JOIN entities ON valuemap.entityiesid = entities.id INNER JOIN"
-                                                       " components ON valuemap.componentid = components.id"
-                                                       " WHERE session_name= :sessionname AND entity_name= :entity AND component_name= :component;");
 
+                m_dPtr->m_autoVacuumMode = m_dPtr->readPragma("auto_vacuum");
+                m_dPtr->m_reclaimableBytes = -1;
+                m_dPtr->m_vacuumRetryTimer.invalidate();
+                if(m_dPtr->m_autoVacuumMode == 0) {
+                    qCDebug(VEIN_LOGGER) << "Database" << t_dbPath << "has no auto vacuum, free pages are kept until convertToIncrementalVacuum is called";
+                }
+                if(schemaCreated) {
+                    while(m_dPtr->m_pendingMigrationSteps.isEmpty() == false && m_dPtr->runMigrationStep()) {
+                    }
+                }
+                else if(m_dPtr->m_pendingMigrationSteps.isEmpty() == false) {
+                    qCDebug(VEIN_LOGGER) << "Database" << t_dbPath << "has schema version" << userVersion << "upgrading to" << DBPrivate::s_schemaVersion << "in background";
+                }
 
-                //get next valuemap_id
-                if(m_dPtr->m_valueMapSequenceQuery.exec() == false) {
-                    emit sigDatabaseError(QString("Error executing m_valueMappingSequenceQuery: %1").arg(m_dPtr->m_valueMapSequenceQuery.lastError().text()));
+                //seed the ids assigned in memory
+                qint64 nextTransactionId = 0;
+                qint64 nextSessionId = 0;
+                if(m_dPtr->readNextId(QStringLiteral("valuemap"), m_dPtr->m_nextValueId) == false
+                        || m_dPtr->readNextId(QStringLiteral("transactions"), nextTransactionId) == false
+                        || m_dPtr->readNextId(QStringLiteral("sessions"), nextSessionId) == false) {
                     return retVal;
                 }
                 retVal = true;
-                m_dPtr->m_valueMapSequenceQuery.next();
-                m_dPtr->m_valueMapQueryCounter = m_dPtr->m_valueMapSequenceQuery.value(0).toInt()+1;
-                //close the query as we read all data from it and it has to be closed to commit the transaction
-                m_dPtr->m_valueMapSequenceQuery.finish();
+                m_dPtr->m_nextSessionId = int(nextSessionId);
+                //published with sigDatabaseReady, the logger reserves ids only once the database is ready
+                m_dPtr->m_nextTransactionId.store(int(nextTransactionId));
 
                 initLocalData();
                 emit sigNewSessionList(QStringList(m_dPtr->m_sessionIds.keys()));
 
-                QSqlQuery tuningQuery(m_dPtr->m_logDB);
-                tuningQuery.exec("pragma journal_mode = memory;"); //prevent .journal files and speed up the logging
+                m_dPtr->applyDurabilityProfile();
+                m_dPtr->m_walDirty = false;
+                m_dPtr->m_lastBatchTimer.start();
+                m_dPtr->m_lastCheckpointTimer.start();
+                m_dPtr->m_maintenanceTimer->start();
+                m_dPtr->updateEffectiveBatchRows();
+                m_dPtr->startStorageMonitor(t_dbPath);
+
+                //values spilled while the database was not writable the last time
+                const QString spillPath = SpillFile::pathForDatabase(t_dbPath);
+                if(QFile::exists(spillPath)) {
+                    if(m_dPtr->m_spillFile.open(spillPath)) {
+                        qCDebug(VEIN_LOGGER) << "Replaying" << m_dPtr->m_spillFile.pendingBytes() << "bytes of spilled values from" << spillPath;
+                        m_dPtr->requestFlush();
+                    }
+                    else {
+                        qCWarning(VEIN_LOGGER) << "Spilled values are not replayed:" << m_dPtr->m_spillFile.lastError();
+                    }
+                }
+                m_dPtr->emitBufferState(true);
+
+                //reads run on their own connections, this one is used for writing only
+                QSharedPointer<SQLiteReadPool> readPool = QSharedPointer<SQLiteReadPool>::create(t_dbPath, m_dPtr->m_storageMode);
+                if(readPool->isValid() == false) {
+                    emit sigDatabaseError(QString("Unable to open read connections for database: %1").arg(t_dbPath));
+                    retVal = false;
+                    return retVal;
+                }
+                m_dPtr->setReadPool(readPool);
+                if(m_dPtr->m_pendingMigrationSteps.isEmpty()) {
+                    m_dPtr->verifyQueryPlans();
+                }
+                replayJournal(t_dbPath);
 
                 emit sigDatabaseReady();
             }
@@ -861,28 +2226,135 @@ bool SQLiteDB::openDatabase(const QString &t_dbPath)
     return retVal;
 }
 
+void SQLiteDB::runMaintenance()
+{
+    if(m_dPtr->m_logDB.isOpen() && m_dPtr->m_pendingMigrationSteps.isEmpty() == false) {
+        //one statement per idle slice, a batch waits for one statement at most
+        if(m_dPtr->m_lastBatchTimer.hasExpired(DBPrivate::s_idleCheckpointDelayMs)) {
+            if(m_dPtr->runMigrationStep() && m_dPtr->m_pendingMigrationSteps.isEmpty()) {
+                m_dPtr->verifyQueryPlans();
+            }
+            return;
+        }
+    }
+    if(m_dPtr->m_logDB.isOpen()) {
+        m_dPtr->updateReclaimableSize();
+        //one slice per maintenance interval while idle, deleting a session frees pages faster than that
+        if(m_dPtr->m_autoVacuumMode == 2 && m_dPtr->m_reclaimableBytes > 0 && m_dPtr->m_lastBatchTimer.hasExpired(DBPrivate::s_idleCheckpointDelayMs)) {
+            m_dPtr->reclaimFreePages();
+        }
+    }
+    if(m_dPtr->m_logDB.isOpen() && m_dPtr->m_walDirty) {
+        if(m_dPtr->m_lastBatchTimer.hasExpired(DBPrivate::s_idleCheckpointDelayMs)
+                || m_dPtr->m_lastCheckpointTimer.hasExpired(DBPrivate::s_maxCheckpointIntervalMs)) {
+            m_dPtr->checkpoint();
+        }
+    }
+}
+
+QStringList SQLiteDB::queryPlanScans()
+{
+    if(m_dPtr->m_logDB.isOpen() == false) {
+        return QStringList();
+    }
+    return m_dPtr->queryPlanScans();
+}
+
 bool SQLiteDB::isDbStillWitable(const QString &t_dbPath)
 {
-    QFileInfo fileInfo(t_dbPath);
-    bool storageOK = true;
-    if(!fileInfo.exists()) {
-        storageOK = false;
-        emit sigDatabaseError(QString("SQLite database file %1 is gone!").arg(t_dbPath));
+    //a stat per batch, a deleted or unmounted file must not wait for the next refresh of the monitor
+    if(QFile::exists(t_dbPath) == false) {
+        if(m_dPtr->m_storageErrorReported == false) {
+            m_dPtr->m_storageErrorReported = true;
+            emit sigDatabaseError(QString("SQLite database file %1 is gone!").arg(t_dbPath));
+        }
+        return false;
     }
-    else {
-        QStorageInfo storageInfo(fileInfo.absoluteDir());
-        if(storageInfo.isValid()) {
-            qint64 promilleFree = (storageInfo.bytesAvailable() * 1000) / storageInfo.bytesTotal();
-            storageOK = promilleFree > 25 /* 2.5% */;
-            if(!storageOK) {
-                emit sigDatabaseError("Error volume is almost full");
+    //free space is checked by the storage monitor in the background
+    if(m_dPtr->m_storageMonitor != nullptr && m_dPtr->m_storageMonitor->isStorageOk() == false) {
+        m_dPtr->reportStorageFailure();
+        return false;
+    }
+    return true;
+}
+
+void SQLiteDB::runBatchedExecution()
+{
+    //pick up everything the logger queued since the last batch, the flush requests of the drained values are covered by this run
+    m_dPtr->m_flushQueued = true;
+    drainRecordQueue();
+    m_dPtr->m_flushQueued = false;
+    m_dPtr->m_flushTimer->stop();
+
+    if(m_dPtr->m_batchVector.isEmpty() && m_dPtr->m_spillFile.isOpen() && m_dPtr->m_spillFile.hasUnreadRecords()) {
+        m_dPtr->readSpilledValues();
+    }
+
+    writeBatch();
+
+    if(m_dPtr->m_replayingSpill && m_dPtr->m_batchVector.isEmpty()) {
+        m_dPtr->m_replayingSpill = false;
+        if(m_dPtr->m_spillFile.commitRead() == false) {
+            qCWarning(VEIN_LOGGER) << "Storing the replay position failed:" << m_dPtr->m_spillFile.lastError();
+        }
+        if(m_dPtr->m_spillFile.isReplayed()) {
+            qCDebug(VEIN_LOGGER) << "Spilled values replayed:" << m_dPtr->m_spillFile.replayedBytes() << "bytes";
+            if(m_dPtr->m_spillFile.remove() == false) {
+                qCWarning(VEIN_LOGGER) << m_dPtr->m_spillFile.lastError();
             }
+            m_dPtr->emitBufferState(true);
         }
     }
-    return storageOK;
+    m_dPtr->emitBufferState(false);
+
+    if(m_dPtr->m_spillFile.isOpen() && m_dPtr->m_spillFile.hasUnreadRecords() && m_dPtr->m_batchVector.isEmpty()) {
+        //replay at full speed, the queued call lets the logger's wake-ups in between
+        m_dPtr->requestFlush();
+    }
+    //values of a failed batch and records queued while writing wait for the next flush
+    else if(m_dPtr->m_batchVector.isEmpty() == false || (m_recordQueue.isNull() == false && m_recordQueue->occupancy() > 0)) {
+        m_dPtr->m_flushTimer->start(m_dPtr->m_flushPolicy.maxAgeMs);
+    }
 }
 
-void SQLiteDB::runBatchedExecution()
+void SQLiteDB::replayJournal(const QString &t_dbPath)
+{
+    //the journal is created with the first journaled value (DBPrivate::journalValue)
+    const QString journalPath = ValueJournal::pathForDatabase(t_dbPath);
+    m_dPtr->m_journalUnavailable = false;
+    if(QFile::exists(journalPath) == false) {
+        return;
+    }
+    if(m_dPtr->m_journal.open(journalPath) == false) {
+        qCWarning(VEIN_LOGGER) << "Journaled values are not replayed:" << m_dPtr->m_journal.lastError();
+        return;
+    }
+    if(m_dPtr->m_journal.isEmpty() == false) {
+        Q_ASSERT(m_dPtr->m_batchVector.isEmpty());
+        if(m_dPtr->readCommittedJournalEpoch() == m_dPtr->m_journal.epoch()) {
+            //crashed after the commit of the batch, before the journal was truncated
+            qCDebug(VEIN_LOGGER) << "Journaled values of" << t_dbPath << "are already committed";
+            if(m_dPtr->m_journal.truncate() == false) {
+                qCWarning(VEIN_LOGGER) << m_dPtr->m_journal.lastError();
+            }
+        }
+        else if(m_dPtr->m_journal.readRecords(m_dPtr->m_batchVector)) {
+            qCWarning(VEIN_LOGGER) << "Replaying" << m_dPtr->m_batchVector.size() << "journaled values of" << t_dbPath;
+            m_dPtr->dropUnknownValues();
+            writeBatch(); //truncates the journal on success
+        }
+        else {
+            qCWarning(VEIN_LOGGER) << "Journal is unreadable, its values are lost:" << m_dPtr->m_journal.lastError();
+            m_dPtr->m_batchVector.clear();
+            m_dPtr->m_journal.truncate();
+        }
+    }
+    if(m_dPtr->m_journal.isEmpty() && m_dPtr->m_journal.remove() == false) {
+        qCWarning(VEIN_LOGGER) << m_dPtr->m_journal.lastError();
+    }
+}
+
+void SQLiteDB::writeBatch()
 {
     QString dbFileName = m_dPtr->m_logDB.databaseName();
     if(!isDbStillWitable(dbFileName)) {
@@ -890,171 +2362,178 @@ void SQLiteDB::runBatchedExecution()
     }
 
     if(m_dPtr->m_logDB.isOpen()) {
-        //addBindValue requires QList<QVariant>
-        QList<QVariant> tmpTimestamps;
-        QList<QVariant> tmpComponentIds;
-        QList<QVariant> tmpValuemapIds;
-        QList<QVariant> tmpEntityIds;
-
-        //do not use QHash here, the sorted key lists are required
-        QMultiMap<QVariant, QVariant> tmpTransactionIds; //session_id, valuemap_id
-        QSet<int> activeTransactions;
-        QMap<int, QVariant> tmpValues; //valuemap_id, component_value
-
-        //code that is used in both loops
-        const auto commonCode = [&](const SQLBatchData &entry) {
-            tmpValuemapIds.append(m_dPtr->m_valueMapQueryCounter);
-            tmpEntityIds.append(entry.entityId);
-            tmpComponentIds.append(entry.componentId);
-            //one value can be logged to multiple sessions simultaneously
-            for(const int currentTransId : entry.transactionIds) {
-                tmpTransactionIds.insert(currentTransId, m_dPtr->m_valueMapQueryCounter);
-                activeTransactions.insert(currentTransId);
-            }
-            tmpTimestamps.append(entry.timestamp);
-            ++m_dPtr->m_valueMapQueryCounter;
-        };
-
-        if(m_dPtr->m_storageMode == SQLiteDB::STORAGE_MODE::TEXT) {
-            for(const SQLBatchData &entry : qAsConst(m_dPtr->m_batchVector)) {
-                tmpValues.insert(m_dPtr->m_valueMapQueryCounter, m_dPtr->getTextRepresentation(entry.value)); //store as text
-                commonCode(entry);
+        QElapsedTimer batchTimer;
+        batchTimer.start();
+
+        const qint64 firstValueId = m_dPtr->m_nextValueId;
+        m_dPtr->m_batchWriter.clear();
+        m_dPtr->m_rollupWriter.clear();
+        int droppedValues = 0;
+        for(const SQLBatchData &entry : qAsConst(m_dPtr->m_batchVector)) {
+            //values queued before their session was deleted would be written behind the deletion, without parents
+            QVector<int> transactionIds = entry.transactionIds;
+            if(m_dPtr->m_deletedTransactionIds.isEmpty() == false && transactionIds.isEmpty() == false) {
+                transactionIds.erase(std::remove_if(transactionIds.begin(), transactionIds.end(), [this](int t_transactionId) {
+                    return m_dPtr->m_deletedTransactionIds.contains(t_transactionId);
+                }), transactionIds.end());
+                if(transactionIds.isEmpty()) {
+                    ++droppedValues;
+                    continue;
+                }
             }
-        }
-        else if(m_dPtr->m_storageMode == SQLiteDB::STORAGE_MODE::BINARY) {
-            for(const SQLBatchData &entry : qAsConst(m_dPtr->m_batchVector)) {
-                tmpValues.insert(m_dPtr->m_valueMapQueryCounter, m_dPtr->getBinaryRepresentation(entry.value)); //store as binary
-                commonCode(entry);
+            const qint64 valueId = m_dPtr->m_nextValueId++;
+            m_dPtr->appendValueRow(valueId, entry);
+            double number = 0.0;
+            const bool rollup = m_dPtr->m_rollupWriter.isPrepared() && SQLiteRollupWriter::toNumber(entry.value, number);
+            //one value can be logged to multiple transactions simultaneously
+            for(const int currentTransId : qAsConst(transactionIds)) {
+                m_dPtr->m_batchWriter.addTransactionMapping(currentTransId, valueId);
+                if(rollup) {
+                    if(m_dPtr->m_rollupCoveredTransactions.contains(currentTransId) == false) {
+                        m_dPtr->m_rollupWriter.markCoverage(currentTransId, valueId);
+                    }
+                    m_dPtr->m_rollupWriter.addValue(currentTransId, entry.entityId, entry.componentId, entry.timestamp, number);
+                }
+                // the stop time of a transaction is the time of its last value
+                addStopTime(currentTransId, entry.timestamp);
             }
         }
 
         if(m_dPtr->m_logDB.transaction() == true) {
-            //valuemap_id, transactionid, value_timestamp, value, entity_id, component_id,
-            m_dPtr->m_valueMapInsertQuery.addBindValue(tmpValuemapIds);
-            m_dPtr->m_valueMapInsertQuery.addBindValue(tmpTimestamps);
-            m_dPtr->m_valueMapInsertQuery.addBindValue(tmpValues.values());
-            m_dPtr->m_valueMapInsertQuery.addBindValue(tmpComponentIds);
-            m_dPtr->m_valueMapInsertQuery.addBindValue(tmpEntityIds);
-
-            if(m_dPtr->m_valueMapInsertQuery.execBatch() == false) {
-                emit sigDatabaseError(QString("Error executing m_valueMapInsertQuery: %1").arg(m_dPtr->m_valueMapInsertQuery.lastError().text()));
+            if(m_dPtr->m_batchWriter.execute() == false) {
+                m_dPtr->m_logDB.rollback();
+                m_dPtr->m_nextValueId = firstValueId;
+                emit sigDatabaseError(QString("Error executing batch: %1").arg(m_dPtr->m_batchWriter.lastError()));
                 return;
             }
-            //transaction_id, valuemap_id
-            m_dPtr->m_transactionMappingInsertQuery.addBindValue(tmpTransactionIds.keys());
-            m_dPtr->m_transactionMappingInsertQuery.addBindValue(tmpTransactionIds.values());
-            if(m_dPtr->m_transactionMappingInsertQuery.execBatch() == false) {
-                emit sigDatabaseError(QString("Error executing m_transactionMappingInsertQuery: %1").arg(m_dPtr->m_transactionMappingInsertQuery.lastError().text()));
+            //same transaction as the values, so the rollups never disagree with valuemap
+            if(m_dPtr->m_rollupWriter.isPrepared() && m_dPtr->m_rollupWriter.execute() == false) {
+                m_dPtr->m_logDB.rollback();
+                m_dPtr->m_nextValueId = firstValueId;
+                emit sigDatabaseError(QString("Error updating rollups: %1").arg(m_dPtr->m_rollupWriter.lastError()));
                 return;
             }
 
-            // Add stop time to active transactions. we have to that here becaus a bathc might be written after the script is removed.
-            // The result is an sql conflict.
-            for(int id : activeTransactions.values()) {
-                addStopTime(id ,QDateTime::currentDateTime());
+            // Start and stop times are written here because a batch might be written after the script is removed.
+            // One update per changed transaction and batch, inside the batch's transaction.
+            if(m_dPtr->writeTransactionTimes() == false) {
+                const QString timeError = m_dPtr->m_stopTimeUpdateQuery.lastError().text() + m_dPtr->m_startTimeUpdateQuery.lastError().text();
+                m_dPtr->m_logDB.rollback();
+                m_dPtr->m_nextValueId = firstValueId;
+                emit sigDatabaseError(QString("Error writing transaction times: %1").arg(timeError));
+                return;
             }
 
-            if(tmpValuemapIds.isEmpty() == false) {
-                vCDebug(VEIN_LOGGER) << "Batched" << tmpValuemapIds.length() << "queries";
+            //replayJournal skips the journal if the crash happened between this commit and the truncate
+            if(m_dPtr->m_journal.isOpen() && m_dPtr->m_journal.isEmpty() == false) {
+                m_dPtr->m_journalEpochUpdateQuery.bindValue(":epoch", m_dPtr->m_journal.epoch());
+                if(m_dPtr->m_journalEpochUpdateQuery.exec() == false) {
+                    const QString epochError = m_dPtr->m_journalEpochUpdateQuery.lastError().text();
+                    m_dPtr->m_logDB.rollback();
+                    m_dPtr->m_nextValueId = firstValueId;
+                    emit sigDatabaseError(QString("Error storing the journal epoch: %1").arg(epochError));
+                    return;
+                }
             }
 
             if(m_dPtr->m_logDB.commit() == false) { //do not use assert here, asserts are no-ops in release code
-                emit sigDatabaseError(QString("Error in database transaction commit: %1").arg(m_dPtr->m_logDB.lastError().text()));
+                const QString commitError = m_dPtr->m_logDB.lastError().text();
+                m_dPtr->m_logDB.rollback();
+                m_dPtr->m_nextValueId = firstValueId;
+                emit sigDatabaseError(QString("Error in database transaction commit: %1").arg(commitError));
                 return;
             }
+            m_dPtr->m_walDirty = true;
+            m_dPtr->m_lastBatchTimer.start();
+            for(const int transactionId : m_dPtr->m_rollupWriter.markedTransactions()) {
+                m_dPtr->m_rollupCoveredTransactions.insert(transactionId);
+            }
+            m_dPtr->m_pendingStartTimes.clear();
+            m_dPtr->m_pendingStopTimes.clear();
+
+            if(droppedValues > 0) {
+                qCDebug(VEIN_LOGGER) << "Dropped" << droppedValues << "values of deleted sessions";
+            }
+            const int rowCount = m_dPtr->m_batchWriter.valueRowCount();
+            if(rowCount > 0) {
+                const qint64 batchNsecs = qMax(batchTimer.nsecsElapsed(), qint64(1));
+                m_dPtr->tuneBatchSize(rowCount, batchNsecs);
+                vCDebug(VEIN_LOGGER) << "Batched" << rowCount << "queries in" << batchNsecs / 1000 << "us"
+                                     << "(" << (qint64(rowCount) * 1000000000) / batchNsecs << "rows/s )";
+                if(m_recordQueue.isNull() == false) {
+                    vCDebug(VEIN_LOGGER) << "Record queue high water mark:" << m_recordQueue->highWaterMark() << "of" << m_recordQueue->capacity();
+                }
+            }
         }
         else {
+            m_dPtr->m_nextValueId = firstValueId;
             emit sigDatabaseError(QString("Error in database transaction: %1").arg(m_dPtr->m_logDB.lastError().text()));
             return;
         }
         m_dPtr->m_batchVector.clear();
+        m_dPtr->m_batchBytes = 0;
+        if(m_dPtr->m_journal.truncate() == false) {
+            qCWarning(VEIN_LOGGER) << m_dPtr->m_journal.lastError();
+        }
+        m_dPtr->m_journalOverflow = false;
     }
 }
 
-void SQLiteDB::writeStaticData(QVector<SQLBatchData> p_batchData)
+bool SQLiteDB::writeSession(int t_sessionId, const QString &t_sessionName, QVector<SQLBatchData> p_batchData)
 {
     if(m_dPtr->m_logDB.isOpen()) {
         if(!isDbStillWitable(m_dPtr->m_logDB.databaseName())) {
-            return;
-        }
-        //addBindValue requires QList<QVariant>
-        QList<QVariant> tmpTimestamps;
-        QList<QVariant> tmpComponentIds;
-        QList<QVariant> tmpValuemapIds;
-        QList<QVariant> tmpEntityIds;
-
-        //do not use QHash here, the sorted key lists are required
-        QMultiMap<QVariant, QVariant> tmpSessionIds; //session_id, valuemap_id
-        QSet<int> activeTransactions;
-        QMap<int, QVariant> tmpValues; //valuemap_id, component_value
-
-        //code that is used in both loops
-        const auto commonCode = [&](const SQLBatchData &entry) {
-            tmpValuemapIds.append(m_dPtr->m_valueMapQueryCounter);
-            tmpEntityIds.append(entry.entityId);
-            tmpComponentIds.append(entry.componentId);
-            tmpSessionIds.insert(entry.sessionId,m_dPtr->m_valueMapQueryCounter);
-            tmpTimestamps.append(entry.timestamp);
-            ++m_dPtr->m_valueMapQueryCounter;
-        };
-
-        if(m_dPtr->m_storageMode == SQLiteDB::STORAGE_MODE::TEXT) {
-            for(const SQLBatchData &entry : qAsConst(p_batchData)) {
-                tmpValues.insert(m_dPtr->m_valueMapQueryCounter, m_dPtr->getTextRepresentation(entry.value)); //store as text
-                commonCode(entry);
-            }
+            return false;
         }
-        else if(m_dPtr->m_storageMode == SQLiteDB::STORAGE_MODE::BINARY) {
-            for(const SQLBatchData &entry : qAsConst(p_batchData)) {
-                tmpValues.insert(m_dPtr->m_valueMapQueryCounter, m_dPtr->getBinaryRepresentation(entry.value)); //store as binary
-                commonCode(entry);
+
+        const qint64 firstValueId = m_dPtr->m_nextValueId;
+        m_dPtr->m_batchWriter.clear();
+        for(const SQLBatchData &entry : qAsConst(p_batchData)) {
+            if(m_dPtr->m_deletedSessionIds.contains(entry.sessionId)) {
+                continue;
             }
+            const qint64 valueId = m_dPtr->m_nextValueId++;
+            m_dPtr->appendValueRow(valueId, entry);
+            m_dPtr->m_batchWriter.addSessionMapping(entry.sessionId, valueId);
         }
 
         if(m_dPtr->m_logDB.transaction() == true) {
-            //valuemap_id, transactionid, value_timestamp, value, entity_id, component_id,
-            m_dPtr->m_valueMapInsertQuery.addBindValue(tmpValuemapIds);
-            m_dPtr->m_valueMapInsertQuery.addBindValue(tmpTimestamps);
-            m_dPtr->m_valueMapInsertQuery.addBindValue(tmpValues.values());
-            m_dPtr->m_valueMapInsertQuery.addBindValue(tmpComponentIds);
-            m_dPtr->m_valueMapInsertQuery.addBindValue(tmpEntityIds);
-
-            if(m_dPtr->m_valueMapInsertQuery.execBatch() == false) {
-                emit sigDatabaseError(QString("Error executing m_valueMapInsertQuery: %1").arg(m_dPtr->m_valueMapInsertQuery.lastError().text()));
-                return;
-            }
-            m_dPtr->m_valueMapInsertQuery.finish();
-
-            //transaction_id, valuemap_id
-            m_dPtr->m_sessionMappingInsertQuery.addBindValue(tmpSessionIds.keys());
-            m_dPtr->m_sessionMappingInsertQuery.addBindValue(tmpSessionIds.values());
-            if(m_dPtr->m_sessionMappingInsertQuery.execBatch() == false) {
-                emit sigDatabaseError(QString("Error executing m_transactionMappingInsertQuery: %1").arg(m_dPtr->m_transactionMappingInsertQuery.lastError().text()));
-                return;
+            m_dPtr->m_sessionInsertQuery.bindValue(":id", t_sessionId);
+            m_dPtr->m_sessionInsertQuery.bindValue(":session_name", t_sessionName);
+            if(m_dPtr->m_sessionInsertQuery.exec() == false) {
+                const QString sessionError = m_dPtr->m_sessionInsertQuery.lastError().text();
+                m_dPtr->m_logDB.rollback();
+                m_dPtr->m_nextValueId = firstValueId;
+                emit sigDatabaseError(QString("SQLiteDB::addSession m_sessionInsertQuery failed: %1").arg(sessionError));
+                return false;
             }
-
-            m_dPtr->m_sessionMappingInsertQuery.finish();
-
-            // Add stop time to active transactions. we have to that here becaus a bathc might be written after the script is removed.
-            // The result is an sql conflict.
-            for(int id : activeTransactions.values()) {
-                addStopTime(id ,QDateTime::currentDateTime());
+            m_dPtr->m_sessionInsertQuery.finish();
+            if(m_dPtr->m_batchWriter.execute() == false) {
+                m_dPtr->m_logDB.rollback();
+                m_dPtr->m_nextValueId = firstValueId;
+                emit sigDatabaseError(QString("Error executing static data batch: %1").arg(m_dPtr->m_batchWriter.lastError()));
+                return false;
             }
 
-            if(tmpValuemapIds.isEmpty() == false) {
-                vCDebug(VEIN_LOGGER) << "Batched" << tmpValuemapIds.length() << "queries";
+            if(m_dPtr->m_batchWriter.valueRowCount() > 0) {
+                vCDebug(VEIN_LOGGER) << "Batched" << m_dPtr->m_batchWriter.valueRowCount() << "static queries";
             }
 
             if(m_dPtr->m_logDB.commit() == false) { //do not use assert here, asserts are no-ops in release code
-                emit sigDatabaseError(QString("Error in database transaction commit: %1").arg(m_dPtr->m_logDB.lastError().text()));
-                return;
+                const QString commitError = m_dPtr->m_logDB.lastError().text();
+                m_dPtr->m_logDB.rollback();
+                m_dPtr->m_nextValueId = firstValueId;
+                emit sigDatabaseError(QString("Error in database transaction commit: %1").arg(commitError));
+                return false;
             }
         }
         else {
+            m_dPtr->m_nextValueId = firstValueId;
             emit sigDatabaseError(QString("Error in database transaction: %1").arg(m_dPtr->m_logDB.lastError().text()));
-            return;
+            return false;
         }
-        m_dPtr->m_batchVector.clear();
+        return true;
     }
+    return false;
 }
 } // namespace VeinLogger
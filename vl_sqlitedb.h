@@ -7,6 +7,7 @@
 #include <QVector>
 #include <QDateTime>
 #include <QVariant>
+#include <QStringList>
 
 #include <functional>
 
@@ -19,7 +20,11 @@ struct SQLBatchData
     int componentId;
     QVector<int> transactionIds;
     int sessionId;
-    QDateTime timestamp;
+    /**
+     * @brief timestamp
+     * UTC microseconds since epoch
+     */
+    qint64 timestamp;
     QVariant value;
 };
 
@@ -41,32 +46,80 @@ public:
     QString databasePath() const override;
     void setStorageMode(AbstractLoggerDB::STORAGE_MODE t_storageMode) override;
     AbstractLoggerDB::STORAGE_MODE getStorageMode() const override;
+    void setDurabilityProfile(AbstractLoggerDB::DURABILITY_PROFILE t_profile) override;
+    AbstractLoggerDB::DURABILITY_PROFILE getDurabilityProfile() const override;
+    void setFlushPolicy(const AbstractLoggerDB::FlushPolicy &t_policy) override;
+    AbstractLoggerDB::FlushPolicy getFlushPolicy() const override;
     std::function<bool(QString)> getDatabaseValidationFunction() const override;
+    int reserveTransactionId() override;
 
     QJsonDocument  readTransaction(const QString &p_transaction, const QString &p_session);
+    QCborMap readTransactionColumns(const QString &p_transaction, const QString &p_session) override;
 
     static bool isValidDatabase(QString t_dbPath);
+    /**
+     * @brief queryPlanScans
+     * @return "statement: plan detail" for every full table scan in the query plans of the read, write and delete
+     * statements, empty for an up to date schema. Logged as warning when the schema migration is done.
+     */
+    QStringList queryPlanScans();
 
 public slots:
     void initLocalData() override;
     void addComponent(const QString &t_componentName) override;
     void addEntity(int t_entityId, QString t_entityName) override;
-    int addTransaction(const QString &t_transactionName, const QString &t_sessionName, const QString &t_contentSets, const QString &t_guiContextName) override;
-    bool addStartTime(int t_transactionId, QDateTime t_time) override;
-    bool addStopTime(int t_transactionId,  QDateTime t_time) override;
+    bool addTransaction(int t_transactionId, const QString &t_transactionName, const QString &t_sessionName, const QString &t_contentSets, const QString &t_guiContextName) override;
+    bool addTransactionMetadata(int t_transactionId, const QString &t_key, const QString &t_value) override;
+    bool addStartTime(int t_transactionId, qint64 t_timestampUs) override;
+    bool addStopTime(int t_transactionId, qint64 t_timestampUs) override;
     bool deleteSession(const QString &t_session) override;
+    bool deleteSessions(const QStringList &t_sessions) override;
+    bool convertToIncrementalVacuum() override;
     int addSession(const QString &t_sessionName,QList<QVariantMap> p_staticData) override;
-    void addLoggedValue(int t_sessionId, QVector<int> transactionIds, int t_entityId, const QString &t_componentName, QVariant t_value, QDateTime t_timestamp) override;
-    void addLoggedValue(const  QString &t_sessionName, QVector<int> t_transactionIds, int t_entityId, const QString &t_componentName, QVariant t_value, QDateTime t_timestamp) override;
+    void addLoggedValue(int t_sessionId, QVector<int> transactionIds, int t_entityId, const QString &t_componentName, QVariant t_value, qint64 t_timestamp) override;
+    void addLoggedValue(const  QString &t_sessionName, QVector<int> t_transactionIds, int t_entityId, const QString &t_componentName, QVariant t_value, qint64 t_timestamp) override;
     QVariant readSessionComponent(const QString &p_session, const QString &p_enity, const QString &p_component) override;
+    QVector<int> readTransactionIds(const QString &p_transaction, const QString &p_session) override;
+    qint64 readLastValueId() override;
+    QJsonArray readTransactionPage(int t_transactionId, qint64 t_afterValueId, qint64 t_lastValueId, int t_pageSize) override;
+    QJsonObject readTrend(const QString &p_transaction, const QString &p_session, const QString &p_entity, const QString &p_component, qint64 t_resolutionUs) override;
+    QJsonObject readRange(const QString &p_session, const QString &p_entity, const QString &p_component, qint64 t_fromUs, qint64 t_toUs, int t_maxPoints) override;
 
     bool openDatabase(const QString &t_dbPath) override;
     bool isDbStillWitable(const QString &t_dbPath);
 
     void runBatchedExecution() override;
 
+private slots:
+    /**
+     * @brief runMaintenance
+     * Periodic checkpoints of the write ahead log, schema migrations and reclaiming free pages,
+     * preferably while no batches are written
+     */
+    void runMaintenance();
+    /**
+     * @brief runSessionDeletion
+     * Runs one chunk of the session deletion and schedules the next one
+     */
+    void runSessionDeletion();
+
 private:
-    void writeStaticData(QVector<SQLBatchData> p_batchData);
+    /**
+     * @brief writeSession
+     * Writes the session row and its static data in one sql transaction
+     * @return false if neither was written
+     */
+    bool writeSession(int t_sessionId, const QString &t_sessionName, QVector<SQLBatchData> p_batchData);
+    /**
+     * @brief writeBatch
+     * Writes m_batchVector in one sql transaction, keeps it on errors
+     */
+    void writeBatch();
+    /**
+     * @brief replayJournal
+     * Writes the values journaled before a crash, opens the journal for the new values
+     */
+    void replayJournal(const QString &t_dbPath);
 
 private:
     DBPrivate *m_dPtr=nullptr;
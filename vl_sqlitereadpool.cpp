@@ -0,0 +1,718 @@
+#include "vl_sqlitereadpool.h"
+#include "vl_valuecodec.h"
+#include "vl_loggerclock.h"
+#include "vl_sqliterollupwriter.h"
+#include "vl_lttbsampler.h"
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QCborArray>
+#include <QHash>
+#include <QMap>
+#include <QtSql>
+#include <QtSql/QSqlQuery>
+
+#include <limits>
+
+namespace VeinLogger
+{
+/**
+ * @brief The SQLiteReader class
+ * One read-only connection, lives on a worker thread of the SQLiteReadPool
+ */
+class SQLiteReader : public QObject
+{
+public:
+    SQLiteReader(const QString &t_connectionName, AbstractLoggerDB::STORAGE_MODE t_storageMode) :
+        m_connectionName(t_connectionName),
+        m_storageMode(t_storageMode)
+    {
+    }
+
+    ~SQLiteReader()
+    {
+        m_readTransactionQuery = QSqlQuery();
+        m_sessionStaticDataQuery = QSqlQuery();
+        m_transactionIdsQuery = QSqlQuery();
+        m_lastValueIdQuery = QSqlQuery();
+        m_transactionPageQuery = QSqlQuery();
+        m_trendSecondQuery = QSqlQuery();
+        m_trendMinuteQuery = QSqlQuery();
+        m_trendValueQuery = QSqlQuery();
+        m_trendCoverageQuery = QSqlQuery();
+        m_rangeCountQuery = QSqlQuery();
+        m_rangeQuery = QSqlQuery();
+        if(m_readDB.isValid()) {
+            m_readDB.close();
+            m_readDB = QSqlDatabase();
+            QSqlDatabase::removeDatabase(m_connectionName);
+        }
+    }
+
+    bool open(const QString &t_dbPath)
+    {
+        m_readDB = QSqlDatabase::addDatabase("QSQLITE", m_connectionName);
+        m_readDB.setConnectOptions(QLatin1String("QSQLITE_OPEN_READONLY"));
+        m_readDB.setDatabaseName(t_dbPath);
+        if(m_readDB.open() == false) {
+            qCWarning(VEIN_LOGGER) << "Reader" << m_connectionName << "failed to open" << t_dbPath << m_readDB.lastError().text();
+            return false;
+        }
+
+        m_readTransactionQuery = QSqlQuery(m_readDB);
+        m_sessionStaticDataQuery = QSqlQuery(m_readDB);
+        m_transactionIdsQuery = QSqlQuery(m_readDB);
+        m_lastValueIdQuery = QSqlQuery(m_readDB);
+        m_transactionPageQuery = QSqlQuery(m_readDB);
+        m_trendSecondQuery = QSqlQuery(m_readDB);
+        m_trendMinuteQuery = QSqlQuery(m_readDB);
+        m_trendValueQuery = QSqlQuery(m_readDB);
+        m_trendCoverageQuery = QSqlQuery(m_readDB);
+        m_rangeCountQuery = QSqlQuery(m_readDB);
+        m_rangeQuery = QSqlQuery(m_readDB);
+        bool retVal = m_readTransactionQuery.prepare("SELECT valuemap.value_timestamp,"
+                                                     " valuemap.component_value,"
+                                                     " valuemap.id,"
+                                                     " components.component_name,"
+                                                     " entities.entity_name,"
+                                                     " transactions.transaction_name,"
+                                                     " sessions.session_name"
+                                                     " FROM sessions INNER JOIN transactions ON"
+                                                     " sessions.id = transactions.sessionid "
+                                                     " INNER JOIN transactions_valuemap ON "
+                                                     " transactions.id = transactions_valuemap.transactionsid "
+                                                     " INNER JOIN valuemap ON "
+                                                     " transactions_valuemap.valueid = valuemap.id "
+                                                     " INNER JOIN components ON "
+                                                     " valuemap.componentid = components.id "
+                                                     " INNER JOIN entities ON valuemap.entityiesid = entities.id where transactions.transaction_name = :transaction AND sessions.session_name = :sessionname ;");
+        //ordered by value id: the last value of a component wins
+        retVal = m_sessionStaticDataQuery.prepare("SELECT entities.entity_name, components.component_name, valuemap.component_value"
+                                                  " FROM sessions INNER JOIN"
+                                                  " sessions_valuemap ON sessions.id = sessions_valuemap.sessionsid INNER JOIN"
+                                                  " valuemap ON sessions_valuemap.valueid = valuemap.id INNER JOIN entities ON valuemap.entityiesid = entities.id INNER JOIN"
+                                                  " components ON valuemap.componentid = components.id"
+                                                  " WHERE session_name= :sessionname ORDER BY sessions_valuemap.valueid;") && retVal;
+        retVal = m_transactionIdsQuery.prepare("SELECT transactions.id FROM transactions INNER JOIN sessions ON sessions.id = transactions.sessionid"
+                                               " WHERE transactions.transaction_name = :transaction AND sessions.session_name = :sessionname"
+                                               " ORDER BY transactions.id;") && retVal;
+        retVal = m_lastValueIdQuery.prepare("SELECT MAX(id) FROM valuemap;") && retVal;
+        //keyset pagination: seeks the primary key (transactionsid, valueid) instead of skipping rows
+        retVal = m_transactionPageQuery.prepare("SELECT valuemap.value_timestamp,"
+                                                " valuemap.component_value,"
+                                                " valuemap.id,"
+                                                " components.component_name,"
+                                                " entities.entity_name,"
+                                                " transactions.transaction_name,"
+                                                " sessions.session_name"
+                                                " FROM transactions_valuemap"
+                                                " INNER JOIN transactions ON transactions.id = transactions_valuemap.transactionsid"
+                                                " INNER JOIN sessions ON sessions.id = transactions.sessionid"
+                                                " INNER JOIN valuemap ON transactions_valuemap.valueid = valuemap.id"
+                                                " INNER JOIN components ON valuemap.componentid = components.id"
+                                                " INNER JOIN entities ON valuemap.entityiesid = entities.id"
+                                                " WHERE transactions_valuemap.transactionsid = :transactionId"
+                                                " AND transactions_valuemap.valueid > :afterValueId AND transactions_valuemap.valueid <= :lastValueId"
+                                                " ORDER BY transactions_valuemap.valueid LIMIT :pageSize;") && retVal;
+        const QString trendRollupQuery = QStringLiteral("SELECT bucket_start, value_count, value_min, value_max, value_sum, value_first, value_last, first_timestamp, last_timestamp"
+                                                        " FROM %1 WHERE transactionsid = :transactionId"
+                                                        " AND entityiesid IN (SELECT id FROM entities WHERE entity_name = :entity)"
+                                                        " AND componentid IN (SELECT id FROM components WHERE component_name = :component);");
+        retVal = m_trendSecondQuery.prepare(trendRollupQuery.arg(QLatin1String(SQLiteRollupWriter::s_secondTable))) && retVal;
+        retVal = m_trendMinuteQuery.prepare(trendRollupQuery.arg(QLatin1String(SQLiteRollupWriter::s_minuteTable))) && retVal;
+        //the values of a transaction logged before the rollup tables existed, seeks the primary key (transactionsid, valueid)
+        retVal = m_trendValueQuery.prepare("SELECT valuemap.value_timestamp, valuemap.component_value"
+                                           " FROM transactions_valuemap INNER JOIN valuemap ON transactions_valuemap.valueid = valuemap.id"
+                                           " WHERE transactions_valuemap.transactionsid = :transactionId AND transactions_valuemap.valueid < :beforeValueId"
+                                           " AND valuemap.entityiesid IN (SELECT id FROM entities WHERE entity_name = :entity)"
+                                           " AND valuemap.componentid IN (SELECT id FROM components WHERE component_name = :component);") && retVal;
+        retVal = m_trendCoverageQuery.prepare(QString("SELECT first_valueid FROM %1 WHERE transactionsid = :transactionId;")
+                                              .arg(QLatin1String(SQLiteRollupWriter::s_coverageTable))) && retVal;
+        //seeks the index valuemap_entity_component_timestamp, ISO 8601 text timestamps of older versions sort after all numbers and are not in the range
+        //entity and component names are unique in a vein system: = instead of IN reads the index in timestamp order, without a sort of the whole range
+        const QString rangeCondition = QStringLiteral(" WHERE valuemap.entityiesid = (SELECT id FROM entities WHERE entity_name = :entity)"
+                                                      " AND valuemap.componentid = (SELECT id FROM components WHERE component_name = :component)"
+                                                      " AND valuemap.value_timestamp >= :fromUs AND valuemap.value_timestamp <= :toUs"
+                                                      " AND EXISTS (SELECT 1 FROM transactions_valuemap INNER JOIN transactions ON transactions.id = transactions_valuemap.transactionsid"
+                                                      " WHERE transactions_valuemap.valueid = valuemap.id"
+                                                      " AND transactions.sessionid IN (SELECT id FROM sessions WHERE session_name = :sessionname))");
+        retVal = m_rangeCountQuery.prepare(QString("SELECT COUNT(*) FROM valuemap%1;").arg(rangeCondition)) && retVal;
+        retVal = m_rangeQuery.prepare(QString("SELECT valuemap.value_timestamp, valuemap.component_value FROM valuemap%1"
+                                              " ORDER BY valuemap.value_timestamp;").arg(rangeCondition)) && retVal;
+        if(retVal == false) {
+            qCWarning(VEIN_LOGGER) << "Reader" << m_connectionName << "failed to prepare queries:" << m_readDB.lastError().text();
+        }
+        return retVal;
+    }
+
+    QJsonDocument readTransaction(const QString &p_transaction, const QString &p_session)
+    {
+        QJsonDocument  retVal;
+        QJsonArray     recordsArray;
+        m_readTransactionQuery.bindValue(":transaction",p_transaction);
+        m_readTransactionQuery.bindValue(":sessionname",p_session);
+        //one snapshot for the whole result
+        m_readDB.transaction();
+        if (!m_readTransactionQuery.exec()) {
+            m_readDB.rollback();
+            return QJsonDocument();
+        }
+
+        appendRecords(m_readTransactionQuery, recordsArray);
+        m_readDB.commit();
+        retVal.setArray(recordsArray);
+        return retVal;
+    }
+
+    QCborMap readTransactionColumns(const QString &p_transaction, const QString &p_session)
+    {
+        QCborMap retVal;
+        m_readTransactionQuery.bindValue(":transaction",p_transaction);
+        m_readTransactionQuery.bindValue(":sessionname",p_session);
+        m_readDB.transaction();
+        if (!m_readTransactionQuery.exec()) {
+            m_readDB.rollback();
+            return retVal;
+        }
+
+        const QSqlRecord record = m_readTransactionQuery.record();
+        const int timestampFieldNo = record.indexOf("value_timestamp");
+        const int valueFieldNo = record.indexOf("component_value");
+        const int idFieldNo = record.indexOf("id");
+        const int componentFieldNo = record.indexOf("component_name");
+        const int entityFieldNo = record.indexOf("entity_name");
+        QHash<QString, int> entityIndex;
+        QHash<QString, int> componentIndex;
+        QCborArray entities, components, ids, timestamps, entityColumn, componentColumn, values;
+        while(m_readTransactionQuery.next()) {
+            const QString entityName = m_readTransactionQuery.value(entityFieldNo).toString();
+            auto entityIter = entityIndex.constFind(entityName);
+            if(entityIter == entityIndex.constEnd()) {
+                entityIter = entityIndex.insert(entityName, entities.size());
+                entities.append(entityName);
+            }
+            const QString componentName = m_readTransactionQuery.value(componentFieldNo).toString();
+            auto componentIter = componentIndex.constFind(componentName);
+            if(componentIter == componentIndex.constEnd()) {
+                componentIter = componentIndex.insert(componentName, components.size());
+                components.append(componentName);
+            }
+            const QVariant timestamp = m_readTransactionQuery.value(timestampFieldNo);
+            ids.append(m_readTransactionQuery.value(idFieldNo).toLongLong());
+            timestamps.append(timestamp.type() == QVariant::LongLong ? QCborValue(timestamp.toLongLong()) : QCborValue(timestamp.toString()));
+            entityColumn.append(entityIter.value());
+            componentColumn.append(componentIter.value());
+            values.append(storedValueToCbor(m_readTransactionQuery.value(valueFieldNo)));
+        }
+        m_readTransactionQuery.finish();
+        m_readDB.commit();
+
+        retVal.insert(QLatin1String("session"), p_session);
+        retVal.insert(QLatin1String("transaction"), p_transaction);
+        retVal.insert(QLatin1String("entities"), entities);
+        retVal.insert(QLatin1String("components"), components);
+        retVal.insert(QLatin1String("id"), ids);
+        retVal.insert(QLatin1String("value_timestamp"), timestamps);
+        retVal.insert(QLatin1String("entity"), entityColumn);
+        retVal.insert(QLatin1String("component"), componentColumn);
+        retVal.insert(QLatin1String("component_value"), values);
+        return retVal;
+    }
+
+    QHash<QString, QVariantHash> readSessionStaticData(const QString &p_session)
+    {
+        QHash<QString, QVariantHash> retVal;
+        m_sessionStaticDataQuery.bindValue(":sessionname",p_session);
+        m_readDB.transaction();
+        if (!m_sessionStaticDataQuery.exec()){
+            m_readDB.rollback();
+            return retVal;
+        }
+
+        while(m_sessionStaticDataQuery.next()){
+            retVal[m_sessionStaticDataQuery.value(0).toString()].insert(m_sessionStaticDataQuery.value(1).toString(), decodeStoredValue(m_sessionStaticDataQuery.value(2)));
+        }
+        m_sessionStaticDataQuery.finish();
+        m_readDB.commit();
+        return retVal;
+    }
+
+    QVector<int> readTransactionIds(const QString &p_transaction, const QString &p_session)
+    {
+        QVector<int> retVal;
+        m_transactionIdsQuery.bindValue(":transaction", p_transaction);
+        m_transactionIdsQuery.bindValue(":sessionname", p_session);
+        if(m_transactionIdsQuery.exec()) {
+            while(m_transactionIdsQuery.next()) {
+                retVal.append(m_transactionIdsQuery.value(0).toInt());
+            }
+        }
+        m_transactionIdsQuery.finish();
+        return retVal;
+    }
+
+    qint64 readLastValueId()
+    {
+        qint64 retVal = 0;
+        if(m_lastValueIdQuery.exec() && m_lastValueIdQuery.next()) {
+            retVal = m_lastValueIdQuery.value(0).toLongLong();
+        }
+        m_lastValueIdQuery.finish();
+        return retVal;
+    }
+
+    QJsonArray readTransactionPage(int t_transactionId, qint64 t_afterValueId, qint64 t_lastValueId, int t_pageSize)
+    {
+        QJsonArray recordsArray;
+        m_transactionPageQuery.bindValue(":transactionId", t_transactionId);
+        m_transactionPageQuery.bindValue(":afterValueId", t_afterValueId);
+        m_transactionPageQuery.bindValue(":lastValueId", t_lastValueId);
+        m_transactionPageQuery.bindValue(":pageSize", t_pageSize);
+        if(m_transactionPageQuery.exec()) {
+            appendRecords(m_transactionPageQuery, recordsArray);
+        }
+        else {
+            m_transactionPageQuery.finish();
+        }
+        return recordsArray;
+    }
+
+    QJsonObject readTrend(const QString &p_transaction, const QString &p_session, const QString &p_entity, const QString &p_component, qint64 t_resolutionUs)
+    {
+        QJsonObject retVal;
+        if(t_resolutionUs <= 0) {
+            return retVal;
+        }
+        //bucket start -> aggregate, ordered for the output
+        QMap<qint64, SQLiteRollupWriter::Cell> buckets;
+        //the coarsest rollup whose buckets add up to the requested ones exactly
+        QSqlQuery *rollupQuery = nullptr;
+        const char *rollupTable = nullptr;
+        if(t_resolutionUs % SQLiteRollupWriter::s_minuteUs == 0) {
+            rollupQuery = &m_trendMinuteQuery;
+            rollupTable = SQLiteRollupWriter::s_minuteTable;
+        }
+        else if(t_resolutionUs % SQLiteRollupWriter::s_secondUs == 0) {
+            rollupQuery = &m_trendSecondQuery;
+            rollupTable = SQLiteRollupWriter::s_secondTable;
+        }
+        bool rollupsRead = false;
+        bool valuesRead = false;
+        m_readDB.transaction();
+        for(const int transactionId : readTransactionIds(p_transaction, p_session)) {
+            //a transaction recorded across the introduction of the rollups has its older values only in valuemap
+            qint64 rollupStartValueId = rollupQuery != nullptr ? readRollupStart(transactionId) : -1;
+            if(rollupStartValueId >= 0) {
+                readRollupBuckets(*rollupQuery, transactionId, p_entity, p_component, t_resolutionUs, buckets);
+                rollupsRead = true;
+            }
+            else {
+                rollupStartValueId = std::numeric_limits<qint64>::max();
+            }
+            valuesRead = readValueBuckets(transactionId, rollupStartValueId, p_entity, p_component, t_resolutionUs, buckets) || valuesRead;
+        }
+        m_readDB.commit();
+        QStringList sources;
+        if(rollupsRead) {
+            sources.append(QLatin1String(rollupTable));
+        }
+        if(valuesRead || rollupsRead == false) {
+            sources.append(QStringLiteral("valuemap"));
+        }
+        const QString source = sources.join('+');
+
+        QJsonArray bucketStarts, counts, minimums, maximums, means, firsts, lasts;
+        for(auto iter = buckets.constBegin(); iter != buckets.constEnd(); ++iter) {
+            bucketStarts.append(double(iter.key()));
+            counts.append(double(iter->count));
+            minimums.append(iter->min);
+            maximums.append(iter->max);
+            means.append(iter->sum / iter->count);
+            firsts.append(iter->first);
+            lasts.append(iter->last);
+        }
+        retVal.insert(QLatin1String("session"), p_session);
+        retVal.insert(QLatin1String("transaction"), p_transaction);
+        retVal.insert(QLatin1String("entity"), p_entity);
+        retVal.insert(QLatin1String("component"), p_component);
+        retVal.insert(QLatin1String("resolution"), double(t_resolutionUs / 1000));
+        retVal.insert(QLatin1String("source"), source);
+        retVal.insert(QLatin1String("bucket_start"), bucketStarts);
+        retVal.insert(QLatin1String("count"), counts);
+        retVal.insert(QLatin1String("min"), minimums);
+        retVal.insert(QLatin1String("max"), maximums);
+        retVal.insert(QLatin1String("mean"), means);
+        retVal.insert(QLatin1String("first"), firsts);
+        retVal.insert(QLatin1String("last"), lasts);
+        return retVal;
+    }
+
+    QJsonObject readRange(const QString &p_session, const QString &p_entity, const QString &p_component, qint64 t_fromUs, qint64 t_toUs, int t_maxPoints)
+    {
+        QJsonObject retVal;
+        for(QSqlQuery *query : {&m_rangeCountQuery, &m_rangeQuery}) {
+            query->bindValue(":entity", p_entity);
+            query->bindValue(":component", p_component);
+            query->bindValue(":fromUs", t_fromUs);
+            query->bindValue(":toUs", t_toUs);
+            query->bindValue(":sessionname", p_session);
+        }
+        //the count sizes the buckets, the values are then streamed through the sampler instead of loading the whole range
+        m_readDB.transaction();
+        if(m_rangeCountQuery.exec() == false || m_rangeCountQuery.next() == false) {
+            m_rangeCountQuery.finish();
+            m_readDB.rollback();
+            return retVal;
+        }
+        const qint64 rowCount = m_rangeCountQuery.value(0).toLongLong();
+        m_rangeCountQuery.finish();
+        if(m_rangeQuery.exec() == false) {
+            m_readDB.rollback();
+            return retVal;
+        }
+        //rows that are not numbers are counted but skipped, so the buckets hold at most as many points as planned
+        LttbSampler sampler(rowCount, t_maxPoints);
+        while(m_rangeQuery.next()) {
+            double number = 0.0;
+            if(SQLiteRollupWriter::toNumber(decodeStoredValue(m_rangeQuery.value(1)), number)) {
+                sampler.add(m_rangeQuery.value(0).toLongLong(), number);
+            }
+        }
+        m_rangeQuery.finish();
+        m_readDB.commit();
+
+        QJsonArray timestamps, values;
+        const qint64 pointCount = sampler.addedCount();
+        for(const LttbSampler::Point &point : sampler.finish()) {
+            timestamps.append(double(point.timestampUs));
+            values.append(point.value);
+        }
+        retVal.insert(QLatin1String("session"), p_session);
+        retVal.insert(QLatin1String("entity"), p_entity);
+        retVal.insert(QLatin1String("component"), p_component);
+        retVal.insert(QLatin1String("from"), double(t_fromUs));
+        retVal.insert(QLatin1String("to"), double(t_toUs));
+        retVal.insert(QLatin1String("count"), double(pointCount));
+        retVal.insert(QLatin1String("value_timestamp"), timestamps);
+        retVal.insert(QLatin1String("component_value"), values);
+        return retVal;
+    }
+
+    QStringList queryPlanScans()
+    {
+        QStringList statements;
+        const QVector<const QSqlQuery *> queries = {&m_readTransactionQuery, &m_sessionStaticDataQuery, &m_transactionIdsQuery, &m_lastValueIdQuery, &m_transactionPageQuery,
+                                                    &m_trendSecondQuery, &m_trendMinuteQuery, &m_trendValueQuery, &m_trendCoverageQuery, &m_rangeCountQuery, &m_rangeQuery};
+        for(const QSqlQuery *query : queries) {
+            statements.append(query->lastQuery());
+        }
+        return SQLiteReadPool::queryPlanScans(m_readDB, statements);
+    }
+
+private:
+    /**
+     * @brief readRollupStart
+     * @return the first value id of t_transactionId in the rollups, -1 if the transaction has no rollups
+     */
+    qint64 readRollupStart(int t_transactionId)
+    {
+        qint64 retVal = -1;
+        m_trendCoverageQuery.bindValue(":transactionId", t_transactionId);
+        if(m_trendCoverageQuery.exec() && m_trendCoverageQuery.next()) {
+            retVal = m_trendCoverageQuery.value(0).toLongLong();
+        }
+        m_trendCoverageQuery.finish();
+        return retVal;
+    }
+
+    /**
+     * @brief readRollupBuckets
+     * Merges the rows of the rollup table of t_query into buckets of t_resolutionUs
+     */
+    void readRollupBuckets(QSqlQuery &t_query, int t_transactionId, const QString &p_entity, const QString &p_component, qint64 t_resolutionUs, QMap<qint64, SQLiteRollupWriter::Cell> &t_buckets)
+    {
+        t_query.bindValue(":transactionId", t_transactionId);
+        t_query.bindValue(":entity", p_entity);
+        t_query.bindValue(":component", p_component);
+        if(t_query.exec()) {
+            while(t_query.next()) {
+                SQLiteRollupWriter::Cell cell;
+                cell.count = t_query.value(1).toLongLong();
+                cell.min = t_query.value(2).toDouble();
+                cell.max = t_query.value(3).toDouble();
+                cell.sum = t_query.value(4).toDouble();
+                cell.first = t_query.value(5).toDouble();
+                cell.last = t_query.value(6).toDouble();
+                cell.firstTimestampUs = t_query.value(7).toLongLong();
+                cell.lastTimestampUs = t_query.value(8).toLongLong();
+                t_buckets[SQLiteRollupWriter::bucketStartUs(t_query.value(0).toLongLong(), t_resolutionUs)].merge(cell);
+            }
+        }
+        t_query.finish();
+    }
+
+    /**
+     * @brief readValueBuckets
+     * Aggregates the values of t_transactionId logged before t_beforeValueId into buckets of t_resolutionUs,
+     * like the rollups only finite scalar numbers and no rows with ISO 8601 timestamps of older versions
+     * @return true if any value was aggregated
+     */
+    bool readValueBuckets(int t_transactionId, qint64 t_beforeValueId, const QString &p_entity, const QString &p_component, qint64 t_resolutionUs, QMap<qint64, SQLiteRollupWriter::Cell> &t_buckets)
+    {
+        bool retVal = false;
+        m_trendValueQuery.bindValue(":transactionId", t_transactionId);
+        m_trendValueQuery.bindValue(":beforeValueId", t_beforeValueId);
+        m_trendValueQuery.bindValue(":entity", p_entity);
+        m_trendValueQuery.bindValue(":component", p_component);
+        if(m_trendValueQuery.exec()) {
+            while(m_trendValueQuery.next()) {
+                const QVariant timestamp = m_trendValueQuery.value(0);
+                double number = 0.0;
+                if(timestamp.type() == QVariant::LongLong && SQLiteRollupWriter::toNumber(decodeStoredValue(m_trendValueQuery.value(1)), number)) {
+                    const qint64 timestampUs = timestamp.toLongLong();
+                    t_buckets[SQLiteRollupWriter::bucketStartUs(timestampUs, t_resolutionUs)].add(number, timestampUs);
+                    retVal = true;
+                }
+            }
+        }
+        m_trendValueQuery.finish();
+        return retVal;
+    }
+
+    /**
+     * @brief appendRecords
+     * Appends all rows of the executed t_query as JSON objects and finishes the query
+     */
+    void appendRecords(QSqlQuery &t_query, QJsonArray &t_recordsArray) const
+    {
+        const QSqlRecord record = t_query.record();
+        const int valueFieldNo = record.indexOf("component_value");
+        const int timestampFieldNo = record.indexOf("value_timestamp");
+        while(t_query.next())
+        {
+            QJsonObject recordObject;
+            for(int x=0; x < record.count(); x++)
+            {
+                if(x == valueFieldNo) {
+                    recordObject.insert(record.fieldName(x), storedValueToJson(t_query.value(x)));
+                }
+                else if(x == timestampFieldNo) {
+                    recordObject.insert(record.fieldName(x), timestampToJson(t_query.value(x)));
+                }
+                else {
+                    recordObject.insert(record.fieldName(x), QJsonValue::fromVariant(t_query.value(x)));
+                }
+            }
+            t_recordsArray.push_back(recordObject);
+        }
+        t_query.finish();
+    }
+
+    /**
+     * @brief isEncodedBlob
+     * @return true if t_storedValue was written by ValueCodec
+     */
+    bool isEncodedBlob(const QVariant &t_storedValue) const
+    {
+        return m_storageMode != AbstractLoggerDB::STORAGE_MODE::TEXT && t_storedValue.type() == QVariant::ByteArray;
+    }
+
+    /**
+     * @brief decodeStoredValue
+     * @param t_storedValue: component_value as returned by QSQLITE
+     * @return the logged value, BLOBs of STORAGE_MODE::BINARY and STORAGE_MODE::TYPED are converted back to their original type
+     */
+    QVariant decodeStoredValue(const QVariant &t_storedValue) const
+    {
+        if(isEncodedBlob(t_storedValue)) {
+            return ValueCodec::decode(t_storedValue.toByteArray());
+        }
+        return t_storedValue;
+    }
+
+    /**
+     * @brief storedValueToJson
+     * BLOBs are converted without creating the intermediate QVariant
+     */
+    QJsonValue storedValueToJson(const QVariant &t_storedValue) const
+    {
+        if(isEncodedBlob(t_storedValue)) {
+            return ValueCodec::decodeToJson(t_storedValue.toByteArray());
+        }
+        return ValueCodec::toJson(t_storedValue);
+    }
+
+    /**
+     * @brief storedValueToCbor
+     * Same as storedValueToJson without the detour through JSON, so 64 bit integers and byte arrays keep their type
+     */
+    QCborValue storedValueToCbor(const QVariant &t_storedValue) const
+    {
+        if(isEncodedBlob(t_storedValue)) {
+            return ValueCodec::decodeToCbor(t_storedValue.toByteArray());
+        }
+        return ValueCodec::toCbor(t_storedValue);
+    }
+
+    /**
+     * @brief timestampToJson
+     * Timestamps are formatted for the readers only, databases of older versions contain ISO 8601 text
+     */
+    QJsonValue timestampToJson(const QVariant &t_storedTimestamp) const
+    {
+        if(t_storedTimestamp.type() == QVariant::LongLong) {
+            return LoggerClock::toIsoString(t_storedTimestamp.toLongLong());
+        }
+        return QJsonValue::fromVariant(t_storedTimestamp);
+    }
+
+    QString m_connectionName;
+    AbstractLoggerDB::STORAGE_MODE m_storageMode;
+    QSqlDatabase m_readDB;
+    QSqlQuery m_readTransactionQuery;
+    QSqlQuery m_sessionStaticDataQuery;
+    QSqlQuery m_transactionIdsQuery;
+    QSqlQuery m_lastValueIdQuery;
+    QSqlQuery m_transactionPageQuery;
+    QSqlQuery m_trendSecondQuery;
+    QSqlQuery m_trendMinuteQuery;
+    QSqlQuery m_trendValueQuery;
+    QSqlQuery m_trendCoverageQuery;
+    QSqlQuery m_rangeCountQuery;
+    QSqlQuery m_rangeQuery;
+};
+
+constexpr int SQLiteReadPool::s_defaultReaderCount;
+
+SQLiteReadPool::SQLiteReadPool(const QString &t_dbPath, AbstractLoggerDB::STORAGE_MODE t_storageMode, int t_readerCount)
+{
+    //connection names are process global: pools of a reopened or a second database must not share them
+    static QAtomicInt s_poolCounter;
+    const int poolId = s_poolCounter.fetchAndAddRelaxed(1);
+    m_valid = true;
+    for(int i = 0; i < qMax(t_readerCount, 1); ++i) {
+        Worker worker;
+        worker.thread = new QThread();
+        worker.thread->setObjectName(QString("VFLoggerDBReader%1").arg(i));
+        worker.reader = new SQLiteReader(QString("VFLogDBReader%1_%2").arg(poolId).arg(i), t_storageMode);
+        worker.reader->moveToThread(worker.thread);
+        worker.thread->start();
+
+        //connections are bound to the thread that opened them
+        bool opened = false;
+        SQLiteReader *reader = worker.reader;
+        QMetaObject::invokeMethod(reader, [reader, t_dbPath, &opened]() { opened = reader->open(t_dbPath); }, Qt::BlockingQueuedConnection);
+        m_valid = m_valid && opened;
+        m_workers.append(worker);
+    }
+}
+
+SQLiteReadPool::~SQLiteReadPool()
+{
+    for(const Worker &worker : qAsConst(m_workers)) {
+        //the connection has to be closed in its own thread
+        SQLiteReader *reader = worker.reader;
+        QMetaObject::invokeMethod(reader, [reader]() { delete reader; }, Qt::BlockingQueuedConnection);
+        worker.thread->quit();
+        worker.thread->wait();
+        delete worker.thread;
+    }
+}
+
+bool SQLiteReadPool::isValid() const
+{
+    return m_valid;
+}
+
+template <class T, class F> T SQLiteReadPool::runOnReader(F t_function)
+{
+    T retVal;
+    SQLiteReader *reader = nextReader();
+    QMetaObject::invokeMethod(reader, [reader, &retVal, &t_function]() { retVal = t_function(reader); }, Qt::BlockingQueuedConnection);
+    return retVal;
+}
+
+QJsonDocument SQLiteReadPool::readTransaction(const QString &p_transaction, const QString &p_session)
+{
+    return runOnReader<QJsonDocument>([&](SQLiteReader *t_reader) { return t_reader->readTransaction(p_transaction, p_session); });
+}
+
+QCborMap SQLiteReadPool::readTransactionColumns(const QString &p_transaction, const QString &p_session)
+{
+    return runOnReader<QCborMap>([&](SQLiteReader *t_reader) { return t_reader->readTransactionColumns(p_transaction, p_session); });
+}
+
+QHash<QString, QVariantHash> SQLiteReadPool::readSessionStaticData(const QString &p_session)
+{
+    return runOnReader<QHash<QString, QVariantHash> >([&](SQLiteReader *t_reader) { return t_reader->readSessionStaticData(p_session); });
+}
+
+QVector<int> SQLiteReadPool::readTransactionIds(const QString &p_transaction, const QString &p_session)
+{
+    return runOnReader<QVector<int> >([&](SQLiteReader *t_reader) { return t_reader->readTransactionIds(p_transaction, p_session); });
+}
+
+QStringList SQLiteReadPool::queryPlanScans()
+{
+    return runOnReader<QStringList>([](SQLiteReader *t_reader) { return t_reader->queryPlanScans(); });
+}
+
+QStringList SQLiteReadPool::queryPlanScans(const QSqlDatabase &t_database, const QStringList &t_statements, const QStringList &t_allowedTables)
+{
+    QStringList retVal;
+    QSqlQuery explainQuery(t_database);
+    for(const QString &statement : t_statements) {
+        if(explainQuery.exec(QString("EXPLAIN QUERY PLAN %1").arg(statement)) == false) {
+            retVal.append(QString("%1: %2").arg(statement, explainQuery.lastError().text()));
+            continue;
+        }
+        const int detailFieldNo = explainQuery.record().indexOf("detail");
+        while(explainQuery.next()) {
+            //"SCAN <table> ..." since sqlite 3.36, "SCAN TABLE <table> ..." before
+            const QString detail = explainQuery.value(detailFieldNo).toString();
+            QStringList words = detail.split(' ', Qt::SkipEmptyParts);
+            if(words.size() < 2 || words.at(0) != QLatin1String("SCAN")) {
+                continue;
+            }
+            if(words.at(1) == QLatin1String("TABLE") && words.size() > 2) {
+                words.removeAt(1);
+            }
+            if(words.at(1) == QLatin1String("CONSTANT") || t_allowedTables.contains(words.at(1))) {
+                continue;
+            }
+            retVal.append(QString("%1: %2").arg(statement, detail));
+        }
+        explainQuery.finish();
+    }
+    return retVal;
+}
+
+qint64 SQLiteReadPool::readLastValueId()
+{
+    return runOnReader<qint64>([](SQLiteReader *t_reader) { return t_reader->readLastValueId(); });
+}
+
+QJsonArray SQLiteReadPool::readTransactionPage(int t_transactionId, qint64 t_afterValueId, qint64 t_lastValueId, int t_pageSize)
+{
+    return runOnReader<QJsonArray>([&](SQLiteReader *t_reader) { return t_reader->readTransactionPage(t_transactionId, t_afterValueId, t_lastValueId, t_pageSize); });
+}
+
+QJsonObject SQLiteReadPool::readTrend(const QString &p_transaction, const QString &p_session, const QString &p_entity, const QString &p_component, qint64 t_resolutionUs)
+{
+    return runOnReader<QJsonObject>([&](SQLiteReader *t_reader) { return t_reader->readTrend(p_transaction, p_session, p_entity, p_component, t_resolutionUs); });
+}
+
+QJsonObject SQLiteReadPool::readRange(const QString &p_session, const QString &p_entity, const QString &p_component, qint64 t_fromUs, qint64 t_toUs, int t_maxPoints)
+{
+    return runOnReader<QJsonObject>([&](SQLiteReader *t_reader) { return t_reader->readRange(p_session, p_entity, p_component, t_fromUs, t_toUs, t_maxPoints); });
+}
+
+SQLiteReader *SQLiteReadPool::nextReader()
+{
+    const unsigned int index = m_nextWorker.fetch_add(1, std::memory_order_relaxed);
+    return m_workers.at(static_cast<int>(index % static_cast<unsigned int>(m_workers.size()))).reader;
+}
+
+} // namespace VeinLogger
@@ -0,0 +1,104 @@
+#ifndef VEINLOGGER_SQLITEREADPOOL_H
+#define VEINLOGGER_SQLITEREADPOOL_H
+
+#include "globalIncludes.h"
+#include "vl_abstractloggerdb.h"
+
+#include <QString>
+#include <QVector>
+#include <QVariant>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QCborMap>
+#include <QSqlDatabase>
+#include <QStringList>
+
+#include <atomic>
+
+class QThread;
+
+namespace VeinLogger
+{
+class SQLiteReader;
+
+/**
+ * @brief The SQLiteReadPool class
+ *
+ * Read-only connections to the logger database, each one living on its own worker thread
+ * with its own prepared read statements.
+ *
+ * Every read runs in a read transaction, so it sees one consistent snapshot
+ * of the database while the writer keeps committing batches (WAL mode).
+ *
+ * The read functions are thread safe and block the caller until the result is available.
+ * They must not be called from a worker thread of the pool.
+ */
+class SQLiteReadPool
+{
+public:
+    /**
+     * @param t_dbPath: database written by SQLiteDB, must exist
+     * @param t_storageMode: storage mode of the writer, needed to decode the values
+     */
+    SQLiteReadPool(const QString &t_dbPath, AbstractLoggerDB::STORAGE_MODE t_storageMode, int t_readerCount = s_defaultReaderCount);
+    ~SQLiteReadPool();
+
+    /**
+     * @brief isValid
+     * @return true if all connections were opened
+     */
+    bool isValid() const;
+
+    QJsonDocument readTransaction(const QString &p_transaction, const QString &p_session);
+    QCborMap readTransactionColumns(const QString &p_transaction, const QString &p_session);
+    /**
+     * @brief readSessionStaticData
+     * @return entity name -> component name -> value of the static data stored with the session
+     */
+    QHash<QString, QVariantHash> readSessionStaticData(const QString &p_session);
+    QVector<int> readTransactionIds(const QString &p_transaction, const QString &p_session);
+    qint64 readLastValueId();
+    QJsonArray readTransactionPage(int t_transactionId, qint64 t_afterValueId, qint64 t_lastValueId, int t_pageSize);
+    QJsonObject readTrend(const QString &p_transaction, const QString &p_session, const QString &p_entity, const QString &p_component, qint64 t_resolutionUs);
+    QJsonObject readRange(const QString &p_session, const QString &p_entity, const QString &p_component, qint64 t_fromUs, qint64 t_toUs, int t_maxPoints);
+    /**
+     * @brief queryPlanScans
+     * @return "query: plan detail" for every full table or index scan in the query plans of the read queries
+     */
+    QStringList queryPlanScans();
+    /**
+     * @brief queryPlanScans
+     * Runs EXPLAIN QUERY PLAN for every statement of t_statements on t_database, parameters stay unbound
+     * @param t_allowedTables: tables that are read completely on purpose, e.g. small temp tables
+     * @return "statement: plan detail" for every full table or index scan, and for statements that can not be explained
+     */
+    static QStringList queryPlanScans(const QSqlDatabase &t_database, const QStringList &t_statements, const QStringList &t_allowedTables = QStringList());
+
+    static constexpr int s_defaultReaderCount = 2;
+
+private:
+    struct Worker
+    {
+        QThread *thread;
+        SQLiteReader *reader;
+    };
+    /**
+     * @brief nextReader
+     * round robin over the workers
+     */
+    SQLiteReader *nextReader();
+    /**
+     * @brief runOnReader
+     * Calls t_function(reader) in the thread of the next reader and waits for the result
+     */
+    template <class T, class F> T runOnReader(F t_function);
+
+    QVector<Worker> m_workers;
+    std::atomic<unsigned int> m_nextWorker{0};
+    bool m_valid = false;
+};
+} // namespace VeinLogger
+
+#endif // VEINLOGGER_SQLITEREADPOOL_H
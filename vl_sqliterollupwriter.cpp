@@ -0,0 +1,305 @@
+#include "vl_sqliterollupwriter.h"
+
+#include <sqlite3.h>
+
+#include <cmath>
+
+namespace VeinLogger
+{
+//constexpr definition, see: https://stackoverflow.com/questions/8016780/undefined-reference-to-static-constexpr-char
+constexpr const char *SQLiteRollupWriter::s_secondTable;
+constexpr const char *SQLiteRollupWriter::s_minuteTable;
+constexpr const char *SQLiteRollupWriter::s_coverageTable;
+constexpr int SQLiteRollupWriter::s_minimumSqliteVersion;
+constexpr qint64 SQLiteRollupWriter::s_secondUs;
+constexpr qint64 SQLiteRollupWriter::s_minuteUs;
+
+uint qHash(const SQLiteRollupWriter::CellKey &t_key, uint t_seed)
+{
+    return qHash(t_key.bucketStartUs, t_seed) ^ (uint(t_key.componentId) * 31u + uint(t_key.entityId) * 17u + uint(t_key.transactionId));
+}
+
+void SQLiteRollupWriter::Cell::add(double t_value, qint64 t_timestampUs)
+{
+    if(count == 0) {
+        min = t_value;
+        max = t_value;
+        sum = t_value;
+        first = t_value;
+        last = t_value;
+        firstTimestampUs = t_timestampUs;
+        lastTimestampUs = t_timestampUs;
+    }
+    else {
+        min = qMin(min, t_value);
+        max = qMax(max, t_value);
+        sum += t_value;
+        if(t_timestampUs < firstTimestampUs) {
+            first = t_value;
+            firstTimestampUs = t_timestampUs;
+        }
+        if(t_timestampUs >= lastTimestampUs) {
+            last = t_value;
+            lastTimestampUs = t_timestampUs;
+        }
+    }
+    ++count;
+}
+
+void SQLiteRollupWriter::Cell::merge(const Cell &t_other)
+{
+    if(t_other.count == 0) {
+        return;
+    }
+    if(count == 0) {
+        *this = t_other;
+        return;
+    }
+    min = qMin(min, t_other.min);
+    max = qMax(max, t_other.max);
+    sum += t_other.sum;
+    if(t_other.firstTimestampUs < firstTimestampUs) {
+        first = t_other.first;
+        firstTimestampUs = t_other.firstTimestampUs;
+    }
+    if(t_other.lastTimestampUs >= lastTimestampUs) {
+        last = t_other.last;
+        lastTimestampUs = t_other.lastTimestampUs;
+    }
+    count += t_other.count;
+}
+
+SQLiteRollupWriter::SQLiteRollupWriter()
+{
+}
+
+SQLiteRollupWriter::~SQLiteRollupWriter()
+{
+    finalize();
+}
+
+QString SQLiteRollupWriter::createTableStatement(const char *t_table)
+{
+    //bucket_start: UTC microseconds since epoch, the primary key is the access path of the trend reads
+    return QString("CREATE TABLE IF NOT EXISTS %1 (transactionsid integer(10) NOT NULL, entityiesid integer(10) NOT NULL, componentid integer(10) NOT NULL,"
+                   " bucket_start INTEGER NOT NULL, value_count INTEGER NOT NULL, value_min REAL, value_max REAL, value_sum REAL, value_first REAL, value_last REAL,"
+                   " first_timestamp INTEGER, last_timestamp INTEGER,"
+                   " PRIMARY KEY (transactionsid, entityiesid, componentid, bucket_start), FOREIGN KEY(transactionsid) REFERENCES transactions(id)) WITHOUT ROWID;").arg(QLatin1String(t_table));
+}
+
+QString SQLiteRollupWriter::upsertStatement(const char *t_table)
+{
+    //the cells of a bucket written by earlier batches are merged in sqlite
+    return QString("INSERT INTO %1 (transactionsid, entityiesid, componentid, bucket_start, value_count, value_min, value_max, value_sum,"
+                   " value_first, value_last, first_timestamp, last_timestamp) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"
+                   " ON CONFLICT (transactionsid, entityiesid, componentid, bucket_start) DO UPDATE SET"
+                   " value_count = value_count + excluded.value_count,"
+                   " value_min = MIN(value_min, excluded.value_min),"
+                   " value_max = MAX(value_max, excluded.value_max),"
+                   " value_sum = value_sum + excluded.value_sum,"
+                   " value_first = CASE WHEN excluded.first_timestamp < first_timestamp THEN excluded.value_first ELSE value_first END,"
+                   " value_last = CASE WHEN excluded.last_timestamp >= last_timestamp THEN excluded.value_last ELSE value_last END,"
+                   " first_timestamp = MIN(first_timestamp, excluded.first_timestamp),"
+                   " last_timestamp = MAX(last_timestamp, excluded.last_timestamp);").arg(QLatin1String(t_table));
+}
+
+QString SQLiteRollupWriter::coverageTableStatement()
+{
+    //first_valueid: the values of the transaction before it are not in the rollups
+    return QString("CREATE TABLE IF NOT EXISTS %1 (transactionsid INTEGER PRIMARY KEY, first_valueid INTEGER NOT NULL,"
+                   " FOREIGN KEY(transactionsid) REFERENCES transactions(id));").arg(QLatin1String(s_coverageTable));
+}
+
+QStringList SQLiteRollupWriter::statements()
+{
+    return QStringList()
+            << upsertStatement(s_secondTable)
+            << upsertStatement(s_minuteTable)
+            << coverageInsertStatement();
+}
+
+bool SQLiteRollupWriter::toNumber(const QVariant &t_value, double &t_number)
+{
+    switch(static_cast<QMetaType::Type>(t_value.type())) { //see http://stackoverflow.com/questions/31290606/qmetatypefloat-not-in-qvarianttype
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::Long:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Float:
+    case QMetaType::Double:
+        t_number = t_value.toDouble();
+        //sqlite stores NaN as NULL
+        return std::isfinite(t_number);
+    default:
+        return false;
+    }
+}
+
+qint64 SQLiteRollupWriter::bucketStartUs(qint64 t_timestampUs, qint64 t_bucketUs)
+{
+    //rounds down for timestamps before the epoch as well
+    qint64 offset = t_timestampUs % t_bucketUs;
+    if(offset < 0) {
+        offset += t_bucketUs;
+    }
+    return t_timestampUs - offset;
+}
+
+bool SQLiteRollupWriter::prepare(sqlite3 *t_handle)
+{
+    finalize();
+    m_handle = t_handle;
+    if(m_handle == nullptr) {
+        m_lastError = QStringLiteral("SQLiteRollupWriter: no native database handle");
+        return false;
+    }
+    //the upsert syntax is a parse error before
+    if(sqlite3_libversion_number() < s_minimumSqliteVersion) {
+        m_lastError = QString("SQLiteRollupWriter: sqlite %1 has no upsert").arg(QLatin1String(sqlite3_libversion()));
+        m_handle = nullptr;
+        return false;
+    }
+    if(prepareUpsert(s_secondTable, &m_secondUpsertStatement) == false) {
+        return setError("prepare rollup_second upsert");
+    }
+    if(prepareUpsert(s_minuteTable, &m_minuteUpsertStatement) == false) {
+        return setError("prepare rollup_minute upsert");
+    }
+    const QByteArray coverageInsert = coverageInsertStatement().toUtf8();
+    if(sqlite3_prepare_v2(m_handle, coverageInsert.constData(), -1, &m_coverageInsertStatement, nullptr) != SQLITE_OK) {
+        return setError("prepare rollup_coverage insert");
+    }
+    return true;
+}
+
+void SQLiteRollupWriter::finalize()
+{
+    //sqlite3_finalize is a harmless no-op for nullptr
+    sqlite3_finalize(m_secondUpsertStatement);
+    sqlite3_finalize(m_minuteUpsertStatement);
+    sqlite3_finalize(m_coverageInsertStatement);
+    m_secondUpsertStatement = nullptr;
+    m_minuteUpsertStatement = nullptr;
+    m_coverageInsertStatement = nullptr;
+    m_handle = nullptr;
+}
+
+bool SQLiteRollupWriter::isPrepared() const
+{
+    return m_secondUpsertStatement != nullptr && m_minuteUpsertStatement != nullptr && m_coverageInsertStatement != nullptr;
+}
+
+void SQLiteRollupWriter::clear()
+{
+    m_secondCells.clear();
+    m_minuteCells.clear();
+    m_coverageStarts.clear();
+}
+
+void SQLiteRollupWriter::addValue(int t_transactionId, int t_entityId, int t_componentId, qint64 t_timestampUs, double t_value)
+{
+    CellKey key{t_transactionId, t_entityId, t_componentId, bucketStartUs(t_timestampUs, s_secondUs)};
+    m_secondCells[key].add(t_value, t_timestampUs);
+    key.bucketStartUs = bucketStartUs(t_timestampUs, s_minuteUs);
+    m_minuteCells[key].add(t_value, t_timestampUs);
+}
+
+void SQLiteRollupWriter::markCoverage(int t_transactionId, qint64 t_valueId)
+{
+    auto iter = m_coverageStarts.find(t_transactionId);
+    if(iter == m_coverageStarts.end()) {
+        m_coverageStarts.insert(t_transactionId, t_valueId);
+    }
+    else if(t_valueId < iter.value()) {
+        iter.value() = t_valueId;
+    }
+}
+
+QList<int> SQLiteRollupWriter::markedTransactions() const
+{
+    return m_coverageStarts.keys();
+}
+
+bool SQLiteRollupWriter::execute()
+{
+    if(isPrepared() == false) {
+        m_lastError = QStringLiteral("SQLiteRollupWriter: statements are not prepared");
+        return false;
+    }
+    if(upsertCells(m_secondUpsertStatement, m_secondCells) == false) {
+        return setError("rollup_second upsert");
+    }
+    if(upsertCells(m_minuteUpsertStatement, m_minuteCells) == false) {
+        return setError("rollup_minute upsert");
+    }
+    if(insertCoverage() == false) {
+        return setError("rollup_coverage insert");
+    }
+    return true;
+}
+
+QString SQLiteRollupWriter::lastError() const
+{
+    return m_lastError;
+}
+
+QString SQLiteRollupWriter::coverageInsertStatement()
+{
+    //the first mark of a transaction wins, later batches are covered anyway
+    return QString("INSERT OR IGNORE INTO %1 (transactionsid, first_valueid) VALUES (?, ?);").arg(QLatin1String(s_coverageTable));
+}
+
+bool SQLiteRollupWriter::prepareUpsert(const char *t_table, sqlite3_stmt **t_statement)
+{
+    const QByteArray upsert = upsertStatement(t_table).toUtf8();
+    return sqlite3_prepare_v2(m_handle, upsert.constData(), -1, t_statement, nullptr) == SQLITE_OK;
+}
+
+bool SQLiteRollupWriter::upsertCells(sqlite3_stmt *t_statement, const QHash<CellKey, Cell> &t_cells)
+{
+    for(auto iter = t_cells.constBegin(); iter != t_cells.constEnd(); ++iter) {
+        const CellKey &key = iter.key();
+        const Cell &cell = iter.value();
+        sqlite3_bind_int(t_statement, 1, key.transactionId);
+        sqlite3_bind_int(t_statement, 2, key.entityId);
+        sqlite3_bind_int(t_statement, 3, key.componentId);
+        sqlite3_bind_int64(t_statement, 4, key.bucketStartUs);
+        sqlite3_bind_int64(t_statement, 5, cell.count);
+        sqlite3_bind_double(t_statement, 6, cell.min);
+        sqlite3_bind_double(t_statement, 7, cell.max);
+        sqlite3_bind_double(t_statement, 8, cell.sum);
+        sqlite3_bind_double(t_statement, 9, cell.first);
+        sqlite3_bind_double(t_statement, 10, cell.last);
+        sqlite3_bind_int64(t_statement, 11, cell.firstTimestampUs);
+        sqlite3_bind_int64(t_statement, 12, cell.lastTimestampUs);
+        const int stepResult = sqlite3_step(t_statement);
+        sqlite3_reset(t_statement);
+        if(stepResult != SQLITE_DONE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SQLiteRollupWriter::insertCoverage()
+{
+    for(auto iter = m_coverageStarts.constBegin(); iter != m_coverageStarts.constEnd(); ++iter) {
+        sqlite3_bind_int(m_coverageInsertStatement, 1, iter.key());
+        sqlite3_bind_int64(m_coverageInsertStatement, 2, iter.value());
+        const int stepResult = sqlite3_step(m_coverageInsertStatement);
+        sqlite3_reset(m_coverageInsertStatement);
+        if(stepResult != SQLITE_DONE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SQLiteRollupWriter::setError(const char *t_context)
+{
+    m_lastError = QString("SQLiteRollupWriter %1 failed: %2").arg(QLatin1String(t_context)).arg(QString::fromUtf8(sqlite3_errmsg(m_handle)));
+    return false;
+}
+
+} // namespace VeinLogger
@@ -0,0 +1,168 @@
+#ifndef VEINLOGGER_SQLITEROLLUPWRITER_H
+#define VEINLOGGER_SQLITEROLLUPWRITER_H
+
+#include "globalIncludes.h"
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVariant>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace VeinLogger
+{
+/**
+ * @brief The SQLiteRollupWriter class
+ *
+ * Keeps the rollup tables rollup_second and rollup_minute up to date: one row per transaction, entity, component
+ * and second or minute with count, min, max, sum, first and last of the scalar numbers logged in that time.
+ *
+ * The values of a batch are aggregated in memory first, execute() merges the cells into the tables with one
+ * upsert per cell, so a batch adds at most one statement per component and second.
+ *
+ * Transactions recorded before the rollup tables existed are only partly in the rollups: rollup_coverage holds
+ * the first value id of each transaction that went into the rollups, readers take the values before it from valuemap.
+ *
+ * Like the SQLiteBatchWriter it works on the native sqlite3 handle and the caller owns the SQL transaction.
+ */
+class SQLiteRollupWriter
+{
+public:
+    /**
+     * @brief The Cell struct
+     * Aggregate of the values of one bucket, also used by the readers to merge buckets
+     */
+    struct Cell
+    {
+        qint64 count = 0;
+        double min = 0.0;
+        double max = 0.0;
+        double sum = 0.0;
+        double first = 0.0;
+        double last = 0.0;
+        qint64 firstTimestampUs = 0;
+        qint64 lastTimestampUs = 0;
+
+        void add(double t_value, qint64 t_timestampUs);
+        void merge(const Cell &t_other);
+    };
+
+    SQLiteRollupWriter();
+    ~SQLiteRollupWriter();
+
+    /**
+     * @brief createTableStatement
+     * @return CREATE TABLE IF NOT EXISTS statement for t_table, one of s_secondTable and s_minuteTable
+     */
+    static QString createTableStatement(const char *t_table);
+    /**
+     * @brief upsertStatement
+     * @return statement merging one cell into t_table, needs sqlite 3.24
+     */
+    static QString upsertStatement(const char *t_table);
+    /**
+     * @brief coverageTableStatement
+     * @return CREATE TABLE IF NOT EXISTS statement for rollup_coverage
+     */
+    static QString coverageTableStatement();
+    /**
+     * @brief statements
+     * @return the statements execute() runs, for query plan checks
+     */
+    static QStringList statements();
+    /**
+     * @brief toNumber
+     * @return false if t_value is not a finite scalar number, only those are aggregated
+     */
+    static bool toNumber(const QVariant &t_value, double &t_number);
+    /**
+     * @brief bucketStartUs
+     * @return start of the bucket of t_bucketUs length containing t_timestampUs
+     */
+    static qint64 bucketStartUs(qint64 t_timestampUs, qint64 t_bucketUs);
+
+    /**
+     * @brief prepare
+     * @param t_handle: native handle taken from QSqlDriver::handle(), the rollup tables must exist
+     * @return false on error or if the sqlite library is older than 3.24 (no upsert), see lastError()
+     */
+    bool prepare(sqlite3 *t_handle);
+    /**
+     * @brief finalize
+     * Must be called before the connection is closed
+     */
+    void finalize();
+    bool isPrepared() const;
+
+    /**
+     * @brief clear
+     * Drops all collected cells and coverage marks
+     */
+    void clear();
+    void addValue(int t_transactionId, int t_entityId, int t_componentId, qint64 t_timestampUs, double t_value);
+    /**
+     * @brief markCoverage
+     * Records t_valueId as the first value of t_transactionId in the rollups, execute() keeps an existing mark
+     */
+    void markCoverage(int t_transactionId, qint64 t_valueId);
+    /**
+     * @brief markedTransactions
+     * @return the transactions marked since clear()
+     */
+    QList<int> markedTransactions() const;
+    /**
+     * @brief execute
+     * @return false on error, see lastError(). The collected cells are kept in both cases.
+     */
+    bool execute();
+    QString lastError() const;
+
+    static constexpr const char *s_secondTable = "rollup_second";
+    static constexpr const char *s_minuteTable = "rollup_minute";
+    static constexpr const char *s_coverageTable = "rollup_coverage";
+    static constexpr int s_minimumSqliteVersion = 3024000;
+    static constexpr qint64 s_secondUs = 1000 * 1000;
+    static constexpr qint64 s_minuteUs = 60 * s_secondUs;
+
+private:
+    struct CellKey
+    {
+        int transactionId;
+        int entityId;
+        int componentId;
+        qint64 bucketStartUs;
+
+        bool operator==(const CellKey &t_other) const
+        {
+            return bucketStartUs == t_other.bucketStartUs && componentId == t_other.componentId
+                    && entityId == t_other.entityId && transactionId == t_other.transactionId;
+        }
+    };
+    friend uint qHash(const CellKey &t_key, uint t_seed);
+
+    static QString coverageInsertStatement();
+    bool prepareUpsert(const char *t_table, sqlite3_stmt **t_statement);
+    bool upsertCells(sqlite3_stmt *t_statement, const QHash<CellKey, Cell> &t_cells);
+    bool insertCoverage();
+    bool setError(const char *t_context);
+
+    sqlite3 *m_handle = nullptr;
+    sqlite3_stmt *m_secondUpsertStatement = nullptr;
+    sqlite3_stmt *m_minuteUpsertStatement = nullptr;
+    sqlite3_stmt *m_coverageInsertStatement = nullptr;
+
+    QHash<CellKey, Cell> m_secondCells;
+    QHash<CellKey, Cell> m_minuteCells;
+    /**
+     * @brief m_coverageStarts
+     * transaction id -> first value id of the batch in the rollups
+     */
+    QHash<int, qint64> m_coverageStarts;
+
+    QString m_lastError;
+};
+} // namespace VeinLogger
+
+#endif // VEINLOGGER_SQLITEROLLUPWRITER_H
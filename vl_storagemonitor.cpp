@@ -0,0 +1,160 @@
+#include "vl_storagemonitor.h"
+
+#include <QThread>
+#include <QTimer>
+#include <QFileInfo>
+#include <QStorageInfo>
+
+namespace VeinLogger
+{
+namespace
+{
+/**
+ * @return true if t_new differs from t_old by more than 10%, or one of them is unknown (-1)
+ */
+bool changedNotably(qint64 t_old, qint64 t_new)
+{
+    if(t_old < 0 || t_new < 0) {
+        return t_old != t_new;
+    }
+    return qAbs(t_new - t_old) * 10 > qMax(t_old, qint64(1));
+}
+} // namespace
+
+//constexpr definition, see: https://stackoverflow.com/questions/8016780/undefined-reference-to-static-constexpr-char
+constexpr qint64 StorageMonitor::s_reservePromille;
+constexpr int StorageMonitor::s_minRefreshMs;
+constexpr int StorageMonitor::s_maxRefreshMs;
+constexpr int StorageMonitor::s_rateTimeConstantMs;
+constexpr qint64 StorageMonitor::s_tightMarginFactor;
+
+StorageMonitor *StorageMonitor::create(const QString &t_dbPath)
+{
+    QThread *thread = new QThread();
+    thread->setObjectName(QStringLiteral("VFLoggerStorageMonitor"));
+    StorageMonitor *monitor = new StorageMonitor(t_dbPath);
+    monitor->moveToThread(thread);
+    thread->start();
+    //the timer has to be created in the thread of the monitor
+    QMetaObject::invokeMethod(monitor, [monitor]() {
+        monitor->m_refreshTimer = new QTimer(monitor);
+        monitor->m_refreshTimer->setSingleShot(true);
+        QObject::connect(monitor->m_refreshTimer, &QTimer::timeout, monitor, &StorageMonitor::refresh);
+        monitor->refresh();
+    }, Qt::BlockingQueuedConnection);
+    return monitor;
+}
+
+void StorageMonitor::destroy(StorageMonitor *t_monitor)
+{
+    if(t_monitor == nullptr) {
+        return;
+    }
+    QThread *thread = t_monitor->thread();
+    //deferred deletes are processed in the thread when it finishes at the latest
+    t_monitor->deleteLater();
+    thread->quit();
+    thread->wait();
+    delete thread;
+}
+
+bool StorageMonitor::isStorageOk() const
+{
+    return m_storageOk.load(std::memory_order_relaxed);
+}
+
+qint64 StorageMonitor::bytesAvailable() const
+{
+    return m_bytesAvailable.load(std::memory_order_relaxed);
+}
+
+QString StorageMonitor::failureReason() const
+{
+    QMutexLocker locker(&m_failureReasonMutex);
+    return m_failureReason;
+}
+
+StorageMonitor::StorageMonitor(const QString &t_dbPath) :
+    m_dbPath(t_dbPath)
+{
+}
+
+StorageMonitor::~StorageMonitor()
+{
+}
+
+void StorageMonitor::refresh()
+{
+    QString failure;
+    const QFileInfo fileInfo(m_dbPath);
+    const QStorageInfo storageInfo(fileInfo.absolutePath());
+    if(fileInfo.exists() == false) {
+        failure = QString("SQLite database file %1 is gone!").arg(m_dbPath);
+    }
+    else if(storageInfo.isValid() && storageInfo.isReady()) {
+        const qint64 available = storageInfo.bytesAvailable();
+        m_bytesTotal = storageInfo.bytesTotal();
+        if(m_sampleTimer.isValid()) {
+            //space freed by deletion or vacuum does not count as negative ingest
+            const qint64 elapsedMs = qMax(m_sampleTimer.restart(), qint64(1));
+            const double rateSample = qMax(m_bytesAvailable.load() - available, qint64(0)) * 1000.0 / elapsedMs;
+            m_ingestRate += (rateSample - m_ingestRate) * elapsedMs / (s_rateTimeConstantMs + elapsedMs);
+        }
+        else {
+            m_sampleTimer.start();
+        }
+        m_bytesAvailable.store(available);
+
+        const qint64 margin = available - reserveBytes();
+        m_marginBytes = margin;
+        m_timeToFull = m_ingestRate >= 1.0 ? qint64(qMax(margin, qint64(0)) / m_ingestRate) : -1;
+        if(margin <= 0) {
+            failure = QStringLiteral("Error volume is almost full");
+        }
+    }
+
+    const bool storageOk = failure.isEmpty();
+    if(storageOk == false) {
+        QMutexLocker locker(&m_failureReasonMutex);
+        m_failureReason = failure;
+    }
+    if(m_storageOk.exchange(storageOk) && storageOk == false) {
+        emit sigStorageFailed(failure);
+    }
+
+    const qint64 ingestRate = qint64(m_ingestRate);
+    if(changedNotably(m_reportedTimeToFull, m_timeToFull) || changedNotably(m_reportedIngestRate, ingestRate)) {
+        m_reportedTimeToFull = m_timeToFull;
+        m_reportedIngestRate = ingestRate;
+        QVariantMap info;
+        info.insert("rootPath", storageInfo.rootPath());
+        info.insert("bytesAvailable", m_bytesAvailable.load());
+        info.insert("bytesTotal", m_bytesTotal);
+        info.insert("ingestRate", ingestRate);
+        info.insert("timeToFull", m_timeToFull);
+        emit sigStorageInfoChanged(info);
+    }
+    scheduleRefresh();
+}
+
+void StorageMonitor::scheduleRefresh()
+{
+    //about 20 refreshes before the reserve is reached
+    qint64 refreshMs = s_maxRefreshMs;
+    if(m_timeToFull >= 0) {
+        refreshMs = m_timeToFull * 1000 / 20;
+    }
+    //closer to the reserve the rate is no safe prediction, a burst after an idle phase fills the margin quickly
+    const qint64 tightMargin = reserveBytes() * s_tightMarginFactor;
+    if(m_marginBytes >= 0 && m_marginBytes < tightMargin) {
+        refreshMs = qMin(refreshMs, s_maxRefreshMs * m_marginBytes / tightMargin);
+    }
+    m_refreshTimer->start(int(qBound(qint64(s_minRefreshMs), refreshMs, qint64(s_maxRefreshMs))));
+}
+
+qint64 StorageMonitor::reserveBytes() const
+{
+    return m_bytesTotal * s_reservePromille / 1000;
+}
+
+} // namespace VeinLogger
@@ -0,0 +1,125 @@
+#ifndef VEINLOGGER_STORAGEMONITOR_H
+#define VEINLOGGER_STORAGEMONITOR_H
+
+#include "globalIncludes.h"
+
+#include <QObject>
+#include <QString>
+#include <QVariantMap>
+#include <QElapsedTimer>
+#include <QMutex>
+
+#include <atomic>
+
+class QTimer;
+
+namespace VeinLogger
+{
+/**
+ * @brief The StorageMonitor class
+ *
+ * Watches the volume of the database in its own thread and caches the free space,
+ * so writers only read the atomic isStorageOk() flag.
+ *
+ * The refresh interval adapts to the predicted time until the volume reaches the reserve:
+ * s_maxRefreshMs while there is plenty of space or nothing is written, down to s_minRefreshMs when it becomes tight.
+ * The ingest rate is the smoothed decrease of free space, so it includes the write ahead log, journal and spill file.
+ * Within s_tightMarginFactor times the reserve the interval also shrinks with the margin left, regardless of the rate.
+ *
+ * Create and delete it with create() and destroy(), it must be deleted in its thread.
+ */
+class StorageMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief create
+     * Starts a monitor for the volume of t_dbPath in a new thread, the first refresh is done when this returns
+     */
+    static StorageMonitor *create(const QString &t_dbPath);
+    /**
+     * @brief destroy
+     * Deletes the monitor and stops its thread
+     */
+    static void destroy(StorageMonitor *t_monitor);
+
+    /**
+     * @brief isStorageOk
+     * @return false if the database file is gone or the free space dropped below the reserve, thread safe
+     */
+    bool isStorageOk() const;
+    /**
+     * @brief bytesAvailable
+     * @return free space of the volume at the last refresh, thread safe
+     */
+    qint64 bytesAvailable() const;
+    /**
+     * @brief failureReason
+     * @return why isStorageOk() is false, thread safe
+     */
+    QString failureReason() const;
+
+    /**
+     * @brief s_reservePromille
+     * free space kept on the volume, 2.5% of its size
+     */
+    static constexpr qint64 s_reservePromille = 25;
+    static constexpr int s_minRefreshMs = 250;
+    static constexpr int s_maxRefreshMs = 10000;
+
+signals:
+    /**
+     * @brief sigStorageInfoChanged
+     * @param t_info: "rootPath" (QString), "bytesAvailable", "bytesTotal" (qint64), "ingestRate" (bytes/s, qint64),
+     * "timeToFull" (seconds until the reserve is reached, -1 if nothing is written)
+     */
+    void sigStorageInfoChanged(const QVariantMap &t_info);
+    /**
+     * @brief sigStorageFailed
+     * emitted once when isStorageOk() becomes false, the first refresh in create() reports with isStorageOk() only
+     */
+    void sigStorageFailed(const QString &t_reason);
+
+private:
+    explicit StorageMonitor(const QString &t_dbPath);
+    ~StorageMonitor();
+
+    void refresh();
+    void scheduleRefresh();
+    qint64 reserveBytes() const;
+
+    QString m_dbPath;
+    QTimer *m_refreshTimer = nullptr;
+    std::atomic<bool> m_storageOk{true};
+    std::atomic<qint64> m_bytesAvailable{0};
+    QString m_failureReason;
+    mutable QMutex m_failureReasonMutex;
+    qint64 m_bytesTotal = 0;
+    QElapsedTimer m_sampleTimer;
+    /**
+     * @brief m_ingestRate
+     * smoothed decrease of free space in bytes/s
+     */
+    double m_ingestRate = 0.0;
+    qint64 m_timeToFull = -1;
+    /**
+     * @brief m_marginBytes
+     * free space above the reserve at the last refresh, -1 if unknown
+     */
+    qint64 m_marginBytes = -1;
+    qint64 m_reportedTimeToFull = -1;
+    qint64 m_reportedIngestRate = -1;
+    /**
+     * @brief s_rateTimeConstantMs
+     * time constant of the ingest rate smoothing
+     */
+    static constexpr int s_rateTimeConstantMs = 30000;
+    /**
+     * @brief s_tightMarginFactor
+     * margin in multiples of the reserve below which the refresh interval shrinks linearly
+     */
+    static constexpr qint64 s_tightMarginFactor = 2;
+};
+} // namespace VeinLogger
+
+#endif // VEINLOGGER_STORAGEMONITOR_H
@@ -0,0 +1,91 @@
+#include "vl_subscriptionindex.h"
+#include "vl_qmllogger.h"
+#include "vl_globallabels.h"
+
+#include <QSet>
+
+namespace VeinLogger
+{
+
+void SubscriptionIndex::rebuild(const QVector<QmlLogger *> &t_scripts)
+{
+    clear();
+
+    //entity id -> component names that need an explicit entry
+    QHash<int, QSet<QString>> explicitComponents;
+    QSet<int> allComponentEntities;
+    for(const QmlLogger *script : t_scripts) {
+        const QMultiHash<int, QString> loggedValues = script->getLoggedValues();
+        for(auto iter = loggedValues.constBegin(); iter != loggedValues.constEnd(); ++iter) {
+            if(iter.value() == VLGlobalLabels::allComponentsName()) {
+                allComponentEntities.insert(iter.key());
+            }
+            else {
+                explicitComponents[iter.key()].insert(iter.value());
+            }
+        }
+    }
+
+    const QStringList componentsNoStore = VLGlobalLabels::noStoreComponents();
+    for(const int entityId : qAsConst(allComponentEntities)) {
+        EntitySubscriptions &entitySubscriptions = m_entities[entityId];
+        for(const QmlLogger *script : t_scripts) {
+            if(script->getLoggedValues().contains(entityId, VLGlobalLabels::allComponentsName())) {
+                entitySubscriptions.allComponents.sessionName = script->sessionName();
+                entitySubscriptions.allComponents.transactionIds.append(script->getTransactionId());
+            }
+        }
+        //components that must not be stored need an entry so they do not fall back to allComponents
+        for(const QString &componentName : componentsNoStore) {
+            explicitComponents[entityId].insert(componentName);
+        }
+    }
+
+    for(auto iter = explicitComponents.constBegin(); iter != explicitComponents.constEnd(); ++iter) {
+        EntitySubscriptions &entitySubscriptions = m_entities[iter.key()];
+        for(const QString &componentName : iter.value()) {
+            Subscription subscription;
+            for(const QmlLogger *script : t_scripts) {
+                if(script->isLoggedComponent(iter.key(), componentName)) {
+                    subscription.sessionName = script->sessionName();
+                    subscription.transactionIds.append(script->getTransactionId());
+                }
+            }
+            entitySubscriptions.components.insert(internComponent(componentName), subscription);
+        }
+    }
+}
+
+void SubscriptionIndex::clear()
+{
+    m_entities.clear();
+}
+
+const SubscriptionIndex::Subscription *SubscriptionIndex::find(int t_entityId, const QString &t_componentName) const
+{
+    const auto entityIter = m_entities.constFind(t_entityId);
+    if(entityIter == m_entities.constEnd()) {
+        return nullptr;
+    }
+
+    const Subscription *subscription = &entityIter->allComponents;
+    const auto componentIdIter = m_componentIds.constFind(t_componentName);
+    if(componentIdIter != m_componentIds.constEnd()) {
+        const auto componentIter = entityIter->components.constFind(componentIdIter.value());
+        if(componentIter != entityIter->components.constEnd()) {
+            subscription = &componentIter.value();
+        }
+    }
+    return subscription->transactionIds.isEmpty() ? nullptr : subscription;
+}
+
+int SubscriptionIndex::internComponent(const QString &t_componentName)
+{
+    auto iter = m_componentIds.constFind(t_componentName);
+    if(iter == m_componentIds.constEnd()) {
+        iter = m_componentIds.insert(t_componentName, m_componentIds.count());
+    }
+    return iter.value();
+}
+
+} // namespace VeinLogger
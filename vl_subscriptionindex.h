@@ -0,0 +1,71 @@
+#ifndef VEINLOGGER_SUBSCRIPTIONINDEX_H
+#define VEINLOGGER_SUBSCRIPTIONINDEX_H
+
+#include "globalIncludes.h"
+
+#include <QHash>
+#include <QVector>
+#include <QString>
+
+namespace VeinLogger
+{
+class QmlLogger;
+
+/**
+ * @brief The SubscriptionIndex class
+ *
+ * Precompiled answer to "which transactions log this value change?".
+ *
+ * The index is rebuilt whenever scripts are added or removed or their logged
+ * components change. It is keyed by entity id and then by an interned component id,
+ * so entities no script is interested in are rejected with a single hash lookup
+ * and lookups never allocate.
+ */
+class SubscriptionIndex
+{
+public:
+    struct Subscription
+    {
+        QString sessionName;
+        QVector<int> transactionIds;
+    };
+
+    /**
+     * @brief rebuild
+     * @param t_scripts: active scripts in the order they were added
+     *
+     * Compiles the index from scratch using QmlLogger::isLoggedComponent semantics.
+     */
+    void rebuild(const QVector<QmlLogger *> &t_scripts);
+    void clear();
+    /**
+     * @brief find
+     * @return the matching subscription or nullptr if the component is not logged
+     *
+     * The returned pointer is valid until the next rebuild() or clear().
+     */
+    const Subscription *find(int t_entityId, const QString &t_componentName) const;
+
+private:
+    struct EntitySubscriptions
+    {
+        /**
+         * @brief allComponents
+         * Used for components without an explicit entry (__ALL_COMPONENTS__ scripts)
+         */
+        Subscription allComponents;
+        /**
+         * @brief components
+         * interned component id -> subscription
+         */
+        QHash<int, Subscription> components;
+    };
+
+    int internComponent(const QString &t_componentName);
+
+    QHash<QString, int> m_componentIds;
+    QHash<int, EntitySubscriptions> m_entities;
+};
+} // namespace VeinLogger
+
+#endif // VEINLOGGER_SUBSCRIPTIONINDEX_H
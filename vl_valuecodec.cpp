@@ -0,0 +1,507 @@
+#include "vl_valuecodec.h"
+
+#include <QDataStream>
+#include <QStringList>
+#include <QJsonArray>
+#include <QCborArray>
+#include <QtEndian>
+
+#include <cstring>
+#include <type_traits>
+
+namespace VeinLogger
+{
+namespace
+{
+//the element types are copied through an unsigned integer of the same size to apply the byte order
+template <class T> using RawType = typename std::conditional<sizeof(T) == 8, quint64, quint32>::type;
+
+template <class T> void writeLittleEndian(char *t_target, T t_value)
+{
+    RawType<T> raw;
+    memcpy(&raw, &t_value, sizeof(T));
+    raw = qToLittleEndian(raw);
+    memcpy(t_target, &raw, sizeof(T));
+}
+
+template <class T> T readLittleEndian(const char *t_source)
+{
+    RawType<T> raw;
+    memcpy(&raw, t_source, sizeof(T));
+    raw = qFromLittleEndian(raw);
+    T retVal;
+    memcpy(&retVal, &raw, sizeof(T));
+    return retVal;
+}
+
+void appendTag(QByteArray &t_target, ValueCodec::Tag t_tag)
+{
+    t_target.append(static_cast<char>(t_tag));
+}
+
+void appendVarint(QByteArray &t_target, quint64 t_value)
+{
+    char buffer[10];
+    int length = 0;
+    while(t_value >= 0x80) {
+        buffer[length++] = static_cast<char>((t_value & 0x7f) | 0x80);
+        t_value >>= 7;
+    }
+    buffer[length++] = static_cast<char>(t_value);
+    t_target.append(buffer, length);
+}
+
+bool readVarint(const char *&t_pos, const char *t_end, quint64 &t_value)
+{
+    t_value = 0;
+    for(int shift = 0; shift < 64 && t_pos < t_end; shift += 7) {
+        const quint8 byte = static_cast<quint8>(*t_pos++);
+        t_value |= static_cast<quint64>(byte & 0x7f) << shift;
+        if((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+quint64 zigzagEncode(qint64 t_value)
+{
+    return (static_cast<quint64>(t_value) << 1) ^ static_cast<quint64>(t_value >> 63);
+}
+
+qint64 zigzagDecode(quint64 t_value)
+{
+    return static_cast<qint64>(t_value >> 1) ^ -static_cast<qint64>(t_value & 1);
+}
+
+void appendBytes(QByteArray &t_target, ValueCodec::Tag t_tag, const QByteArray &t_bytes)
+{
+    appendTag(t_target, t_tag);
+    appendVarint(t_target, static_cast<quint64>(t_bytes.size()));
+    t_target.append(t_bytes);
+}
+
+template <class T> void appendArray(QByteArray &t_target, ValueCodec::Tag t_tag, const QList<T> &t_list)
+{
+    appendTag(t_target, t_tag);
+    appendVarint(t_target, static_cast<quint64>(t_list.size()));
+    int offset = t_target.size();
+    //one resize for the whole array, the elements are copied in place
+    t_target.resize(offset + t_list.size() * static_cast<int>(sizeof(T)));
+    char *target = t_target.data();
+    for(const T &element : t_list) {
+        writeLittleEndian<T>(target + offset, element);
+        offset += sizeof(T);
+    }
+}
+
+template <class T> QList<T> readArray(const ValueCodec::View &t_view)
+{
+    QList<T> retVal;
+    retVal.reserve(t_view.size);
+    for(int i = 0; i < t_view.size; ++i) {
+        retVal.append(readLittleEndian<T>(t_view.payload + i * static_cast<int>(sizeof(T))));
+    }
+    return retVal;
+}
+
+QByteArray dataStreamRepresentation(const QVariant &t_value)
+{
+    QByteArray tmpData;
+    QDataStream dataWriter(&tmpData, QIODevice::WriteOnly);
+    dataWriter.setVersion(QDataStream::Qt_5_0);
+    dataWriter << t_value;
+    return tmpData;
+}
+
+QVariant dataStreamValue(const QByteArray &t_data)
+{
+    QVariant retVal;
+    QDataStream dataReader(t_data);
+    dataReader.setVersion(QDataStream::Qt_5_0);
+    dataReader >> retVal;
+    return retVal;
+}
+} // namespace
+
+double ValueCodec::View::float64At(int t_index) const
+{
+    return readLittleEndian<double>(payload + t_index * 8);
+}
+
+float ValueCodec::View::float32At(int t_index) const
+{
+    return readLittleEndian<float>(payload + t_index * 4);
+}
+
+qint32 ValueCodec::View::int32At(int t_index) const
+{
+    return readLittleEndian<qint32>(payload + t_index * 4);
+}
+
+void ValueCodec::encode(const QVariant &t_value, QByteArray &t_target)
+{
+    switch(static_cast<QMetaType::Type>(t_value.type())) { //see http://stackoverflow.com/questions/31290606/qmetatypefloat-not-in-qvarianttype
+    case QMetaType::UnknownType: {
+        appendTag(t_target, Tag::NULL_VALUE);
+        break;
+    }
+    case QMetaType::Bool: {
+        appendTag(t_target, t_value.toBool() ? Tag::BOOL_TRUE : Tag::BOOL_FALSE);
+        break;
+    }
+    case QMetaType::Int:
+    case QMetaType::Long:
+    case QMetaType::LongLong: {
+        appendTag(t_target, Tag::INT64);
+        appendVarint(t_target, zigzagEncode(t_value.toLongLong()));
+        break;
+    }
+    case QMetaType::UInt:
+    case QMetaType::ULong:
+    case QMetaType::ULongLong: {
+        appendTag(t_target, Tag::UINT64);
+        appendVarint(t_target, t_value.toULongLong());
+        break;
+    }
+    case QMetaType::Double: {
+        appendTag(t_target, Tag::FLOAT64);
+        const int offset = t_target.size();
+        t_target.resize(offset + 8);
+        writeLittleEndian<double>(t_target.data() + offset, t_value.toDouble());
+        break;
+    }
+    case QMetaType::Float: {
+        appendTag(t_target, Tag::FLOAT32);
+        const int offset = t_target.size();
+        t_target.resize(offset + 4);
+        writeLittleEndian<float>(t_target.data() + offset, t_value.value<float>());
+        break;
+    }
+    case QMetaType::QString: {
+        appendBytes(t_target, Tag::STRING, t_value.toString().toUtf8());
+        break;
+    }
+    case QMetaType::QByteArray: {
+        appendBytes(t_target, Tag::BYTES, t_value.toByteArray());
+        break;
+    }
+    case QMetaType::QStringList: {
+        const QStringList tmpList = t_value.toStringList();
+        appendTag(t_target, Tag::STRING_LIST);
+        appendVarint(t_target, static_cast<quint64>(tmpList.size()));
+        for(const QString &entry : tmpList) {
+            const QByteArray utf8 = entry.toUtf8();
+            appendVarint(t_target, static_cast<quint64>(utf8.size()));
+            t_target.append(utf8);
+        }
+        break;
+    }
+    default: {
+        const int tmpDataType = t_value.userType();
+        if(tmpDataType == qMetaTypeId<QList<double> >()) {
+            appendArray<double>(t_target, Tag::FLOAT64_ARRAY, t_value.value<QList<double> >());
+        }
+        else if(tmpDataType == qMetaTypeId<QList<float> >()) {
+            appendArray<float>(t_target, Tag::FLOAT32_ARRAY, t_value.value<QList<float> >());
+        }
+        else if(tmpDataType == qMetaTypeId<QList<int> >()) {
+            appendArray<qint32>(t_target, Tag::INT32_ARRAY, t_value.value<QList<int> >());
+        }
+        else {
+            appendBytes(t_target, Tag::DATASTREAM, dataStreamRepresentation(t_value));
+        }
+        break;
+    }
+    }
+}
+
+QByteArray ValueCodec::encode(const QVariant &t_value)
+{
+    QByteArray retVal;
+    encode(t_value, retVal);
+    return retVal;
+}
+
+bool ValueCodec::view(const char *t_data, int t_size, View &t_view)
+{
+    if(t_size < 1) {
+        return false;
+    }
+    const char *pos = t_data + 1;
+    const char *end = t_data + t_size;
+    quint64 tmpValue = 0;
+    t_view = View();
+    t_view.tag = static_cast<Tag>(static_cast<quint8>(t_data[0]));
+
+    switch(t_view.tag) {
+    case Tag::NULL_VALUE:
+        return true;
+    case Tag::BOOL_FALSE:
+    case Tag::BOOL_TRUE:
+        t_view.integerValue = t_view.tag == Tag::BOOL_TRUE ? 1 : 0;
+        return true;
+    case Tag::INT64:
+        if(readVarint(pos, end, tmpValue) == false) {
+            return false;
+        }
+        t_view.integerValue = zigzagDecode(tmpValue);
+        return true;
+    case Tag::UINT64:
+        if(readVarint(pos, end, tmpValue) == false) {
+            return false;
+        }
+        t_view.integerValue = static_cast<qint64>(tmpValue);
+        return true;
+    case Tag::FLOAT64:
+        if(end - pos < 8) {
+            return false;
+        }
+        t_view.realValue = readLittleEndian<double>(pos);
+        return true;
+    case Tag::FLOAT32:
+        if(end - pos < 4) {
+            return false;
+        }
+        t_view.realValue = readLittleEndian<float>(pos);
+        return true;
+    case Tag::STRING:
+    case Tag::BYTES:
+    case Tag::DATASTREAM:
+    case Tag::STRING_LIST:
+    case Tag::FLOAT64_ARRAY:
+    case Tag::FLOAT32_ARRAY:
+    case Tag::INT32_ARRAY: {
+        if(readVarint(pos, end, tmpValue) == false) {
+            return false;
+        }
+        quint64 payloadSize = tmpValue;
+        if(t_view.tag == Tag::FLOAT64_ARRAY) {
+            payloadSize = tmpValue * 8;
+        }
+        else if(t_view.tag == Tag::FLOAT32_ARRAY || t_view.tag == Tag::INT32_ARRAY) {
+            payloadSize = tmpValue * 4;
+        }
+        else if(t_view.tag == Tag::STRING_LIST) {
+            //entries have their own length prefix, checked while reading them
+            payloadSize = 0;
+        }
+        if(tmpValue > static_cast<quint64>(t_size) || payloadSize > static_cast<quint64>(end - pos)) {
+            return false;
+        }
+        t_view.payload = pos;
+        t_view.size = static_cast<int>(tmpValue);
+        return true;
+    }
+    default:
+        //LEGACY_DATASTREAM or unknown
+        return false;
+    }
+}
+
+QVariant ValueCodec::decode(const QByteArray &t_data)
+{
+    View tmpView;
+    if(view(t_data.constData(), t_data.size(), tmpView) == false) {
+        if(t_data.isEmpty() == false && static_cast<Tag>(static_cast<quint8>(t_data.at(0))) == Tag::LEGACY_DATASTREAM) {
+            return decodeLegacy(t_data);
+        }
+        return QVariant();
+    }
+
+    switch(tmpView.tag) {
+    case Tag::BOOL_FALSE:
+    case Tag::BOOL_TRUE:
+        return QVariant(tmpView.integerValue != 0);
+    case Tag::INT64:
+        return QVariant(tmpView.integerValue);
+    case Tag::UINT64:
+        return QVariant(static_cast<quint64>(tmpView.integerValue));
+    case Tag::FLOAT64:
+        return QVariant(tmpView.realValue);
+    case Tag::FLOAT32:
+        return QVariant(static_cast<float>(tmpView.realValue));
+    case Tag::STRING:
+        return QVariant(QString::fromUtf8(tmpView.payload, tmpView.size));
+    case Tag::BYTES:
+        return QVariant(QByteArray(tmpView.payload, tmpView.size));
+    case Tag::FLOAT64_ARRAY:
+        return QVariant::fromValue(readArray<double>(tmpView));
+    case Tag::FLOAT32_ARRAY:
+        return QVariant::fromValue(readArray<float>(tmpView));
+    case Tag::INT32_ARRAY:
+        return QVariant::fromValue(readArray<qint32>(tmpView));
+    case Tag::STRING_LIST: {
+        QStringList tmpList;
+        const char *pos = tmpView.payload;
+        const char *end = t_data.constData() + t_data.size();
+        for(int i = 0; i < tmpView.size; ++i) {
+            quint64 length = 0;
+            if(readVarint(pos, end, length) == false || length > static_cast<quint64>(end - pos)) {
+                return QVariant();
+            }
+            tmpList.append(QString::fromUtf8(pos, static_cast<int>(length)));
+            pos += length;
+        }
+        return QVariant(tmpList);
+    }
+    case Tag::DATASTREAM:
+        return dataStreamValue(QByteArray::fromRawData(tmpView.payload, tmpView.size));
+    default:
+        return QVariant();
+    }
+}
+
+QJsonValue ValueCodec::decodeToJson(const QByteArray &t_data)
+{
+    View tmpView;
+    if(view(t_data.constData(), t_data.size(), tmpView) == false) {
+        return toJson(decode(t_data));
+    }
+
+    switch(tmpView.tag) {
+    case Tag::FLOAT64_ARRAY: {
+        QJsonArray tmpArray;
+        for(int i = 0; i < tmpView.size; ++i) {
+            tmpArray.append(tmpView.float64At(i));
+        }
+        return tmpArray;
+    }
+    case Tag::FLOAT32_ARRAY: {
+        QJsonArray tmpArray;
+        for(int i = 0; i < tmpView.size; ++i) {
+            tmpArray.append(static_cast<double>(tmpView.float32At(i)));
+        }
+        return tmpArray;
+    }
+    case Tag::INT32_ARRAY: {
+        QJsonArray tmpArray;
+        for(int i = 0; i < tmpView.size; ++i) {
+            tmpArray.append(tmpView.int32At(i));
+        }
+        return tmpArray;
+    }
+    case Tag::INT64:
+    case Tag::UINT64:
+        return QJsonValue(tmpView.integerValue);
+    case Tag::FLOAT64:
+    case Tag::FLOAT32:
+        return QJsonValue(tmpView.realValue);
+    case Tag::STRING:
+        return QJsonValue(QString::fromUtf8(tmpView.payload, tmpView.size));
+    default:
+        return toJson(decode(t_data));
+    }
+}
+
+QCborValue ValueCodec::decodeToCbor(const QByteArray &t_data)
+{
+    View tmpView;
+    if(view(t_data.constData(), t_data.size(), tmpView) == false) {
+        return toCbor(decode(t_data));
+    }
+
+    switch(tmpView.tag) {
+    case Tag::NULL_VALUE:
+        return QCborValue(QCborValue::Null);
+    case Tag::BOOL_FALSE:
+    case Tag::BOOL_TRUE:
+        return QCborValue(tmpView.integerValue != 0);
+    case Tag::FLOAT64_ARRAY: {
+        QCborArray tmpArray;
+        for(int i = 0; i < tmpView.size; ++i) {
+            tmpArray.append(tmpView.float64At(i));
+        }
+        return tmpArray;
+    }
+    case Tag::FLOAT32_ARRAY: {
+        QCborArray tmpArray;
+        for(int i = 0; i < tmpView.size; ++i) {
+            tmpArray.append(static_cast<double>(tmpView.float32At(i)));
+        }
+        return tmpArray;
+    }
+    case Tag::INT32_ARRAY: {
+        QCborArray tmpArray;
+        for(int i = 0; i < tmpView.size; ++i) {
+            tmpArray.append(static_cast<qint64>(tmpView.int32At(i)));
+        }
+        return tmpArray;
+    }
+    case Tag::INT64:
+        return QCborValue(tmpView.integerValue);
+    case Tag::FLOAT64:
+    case Tag::FLOAT32:
+        return QCborValue(tmpView.realValue);
+    case Tag::STRING:
+        return QCborValue(QString::fromUtf8(tmpView.payload, tmpView.size));
+    case Tag::BYTES:
+        return QCborValue(QByteArray(tmpView.payload, tmpView.size));
+    default:
+        return toCbor(decode(t_data));
+    }
+}
+
+QCborValue ValueCodec::toCbor(const QVariant &t_value)
+{
+    const int tmpDataType = t_value.userType();
+    if(tmpDataType == qMetaTypeId<QList<double> >()) {
+        QCborArray tmpArray;
+        for(const double var : t_value.value<QList<double> >()) {
+            tmpArray.append(var);
+        }
+        return tmpArray;
+    }
+    if(tmpDataType == qMetaTypeId<QList<float> >()) {
+        QCborArray tmpArray;
+        for(const float var : t_value.value<QList<float> >()) {
+            tmpArray.append(static_cast<double>(var));
+        }
+        return tmpArray;
+    }
+    if(tmpDataType == qMetaTypeId<QList<int> >()) {
+        QCborArray tmpArray;
+        for(const int var : t_value.value<QList<int> >()) {
+            tmpArray.append(static_cast<qint64>(var));
+        }
+        return tmpArray;
+    }
+    if(tmpDataType == QMetaType::Float) {
+        return QCborValue(static_cast<double>(t_value.value<float>()));
+    }
+    return QCborValue::fromVariant(t_value);
+}
+
+QVariant ValueCodec::decodeLegacy(const QByteArray &t_data)
+{
+    return dataStreamValue(t_data);
+}
+
+QJsonValue ValueCodec::toJson(const QVariant &t_value)
+{
+    const int tmpDataType = t_value.userType();
+    if(tmpDataType == qMetaTypeId<QList<double> >()) {
+        QJsonArray tmpArray;
+        for(const double var : t_value.value<QList<double> >()) {
+            tmpArray.append(var);
+        }
+        return tmpArray;
+    }
+    if(tmpDataType == qMetaTypeId<QList<float> >()) {
+        QJsonArray tmpArray;
+        for(const float var : t_value.value<QList<float> >()) {
+            tmpArray.append(static_cast<double>(var));
+        }
+        return tmpArray;
+    }
+    if(tmpDataType == qMetaTypeId<QList<int> >()) {
+        QJsonArray tmpArray;
+        for(const int var : t_value.value<QList<int> >()) {
+            tmpArray.append(var);
+        }
+        return tmpArray;
+    }
+    return QJsonValue::fromVariant(t_value);
+}
+
+} // namespace VeinLogger
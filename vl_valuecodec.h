@@ -0,0 +1,117 @@
+#ifndef VEINLOGGER_VALUECODEC_H
+#define VEINLOGGER_VALUECODEC_H
+
+#include "globalIncludes.h"
+
+#include <QByteArray>
+#include <QVariant>
+#include <QJsonValue>
+#include <QCborValue>
+
+namespace VeinLogger
+{
+/**
+ * @brief The ValueCodec class
+ *
+ * Compact binary representation of logged values, used for BLOBs in STORAGE_MODE::BINARY and STORAGE_MODE::TYPED.
+ *
+ * Layout: one type tag byte followed by the payload
+ * - scalars: zigzag varint for integers, raw little endian float64/float32
+ * - strings and byte arrays: varint length + bytes (utf8 for strings)
+ * - QList<double>, QList<float>, QList<int>: varint count + raw little endian elements, copied with memcpy
+ * - other types: QDataStream representation of the QVariant as payload
+ *
+ * The tags are never 0, blobs written with QDataStream (Qt_5_0) before start with the 0 byte of
+ * the big endian type id and are decoded with the legacy reader.
+ */
+class ValueCodec
+{
+public:
+    enum class Tag : quint8 {
+        LEGACY_DATASTREAM = 0x00, ///< never written, first byte of old QDataStream blobs
+        NULL_VALUE = 0x01,
+        BOOL_FALSE = 0x02,
+        BOOL_TRUE = 0x03,
+        INT64 = 0x04,
+        UINT64 = 0x05,
+        FLOAT64 = 0x06,
+        FLOAT32 = 0x07,
+        STRING = 0x08,
+        BYTES = 0x09,
+        FLOAT64_ARRAY = 0x0a,
+        FLOAT32_ARRAY = 0x0b,
+        INT32_ARRAY = 0x0c,
+        STRING_LIST = 0x0d,
+        DATASTREAM = 0x7f, ///< fallback for types without own encoding
+    };
+
+    /**
+     * @brief The View struct
+     *
+     * Decoded header of an encoded value, the payload is not copied.
+     * Array elements are read with float64At(), float32At() and int32At() as the blob is not necessarily aligned.
+     */
+    struct View
+    {
+        Tag tag = Tag::NULL_VALUE;
+        const char *payload = nullptr;
+        /**
+         * @brief size
+         * payload size in bytes, element count for arrays and string lists
+         */
+        int size = 0;
+        qint64 integerValue = 0;
+        double realValue = 0.0;
+
+        double float64At(int t_index) const;
+        float float32At(int t_index) const;
+        qint32 int32At(int t_index) const;
+    };
+
+    /**
+     * @brief encode
+     * Appends the encoded t_value to t_target, t_target is not cleared so the caller can reuse its capacity
+     */
+    static void encode(const QVariant &t_value, QByteArray &t_target);
+    static QByteArray encode(const QVariant &t_value);
+
+    /**
+     * @brief view
+     * @return false for truncated or unknown data and for legacy QDataStream blobs
+     */
+    static bool view(const char *t_data, int t_size, View &t_view);
+
+    /**
+     * @brief decode
+     * Decodes new and legacy (QDataStream) blobs back to the original QVariant
+     */
+    static QVariant decode(const QByteArray &t_data);
+    /**
+     * @brief decodeToJson
+     * Converts directly from the blob to JSON, arrays are not materialized as QList first
+     */
+    static QJsonValue decodeToJson(const QByteArray &t_data);
+    /**
+     * @brief toJson
+     * QJsonValue::fromVariant does not know the list types used by vein components
+     */
+    static QJsonValue toJson(const QVariant &t_value);
+    /**
+     * @brief decodeToCbor
+     * Like decodeToJson, but integers keep 64 bit and byte arrays stay binary
+     */
+    static QCborValue decodeToCbor(const QByteArray &t_data);
+    /**
+     * @brief toCbor
+     * QCborValue::fromVariant does not know the list types used by vein components
+     */
+    static QCborValue toCbor(const QVariant &t_value);
+    /**
+     * @brief decodeLegacy
+     * Reader for blobs written with QDataStream::Qt_5_0
+     */
+    static QVariant decodeLegacy(const QByteArray &t_data);
+};
+} // namespace VeinLogger
+
+#endif // VEINLOGGER_VALUECODEC_H
@@ -0,0 +1,258 @@
+#include "vl_valuejournal.h"
+#include "vl_batchrecordcodec.h"
+
+#include <QtEndian>
+
+#include <cerrno>
+#include <cstring>
+#if defined(Q_OS_UNIX)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace VeinLogger
+{
+namespace
+{
+const char s_magic[8] = {'V', 'L', 'J', 'R', 'N', 'L', '0', '1'};
+constexpr qint64 s_headerSize = 16;
+constexpr int s_epochOffset = 8;
+/**
+ * payload size, epoch, checksum, reserved
+ */
+constexpr int s_recordHeaderSize = 4 + 4 + 2 + 2;
+} // namespace
+
+//constexpr definition, see: https://stackoverflow.com/questions/8016780/undefined-reference-to-static-constexpr-char
+constexpr qint64 ValueJournal::s_defaultCapacity;
+
+ValueJournal::ValueJournal()
+{
+}
+
+ValueJournal::~ValueJournal()
+{
+    close();
+}
+
+QString ValueJournal::pathForDatabase(const QString &t_dbPath)
+{
+    return t_dbPath + QStringLiteral(".journal");
+}
+
+bool ValueJournal::open(const QString &t_path, qint64 t_capacity)
+{
+    close();
+#if !defined(Q_OS_UNIX)
+    //mapped records reach the storage with msync only
+    m_lastError = QStringLiteral("ValueJournal: not supported on this platform");
+    Q_UNUSED(t_path)
+    Q_UNUSED(t_capacity)
+    return false;
+#endif
+    m_file.setFileName(t_path);
+    if(m_file.open(QIODevice::ReadWrite) == false) {
+        return setError(QStringLiteral("open"));
+    }
+    const bool existing = m_file.size() >= s_headerSize;
+    if(m_file.size() != t_capacity && m_file.resize(t_capacity) == false) {
+        return setError(QStringLiteral("resize"));
+    }
+    m_capacity = t_capacity;
+    m_map = m_file.map(0, m_capacity);
+    if(m_map == nullptr) {
+        return setError(QStringLiteral("map"));
+    }
+    if(existing && std::memcmp(m_map, s_magic, sizeof(s_magic)) == 0) {
+        m_epoch = qFromLittleEndian<quint32>(m_map + s_epochOffset);
+        //the records of the current epoch were not committed, new ones are appended behind them
+        m_writePos = s_headerSize;
+        while(m_writePos + s_recordHeaderSize <= m_capacity) {
+            const uchar *record = m_map + m_writePos;
+            const qint64 payloadSize = qFromLittleEndian<quint32>(record);
+            if(qFromLittleEndian<quint32>(record + 4) != m_epoch
+                    || m_writePos + s_recordHeaderSize + payloadSize > m_capacity
+                    || qChecksum(reinterpret_cast<const char *>(record + s_recordHeaderSize), uint(payloadSize)) != qFromLittleEndian<quint16>(record + 8)) {
+                break;
+            }
+            m_writePos += s_recordHeaderSize + payloadSize;
+        }
+    }
+    else {
+        std::memcpy(m_map, s_magic, sizeof(s_magic));
+        m_epoch = 1;
+        qToLittleEndian<quint32>(m_epoch, m_map + s_epochOffset);
+        qToLittleEndian<quint32>(0, m_map + s_epochOffset + 4);
+        m_writePos = s_headerSize;
+        if(syncRange(0, s_headerSize) == false) {
+            return false;
+        }
+    }
+    m_syncedPos = m_writePos;
+    return true;
+}
+
+bool ValueJournal::isOpen() const
+{
+    return m_map != nullptr;
+}
+
+void ValueJournal::close()
+{
+    if(m_map != nullptr) {
+        sync();
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    if(m_file.isOpen()) {
+        m_file.close();
+    }
+    m_capacity = 0;
+    m_writePos = 0;
+    m_syncedPos = 0;
+}
+
+bool ValueJournal::remove()
+{
+    if(m_map == nullptr) {
+        return true;
+    }
+    const QString path = m_file.fileName();
+    close();
+    if(QFile::remove(path) == false) {
+        m_lastError = QStringLiteral("ValueJournal: unable to remove %1").arg(path);
+        return false;
+    }
+    return true;
+}
+
+bool ValueJournal::readRecords(QVector<SQLBatchData> &t_target)
+{
+    if(m_map == nullptr) {
+        m_lastError = QStringLiteral("ValueJournal: not open");
+        return false;
+    }
+    qint64 recordPos = s_headerSize;
+    while(recordPos < m_writePos) {
+        const uchar *record = m_map + recordPos;
+        const int payloadSize = int(qFromLittleEndian<quint32>(record));
+        SQLBatchData batchData;
+        if(BatchRecordCodec::decode(reinterpret_cast<const char *>(record + s_recordHeaderSize), payloadSize, batchData) == false) {
+            m_lastError = QStringLiteral("ValueJournal: corrupt record at %1").arg(recordPos);
+            return false;
+        }
+        t_target.append(batchData);
+        recordPos += s_recordHeaderSize + payloadSize;
+    }
+    return true;
+}
+
+bool ValueJournal::append(const SQLBatchData &t_data)
+{
+    if(m_map == nullptr) {
+        m_lastError = QStringLiteral("ValueJournal: not open");
+        return false;
+    }
+    m_buffer.clear();
+    if(BatchRecordCodec::encode(t_data, m_buffer) == false) {
+        m_lastError = QStringLiteral("ValueJournal: too many transactions for one value");
+        return false;
+    }
+    const qint64 recordSize = s_recordHeaderSize + m_buffer.size();
+    if(m_writePos + recordSize > m_capacity) {
+        m_lastError = QStringLiteral("ValueJournal: full");
+        return false;
+    }
+    uchar *record = m_map + m_writePos;
+    std::memcpy(record + s_recordHeaderSize, m_buffer.constData(), size_t(m_buffer.size()));
+    qToLittleEndian<quint32>(quint32(m_buffer.size()), record);
+    qToLittleEndian<quint32>(m_epoch, record + 4);
+    qToLittleEndian<quint16>(qChecksum(m_buffer.constData(), uint(m_buffer.size())), record + 8);
+    qToLittleEndian<quint16>(0, record + 10);
+    m_writePos += recordSize;
+    return true;
+}
+
+bool ValueJournal::sync()
+{
+    if(m_map == nullptr || m_syncedPos == m_writePos) {
+        return true;
+    }
+    if(syncRange(m_syncedPos, m_writePos) == false) {
+        return false;
+    }
+    m_syncedPos = m_writePos;
+    return true;
+}
+
+bool ValueJournal::truncate()
+{
+    if(m_map == nullptr) {
+        return true;
+    }
+    if(m_writePos == s_headerSize) {
+        return true;
+    }
+    ++m_epoch;
+    qToLittleEndian<quint32>(m_epoch, m_map + s_epochOffset);
+    m_writePos = s_headerSize;
+    m_syncedPos = s_headerSize;
+    return syncRange(0, s_headerSize);
+}
+
+quint32 ValueJournal::epoch() const
+{
+    return m_epoch;
+}
+
+bool ValueJournal::isEmpty() const
+{
+    return m_writePos <= s_headerSize;
+}
+
+bool ValueJournal::needsSync() const
+{
+    return m_syncedPos != m_writePos;
+}
+
+qint64 ValueJournal::usedBytes() const
+{
+    return qMax(m_writePos - s_headerSize, qint64(0));
+}
+
+QString ValueJournal::lastError() const
+{
+    return m_lastError;
+}
+
+bool ValueJournal::syncRange(qint64 t_from, qint64 t_to)
+{
+#if defined(Q_OS_UNIX)
+    //msync needs a page aligned start
+    static const qint64 pageSize = ::sysconf(_SC_PAGESIZE);
+    const qint64 alignedFrom = t_from - t_from % pageSize;
+    if(::msync(m_map + alignedFrom, size_t(t_to - alignedFrom), MS_SYNC) != 0) {
+        m_lastError = QStringLiteral("ValueJournal: msync failed for %1: %2").arg(m_file.fileName()).arg(QString::fromLocal8Bit(std::strerror(errno)));
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED(t_from)
+    Q_UNUSED(t_to)
+    m_lastError = QStringLiteral("ValueJournal: not supported on this platform");
+    return false;
+#endif
+}
+
+bool ValueJournal::setError(const QString &t_context)
+{
+    m_lastError = QStringLiteral("ValueJournal %1 (%2): %3").arg(t_context).arg(m_file.fileName()).arg(m_file.errorString());
+    if(m_map != nullptr) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_file.close();
+    return false;
+}
+
+} // namespace VeinLogger
@@ -0,0 +1,113 @@
+#ifndef VEINLOGGER_VALUEJOURNAL_H
+#define VEINLOGGER_VALUEJOURNAL_H
+
+#include "globalIncludes.h"
+#include "vl_sqlitedb.h"
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QFile>
+
+namespace VeinLogger
+{
+/**
+ * @brief The ValueJournal class
+ *
+ * Pre-commit journal of the values buffered for the next batch: every value is appended to a memory mapped
+ * file of fixed size when it is logged, the journal is truncated after the batch is committed.
+ * After a crash the values of the last epoch are read back and written to the database.
+ *
+ * Layout: 8 bytes magic, uint32 epoch, uint32 reserved, then the records:
+ * uint32 payload size, uint32 epoch, uint16 checksum of the payload, uint16 reserved, payload (see BatchRecordCodec).
+ * All integers are little endian.
+ *
+ * The file is not a ring buffer: records are appended linearly from the header up to the fixed capacity,
+ * append() fails when it is full. Truncating only increments the epoch in the header, so the file is reused
+ * from the start without clearing it. Records of older epochs and records torn by a power loss end the replay.
+ *
+ * A crash after the batch commit but before truncate() leaves committed records in the journal. SQLiteDB stores
+ * epoch() in the batch transaction and does not replay a journal whose epoch is already committed.
+ *
+ * Appended records reach the storage with sync(), called by the owner at its sync interval.
+ */
+class ValueJournal
+{
+public:
+    ValueJournal();
+    ~ValueJournal();
+
+    static QString pathForDatabase(const QString &t_dbPath);
+
+    /**
+     * @brief open
+     * Creates and maps the file, the records of an existing journal are kept for readRecords()
+     * @return false on error, see lastError()
+     */
+    bool open(const QString &t_path, qint64 t_capacity = s_defaultCapacity);
+    bool isOpen() const;
+    void close();
+    /**
+     * @brief remove
+     * Closes and deletes the open journal, call when it is empty
+     */
+    bool remove();
+
+    /**
+     * @brief readRecords
+     * Appends the records of the current epoch to t_target
+     * @return false for records that cannot be decoded
+     */
+    bool readRecords(QVector<SQLBatchData> &t_target);
+    /**
+     * @brief append
+     * @return false if the journal is full, the value is not crash safe until the next truncate()
+     */
+    bool append(const SQLBatchData &t_data);
+    /**
+     * @brief sync
+     * Writes the records appended since the last sync to the storage
+     */
+    bool sync();
+    /**
+     * @brief truncate
+     * Drops all records, the new epoch is synced immediately so committed values are not replayed twice
+     */
+    bool truncate();
+
+    /**
+     * @brief epoch
+     * @return epoch of the records not yet truncated, the owner stores it with the commit of their batch
+     */
+    quint32 epoch() const;
+    bool isEmpty() const;
+    bool needsSync() const;
+    qint64 usedBytes() const;
+    QString lastError() const;
+
+    /**
+     * @brief s_defaultCapacity
+     * the compact records of a batch at the memory budget of SQLiteDB fit in
+     */
+    static constexpr qint64 s_defaultCapacity = 32 * 1024 * 1024;
+
+private:
+    bool syncRange(qint64 t_from, qint64 t_to);
+    bool setError(const QString &t_context);
+
+    QFile m_file;
+    uchar *m_map = nullptr;
+    qint64 m_capacity = 0;
+    quint32 m_epoch = 0;
+    qint64 m_writePos = 0;
+    qint64 m_syncedPos = 0;
+    /**
+     * @brief m_buffer
+     * reused for encoding
+     */
+    QByteArray m_buffer;
+    QString m_lastError;
+};
+} // namespace VeinLogger
+
+#endif // VEINLOGGER_VALUEJOURNAL_H
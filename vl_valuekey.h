@@ -0,0 +1,34 @@
+#ifndef VEINLOGGER_VALUEKEY_H
+#define VEINLOGGER_VALUEKEY_H
+
+#include "globalIncludes.h"
+
+#include <QHash>
+#include <QString>
+
+namespace VeinLogger
+{
+/**
+ * @brief The ValueKey struct
+ *
+ * Identifies the values of one component logged by one transaction, key of the per value state of the logging stages
+ */
+struct ValueKey
+{
+    int transactionId;
+    int entityId;
+    QString componentName;
+
+    bool operator==(const ValueKey &t_other) const
+    {
+        return transactionId == t_other.transactionId && entityId == t_other.entityId && componentName == t_other.componentName;
+    }
+};
+
+inline uint qHash(const ValueKey &t_key, uint t_seed = 0)
+{
+    return qHash(t_key.componentName, t_seed) ^ (uint(t_key.entityId) * 31u + uint(t_key.transactionId));
+}
+} // namespace VeinLogger
+
+#endif // VEINLOGGER_VALUEKEY_H